@@ -0,0 +1,35 @@
+################################################################
+# modbus4qt library
+# Copyright (C) 2012-2013, MELZ-INVEST JSC
+# Author: Leonid Kolesnik
+#
+# Common settings for benchmark programs
+#
+################################################################
+
+MODBUS4QT_ROOT = $${PWD}/..
+include($${MODBUS4QT_ROOT}/modbus4qt_config.pri)
+include($${MODBUS4QT_ROOT}/modbus4qt_build.pri)
+
+TEMPLATE = app
+
+QT += network serialport
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+DESTDIR = $${MODBUS4QT_BUILD}/benchmarks
+
+INCLUDEPATH += $${PWD}/common
+DEPENDPATH  += $${PWD}/common
+
+SOURCES += \
+    $${PWD}/common/bench_requests.cpp \
+    $${PWD}/common/bench_utils.cpp
+
+HEADERS += \
+    $${PWD}/common/bench_requests.h \
+    $${PWD}/common/bench_utils.h
+
+LIBS += -lmodbus4qt
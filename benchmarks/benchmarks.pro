@@ -0,0 +1,21 @@
+################################################################
+# modbus4qt library
+# Copyright (C) 2012-2013, MELZ-INVEST JSC
+# Author: Leonid Kolesnik
+#
+################################################################
+
+include( $${PWD}/../modbus4qt_config.pri )
+
+TEMPLATE = subdirs
+
+    SUBDIRS += \
+        codec \
+        loopback \
+        queue
+
+# Pseudo terminals are used to emulate serial line
+linux {
+    SUBDIRS += \
+        rtu_pty
+}
@@ -0,0 +1,15 @@
+include( $${PWD}/../benchmarks.pri )
+
+TARGET = codec-bench
+
+MOC_DIR = $${MOC_DIR}/benchmarks/codec
+OBJECTS_DIR = $${OBJECTS_DIR}/benchmarks/codec
+
+SOURCES += \
+    main.cpp \
+    codec_kernels.cpp \
+    reference_codec.cpp
+
+HEADERS += \
+    codec_kernels.h \
+    reference_codec.h
@@ -0,0 +1,632 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "codec_kernels.h"
+#include "reference_codec.h"
+
+#include "register_decoder.h"
+#include "rtu_client.h"
+#include "utils.h"
+
+#include <QByteArray>
+#include <QVector>
+
+#include <random>
+
+#include <string.h>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+/**
+ * @brief
+ * @en Gives access to ADU builders of RtuClient
+ * @ru Предоставляет доступ к функциям формирования ADU класса RtuClient
+ */
+class RtuCodec : public RtuClient
+{
+    public:
+
+        RtuCodec()
+            : RtuClient(QString(), QSerialPort::Baud9600, QSerialPort::Data8, QSerialPort::OneStop, QSerialPort::EvenParity, 0)
+        {
+        }
+
+        QByteArray buildADU(const ProtocolDataUnit& pdu, int pduSize)
+        {
+            return prepareADU_(pdu, pduSize);
+        }
+
+        ProtocolDataUnit parseADU(const QByteArray& adu)
+        {
+            return processADU_(adu);
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+static QByteArray
+randomBytes(int size, std::mt19937& random)
+{
+    QByteArray result(size, 0);
+
+    for (int i = 0; i < size; ++i)
+        result[i] = char(random() & 0xFF);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+static QList<int>
+makeSizes(int first, int second, int third)
+{
+    QList<int> result;
+    result << first << second << third;
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+class Crc16Kernel : public CodecKernel
+{
+    private:
+
+        QByteArray data_;
+
+    public:
+
+        virtual QString name() const
+        {
+            return "crc16";
+        }
+
+        virtual QString unit() const
+        {
+            return "bytes";
+        }
+
+        // Shortest request, typical response and maximum RTU frame without CRC
+        virtual QList<int> sizes() const
+        {
+            return makeSizes(6, 64, 254);
+        }
+
+        virtual void setUp(int size, quint32 seed)
+        {
+            std::mt19937 random(seed);
+            data_ = randomBytes(size, random);
+        }
+
+        virtual int bytes() const
+        {
+            return data_.size();
+        }
+
+        virtual quint32 run()
+        {
+            return modbus4qt::crc16(data_);
+        }
+
+        // Library returns CRC with first transmitted byte in high byte
+        virtual bool verify()
+        {
+            quint16 expected = reference::crc16((const quint8*)data_.constData(), data_.size());
+
+            return modbus4qt::crc16(data_) == swap(expected);
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+class GetCoilsKernel : public CodecKernel
+{
+    private:
+
+        QByteArray buffer_;
+
+        int count_;
+
+    public:
+
+        GetCoilsKernel()
+            : count_(0)
+        {
+        }
+
+        virtual QString name() const
+        {
+            return "getCoilsFromBuffer";
+        }
+
+        virtual QString unit() const
+        {
+            return "coils";
+        }
+
+        virtual QList<int> sizes() const
+        {
+            return makeSizes(8, 128, MaxCoilsForRead);
+        }
+
+        virtual void setUp(int size, quint32 seed)
+        {
+            std::mt19937 random(seed);
+            count_ = size;
+            buffer_ = randomBytes((size + 7) / 8, random);
+        }
+
+        virtual int bytes() const
+        {
+            return buffer_.size();
+        }
+
+        virtual quint32 run()
+        {
+            QVector<bool> values = getCoilsFromBuffer(buffer_, count_);
+
+            return values.at(count_ - 1);
+        }
+
+        virtual bool verify()
+        {
+            QVector<bool> expected(count_);
+            reference::unpackCoils((const quint8*)buffer_.constData(), count_, expected.data());
+
+            return getCoilsFromBuffer(buffer_, count_) == expected;
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+class PutCoilsKernel : public CodecKernel
+{
+    private:
+
+        QVector<bool> values_;
+
+        QByteArray buffer_;
+
+    public:
+
+        virtual QString name() const
+        {
+            return "putCoilsIntoBuffer";
+        }
+
+        virtual QString unit() const
+        {
+            return "coils";
+        }
+
+        virtual QList<int> sizes() const
+        {
+            return makeSizes(8, 128, MaxCoilsForRead);
+        }
+
+        virtual void setUp(int size, quint32 seed)
+        {
+            std::mt19937 random(seed);
+
+            values_.resize(size);
+            for (int i = 0; i < size; ++i)
+                values_[i] = random() & 1;
+
+            buffer_.fill(0, (size + 7) / 8);
+        }
+
+        virtual int bytes() const
+        {
+            return buffer_.size();
+        }
+
+        virtual quint32 run()
+        {
+            putCoilsIntoBuffer((quint8*)buffer_.data(), values_);
+
+            return quint8(buffer_.at(0));
+        }
+
+        virtual bool verify()
+        {
+            QByteArray expected(buffer_.size(), 0);
+            reference::packCoils(values_.constData(), values_.size(), (quint8*)expected.data());
+
+            // Fill with garbage to check that all bits are written
+            buffer_.fill(char(0xA5));
+            putCoilsIntoBuffer((quint8*)buffer_.data(), values_);
+
+            return buffer_ == expected;
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+class GetRegistersKernel : public CodecKernel
+{
+    private:
+
+        QByteArray buffer_;
+
+        int count_;
+
+    public:
+
+        GetRegistersKernel()
+            : count_(0)
+        {
+        }
+
+        virtual QString name() const
+        {
+            return "getRegistersFromBuffer";
+        }
+
+        virtual QString unit() const
+        {
+            return "registers";
+        }
+
+        virtual QList<int> sizes() const
+        {
+            return makeSizes(1, 16, MaxRegistersForRead);
+        }
+
+        virtual void setUp(int size, quint32 seed)
+        {
+            std::mt19937 random(seed);
+            count_ = size;
+            buffer_ = randomBytes(size * 2, random);
+        }
+
+        virtual int bytes() const
+        {
+            return buffer_.size();
+        }
+
+        virtual quint32 run()
+        {
+            QVector<quint16> values = getRegistersFromBuffer(buffer_, count_);
+
+            return values.at(count_ - 1);
+        }
+
+        virtual bool verify()
+        {
+            QVector<quint16> expected(count_);
+            reference::unpackRegisters((const quint8*)buffer_.constData(), count_, expected.data());
+
+            return getRegistersFromBuffer(buffer_, count_) == expected;
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+class PutRegistersKernel : public CodecKernel
+{
+    private:
+
+        QVector<quint16> values_;
+
+        QByteArray buffer_;
+
+    public:
+
+        virtual QString name() const
+        {
+            return "putRegistersIntoBuffer";
+        }
+
+        virtual QString unit() const
+        {
+            return "registers";
+        }
+
+        virtual QList<int> sizes() const
+        {
+            return makeSizes(1, 16, MaxRegistersForRead);
+        }
+
+        virtual void setUp(int size, quint32 seed)
+        {
+            std::mt19937 random(seed);
+
+            values_.resize(size);
+            for (int i = 0; i < size; ++i)
+                values_[i] = random() & 0xFFFF;
+
+            buffer_.fill(0, size * 2);
+        }
+
+        virtual int bytes() const
+        {
+            return buffer_.size();
+        }
+
+        virtual quint32 run()
+        {
+            putRegistersIntoBuffer((quint8*)buffer_.data(), values_);
+
+            return quint8(buffer_.at(0));
+        }
+
+        virtual bool verify()
+        {
+            QByteArray expected(buffer_.size(), 0);
+            reference::packRegisters(values_.constData(), values_.size(), (quint8*)expected.data());
+
+            buffer_.fill(char(0xA5));
+            putRegistersIntoBuffer((quint8*)buffer_.data(), values_);
+
+            return buffer_ == expected;
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @en Builds Write Multiple Registers request, the largest request of library.
+ * @ru Формирует запрос Write Multiple Registers, самый длинный запрос библиотеки.
+ */
+class RtuPrepareAduKernel : public CodecKernel
+{
+    private:
+
+        RtuCodec codec_;
+
+        ProtocolDataUnit pdu_;
+
+        int pduSize_;
+
+    public:
+
+        RtuPrepareAduKernel()
+            : pduSize_(0)
+        {
+            codec_.setUnitID(17);
+        }
+
+        virtual QString name() const
+        {
+            return "RtuClient::prepareADU_";
+        }
+
+        virtual QString unit() const
+        {
+            return "registers";
+        }
+
+        virtual QList<int> sizes() const
+        {
+            return makeSizes(1, 16, MaxRegistersForWrite);
+        }
+
+        virtual void setUp(int size, quint32 seed)
+        {
+            std::mt19937 random(seed);
+
+            pdu_.functionCode = Functions::WriteMultipleRegisters;
+            pdu_.data[0] = random() & 0xFF;
+            pdu_.data[1] = random() & 0xFF;
+            pdu_.data[2] = hi(size);
+            pdu_.data[3] = lo(size);
+            pdu_.data[4] = size * 2;
+
+            for (int i = 0; i < size * 2; ++i)
+                pdu_.data[5 + i] = random() & 0xFF;
+
+            pduSize_ = 6 + size * 2;
+        }
+
+        virtual int bytes() const
+        {
+            return pduSize_ + 3;
+        }
+
+        virtual quint32 run()
+        {
+            return codec_.buildADU(pdu_, pduSize_).size();
+        }
+
+        virtual bool verify()
+        {
+            QByteArray expected = reference::rtuFrame(codec_.unitID(), (const quint8*)&pdu_, pduSize_);
+
+            return codec_.buildADU(pdu_, pduSize_) == expected;
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @en Parses Read Holding Registers response, the largest response of library.
+ * @ru Разбирает ответ Read Holding Registers, самый длинный ответ библиотеки.
+ */
+class RtuProcessAduKernel : public CodecKernel
+{
+    private:
+
+        RtuCodec codec_;
+
+        QByteArray pdu_;
+
+        QByteArray frame_;
+
+    public:
+
+        RtuProcessAduKernel()
+        {
+            codec_.setUnitID(17);
+        }
+
+        virtual QString name() const
+        {
+            return "RtuClient::processADU_";
+        }
+
+        virtual QString unit() const
+        {
+            return "registers";
+        }
+
+        virtual QList<int> sizes() const
+        {
+            return makeSizes(1, 16, MaxRegistersForRead);
+        }
+
+        virtual void setUp(int size, quint32 seed)
+        {
+            std::mt19937 random(seed);
+
+            pdu_.clear();
+            pdu_.append(char(Functions::ReadHoldingRegisters));
+            pdu_.append(char(size * 2));
+            pdu_.append(randomBytes(size * 2, random));
+
+            frame_ = reference::rtuFrame(codec_.unitID(), (const quint8*)pdu_.constData(), pdu_.size());
+        }
+
+        virtual int bytes() const
+        {
+            return frame_.size();
+        }
+
+        virtual quint32 run()
+        {
+            return codec_.parseADU(frame_).data[0];
+        }
+
+        virtual bool verify()
+        {
+            ProtocolDataUnit pdu = codec_.parseADU(frame_);
+
+            return (pdu.functionCode == quint8(pdu_.at(0)))
+                    && (memcmp(pdu.data, pdu_.constData() + 1, pdu_.size() - 1) == 0);
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+class DecodeFloat32Kernel : public CodecKernel
+{
+    private:
+
+        WordOrder order_;
+
+        QByteArray buffer_;
+
+        QVector<float> values_;
+
+    public:
+
+        DecodeFloat32Kernel(WordOrder order)
+            : order_(order)
+        {
+        }
+
+        virtual QString name() const
+        {
+            static const char* const names[] = {"ABCD", "CDAB", "BADC", "DCBA"};
+
+            return QString("decodeFloat32/%1").arg(names[order_]);
+        }
+
+        virtual QString unit() const
+        {
+            return "values";
+        }
+
+        virtual QList<int> sizes() const
+        {
+            return makeSizes(1, 8, MaxRegistersForRead / 2);
+        }
+
+        virtual void setUp(int size, quint32 seed)
+        {
+            std::mt19937 random(seed);
+            buffer_ = randomBytes(size * 4, random);
+            values_.resize(size);
+        }
+
+        virtual int bytes() const
+        {
+            return buffer_.size();
+        }
+
+        virtual quint32 run()
+        {
+            decodeFloat32((const quint8*)buffer_.constData(), values_.size(), order_, values_.data());
+
+            quint32 result;
+            memcpy(&result, values_.constData() + values_.size() - 1, sizeof(result));
+
+            return result;
+        }
+
+        virtual bool verify()
+        {
+            QVector<quint32> expected(values_.size());
+            reference::unpackWords32((const quint8*)buffer_.constData(), values_.size(),
+                                     order_ == CDAB || order_ == DCBA, order_ == BADC || order_ == DCBA, expected.data());
+
+            run();
+
+            // Random bytes may form NaN, so values are compared bitwise
+            return memcmp(values_.constData(), expected.constData(), expected.size() * sizeof(quint32)) == 0;
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+QList<CodecKernel*>
+createCodecKernels()
+{
+    QList<CodecKernel*> result;
+
+    result << new Crc16Kernel
+           << new GetCoilsKernel
+           << new PutCoilsKernel
+           << new GetRegistersKernel
+           << new PutRegistersKernel
+           << new DecodeFloat32Kernel(ABCD)
+           << new DecodeFloat32Kernel(CDAB)
+           << new DecodeFloat32Kernel(DCBA)
+           << new RtuPrepareAduKernel
+           << new RtuProcessAduKernel;
+
+    return result;
+}
+
+} // namespace bench
+
+} // namespace modbus4qt
@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_CODEC_KERNELS_H
+#define MODBUS4QT_CODEC_KERNELS_H
+
+#include <QList>
+#include <QString>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+/**
+ * @brief
+ * @en Codec kernel under measurement
+ * @ru Тестируемое ядро кодека
+ *
+ * @en Every kernel wraps one library function, prepares random input of given
+ * size and compares result of library function with reference implementation.
+ *
+ * @ru Каждое ядро соответствует одной функции библиотеки, готовит случайные
+ * входные данные заданного размера и сравнивает результат функции библиотеки
+ * с эталонной реализацией.
+ */
+class CodecKernel
+{
+    public:
+
+        virtual ~CodecKernel()
+        {
+        }
+
+        virtual QString name() const = 0;
+
+        //! @en Name of items counted by size @ru Название единиц, в которых задается размер
+        virtual QString unit() const = 0;
+
+        //! @en Realistic sizes, items per operation @ru Реалистичные размеры, единиц на операцию
+        virtual QList<int> sizes() const = 0;
+
+        //! @en Prepare random input @ru Готовит случайные входные данные
+        virtual void setUp(int size, quint32 seed) = 0;
+
+        //! @en Encoded bytes processed by one operation @ru Количество закодированных байт, обрабатываемых за одну операцию
+        virtual int bytes() const = 0;
+
+        //! @en Run operation once, result prevents optimizing call away @ru Выполняет операцию, результат не дает компилятору удалить вызов
+        virtual quint32 run() = 0;
+
+        //! @en Compare library result with reference for current input @ru Сравнивает результат библиотеки с эталоном для текущих данных
+        virtual bool verify() = 0;
+};
+
+/**
+ * @brief
+ * @en Create all known kernels. Caller owns returned objects.
+ * @ru Создает все известные ядра. Вызывающий владеет созданными объектами.
+ */
+QList<CodecKernel*> createCodecKernels();
+
+} // namespace bench
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_CODEC_KERNELS_H
@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+//
+// Micro-benchmarks for codec kernels: CRC, coil and register packing, typed
+// register decoding and RTU application data unit builders.
+//
+// Before measurement every kernel is checked against reference implementation
+// on random input. Program exits with code 2 if any kernel is not bit-exact,
+// so it can be used to validate optimizations.
+//
+// Example:
+//     codec-bench --min-time 500 --filter crc --output codec.json
+//
+
+#include "bench_utils.h"
+#include "codec_kernels.h"
+
+#include "global.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+
+using namespace modbus4qt;
+using namespace modbus4qt::bench;
+
+// Results of kernels are accumulated here so calls can not be optimized away
+volatile quint32 sink = 0;
+
+//-----------------------------------------------------------------------------
+
+static bool
+verifyKernel(CodecKernel* kernel, int size, int rounds)
+{
+    for (int seed = 1; seed <= rounds; ++seed)
+    {
+        kernel->setUp(size, seed);
+
+        if (!kernel->verify())
+            return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Double number of iterations until single batch takes at least minTimeNs,
+ * return time of last batch per operation.
+ */
+static double
+measureKernel(CodecKernel* kernel, qint64 minTimeNs, qint64& iterations)
+{
+    quint32 accumulator = 0;
+    qint64 elapsedNs = 0;
+
+    iterations = 1;
+
+    forever
+    {
+        QElapsedTimer clock;
+        clock.start();
+
+        for (qint64 i = 0; i < iterations; ++i)
+            accumulator += kernel->run();
+
+        elapsedNs = clock.nsecsElapsed();
+
+        if (elapsedNs >= minTimeNs)
+            break;
+
+        iterations *= 2;
+    }
+
+    sink = sink + accumulator;
+
+    return double(elapsedNs) / iterations;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("codec-bench");
+    QCoreApplication::setApplicationVersion(MODBUS4QT_VERSION_STR);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("modbus4qt codec micro-benchmarks");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption minTimeOption("min-time", "Minimum measurement time for every kernel and size, ms.", "ms", "200");
+    QCommandLineOption roundsOption("verify-rounds", "Random inputs checked against reference for every size.", "n", "100");
+    QCommandLineOption filterOption("filter", "Run only kernels which name contains text.", "text");
+    QCommandLineOption outputOption("output", "Write JSON report to file (\"-\" for standard output).", "file");
+
+    parser.addOption(minTimeOption);
+    parser.addOption(roundsOption);
+    parser.addOption(filterOption);
+    parser.addOption(outputOption);
+
+    parser.process(app);
+
+    int minTime = parser.value(minTimeOption).toInt();
+    int rounds = parser.value(roundsOption).toInt();
+    QString filter = parser.value(filterOption);
+
+    QTextStream out(parser.value(outputOption) == "-" ? stderr : stdout);
+
+    if (minTime <= 0 || rounds <= 0)
+    {
+        out << "Invalid arguments" << endl;
+        return 1;
+    }
+
+    // Codec functions of RtuClient print every frame
+    installQuietMessageHandler();
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7")
+           .arg("kernel", -26)
+           .arg("size", 6)
+           .arg("unit", -10)
+           .arg("bytes", 6)
+           .arg("ns/frame", 10)
+           .arg("ns/byte", 8)
+           .arg("exact", 6)
+        << endl;
+
+    QJsonArray results;
+    bool allExact = true;
+
+    QList<CodecKernel*> kernels = createCodecKernels();
+
+    foreach (CodecKernel* kernel, kernels)
+    {
+        if (!filter.isEmpty() && !kernel->name().contains(filter, Qt::CaseInsensitive))
+            continue;
+
+        foreach (int size, kernel->sizes())
+        {
+            bool exact = verifyKernel(kernel, size, rounds);
+            allExact = allExact && exact;
+
+            kernel->setUp(size, 0);
+
+            qint64 iterations;
+            double nsPerFrame = measureKernel(kernel, qint64(minTime) * 1000000, iterations);
+            double nsPerByte = nsPerFrame / kernel->bytes();
+
+            out << QString("%1 %2 %3 %4 %5 %6 %7")
+                   .arg(kernel->name(), -26)
+                   .arg(size, 6)
+                   .arg(kernel->unit(), -10)
+                   .arg(kernel->bytes(), 6)
+                   .arg(nsPerFrame, 10, 'f', 1)
+                   .arg(nsPerByte, 8, 'f', 2)
+                   .arg(exact ? "yes" : "NO", 6)
+                << endl;
+
+            QJsonObject result;
+            result["kernel"] = kernel->name();
+            result["size"] = size;
+            result["unit"] = kernel->unit();
+            result["bytes"] = kernel->bytes();
+            result["iterations"] = iterations;
+            result["nsPerFrame"] = nsPerFrame;
+            result["nsPerByte"] = nsPerByte;
+            result["exact"] = exact;
+
+            results.append(result);
+        }
+    }
+
+    qDeleteAll(kernels);
+
+    if (parser.isSet(outputOption))
+    {
+        QJsonObject parameters;
+        parameters["minTimeMs"] = minTime;
+        parameters["verifyRounds"] = rounds;
+
+        if (!writeJsonReport(parser.value(outputOption), "codec", parameters, results))
+            return 1;
+    }
+
+    if (!allExact)
+    {
+        out << "Some kernels differ from reference implementation!" << endl;
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "reference_codec.h"
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+namespace reference
+{
+
+quint16
+crc16(const quint8* data, int size)
+{
+    quint16 crc = 0xFFFF;
+
+    for (int i = 0; i < size; ++i)
+    {
+        crc ^= data[i];
+
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            if (crc & 0x0001)
+                crc = (crc >> 1) ^ 0xA001;
+            else
+                crc = crc >> 1;
+        }
+    }
+
+    return crc;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+packCoils(const bool* values, int count, quint8* buffer)
+{
+    for (int i = 0; i < (count + 7) / 8; ++i)
+        buffer[i] = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (values[i])
+            buffer[i / 8] |= (1 << (i % 8));
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+unpackCoils(const quint8* buffer, int count, bool* values)
+{
+    for (int i = 0; i < count; ++i)
+        values[i] = (buffer[i / 8] >> (i % 8)) & 1;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+packRegisters(const quint16* values, int count, quint8* buffer)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        buffer[i * 2] = values[i] >> 8;
+        buffer[i * 2 + 1] = values[i] & 0xFF;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+unpackRegisters(const quint8* buffer, int count, quint16* values)
+{
+    for (int i = 0; i < count; ++i)
+        values[i] = (buffer[i * 2] << 8) | buffer[i * 2 + 1];
+}
+
+//-----------------------------------------------------------------------------
+
+void
+unpackWords32(const quint8* buffer, int count, bool wordSwap, bool byteSwap, quint32* values)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        quint16 words[2];
+
+        for (int w = 0; w < 2; ++w)
+        {
+            const quint8* reg = buffer + i * 4 + w * 2;
+            words[w] = byteSwap ? quint16((reg[1] << 8) | reg[0]) : quint16((reg[0] << 8) | reg[1]);
+        }
+
+        if (wordSwap)
+            values[i] = (quint32(words[1]) << 16) | words[0];
+        else
+            values[i] = (quint32(words[0]) << 16) | words[1];
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray
+rtuFrame(quint8 unitId, const quint8* pdu, int pduSize)
+{
+    QByteArray frame;
+    frame.append(char(unitId));
+    frame.append((const char*)pdu, pduSize);
+
+    quint16 crc = crc16((const quint8*)frame.constData(), frame.size());
+    frame.append(char(crc & 0xFF));
+    frame.append(char(crc >> 8));
+
+    return frame;
+}
+
+} // namespace reference
+
+} // namespace bench
+
+} // namespace modbus4qt
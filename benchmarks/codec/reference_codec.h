@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_REFERENCE_CODEC_H
+#define MODBUS4QT_REFERENCE_CODEC_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+/**
+ * @en Straightforward implementations of codec kernels written directly from
+ * MODBUS specification. They are slow on purpose and are used only to prove
+ * that library kernels produce bit-exact results.
+ *
+ * @ru Простые реализации кодеков, написанные непосредственно по спецификации
+ * MODBUS. Они намеренно не оптимизированы и используются только для проверки
+ * побитового совпадения результатов функций библиотеки.
+ */
+namespace reference
+{
+
+/**
+ * @brief
+ * @en CRC-16/MODBUS calculated bit by bit (polynomial 0xA001, initial value 0xFFFF)
+ * @ru CRC-16/MODBUS, рассчитанная побитово (полином 0xA001, начальное значение 0xFFFF)
+ *
+ * @en Low byte of result is transmitted first.
+ * @ru Младший байт результата передается первым.
+ */
+quint16 crc16(const quint8* data, int size);
+
+//! @en Pack coils, first coil into LSB of first byte @ru Упаковывает флаги, первый флаг в младший бит первого байта
+void packCoils(const bool* values, int count, quint8* buffer);
+
+//! @en Unpack coils packed by packCoils() @ru Распаковывает флаги, упакованные packCoils()
+void unpackCoils(const quint8* buffer, int count, bool* values);
+
+//! @en Store registers in big-endian order @ru Записывает регистры в порядке big-endian
+void packRegisters(const quint16* values, int count, quint8* buffer);
+
+//! @en Load registers stored in big-endian order @ru Читает регистры, записанные в порядке big-endian
+void unpackRegisters(const quint8* buffer, int count, quint16* values);
+
+/**
+ * @brief
+ * @en Load 32-bit words from registers, wordSwap - low register first, byteSwap - low byte of register first
+ * @ru Читает 32-битные слова из регистров, wordSwap - младший регистр первым, byteSwap - младший байт регистра первым
+ */
+void unpackWords32(const quint8* buffer, int count, bool wordSwap, bool byteSwap, quint32* values);
+
+//! @en Build RTU frame: unit ID, PDU and CRC @ru Формирует кадр RTU: адрес устройства, PDU и CRC
+QByteArray rtuFrame(quint8 unitId, const quint8* pdu, int pduSize);
+
+} // namespace reference
+
+} // namespace bench
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_REFERENCE_CODEC_H
@@ -0,0 +1,213 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "bench_requests.h"
+
+#include "client.h"
+#include "utils.h"
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+int
+maxBlockSize(quint8 function)
+{
+    switch (function)
+    {
+        case Functions::ReadCoils :
+        case Functions::ReadDescereteInputs :
+            return MaxCoilsForRead;
+
+        case Functions::ReadHoldingRegisters :
+        case Functions::ReadInputRegisters :
+            return MaxRegistersForRead;
+
+        case Functions::WriteMultipleCoils :
+            return MaxCoilsForWrite;
+
+        case Functions::WriteMultipleRegisters :
+            return MaxRegistersForWrite;
+
+        default :
+            return 1;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int
+buildRequest(quint8 function, quint16 regStart, int blockSize, quint16 seed, ProtocolDataUnit& pdu)
+{
+    pdu.functionCode = function;
+
+    pdu.data[0] = hi(regStart);
+    pdu.data[1] = lo(regStart);
+
+    switch (function)
+    {
+        case Functions::ReadCoils :
+        case Functions::ReadDescereteInputs :
+        case Functions::ReadHoldingRegisters :
+        case Functions::ReadInputRegisters :
+            pdu.data[2] = hi(blockSize);
+            pdu.data[3] = lo(blockSize);
+            return 5;
+
+        case Functions::WriteSingleCoil :
+            pdu.data[2] = (seed & 1) ? 0xFF : 0x00;
+            pdu.data[3] = 0x00;
+            return 5;
+
+        case Functions::WriteSingleRegister :
+            pdu.data[2] = hi(seed);
+            pdu.data[3] = lo(seed);
+            return 5;
+
+        case Functions::WriteMultipleCoils :
+        {
+            int byteCount = (blockSize + 7) / 8;
+
+            pdu.data[2] = hi(blockSize);
+            pdu.data[3] = lo(blockSize);
+            pdu.data[4] = byteCount;
+
+            for (int i = 0; i < byteCount; ++i)
+                pdu.data[5 + i] = lo(seed + i);
+
+            // Unused bits of last byte should be zero
+            if (blockSize % 8)
+                pdu.data[4 + byteCount] &= (1 << (blockSize % 8)) - 1;
+
+            return 6 + byteCount;
+        }
+
+        case Functions::WriteMultipleRegisters :
+        {
+            pdu.data[2] = hi(blockSize);
+            pdu.data[3] = lo(blockSize);
+            pdu.data[4] = blockSize * 2;
+
+            for (int i = 0; i < blockSize; ++i)
+            {
+                pdu.data[5 + i * 2] = hi(seed + i);
+                pdu.data[6 + i * 2] = lo(seed + i);
+            }
+
+            return 6 + blockSize * 2;
+        }
+
+        default :
+            return 0;
+    }
+}
+
+int
+responseSize(quint8 function, int blockSize)
+{
+    switch (function)
+    {
+        case Functions::ReadCoils :
+        case Functions::ReadDescereteInputs :
+            return 2 + (blockSize + 7) / 8;
+
+        case Functions::ReadHoldingRegisters :
+        case Functions::ReadInputRegisters :
+            return 2 + blockSize * 2;
+
+        default :
+            return 5;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+blockingRequest(Client& client, quint8 function, quint16 regStart, int blockSize, quint16 seed)
+{
+    switch (function)
+    {
+        case Functions::ReadCoils :
+        {
+            QVector<bool> values;
+            return client.readCoils(regStart, blockSize, values);
+        }
+
+        case Functions::ReadDescereteInputs :
+        {
+            QVector<bool> values;
+            return client.readDescreteInputs(regStart, blockSize, values);
+        }
+
+        case Functions::ReadHoldingRegisters :
+        {
+            QVector<quint16> values;
+            return client.readHoldingRegisters(regStart, blockSize, values);
+        }
+
+        case Functions::ReadInputRegisters :
+        {
+            QVector<quint16> values;
+            return client.readInputRegisters(regStart, blockSize, values);
+        }
+
+        case Functions::WriteSingleCoil :
+            return client.writeSingleCoil(regStart, seed & 1);
+
+        case Functions::WriteSingleRegister :
+            return client.writeSingleRegister(regStart, seed);
+
+        case Functions::WriteMultipleCoils :
+        {
+            QVector<bool> values(blockSize);
+            for (int i = 0; i < values.size(); ++i)
+                values[i] = ((seed + i) & 1);
+
+            return client.writeMultipleCoils(regStart, values);
+        }
+
+        case Functions::WriteMultipleRegisters :
+        {
+            QVector<quint16> values(blockSize);
+            for (int i = 0; i < values.size(); ++i)
+                values[i] = seed + i;
+
+            return client.writeMultipleRegisters(regStart, values);
+        }
+
+        default :
+            return false;
+    }
+}
+
+} // namespace bench
+
+} // namespace modbus4qt
@@ -0,0 +1,83 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_BENCH_REQUESTS_H
+#define MODBUS4QT_BENCH_REQUESTS_H
+
+#include "types.h"
+
+namespace modbus4qt
+{
+
+class Client;
+
+namespace bench
+{
+
+/**
+ * @brief
+ * @en Maximum block size allowed by specification for function
+ * @ru Максимальный размер блока, допустимый спецификацией для функции
+ */
+int maxBlockSize(quint8 function);
+
+/**
+ * @brief
+ * @en Build request PDU for function under test
+ * @ru Формирует PDU запроса для тестируемой функции
+ *
+ * @return
+ * @en PDU size in bytes or 0 if function is not supported by benchmarks
+ * @ru Размер PDU в байтах или 0, если функция не поддерживается тестами
+ */
+int buildRequest(quint8 function, quint16 regStart, int blockSize, quint16 seed, ProtocolDataUnit& pdu);
+
+/**
+ * @brief
+ * @en Size of normal (not exception) response PDU, bytes
+ * @ru Размер PDU нормального (не исключения) ответа, в байтах
+ */
+int responseSize(quint8 function, int blockSize);
+
+/**
+ * @brief
+ * @en Execute request by blocking API of client
+ * @ru Выполняет запрос через блокирующий API клиента
+ *
+ * @return
+ * @en Result of client method call
+ * @ru Результат вызова метода клиента
+ */
+bool blockingRequest(Client& client, quint8 function, quint16 regStart, int blockSize, quint16 seed);
+
+} // namespace bench
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_BENCH_REQUESTS_H
@@ -0,0 +1,240 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "bench_utils.h"
+
+#include "global.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QStringList>
+#include <QSysInfo>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+LatencyStats::LatencyStats()
+    : sorted_(true)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void
+LatencyStats::merge(const LatencyStats& other)
+{
+    samples_ += other.samples_;
+    sorted_ = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+LatencyStats::clear()
+{
+    samples_.clear();
+    sorted_ = true;
+}
+
+//-----------------------------------------------------------------------------
+
+qint64
+LatencyStats::percentile(double p) const
+{
+    if (samples_.isEmpty())
+        return 0;
+
+    sort_();
+
+    int rank = static_cast<int>(std::ceil(p / 100.0 * samples_.size()));
+    rank = qBound(1, rank, samples_.size());
+
+    return samples_.at(rank - 1);
+}
+
+//-----------------------------------------------------------------------------
+
+qint64
+LatencyStats::max() const
+{
+    if (samples_.isEmpty())
+        return 0;
+
+    sort_();
+
+    return samples_.last();
+}
+
+//-----------------------------------------------------------------------------
+
+double
+LatencyStats::mean() const
+{
+    if (samples_.isEmpty())
+        return 0;
+
+    double sum = 0;
+    foreach (qint64 sample, samples_)
+        sum += sample;
+
+    return sum / samples_.size();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+LatencyStats::sort_() const
+{
+    if (sorted_)
+        return;
+
+    // samples_ is logically unchanged by sorting
+    QVector<qint64>& samples = const_cast<QVector<qint64>&>(samples_);
+    std::sort(samples.begin(), samples.end());
+
+    sorted_ = true;
+}
+
+//-----------------------------------------------------------------------------
+
+static void
+quietMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg)
+{
+    Q_UNUSED(context)
+
+    if (type == QtDebugMsg)
+        return;
+
+    fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+
+    if (type == QtFatalMsg)
+        abort();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+installQuietMessageHandler()
+{
+    qInstallMessageHandler(quietMessageHandler);
+}
+
+//-----------------------------------------------------------------------------
+
+QList<int>
+parseIntList(const QString& text)
+{
+    QList<int> result;
+
+    foreach (const QString& item, splitNonEmpty(text, ','))
+    {
+        bool ok;
+        int value = item.toInt(&ok, 0);
+
+        if (!ok)
+            return QList<int>();
+
+        result.append(value);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList
+splitNonEmpty(const QString& text, QChar separator)
+{
+    QStringList result;
+
+    foreach (const QString& item, text.split(separator))
+    {
+        QString trimmed = item.trimmed();
+
+        if (!trimmed.isEmpty())
+            result.append(trimmed);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+writeJsonReport(const QString& fileName, const QString& benchmark, const QJsonObject& parameters, const QJsonArray& results,
+                const QJsonObject& summary)
+{
+    QJsonObject environment;
+    environment["library"] = QString(MODBUS4QT_VERSION_STR);
+    environment["qt"] = QString(qVersion());
+    environment["os"] = QSysInfo::prettyProductName();
+    environment["cpu"] = QSysInfo::currentCpuArchitecture();
+
+    QJsonObject report;
+    report["benchmark"] = benchmark;
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["environment"] = environment;
+    report["parameters"] = parameters;
+    report["results"] = results;
+
+    if (!summary.isEmpty())
+        report["summary"] = summary;
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if (fileName == "-")
+    {
+        QTextStream out(stdout);
+        out << json;
+        return true;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Can not write report to" << fileName << ":" << file.errorString();
+        return false;
+    }
+
+    return file.write(json) == json.size();
+}
+
+} // namespace bench
+
+} // namespace modbus4qt
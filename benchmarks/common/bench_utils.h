@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_BENCH_UTILS_H
+#define MODBUS4QT_BENCH_UTILS_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+/**
+ * @brief
+ * @en Collection of latency samples with percentile calculation
+ * @ru Набор замеров задержки с вычислением процентилей
+ *
+ * @en Samples are stored in nanoseconds. Percentiles are calculated by
+ * nearest-rank method on sorted copy of samples.
+ *
+ * @ru Замеры хранятся в наносекундах. Процентили вычисляются методом
+ * ближайшего ранга по отсортированной копии замеров.
+ */
+class LatencyStats
+{
+    private:
+
+        QVector<qint64> samples_;
+
+        mutable bool sorted_;
+
+    public:
+
+        LatencyStats();
+
+        //! @en Add one sample, ns @ru Добавляет замер, нс
+        void add(qint64 ns)
+        {
+            samples_.append(ns);
+            sorted_ = false;
+        }
+
+        //! @en Append all samples from other @ru Добавляет все замеры из other
+        void merge(const LatencyStats& other);
+
+        void clear();
+
+        int count() const
+        {
+            return samples_.size();
+        }
+
+        void reserve(int size)
+        {
+            samples_.reserve(size);
+        }
+
+        /**
+         * @brief
+         * @en Return percentile value, ns
+         * @ru Возвращает значение процентиля, нс
+         *
+         * @param
+         * @en p - percentile in range 0..100
+         * @ru p - процентиль в диапазоне 0..100
+         */
+        qint64 percentile(double p) const;
+
+        qint64 max() const;
+
+        double mean() const;
+
+    private:
+
+        void sort_() const;
+};
+
+/**
+ * @brief
+ * @en Install message handler which drops debug messages
+ * @ru Устанавливает обработчик сообщений, отбрасывающий отладочные сообщения
+ *
+ * @en Library prints every frame by qDebug(), which would dominate measurements.
+ * @ru Библиотека выводит каждый пакет через qDebug(), что исказило бы замеры.
+ */
+void installQuietMessageHandler();
+
+/**
+ * @brief
+ * @en Split text by separator, items are trimmed and empty ones are skipped
+ * @ru Разделяет текст по разделителю, элементы очищаются от пробелов, пустые пропускаются
+ *
+ * @en Used by parsers of command line lists instead of split flags: there is
+ * no Qt::SkipEmptyParts before Qt 5.14 and no QString::SkipEmptyParts in Qt 6.
+ *
+ * @ru Используется разборщиками списков командной строки вместо флагов split:
+ * Qt::SkipEmptyParts нет до Qt 5.14, а QString::SkipEmptyParts нет в Qt 6.
+ */
+QStringList splitNonEmpty(const QString& text, QChar separator);
+
+/**
+ * @brief
+ * @en Parse comma separated list of integers, e.g. "1,4,16"
+ * @ru Разбирает список целых чисел, разделенных запятыми, например "1,4,16"
+ *
+ * @return
+ * @en Empty list if any item is not a number
+ * @ru Пустой список, если какой-либо элемент не является числом
+ */
+QList<int> parseIntList(const QString& text);
+
+/**
+ * @brief
+ * @en Write JSON report with benchmark name, environment and results
+ * @ru Записывает отчет в формате JSON с именем теста, окружением и результатами
+ *
+ * @en Summary is written only if not empty.
+ * @ru Итоговые значения записываются, только если они заданы.
+ *
+ * @param
+ * @en fileName - file to write; "-" means standard output
+ * @ru fileName - имя файла; "-" означает стандартный вывод
+ */
+bool writeJsonReport(const QString& fileName, const QString& benchmark, const QJsonObject& parameters, const QJsonArray& results,
+                     const QJsonObject& summary = QJsonObject());
+
+//! @en Convert nanoseconds into microseconds @ru Переводит наносекунды в микросекунды
+inline double toUs(qint64 ns)
+{
+    return ns / 1000.0;
+}
+
+} // namespace bench
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_BENCH_UTILS_H
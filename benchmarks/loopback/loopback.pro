@@ -0,0 +1,13 @@
+include( $${PWD}/../benchmarks.pri )
+
+TARGET = loopback-bench
+
+MOC_DIR = $${MOC_DIR}/benchmarks/loopback
+OBJECTS_DIR = $${OBJECTS_DIR}/benchmarks/loopback
+
+SOURCES += \
+    main.cpp \
+    loopback_bench.cpp
+
+HEADERS += \
+    loopback_bench.h
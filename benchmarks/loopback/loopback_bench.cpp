@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "loopback_bench.h"
+#include "bench_requests.h"
+
+#include "dummy_device.h"
+#include "epoll_tcp_server.h"
+#include "tcp_client.h"
+#include "tcp_server.h"
+#include "uring_tcp_server.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+ServerThread::ServerThread(const QString& backend)
+    : QThread(),
+      port_(0),
+      backend_(backend)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+ServerThread::startServer()
+{
+    start();
+    started_.acquire();
+
+    return port_ != 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ServerThread::stopServer()
+{
+    quit();
+    wait();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ServerThread::run()
+{
+    DummyDevice device;
+
+    TcpServer tcpServer;
+    EpollTcpServer epollServer;
+    UringTcpServer uringServer;
+
+    tcpServer.setDevice(&device);
+    epollServer.setDevice(&device);
+    uringServer.setDevice(&device);
+
+    if (backend_ == "epoll")
+    {
+        if (epollServer.listen(QHostAddress::LocalHost, 0))
+            port_ = epollServer.serverPort();
+    }
+    else if (backend_ == "uring")
+    {
+        if (uringServer.listen(QHostAddress::LocalHost, 0))
+            port_ = uringServer.serverPort();
+    }
+    else if (tcpServer.listen(QHostAddress::LocalHost, 0))
+    {
+        port_ = tcpServer.serverPort();
+    }
+
+    started_.release();
+
+    if (port_)
+        exec();
+
+    tcpServer.close();
+    epollServer.close();
+    uringServer.close();
+}
+
+//-----------------------------------------------------------------------------
+
+ClientWorker::ClientWorker(const RunConfig& config, int index, QSemaphore* ready, QSemaphore* go)
+    : QThread(),
+      config_(config),
+      index_(index),
+      ready_(ready),
+      go_(go),
+      errors_(0),
+      elapsedNs_(0),
+      connected_(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ClientWorker::run()
+{
+    TcpClient client;
+    client.setServerAddress(QHostAddress(QHostAddress::LocalHost));
+    client.setPort(config_.port);
+    client.setReadTimeOut(config_.timeoutMs);
+    client.setWriteTimeOut(config_.timeoutMs);
+
+    client.connectToServer(config_.timeoutMs);
+    connected_ = client.isConnected();
+
+    ready_->release();
+    go_->acquire();
+
+    if (!connected_)
+        return;
+
+    // Every connection works with its own part of address space
+    quint16 regStart = (index_ * config_.blockSize) % (0x10000 - config_.blockSize);
+    quint16 seed = 0;
+
+    const qint64 durationNs = qint64(config_.durationMs) * 1000000;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    if (config_.depth <= 1)
+    {
+        while (clock.nsecsElapsed() < durationNs)
+        {
+            qint64 start = clock.nsecsElapsed();
+            bool ok = blockingRequest(client, config_.function, regStart, config_.blockSize, ++seed);
+            stats_.add(clock.nsecsElapsed() - start);
+
+            if (!ok)
+                ++errors_;
+        }
+
+        elapsedNs_ = clock.nsecsElapsed();
+        client.disconnectFromServer();
+
+        return;
+    }
+
+    QHash<quint16, qint64> inFlight;
+    inFlight.reserve(config_.depth * 2);
+
+    ProtocolDataUnit request;
+    ProtocolDataUnit response;
+
+    forever
+    {
+        bool stopping = clock.nsecsElapsed() >= durationNs;
+
+        while (!stopping && inFlight.size() < config_.depth)
+        {
+            int pduSize = buildRequest(config_.function, regStart, config_.blockSize, ++seed, request);
+            int transactionId = client.postRequest(request, pduSize);
+
+            if (transactionId < 0)
+            {
+                ++errors_;
+                stopping = true;
+                break;
+            }
+
+            inFlight.insert(transactionId, clock.nsecsElapsed());
+        }
+
+        if (inFlight.isEmpty())
+            break;
+
+        quint16 transactionId;
+        if (!client.waitForResponse(transactionId, response, config_.timeoutMs))
+        {
+            // All outstanding requests are lost
+            errors_ += inFlight.size();
+            break;
+        }
+
+        qint64 sent = inFlight.take(transactionId);
+        stats_.add(clock.nsecsElapsed() - sent);
+
+        if (response.functionCode & 0x80)
+            ++errors_;
+    }
+
+    elapsedNs_ = clock.nsecsElapsed();
+    client.disconnectFromServer();
+}
+
+} // namespace bench
+
+} // namespace modbus4qt
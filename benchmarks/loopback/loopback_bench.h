@@ -0,0 +1,169 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_LOOPBACK_BENCH_H
+#define MODBUS4QT_LOOPBACK_BENCH_H
+
+#include "bench_utils.h"
+
+#include "types.h"
+
+#include <QSemaphore>
+#include <QThread>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+/**
+ * @brief
+ * @en Parameters of one benchmark run
+ * @ru Параметры одного прогона теста
+ */
+struct RunConfig
+{
+    quint8 function;
+
+    //! @en Registers or coils per request @ru Регистров или флагов в запросе
+    int blockSize;
+
+    int connections;
+
+    //! @en Requests in flight per connection @ru Запросов в обработке на одно соединение
+    int depth;
+
+    int durationMs;
+
+    int timeoutMs;
+
+    quint16 port;
+};
+
+/**
+ * @brief
+ * @en Thread running MODBUS/TCP server with DummyDevice on loopback interface
+ * @ru Поток, в котором работает сервер MODBUS/TCP с DummyDevice на петлевом интерфейсе
+ */
+class ServerThread : public QThread
+{
+    private:
+
+        QSemaphore started_;
+
+        quint16 port_;
+
+        //! @en Server implementation: "qt", "epoll" or "uring" @ru Реализация сервера: "qt", "epoll" или "uring"
+        QString backend_;
+
+    public:
+
+        explicit ServerThread(const QString& backend = "qt");
+
+        //! @en Start thread and wait until server is listening @ru Запускает поток и ожидает начала работы сервера
+        bool startServer();
+
+        void stopServer();
+
+        quint16 port() const
+        {
+            return port_;
+        }
+
+    protected:
+
+        virtual void run();
+};
+
+/**
+ * @brief
+ * @en Thread with single TcpClient generating requests
+ * @ru Поток с одним TcpClient, генерирующим запросы
+ *
+ * @en Depth 1 uses blocking client API, deeper pipelines use
+ * TcpClient::postRequest() and TcpClient::waitForResponse().
+ *
+ * @ru При глубине 1 используется блокирующий API клиента, при большей
+ * глубине конвейера - TcpClient::postRequest() и TcpClient::waitForResponse().
+ */
+class ClientWorker : public QThread
+{
+    private:
+
+        RunConfig config_;
+
+        int index_;
+
+        QSemaphore* ready_;
+
+        QSemaphore* go_;
+
+        LatencyStats stats_;
+
+        int errors_;
+
+        qint64 elapsedNs_;
+
+        bool connected_;
+
+    public:
+
+        ClientWorker(const RunConfig& config, int index, QSemaphore* ready, QSemaphore* go);
+
+        const LatencyStats& stats() const
+        {
+            return stats_;
+        }
+
+        int errors() const
+        {
+            return errors_;
+        }
+
+        qint64 elapsedNs() const
+        {
+            return elapsedNs_;
+        }
+
+        bool isConnected() const
+        {
+            return connected_;
+        }
+
+    protected:
+
+        virtual void run();
+};
+
+} // namespace bench
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_LOOPBACK_BENCH_H
@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+//
+// End-to-end MODBUS/TCP benchmark over loopback interface.
+//
+// Server with DummyDevice runs in its own thread, every connection is
+// served by TcpClient in separate thread. For each combination of function
+// code, block size, number of connections and pipeline depth the benchmark
+// reports throughput (transactions per second) and latency percentiles.
+//
+// Example:
+//     loopback-bench --functions 3,16 --sizes 1,125 --connections 1,8 --depths 1,16 --output result.json
+//     loopback-bench --server uring --connections 64 --depths 16
+//
+
+#include "bench_requests.h"
+#include "bench_utils.h"
+#include "loopback_bench.h"
+
+#include "global.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+
+using namespace modbus4qt;
+using namespace modbus4qt::bench;
+
+//-----------------------------------------------------------------------------
+
+static QJsonObject
+runBenchmark(const RunConfig& config, QTextStream& out)
+{
+    QSemaphore ready;
+    QSemaphore go;
+
+    QList<ClientWorker*> workers;
+    for (int i = 0; i < config.connections; ++i)
+    {
+        ClientWorker* worker = new ClientWorker(config, i, &ready, &go);
+        workers.append(worker);
+        worker->start();
+    }
+
+    // Start all connections at the same moment
+    ready.acquire(config.connections);
+    go.release(config.connections);
+
+    LatencyStats stats;
+    int errors = 0;
+    int connected = 0;
+    qint64 elapsedNs = 0;
+
+    foreach (ClientWorker* worker, workers)
+    {
+        worker->wait();
+
+        stats.merge(worker->stats());
+        errors += worker->errors();
+        elapsedNs = qMax(elapsedNs, worker->elapsedNs());
+
+        if (worker->isConnected())
+            ++connected;
+
+        delete worker;
+    }
+
+    double tps = elapsedNs ? stats.count() * 1e9 / elapsedNs : 0;
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+           .arg(config.function, 4)
+           .arg(config.blockSize, 6)
+           .arg(config.connections, 6)
+           .arg(config.depth, 6)
+           .arg(tps, 12, 'f', 0)
+           .arg(toUs(stats.percentile(50)), 10, 'f', 1)
+           .arg(toUs(stats.percentile(99)), 10, 'f', 1)
+           .arg(toUs(stats.percentile(99.9)), 10, 'f', 1)
+           .arg(toUs(stats.max()), 10, 'f', 1)
+           .arg(errors, 8)
+        << endl;
+
+    if (connected != config.connections)
+        out << QString("  only %1 of %2 connections established").arg(connected).arg(config.connections) << endl;
+
+    QJsonObject result;
+    result["function"] = config.function;
+    result["blockSize"] = config.blockSize;
+    result["connections"] = config.connections;
+    result["depth"] = config.depth;
+    result["transactions"] = stats.count();
+    result["errors"] = errors;
+    result["durationMs"] = elapsedNs / 1000000.0;
+    result["tps"] = tps;
+    result["meanUs"] = toUs(stats.mean());
+    result["p50Us"] = toUs(stats.percentile(50));
+    result["p99Us"] = toUs(stats.percentile(99));
+    result["p999Us"] = toUs(stats.percentile(99.9));
+    result["maxUs"] = toUs(stats.max());
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("loopback-bench");
+    QCoreApplication::setApplicationVersion(MODBUS4QT_VERSION_STR);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("modbus4qt end-to-end MODBUS/TCP loopback benchmark");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption functionsOption("functions", "Comma separated function codes (1-6, 15, 16).", "list", "3,16");
+    QCommandLineOption sizesOption("sizes", "Comma separated block sizes in registers or coils.", "list", "1,16,125");
+    QCommandLineOption connectionsOption("connections", "Comma separated numbers of concurrent connections.", "list", "1,4");
+    QCommandLineOption depthsOption("depths", "Comma separated pipeline depths per connection.", "list", "1,8");
+    QCommandLineOption durationOption("duration", "Duration of every run, ms.", "ms", "2000");
+    QCommandLineOption timeoutOption("timeout", "Response timeout, ms.", "ms", "5000");
+    QCommandLineOption outputOption("output", "Write JSON report to file (\"-\" for standard output).", "file");
+    QCommandLineOption serverOption("server", "Server implementation: qt, epoll or uring.", "name", "qt");
+    QCommandLineOption verboseOption("verbose", "Do not suppress library debug output.");
+
+    parser.addOption(functionsOption);
+    parser.addOption(sizesOption);
+    parser.addOption(connectionsOption);
+    parser.addOption(depthsOption);
+    parser.addOption(durationOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(outputOption);
+    parser.addOption(serverOption);
+    parser.addOption(verboseOption);
+
+    parser.process(app);
+
+    QList<int> functions = parseIntList(parser.value(functionsOption));
+    QList<int> sizes = parseIntList(parser.value(sizesOption));
+    QList<int> connections = parseIntList(parser.value(connectionsOption));
+    QList<int> depths = parseIntList(parser.value(depthsOption));
+    int duration = parser.value(durationOption).toInt();
+    int timeout = parser.value(timeoutOption).toInt();
+
+    QTextStream out(parser.value(outputOption) == "-" ? stderr : stdout);
+
+    if (functions.isEmpty() || sizes.isEmpty() || connections.isEmpty() || depths.isEmpty() || duration <= 0 || timeout <= 0)
+    {
+        out << "Invalid arguments" << endl;
+        return 1;
+    }
+
+    if (!parser.isSet(verboseOption))
+        installQuietMessageHandler();
+
+    ServerThread server(parser.value(serverOption));
+    if (!server.startServer())
+    {
+        out << "Can not start server on loopback interface" << endl;
+        return 1;
+    }
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+           .arg("fc", 4)
+           .arg("size", 6)
+           .arg("conn", 6)
+           .arg("depth", 6)
+           .arg("tps", 12)
+           .arg("p50,us", 10)
+           .arg("p99,us", 10)
+           .arg("p99.9,us", 10)
+           .arg("max,us", 10)
+           .arg("errors", 8)
+        << endl;
+
+    QJsonArray results;
+
+    foreach (int function, functions)
+    {
+        ProtocolDataUnit probe;
+        if (!buildRequest(function, 0, 1, 0, probe))
+        {
+            out << QString("Function %1 is not supported by benchmark").arg(function) << endl;
+            continue;
+        }
+
+        QList<int> blockSizes;
+        foreach (int size, sizes)
+        {
+            int blockSize = qBound(1, size, maxBlockSize(function));
+            if (!blockSizes.contains(blockSize))
+                blockSizes.append(blockSize);
+        }
+
+        foreach (int blockSize, blockSizes)
+        {
+            foreach (int connectionCount, connections)
+            {
+                foreach (int depth, depths)
+                {
+                    RunConfig config;
+                    config.function = function;
+                    config.blockSize = blockSize;
+                    config.connections = qMax(1, connectionCount);
+                    config.depth = qMax(1, depth);
+                    config.durationMs = duration;
+                    config.timeoutMs = timeout;
+                    config.port = server.port();
+
+                    results.append(runBenchmark(config, out));
+                }
+            }
+        }
+    }
+
+    server.stopServer();
+
+    if (parser.isSet(outputOption))
+    {
+        QJsonObject parameters;
+        parameters["durationMs"] = duration;
+        parameters["timeoutMs"] = timeout;
+        parameters["server"] = parser.value(serverOption);
+
+        if (!writeJsonReport(parser.value(outputOption), "loopback", parameters, results))
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,274 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+//
+// Check and benchmark of RequestQueue scheduling.
+//
+// Large backlog of normal and background reads is queued and left to age far
+// beyond all aging intervals. Then urgent writes are added one by one while
+// backlog is executed, and for every write the number of other transactions
+// finished between its enqueue and its own completion is counted. Queue
+// promises that urgent write waits at most one transaction, so program exits
+// with code 2 if any write waited longer.
+//
+// Client is not connected, so transactions fail at once and measured rate is
+// the cost of queue itself.
+//
+// Example:
+//     queue-bench --backlog 5000 --aging 1 --rounds 200
+//
+
+#include "bench_requests.h"
+#include "bench_utils.h"
+
+#include "global.h"
+#include "request_queue.h"
+#include "tcp_client.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+
+using namespace modbus4qt;
+using namespace modbus4qt::bench;
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief
+ * @en Adds urgent writes to running queue and counts how long they wait
+ * @ru Добавляет срочные записи в работающую очередь и подсчитывает их ожидание
+ */
+class UrgentProbe : public QObject
+{
+    Q_OBJECT
+
+    private:
+
+        RequestQueue* queue_;
+
+        ProtocolDataUnit pdu_;
+
+        int pduSize_;
+
+        int rounds_;
+
+        //! @en Backlog transactions between urgent writes @ru Транзакций очереди между срочными записями
+        int spacing_;
+
+        quint64 urgentId_;
+
+        //! @en Other transactions finished while urgent write waited @ru Других транзакций, завершенных за время ожидания срочной записи
+        int waited_;
+
+        int sinceUrgent_;
+
+    public:
+
+        int done;
+
+        int maxWaited;
+
+        LatencyStats queueTime;
+
+        UrgentProbe(RequestQueue* queue, int rounds, int spacing)
+            : queue_(queue),
+              pduSize_(0),
+              rounds_(rounds),
+              spacing_(spacing),
+              urgentId_(0),
+              waited_(0),
+              sinceUrgent_(0),
+              done(0),
+              maxWaited(0)
+        {
+            pduSize_ = buildRequest(Functions::WriteSingleRegister, 0, 1, 0, pdu_);
+        }
+
+        void addUrgent()
+        {
+            waited_ = 0;
+            urgentId_ = queue_->enqueue(1, pdu_, pduSize_, RequestQueue::UrgentPriority);
+        }
+
+    public slots:
+
+        void requestFinished(const modbus4qt::RequestResult& result)
+        {
+            if (result.id == urgentId_)
+            {
+                urgentId_ = 0;
+                sinceUrgent_ = 0;
+
+                maxWaited = qMax(maxWaited, waited_);
+                queueTime.add(result.queueTime);
+                ++done;
+            }
+            else if (urgentId_)
+            {
+                ++waited_;
+            }
+            else if ((++sinceUrgent_ >= spacing_) && (done < rounds_))
+            {
+                addUrgent();
+            }
+
+            if (!queue_->pendingCount())
+                QCoreApplication::quit();
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("queue-bench");
+    QCoreApplication::setApplicationVersion(MODBUS4QT_VERSION_STR);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("modbus4qt request queue check and benchmark");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption backlogOption("backlog", "Normal and background reads queued before urgent writes.", "n", "2000");
+    QCommandLineOption agingOption("aging", "Aging interval of queue, ms.", "ms", "1");
+    QCommandLineOption roundsOption("rounds", "Urgent writes added while backlog is executed.", "n", "100");
+    QCommandLineOption spacingOption("spacing", "Backlog transactions between urgent writes.", "n", "10");
+    QCommandLineOption outputOption("output", "Write JSON report to file (\"-\" for standard output).", "file");
+
+    parser.addOption(backlogOption);
+    parser.addOption(agingOption);
+    parser.addOption(roundsOption);
+    parser.addOption(spacingOption);
+    parser.addOption(outputOption);
+
+    parser.process(app);
+
+    int backlog = parser.value(backlogOption).toInt();
+    int aging = parser.value(agingOption).toInt();
+    int rounds = parser.value(roundsOption).toInt();
+    int spacing = parser.value(spacingOption).toInt();
+
+    QTextStream out(parser.value(outputOption) == "-" ? stderr : stdout);
+
+    if (backlog <= 0 || aging <= 0 || rounds <= 0 || spacing <= 0 || rounds * spacing >= backlog)
+    {
+        out << "Invalid arguments" << endl;
+        return 1;
+    }
+
+    // Every failed transaction is reported by client
+    installQuietMessageHandler();
+
+    TcpClient client;
+    client.setAutoConnect(false);
+
+    RequestQueue queue(&client);
+    queue.setAgingInterval(aging);
+
+    UrgentProbe probe(&queue, rounds, spacing);
+    QObject::connect(&queue, SIGNAL(finished(modbus4qt::RequestResult)), &probe, SLOT(requestFinished(modbus4qt::RequestResult)));
+
+    ProtocolDataUnit read;
+    int readSize = buildRequest(Functions::ReadHoldingRegisters, 0, 16, 0, read);
+
+    for (int i = 0; i < backlog; ++i)
+        queue.enqueue(1, read, readSize, (i % 2) ? RequestQueue::NormalPriority : RequestQueue::BackgroundPriority);
+
+    // Whole backlog is aged as far as it can be
+    QThread::msleep(aging * RequestQueue::PriorityCount * 2);
+
+    probe.addUrgent();
+
+    QElapsedTimer clock;
+    clock.start();
+
+    app.exec();
+
+    qint64 elapsedNs = clock.nsecsElapsed();
+    int transactions = backlog + probe.done;
+    double tps = elapsedNs ? transactions * 1e9 / elapsedNs : 0;
+
+    out << QString("%1 %2 %3 %4 %5 %6")
+           .arg("requests", 8)
+           .arg("urgent", 7)
+           .arg("tps", 10)
+           .arg("max wait", 9)
+           .arg("p50,us", 9)
+           .arg("p99,us", 9)
+        << endl;
+
+    out << QString("%1 %2 %3 %4 %5 %6")
+           .arg(transactions, 8)
+           .arg(probe.done, 7)
+           .arg(tps, 10, 'f', 0)
+           .arg(probe.maxWaited, 9)
+           .arg(toUs(probe.queueTime.percentile(50)), 9, 'f', 1)
+           .arg(toUs(probe.queueTime.percentile(99)), 9, 'f', 1)
+        << endl;
+
+    if (parser.isSet(outputOption))
+    {
+        QJsonObject parameters;
+        parameters["backlog"] = backlog;
+        parameters["agingMs"] = aging;
+        parameters["rounds"] = rounds;
+        parameters["spacing"] = spacing;
+
+        QJsonObject result;
+        result["transactions"] = transactions;
+        result["urgent"] = probe.done;
+        result["tps"] = tps;
+        result["maxWaited"] = probe.maxWaited;
+        result["p50Us"] = toUs(probe.queueTime.percentile(50));
+        result["p99Us"] = toUs(probe.queueTime.percentile(99));
+
+        QJsonArray results;
+        results.append(result);
+
+        if (!writeJsonReport(parser.value(outputOption), "queue", parameters, results))
+            return 1;
+    }
+
+    if ((probe.done < rounds) || (probe.maxWaited > 1))
+    {
+        out << "Urgent write waited more than one transaction!" << endl;
+        return 2;
+    }
+
+    return 0;
+}
+
+#include "main.moc"
@@ -0,0 +1,9 @@
+include( $${PWD}/../benchmarks.pri )
+
+TARGET = queue-bench
+
+MOC_DIR = $${MOC_DIR}/benchmarks/queue
+OBJECTS_DIR = $${OBJECTS_DIR}/benchmarks/queue
+
+SOURCES += \
+    main.cpp
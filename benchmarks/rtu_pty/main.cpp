@@ -0,0 +1,329 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+//
+// MODBUS/RTU cycle time benchmark without serial hardware.
+//
+// RtuClient talks through pseudo terminal to in-process RtuServer. Simulated
+// line delivers response with character timing of selected baud rate, adds
+// turnaround delay of slave device and may corrupt bytes or lose requests.
+// For every run measured cycle time is compared with ideal one: time on wire
+// for request and response, two t3.5 gaps and turnaround delay.
+//
+// Client uses QSerialPort by default, "--backend native" switches it to
+// NativeSerialPort (Linux only) to compare both backends on the same line.
+//
+// Example:
+//     rtu-pty-bench --bauds 9600,115200 --functions 3 --sizes 1,125 --turnaround 2000 --output rtu.json
+//     rtu-pty-bench --backend native --bauds 115200 --functions 3 --sizes 1,125
+//
+
+#include "bench_requests.h"
+#include "bench_utils.h"
+#include "simulated_line.h"
+
+#include "global.h"
+#include "rtu_client.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+
+using namespace modbus4qt;
+using namespace modbus4qt::bench;
+
+//-----------------------------------------------------------------------------
+
+struct RunConfig
+{
+    LineConfig line;
+
+    quint8 function;
+
+    int blockSize;
+
+    int durationMs;
+
+    int timeoutMs;
+
+    bool nativeBackend;
+};
+
+//-----------------------------------------------------------------------------
+
+static bool
+runBenchmark(const RunConfig& config, QTextStream& out, QJsonObject& result)
+{
+    SimulatedLine line(config.line);
+    if (!line.open())
+        return false;
+
+    line.start();
+
+    RtuClient client(line.slavePath(),
+                     static_cast<QSerialPort::BaudRate>(config.line.baudRate),
+                     QSerialPort::Data8,
+                     QSerialPort::OneStop,
+                     QSerialPort::EvenParity,
+                     0);
+    client.setUnitID(config.line.unitId);
+    client.setReadTimeOut(config.timeoutMs);
+
+    if (config.nativeBackend)
+        client.setNativeBackend();
+
+    ErrorCounter clientErrors;
+    QObject::connect(&client, SIGNAL(errorMessage(quint8,QString)), &clientErrors, SLOT(addError(quint8,QString)));
+
+    if (!client.openPort())
+        return false;
+
+    LatencyStats stats;
+    int failures = 0;
+    quint16 seed = 0;
+
+    const qint64 durationNs = qint64(config.durationMs) * 1000000;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    while (clock.nsecsElapsed() < durationNs)
+    {
+        qint64 start = clock.nsecsElapsed();
+        bool ok = blockingRequest(client, config.function, 0, config.blockSize, ++seed);
+        stats.add(clock.nsecsElapsed() - start);
+
+        if (!ok)
+            ++failures;
+
+        // Let silence timer of client work as in application with event loop
+        QCoreApplication::processEvents();
+    }
+
+    qint64 elapsedNs = clock.nsecsElapsed();
+
+    line.close();
+
+    ProtocolDataUnit request;
+    int requestAduSize = buildRequest(config.function, 0, config.blockSize, 0, request) + 3;
+    int responseAduSize = responseSize(config.function, config.blockSize) + 3;
+
+    qint64 idealNs = (requestAduSize + responseAduSize) * config.line.charTimeNs()
+            + 2 * config.line.frameGapNs()
+            + qint64(config.line.turnaroundUs) * 1000;
+
+    double tps = elapsedNs ? stats.count() * 1e9 / elapsedNs : 0;
+    double efficiency = stats.percentile(50) ? 100.0 * idealNs / stats.percentile(50) : 0;
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11")
+           .arg(config.line.baudRate, 7)
+           .arg(config.function, 4)
+           .arg(config.blockSize, 6)
+           .arg(stats.count(), 8)
+           .arg(failures, 7)
+           .arg(clientErrors.count(), 7)
+           .arg(tps, 8, 'f', 1)
+           .arg(toUs(idealNs) / 1000, 9, 'f', 2)
+           .arg(toUs(stats.percentile(50)) / 1000, 9, 'f', 2)
+           .arg(toUs(stats.percentile(99)) / 1000, 9, 'f', 2)
+           .arg(efficiency, 6, 'f', 1)
+        << endl;
+
+    result["backend"] = config.nativeBackend ? "native" : "qt";
+    result["baudRate"] = config.line.baudRate;
+    result["function"] = config.function;
+    result["blockSize"] = config.blockSize;
+    result["turnaroundUs"] = config.line.turnaroundUs;
+    result["noiseRate"] = config.line.noiseRate;
+    result["dropRate"] = config.line.dropRate;
+    result["transactions"] = stats.count();
+    result["failures"] = failures;
+    result["clientErrors"] = clientErrors.count();
+    result["framesReceived"] = line.framesReceived();
+    result["framesDropped"] = line.framesDropped();
+    result["bytesCorrupted"] = line.bytesCorrupted();
+    result["tps"] = tps;
+    result["idealUs"] = toUs(idealNs);
+    result["meanUs"] = toUs(stats.mean());
+    result["p50Us"] = toUs(stats.percentile(50));
+    result["p99Us"] = toUs(stats.percentile(99));
+    result["p999Us"] = toUs(stats.percentile(99.9));
+    result["maxUs"] = toUs(stats.max());
+    result["efficiency"] = efficiency;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("rtu-pty-bench");
+    QCoreApplication::setApplicationVersion(MODBUS4QT_VERSION_STR);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("modbus4qt MODBUS/RTU benchmark over pseudo terminal with simulated line");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption baudsOption("bauds", "Comma separated baud rates.", "list", "9600,19200,115200");
+    QCommandLineOption functionsOption("functions", "Comma separated function codes (1-6, 15, 16).", "list", "3");
+    QCommandLineOption sizesOption("sizes", "Comma separated block sizes in registers or coils.", "list", "1,16,125");
+    QCommandLineOption turnaroundOption("turnaround", "Slave turnaround delay, us.", "us", "1000");
+    QCommandLineOption noiseOption("noise", "Probability of bit error in response byte.", "rate", "0");
+    QCommandLineOption dropOption("drop", "Probability of lost request.", "rate", "0");
+    QCommandLineOption seedOption("seed", "Seed for noise generator.", "n", "1");
+    QCommandLineOption durationOption("duration", "Duration of every run, ms.", "ms", "5000");
+    QCommandLineOption timeoutOption("timeout", "Response timeout, ms.", "ms", "1000");
+    QCommandLineOption outputOption("output", "Write JSON report to file (\"-\" for standard output).", "file");
+    QCommandLineOption verboseOption("verbose", "Do not suppress library debug output.");
+    QCommandLineOption backendOption("backend", "Serial port backend of client: qt or native.", "name", "qt");
+
+    parser.addOption(baudsOption);
+    parser.addOption(functionsOption);
+    parser.addOption(sizesOption);
+    parser.addOption(turnaroundOption);
+    parser.addOption(noiseOption);
+    parser.addOption(dropOption);
+    parser.addOption(seedOption);
+    parser.addOption(durationOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(outputOption);
+    parser.addOption(verboseOption);
+    parser.addOption(backendOption);
+
+    parser.process(app);
+
+    QList<int> bauds = parseIntList(parser.value(baudsOption));
+    QList<int> functions = parseIntList(parser.value(functionsOption));
+    QList<int> sizes = parseIntList(parser.value(sizesOption));
+
+    LineConfig line;
+    line.turnaroundUs = parser.value(turnaroundOption).toInt();
+    line.noiseRate = parser.value(noiseOption).toDouble();
+    line.dropRate = parser.value(dropOption).toDouble();
+    line.seed = parser.value(seedOption).toUInt();
+
+    int duration = parser.value(durationOption).toInt();
+    int timeout = parser.value(timeoutOption).toInt();
+
+    QString backend = parser.value(backendOption);
+
+    QTextStream out(parser.value(outputOption) == "-" ? stderr : stdout);
+
+    if (bauds.isEmpty() || functions.isEmpty() || sizes.isEmpty() || bauds.contains(0) || duration <= 0 || timeout <= 0 ||
+            (backend != "qt" && backend != "native"))
+    {
+        out << "Invalid arguments" << endl;
+        return 1;
+    }
+
+    if (!parser.isSet(verboseOption))
+        installQuietMessageHandler();
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11")
+           .arg("baud", 7)
+           .arg("fc", 4)
+           .arg("size", 6)
+           .arg("requests", 8)
+           .arg("failed", 7)
+           .arg("errors", 7)
+           .arg("tps", 8)
+           .arg("ideal,ms", 9)
+           .arg("p50,ms", 9)
+           .arg("p99,ms", 9)
+           .arg("eff,%", 6)
+        << endl;
+
+    QJsonArray results;
+
+    foreach (int baud, bauds)
+    {
+        foreach (int function, functions)
+        {
+            ProtocolDataUnit probe;
+            if (!buildRequest(function, 0, 1, 0, probe))
+            {
+                out << QString("Function %1 is not supported by benchmark").arg(function) << endl;
+                continue;
+            }
+
+            QList<int> blockSizes;
+            foreach (int size, sizes)
+            {
+                int blockSize = qBound(1, size, maxBlockSize(function));
+                if (!blockSizes.contains(blockSize))
+                    blockSizes.append(blockSize);
+            }
+
+            foreach (int blockSize, blockSizes)
+            {
+                RunConfig config;
+                config.line = line;
+                config.line.baudRate = baud;
+                config.function = function;
+                config.blockSize = blockSize;
+                config.durationMs = duration;
+                config.timeoutMs = timeout;
+                config.nativeBackend = (backend == "native");
+
+                QJsonObject result;
+                if (!runBenchmark(config, out, result))
+                {
+                    out << "Can not set up pseudo terminal" << endl;
+                    return 1;
+                }
+
+                results.append(result);
+            }
+        }
+    }
+
+    if (parser.isSet(outputOption))
+    {
+        QJsonObject parameters;
+        parameters["backend"] = backend;
+        parameters["turnaroundUs"] = line.turnaroundUs;
+        parameters["noiseRate"] = line.noiseRate;
+        parameters["dropRate"] = line.dropRate;
+        parameters["seed"] = qint64(line.seed);
+        parameters["durationMs"] = duration;
+        parameters["timeoutMs"] = timeout;
+
+        if (!writeJsonReport(parser.value(outputOption), "rtu_pty", parameters, results))
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,13 @@
+include( $${PWD}/../benchmarks.pri )
+
+TARGET = rtu-pty-bench
+
+MOC_DIR = $${MOC_DIR}/benchmarks/rtu_pty
+OBJECTS_DIR = $${OBJECTS_DIR}/benchmarks/rtu_pty
+
+SOURCES += \
+    main.cpp \
+    simulated_line.cpp
+
+HEADERS += \
+    simulated_line.h
@@ -0,0 +1,296 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "simulated_line.h"
+
+#include "dummy_device.h"
+#include "rtu_server.h"
+
+#include <QByteArray>
+#include <QDebug>
+
+#include <random>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+static qint64
+monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------
+
+static void
+sleepUntil(qint64 ns)
+{
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR)
+        ;
+}
+
+//-----------------------------------------------------------------------------
+
+static bool
+waitReadable(int fd, qint64 timeoutNs)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    struct timespec ts;
+    ts.tv_sec = timeoutNs / 1000000000;
+    ts.tv_nsec = timeoutNs % 1000000000;
+
+    return ppoll(&pfd, 1, &ts, 0) > 0 && (pfd.revents & POLLIN);
+}
+
+//-----------------------------------------------------------------------------
+
+SimulatedLine::SimulatedLine(const LineConfig& config)
+    : QThread(),
+      config_(config),
+      masterFd_(-1),
+      slaveFd_(-1)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+SimulatedLine::~SimulatedLine()
+{
+    close();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimulatedLine::open()
+{
+    masterFd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if (masterFd_ < 0)
+    {
+        qWarning() << "posix_openpt failed:" << strerror(errno);
+        return false;
+    }
+
+    if ((grantpt(masterFd_) != 0) || (unlockpt(masterFd_) != 0))
+    {
+        qWarning() << "Can not unlock pseudo terminal:" << strerror(errno);
+        close();
+        return false;
+    }
+
+    slavePath_ = QString::fromLocal8Bit(ptsname(masterFd_));
+
+    // Keep slave side open, otherwise reading from master fails with EIO
+    // while client has not opened the port yet or between reopenings.
+    // Slave is switched to raw mode to prevent echo of requests.
+    //
+    // Держим сторону slave открытой, иначе чтение со стороны master завершится
+    // ошибкой EIO, пока клиент не открыл порт. Переводим slave в режим raw,
+    // чтобы запросы не возвращались эхом.
+    //
+    slaveFd_ = ::open(slavePath_.toLocal8Bit().constData(), O_RDWR | O_NOCTTY);
+    if (slaveFd_ < 0)
+    {
+        qWarning() << "Can not open" << slavePath_ << ":" << strerror(errno);
+        close();
+        return false;
+    }
+
+    struct termios tio;
+    tcgetattr(slaveFd_, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slaveFd_, TCSANOW, &tio);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimulatedLine::close()
+{
+    if (isRunning())
+    {
+        requestInterruption();
+        wait();
+    }
+
+    if (slaveFd_ >= 0)
+        ::close(slaveFd_);
+
+    if (masterFd_ >= 0)
+        ::close(masterFd_);
+
+    slaveFd_ = -1;
+    masterFd_ = -1;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimulatedLine::writePaced_(const QByteArray& frame)
+{
+    const qint64 charNs = config_.charTimeNs();
+    const qint64 start = monotonicNs();
+
+    int written = 0;
+
+    while (written < frame.size())
+    {
+        // Byte i is completely received at start + (i + 1) * charNs
+        //
+        // Байт i полностью получен в момент start + (i + 1) * charNs
+        //
+        int due = qMin<qint64>(frame.size(), (monotonicNs() - start) / charNs);
+
+        if (due <= written)
+        {
+            sleepUntil(start + (written + 1) * charNs);
+            continue;
+        }
+
+        ssize_t result = ::write(masterFd_, frame.constData() + written, due - written);
+        if (result < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+
+            qWarning() << "Write to pseudo terminal failed:" << strerror(errno);
+            return;
+        }
+
+        written += result;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimulatedLine::run()
+{
+    DummyDevice device;
+
+    RtuServer server;
+    server.setDevice(&device);
+    server.setUnitID(config_.unitId);
+
+    std::mt19937 random(config_.seed);
+    std::uniform_real_distribution<double> probability(0.0, 1.0);
+    std::uniform_int_distribution<int> bit(0, 7);
+
+    const qint64 charNs = config_.charTimeNs();
+    const qint64 gapNs = config_.frameGapNs();
+
+    char buf[512];
+
+    while (!isInterruptionRequested())
+    {
+        if (!waitReadable(masterFd_, 100000000))
+            continue;
+
+        const qint64 firstByteTime = monotonicNs();
+
+        // Collect frame until line is silent for t3.5
+        //
+        // Собираем кадр, пока в линии не наступит тишина длительностью t3.5
+        //
+        QByteArray request;
+        do
+        {
+            ssize_t size = ::read(masterFd_, buf, sizeof(buf));
+            if (size > 0)
+                request.append(buf, size);
+        }
+        while (waitReadable(masterFd_, gapNs));
+
+        if (request.isEmpty())
+            continue;
+
+        framesReceived_.ref();
+
+        // Request needs time to pass the line, then slave waits for t3.5
+        //
+        // Запросу требуется время на передачу по линии, затем устройство ожидает t3.5
+        //
+        sleepUntil(firstByteTime + request.size() * charNs + gapNs);
+
+        if (probability(random) < config_.dropRate)
+        {
+            framesDropped_.ref();
+            continue;
+        }
+
+        QByteArray response = server.processADU(request);
+        if (response.isEmpty())
+            continue;
+
+        sleepUntil(monotonicNs() + qint64(config_.turnaroundUs) * 1000);
+
+        if (config_.noiseRate > 0)
+        {
+            for (int i = 0; i < response.size(); ++i)
+            {
+                if (probability(random) < config_.noiseRate)
+                {
+                    response[i] = response[i] ^ (1 << bit(random));
+                    bytesCorrupted_.ref();
+                }
+            }
+        }
+
+        writePaced_(response);
+    }
+}
+
+} // namespace bench
+
+} // namespace modbus4qt
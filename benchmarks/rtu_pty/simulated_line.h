@@ -0,0 +1,219 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_SIMULATED_LINE_H
+#define MODBUS4QT_SIMULATED_LINE_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+/**
+ * @brief
+ * @en Parameters of emulated serial line and slave device
+ * @ru Параметры эмулируемой последовательной линии и подчиненного устройства
+ */
+struct LineConfig
+{
+    int baudRate;
+
+    //! @en Bits per character: start, 8 data, parity, stop @ru Бит на символ: старт, 8 бит данных, четность, стоп
+    int bitsPerChar;
+
+    //! @en Time between end of request and start of response, us @ru Время от конца запроса до начала ответа, мкс
+    int turnaroundUs;
+
+    //! @en Probability of bit error in every response byte @ru Вероятность искажения бита в каждом байте ответа
+    double noiseRate;
+
+    //! @en Probability of request to be lost @ru Вероятность потери запроса
+    double dropRate;
+
+    quint32 seed;
+
+    quint8 unitId;
+
+    LineConfig()
+        : baudRate(9600),
+          bitsPerChar(11),
+          turnaroundUs(1000),
+          noiseRate(0),
+          dropRate(0),
+          seed(1),
+          unitId(1)
+    {
+    }
+
+    //! @en Time to transmit one character, ns @ru Время передачи одного символа, нс
+    qint64 charTimeNs() const
+    {
+        return qint64(bitsPerChar) * 1000000000 / baudRate;
+    }
+
+    /**
+     * @brief
+     * @en Minimum silent interval between frames (t3.5), ns
+     * @ru Минимальный интервал тишины между кадрами (t3.5), нс
+     *
+     * @en Fixed to 1750 us for baud rates above 19200 as required by specification.
+     * @ru Для скоростей выше 19200 фиксирован на 1750 мкс согласно спецификации.
+     */
+    qint64 frameGapNs() const
+    {
+        return (baudRate > 19200) ? 1750000 : charTimeNs() * 7 / 2;
+    }
+};
+
+/**
+ * @brief
+ * @en RTU slave behind pseudo terminal with emulated serial line timing
+ * @ru Подчиненное устройство RTU за псевдотерминалом с эмуляцией временных характеристик линии
+ *
+ * @en Client opens slavePath() as usual serial port. Thread reads requests
+ * from master side of pseudo terminal, waits for time the request would take
+ * on real line plus t3.5 and turnaround delay, and writes response byte by
+ * byte with character timing of configured baud rate. Requests are processed
+ * by RtuServer with DummyDevice.
+ *
+ * @ru Клиент открывает slavePath() как обычный последовательный порт. Поток
+ * читает запросы со стороны мастера псевдотерминала, выжидает время передачи
+ * запроса по реальной линии, t3.5 и задержку на обработку, после чего
+ * побайтно передает ответ с темпом, соответствующим заданной скорости. Запросы
+ * обрабатываются RtuServer с DummyDevice.
+ */
+class SimulatedLine : public QThread
+{
+    private:
+
+        LineConfig config_;
+
+        int masterFd_;
+
+        int slaveFd_;
+
+        QString slavePath_;
+
+        QAtomicInt framesReceived_;
+
+        QAtomicInt framesDropped_;
+
+        QAtomicInt bytesCorrupted_;
+
+        void writePaced_(const QByteArray& frame);
+
+    public:
+
+        explicit SimulatedLine(const LineConfig& config);
+
+        virtual ~SimulatedLine();
+
+        //! @en Create pseudo terminal pair @ru Создает пару псевдотерминалов
+        bool open();
+
+        //! @en Stop thread and close pseudo terminal @ru Останавливает поток и закрывает псевдотерминал
+        void close();
+
+        //! @en Device name for client, e.g. /dev/pts/3 @ru Имя устройства для клиента, например /dev/pts/3
+        QString slavePath() const
+        {
+            return slavePath_;
+        }
+
+        int framesReceived() const
+        {
+            return framesReceived_.load();
+        }
+
+        int framesDropped() const
+        {
+            return framesDropped_.load();
+        }
+
+        int bytesCorrupted() const
+        {
+            return bytesCorrupted_.load();
+        }
+
+    protected:
+
+        virtual void run();
+};
+
+/**
+ * @brief
+ * @en Counter of client error messages
+ * @ru Счетчик сообщений клиента об ошибках
+ *
+ * @en Client does not fail request on CRC mismatch, it only emits errorMessage().
+ * @ru Клиент не прерывает запрос при несовпадении CRC, а только выдает errorMessage().
+ */
+class ErrorCounter : public QObject
+{
+    Q_OBJECT
+
+    private:
+
+        int count_;
+
+    public:
+
+        explicit ErrorCounter(QObject* parent = 0)
+            : QObject(parent),
+              count_(0)
+        {
+        }
+
+        int count() const
+        {
+            return count_;
+        }
+
+    public slots:
+
+        void addError(quint8 unitID, const QString& msg)
+        {
+            Q_UNUSED(unitID)
+            Q_UNUSED(msg)
+
+            ++count_;
+        }
+};
+
+} // namespace bench
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_SIMULATED_LINE_H
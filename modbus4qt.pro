@@ -39,6 +39,14 @@ contains (MODBUS4QT_CONFIG, modbus4qt_demo) {
     SUBDIRS += demo
 }
 
+contains (MODBUS4QT_CONFIG, modbus4qt_benchmarks) {
+    SUBDIRS += benchmarks
+}
+
+contains (MODBUS4QT_CONFIG, modbus4qt_tools) {
+    SUBDIRS += tools
+}
+
 modbus4qtspec.files  = modbus4qt_config.pri modbus4qt_functions.pri modbus4qt.prf
 modbus4qtspec.path  = $${MODBUS4QT_INSTALL_FEATURES}
 
@@ -80,3 +80,20 @@ MODBUS4QT_CONFIG += modbus4qt_dll
 # Otherwise you have to build them from the examples directory.
 
 MODBUS4QT_CONFIG     += modbus4qt_demo
+
+#------------------------------------------------------------------------------
+# Build benchmarks
+#
+# If you want to build performance benchmarks from the benchmarks directory,
+# enable the line below. Results are printed as a table and may be saved
+# in JSON format for comparison between builds.
+
+#MODBUS4QT_CONFIG     += modbus4qt_benchmarks
+
+#------------------------------------------------------------------------------
+# Build command line tools
+#
+# If you want to build command line tools (load generator and others from
+# the tools directory), enable the line below.
+
+#MODBUS4QT_CONFIG     += modbus4qt_tools
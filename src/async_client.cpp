@@ -0,0 +1,640 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "async_client.h"
+#include "utils.h"
+
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QThread>
+
+namespace modbus4qt
+{
+
+void
+CancellationToken::add(AsyncClient* client, quint64 id)
+{
+    {
+        QMutexLocker locker(&mutex_);
+
+        if (!cancelled_)
+        {
+            requests_.append(qMakePair(client, id));
+            return;
+        }
+    }
+
+    client->cancel(id);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+CancellationToken::cancel()
+{
+    // Handlers called from cancel() may remove themselves from token, so
+    // lock is not held while requests are cancelled
+    //
+    // Получатели, вызванные из cancel(), могут удалять себя из объекта,
+    // поэтому блокировка не удерживается во время отмены запросов
+    //
+    QList<QPair<AsyncClient*, quint64> > requests;
+    {
+        QMutexLocker locker(&mutex_);
+
+        cancelled_ = true;
+        requests = requests_;
+        requests_.clear();
+    }
+
+    for (int i = 0; i < requests.size(); ++i)
+        requests.at(i).first->cancel(requests.at(i).second);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+CancellationToken::remove(AsyncClient* client, quint64 id)
+{
+    QMutexLocker locker(&mutex_);
+
+    requests_.removeAll(qMakePair(client, id));
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Handler which completes QFuture and deletes itself. It is always called in
+ * thread of AsyncClient, so watchers and continuations of cancelled futures
+ * are not run in cancelling thread.
+ */
+template<class T>
+class FutureRequestHandler : public AsyncRequestHandler
+{
+    public:
+
+        typedef bool (*Decoder)(const ProtocolDataUnit& response, quint16 regQty, T& value);
+
+    private:
+
+        QFutureInterface<AsyncResult<T> > interface_;
+
+        quint16 regQty_;
+
+        Decoder decoder_;
+
+    public:
+
+        FutureRequestHandler(quint16 regQty, Decoder decoder)
+            : regQty_(regQty),
+              decoder_(decoder)
+        {
+            interface_.reportStarted();
+        }
+
+        QFuture<AsyncResult<T> > future()
+        {
+            return interface_.future();
+        }
+
+        virtual void requestFinished(const RequestResult& result)
+        {
+            AsyncResult<T> typed;
+            AsyncClient::fillResult(result, typed);
+
+            if (typed.isOk() && !decoder_(result.response, regQty_, typed.value))
+                typed.error = Client::ResponseError;
+
+            if (result.error == Client::CancelledError)
+                interface_.reportCanceled();
+            else
+                interface_.reportResult(typed);
+
+            interface_.reportFinished();
+
+            delete this;
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+AsyncClient::AsyncClient(RequestQueue* queue, QObject* parent)
+    : QObject(parent),
+      queue_(queue)
+{
+    connect(queue_, SIGNAL(finished(modbus4qt::RequestResult)), this, SLOT(queueFinished_(modbus4qt::RequestResult)));
+
+    deadlineTimer_.setSingleShot(true);
+    connect(&deadlineTimer_, SIGNAL(timeout()), this, SLOT(checkDeadlines_()));
+
+    clock_.start();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+AsyncClient::cancel(quint64 id)
+{
+    {
+        QMutexLocker locker(&mutex_);
+
+        if (!pending_.contains(id))
+            return false;
+    }
+
+    finish_(id, Client::CancelledError);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+AsyncClient::cancelAll()
+{
+    QList<quint64> ids;
+    {
+        QMutexLocker locker(&mutex_);
+        ids = pending_.keys();
+    }
+
+    foreach (quint64 id, ids)
+        cancel(id);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+AsyncClient::checkDeadlines_()
+{
+    forever
+    {
+        quint64 id;
+        {
+            QMutexLocker locker(&mutex_);
+
+            if (deadlines_.isEmpty() || deadlines_.begin().key() > clock_.nsecsElapsed())
+                break;
+
+            id = deadlines_.begin().value();
+        }
+
+        finish_(id, Client::TimeoutError);
+    }
+
+    scheduleDeadlineTimer_();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+AsyncClient::decodeCoils(const ProtocolDataUnit& response, quint16 regQty, QVector<bool>& values)
+{
+    int bytes = (regQty + 7) / 8;
+    if (response.data[0] < bytes)
+        return false;
+
+    values = getCoilsFromBuffer(QByteArray((const char*)response.data + 1, bytes), regQty);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+AsyncClient::decodeRegisters(const ProtocolDataUnit& response, quint16 regQty, QVector<quint16>& values)
+{
+    int bytes = regQty * 2;
+    if (response.data[0] < bytes)
+        return false;
+
+    values = getRegistersFromBuffer(QByteArray((const char*)response.data + 1, bytes), regQty);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+AsyncClient::decodeWrite(const ProtocolDataUnit& response, quint16 regQty, bool& value)
+{
+    Q_UNUSED(response)
+    Q_UNUSED(regQty)
+
+    value = true;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+AsyncClient::deliverFinished_()
+{
+    QList<QPair<AsyncRequestHandler*, RequestResult> > finished;
+    {
+        QMutexLocker locker(&mutex_);
+
+        finished = finished_;
+        finished_.clear();
+    }
+
+    for (int i = 0; i < finished.size(); ++i)
+        finished.at(i).first->requestFinished(finished.at(i).second);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+AsyncClient::finish_(quint64 id, Client::RequestError error)
+{
+    PendingRequest request;
+    {
+        QMutexLocker locker(&mutex_);
+
+        // Request may be finished by other thread meanwhile
+        if (!pending_.contains(id))
+            return;
+
+        request = pending_.take(id);
+
+        if (request.deadline)
+            deadlines_.remove(request.deadline, id);
+    }
+
+    // Request which is already on line can not be stopped, its result
+    // will be ignored
+    queue_->cancel(id);
+
+    RequestResult result;
+    result.id = id;
+    result.unitID = request.unitID;
+    result.request = request.pdu;
+    result.error = error;
+
+    if (QThread::currentThread() == thread())
+    {
+        request.handler->requestFinished(result);
+        return;
+    }
+
+    // Cancelled from other thread, handler is called in thread of AsyncClient
+    // as for results from queue
+    //
+    // Отмена из другого потока, получатель вызывается в потоке AsyncClient,
+    // как и для результатов из очереди
+    //
+    {
+        QMutexLocker locker(&mutex_);
+        finished_.append(qMakePair(request.handler, result));
+    }
+
+    QMetaObject::invokeMethod(this, "deliverFinished_", Qt::QueuedConnection);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+AsyncClient::futureCanceled_()
+{
+    cancel(sender()->property("modbus4qtRequestId").toULongLong());
+}
+
+//-----------------------------------------------------------------------------
+
+int
+AsyncClient::pendingCount() const
+{
+    QMutexLocker locker(&mutex_);
+
+    return pending_.size();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+AsyncClient::queueFinished_(const RequestResult& result)
+{
+    PendingRequest request;
+    {
+        QMutexLocker locker(&mutex_);
+
+        // Result of cancelled request or request of other client of queue
+        if (!pending_.contains(result.id))
+            return;
+
+        request = pending_.take(result.id);
+
+        if (request.deadline)
+            deadlines_.remove(request.deadline, result.id);
+    }
+
+    request.handler->requestFinished(result);
+}
+
+//-----------------------------------------------------------------------------
+
+QFuture<AsyncResult<QVector<bool> > >
+AsyncClient::readCoils(quint8 unitID, quint16 regStart, quint16 regQty, RequestQueue::Priority priority, int timeout)
+{
+    regQty = qMin(regQty, quint16(MaxCoilsForRead));
+
+    ProtocolDataUnit pdu;
+    int pduSize = readRequest(Functions::ReadCoils, regStart, regQty, pdu);
+
+    return submitFuture_(unitID, pdu, pduSize, regQty, &AsyncClient::decodeCoils, priority, timeout);
+}
+
+//-----------------------------------------------------------------------------
+
+QFuture<AsyncResult<QVector<bool> > >
+AsyncClient::readDescreteInputs(quint8 unitID, quint16 regStart, quint16 regQty, RequestQueue::Priority priority, int timeout)
+{
+    regQty = qMin(regQty, quint16(MaxCoilsForRead));
+
+    ProtocolDataUnit pdu;
+    int pduSize = readRequest(Functions::ReadDescereteInputs, regStart, regQty, pdu);
+
+    return submitFuture_(unitID, pdu, pduSize, regQty, &AsyncClient::decodeCoils, priority, timeout);
+}
+
+//-----------------------------------------------------------------------------
+
+QFuture<AsyncResult<QVector<quint16> > >
+AsyncClient::readHoldingRegisters(quint8 unitID, quint16 regStart, quint16 regQty, RequestQueue::Priority priority, int timeout)
+{
+    regQty = qMin(regQty, quint16(MaxRegistersForRead));
+
+    ProtocolDataUnit pdu;
+    int pduSize = readRequest(Functions::ReadHoldingRegisters, regStart, regQty, pdu);
+
+    return submitFuture_(unitID, pdu, pduSize, regQty, &AsyncClient::decodeRegisters, priority, timeout);
+}
+
+//-----------------------------------------------------------------------------
+
+QFuture<AsyncResult<QVector<quint16> > >
+AsyncClient::readInputRegisters(quint8 unitID, quint16 regStart, quint16 regQty, RequestQueue::Priority priority, int timeout)
+{
+    regQty = qMin(regQty, quint16(MaxRegistersForRead));
+
+    ProtocolDataUnit pdu;
+    int pduSize = readRequest(Functions::ReadInputRegisters, regStart, regQty, pdu);
+
+    return submitFuture_(unitID, pdu, pduSize, regQty, &AsyncClient::decodeRegisters, priority, timeout);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+AsyncClient::readRequest(quint8 function, quint16 regStart, quint16 regQty, ProtocolDataUnit& pdu)
+{
+    pdu.functionCode = function;
+
+    pdu.data[0] = hi(regStart);
+    pdu.data[1] = lo(regStart);
+    pdu.data[2] = hi(regQty);
+    pdu.data[3] = lo(regQty);
+
+    return 5;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+AsyncClient::scheduleDeadlineTimer_()
+{
+    // Timer can be used only in thread of AsyncClient
+    if (QThread::currentThread() != thread())
+    {
+        QMetaObject::invokeMethod(this, "scheduleDeadlineTimer_", Qt::QueuedConnection);
+        return;
+    }
+
+    qint64 waitNs;
+    {
+        QMutexLocker locker(&mutex_);
+
+        if (deadlines_.isEmpty())
+        {
+            deadlineTimer_.stop();
+            return;
+        }
+
+        waitNs = deadlines_.begin().key() - clock_.nsecsElapsed();
+    }
+
+    // Round up, so timer does not fire before deadline
+    deadlineTimer_.start(int(qMax(Q_INT64_C(0), (waitNs + 999999) / 1000000)));
+}
+
+//-----------------------------------------------------------------------------
+
+quint64
+AsyncClient::submit(quint8 unitID, const ProtocolDataUnit& pdu, int pduSize, AsyncRequestHandler* handler,
+                    RequestQueue::Priority priority, int timeout)
+{
+    PendingRequest request;
+    request.handler = handler;
+    request.unitID = unitID;
+    request.pdu = pdu;
+    request.deadline = 0;
+
+    bool earliestDeadline = false;
+    quint64 id;
+    {
+        // Request is registered before result can arrive
+        QMutexLocker locker(&mutex_);
+
+        id = queue_->enqueue(unitID, pdu, pduSize, priority);
+
+        if (timeout > 0)
+        {
+            // Deadline is never 0 as clock_ is started in constructor
+            request.deadline = qMax(Q_INT64_C(1), clock_.nsecsElapsed() + qint64(timeout) * 1000000);
+            deadlines_.insert(request.deadline, id);
+
+            earliestDeadline = deadlines_.begin().value() == id;
+        }
+
+        pending_.insert(id, request);
+    }
+
+    if (earliestDeadline)
+        scheduleDeadlineTimer_();
+
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+
+template<class T>
+QFuture<AsyncResult<T> >
+AsyncClient::submitFuture_(quint8 unitID, const ProtocolDataUnit& pdu, int pduSize, quint16 regQty,
+                           bool (*decoder)(const ProtocolDataUnit&, quint16, T&),
+                           RequestQueue::Priority priority, int timeout)
+{
+    FutureRequestHandler<T>* handler = new FutureRequestHandler<T>(regQty, decoder);
+    QFuture<AsyncResult<T> > future = handler->future();
+
+    quint64 id = submit(unitID, pdu, pduSize, handler, priority, timeout);
+
+    // Handler may be already deleted by other thread here. Watcher lives
+    // until future is finished and turns cancel of future into cancel of
+    // request.
+    QFutureWatcher<AsyncResult<T> >* watcher = new QFutureWatcher<AsyncResult<T> >();
+    watcher->setProperty("modbus4qtRequestId", id);
+
+    connect(watcher, SIGNAL(canceled()), this, SLOT(futureCanceled_()));
+    connect(watcher, SIGNAL(finished()), watcher, SLOT(deleteLater()));
+
+    watcher->setFuture(future);
+    watcher->moveToThread(thread());
+
+    return future;
+}
+
+//-----------------------------------------------------------------------------
+
+QFuture<AsyncResult<bool> >
+AsyncClient::writeMultipleCoils(quint8 unitID, quint16 regStart, const QVector<bool>& values,
+                                RequestQueue::Priority priority, int timeout)
+{
+    ProtocolDataUnit pdu;
+    int pduSize = writeMultipleCoilsRequest(regStart, values, pdu);
+
+    return submitFuture_(unitID, pdu, pduSize, 0, &AsyncClient::decodeWrite, priority, timeout);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+AsyncClient::writeMultipleCoilsRequest(quint16 regStart, const QVector<bool>& values, ProtocolDataUnit& pdu)
+{
+    int regQty = qMin(values.size(), int(MaxCoilsForWrite));
+
+    pdu.functionCode = Functions::WriteMultipleCoils;
+
+    pdu.data[0] = hi(regStart);
+    pdu.data[1] = lo(regStart);
+    pdu.data[2] = hi(regQty);
+    pdu.data[3] = lo(regQty);
+    pdu.data[4] = (regQty + 7) / 8;
+
+    putCoilsIntoBuffer(pdu.data + 5, values.mid(0, regQty));
+
+    return 6 + pdu.data[4];
+}
+
+//-----------------------------------------------------------------------------
+
+QFuture<AsyncResult<bool> >
+AsyncClient::writeMultipleRegisters(quint8 unitID, quint16 regStart, const QVector<quint16>& values,
+                                    RequestQueue::Priority priority, int timeout)
+{
+    ProtocolDataUnit pdu;
+    int pduSize = writeMultipleRegistersRequest(regStart, values, pdu);
+
+    return submitFuture_(unitID, pdu, pduSize, 0, &AsyncClient::decodeWrite, priority, timeout);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+AsyncClient::writeMultipleRegistersRequest(quint16 regStart, const QVector<quint16>& values, ProtocolDataUnit& pdu)
+{
+    int regQty = qMin(values.size(), int(MaxRegistersForWrite));
+
+    pdu.functionCode = Functions::WriteMultipleRegisters;
+
+    pdu.data[0] = hi(regStart);
+    pdu.data[1] = lo(regStart);
+    pdu.data[2] = hi(regQty);
+    pdu.data[3] = lo(regQty);
+    pdu.data[4] = regQty * 2;
+
+    putRegistersIntoBuffer(pdu.data + 5, values.mid(0, regQty));
+
+    return 6 + pdu.data[4];
+}
+
+//-----------------------------------------------------------------------------
+
+QFuture<AsyncResult<bool> >
+AsyncClient::writeSingleCoil(quint8 unitID, quint16 regAddress, bool value, RequestQueue::Priority priority, int timeout)
+{
+    ProtocolDataUnit pdu;
+    int pduSize = writeSingleCoilRequest(regAddress, value, pdu);
+
+    return submitFuture_(unitID, pdu, pduSize, 0, &AsyncClient::decodeWrite, priority, timeout);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+AsyncClient::writeSingleCoilRequest(quint16 regAddress, bool value, ProtocolDataUnit& pdu)
+{
+    pdu.functionCode = Functions::WriteSingleCoil;
+
+    pdu.data[0] = hi(regAddress);
+    pdu.data[1] = lo(regAddress);
+
+    // 0xFF00 - on, 0x0000 - off
+    pdu.data[2] = value ? 0xFF : 0;
+    pdu.data[3] = 0;
+
+    return 5;
+}
+
+//-----------------------------------------------------------------------------
+
+QFuture<AsyncResult<bool> >
+AsyncClient::writeSingleRegister(quint8 unitID, quint16 regAddress, quint16 value, RequestQueue::Priority priority, int timeout)
+{
+    ProtocolDataUnit pdu;
+    int pduSize = writeSingleRegisterRequest(regAddress, value, pdu);
+
+    return submitFuture_(unitID, pdu, pduSize, 0, &AsyncClient::decodeWrite, priority, timeout);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+AsyncClient::writeSingleRegisterRequest(quint16 regAddress, quint16 value, ProtocolDataUnit& pdu)
+{
+    pdu.functionCode = Functions::WriteSingleRegister;
+
+    pdu.data[0] = hi(regAddress);
+    pdu.data[1] = lo(regAddress);
+    pdu.data[2] = hi(value);
+    pdu.data[3] = lo(value);
+
+    return 5;
+}
+
+} // namespace modbus4qt
@@ -0,0 +1,417 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_ASYNC_CLIENT_H
+#define MODBUS4QT_ASYNC_CLIENT_H
+
+#include "client.h"
+#include "global.h"
+#include "request_queue.h"
+#include "types.h"
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMultiMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QObject>
+#include <QPair>
+#include <QTimer>
+#include <QVector>
+
+namespace modbus4qt
+{
+
+class AsyncClient;
+
+/**
+ * @brief
+ * @en Typed result of asynchronous request
+ * @ru Типизированный результат асинхронного запроса
+ */
+template<class T>
+struct AsyncResult
+{
+    //! @en Decoded value, valid only if isOk() @ru Декодированное значение, действительно только если isOk()
+    T value;
+
+    Client::RequestError error;
+
+    //! @en Exception code if error is ExceptionError @ru Код исключения, если error равно ExceptionError
+    quint8 exceptionCode;
+
+    //! @en Time in queue, ns @ru Время нахождения в очереди, нс
+    qint64 queueTime;
+
+    //! @en Time of transaction, ns @ru Время выполнения транзакции, нс
+    qint64 transactionTime;
+
+    AsyncResult()
+        : value(),
+          error(Client::NoError),
+          exceptionCode(0),
+          queueTime(0),
+          transactionTime(0)
+    {
+    }
+
+    bool isOk() const
+    {
+        return error == Client::NoError;
+    }
+};
+
+/**
+ * @brief
+ * @en Receiver of asynchronous request results
+ * @ru Получатель результатов асинхронных запросов
+ */
+class MODBUS4QT_EXPORT AsyncRequestHandler
+{
+    public:
+
+        virtual ~AsyncRequestHandler()
+        {
+        }
+
+        /**
+         * @brief
+         * @en Called in thread of AsyncClient when request is finished, timed out or cancelled
+         * @ru Вызывается в потоке AsyncClient, когда запрос выполнен, истекло время ожидания или запрос отменен
+         *
+         * @en Request cancelled from other thread is finished through event
+         * loop of AsyncClient, never in cancelling thread.
+         *
+         * @ru Запрос, отмененный из другого потока, завершается через цикл
+         * обработки событий AsyncClient, а не в отменяющем потоке.
+         */
+        virtual void requestFinished(const RequestResult& result) = 0;
+};
+
+/**
+ * @brief
+ * @en Cancellation of group of asynchronous requests
+ * @ru Отмена группы асинхронных запросов
+ *
+ * @en Requests registered in token are cancelled by cancel(). Requests
+ * registered after that are cancelled at once. Token must outlive its requests.
+ * Token may be used from any thread; handlers of cancelled requests are still
+ * called in threads of their AsyncClient objects.
+ *
+ * @ru Запросы, зарегистрированные в объекте, отменяются вызовом cancel().
+ * Запросы, зарегистрированные после этого, отменяются сразу. Объект должен
+ * существовать дольше своих запросов. Объект может использоваться из любого
+ * потока; получатели отмененных запросов по-прежнему вызываются в потоках
+ * своих объектов AsyncClient.
+ */
+class MODBUS4QT_EXPORT CancellationToken
+{
+    private:
+
+        //! @en Protects requests_ and cancelled_ @ru Защищает requests_ и cancelled_
+        mutable QMutex mutex_;
+
+        QList<QPair<AsyncClient*, quint64> > requests_;
+
+        bool cancelled_;
+
+        Q_DISABLE_COPY(CancellationToken)
+
+    public:
+
+        CancellationToken()
+            : cancelled_(false)
+        {
+        }
+
+        bool isCancelled() const
+        {
+            QMutexLocker locker(&mutex_);
+            return cancelled_;
+        }
+
+        //! @en Cancel all registered requests @ru Отменяет все зарегистрированные запросы
+        void cancel();
+
+        //! @en Clear cancelled state @ru Сбрасывает состояние отмены
+        void reset()
+        {
+            QMutexLocker locker(&mutex_);
+            cancelled_ = false;
+        }
+
+        void add(AsyncClient* client, quint64 id);
+
+        void remove(AsyncClient* client, quint64 id);
+};
+
+/**
+ * @brief
+ * @en Asynchronous access to line served by RequestQueue
+ * @ru Асинхронный доступ к линии, обслуживаемой RequestQueue
+ *
+ * @en Requests are executed by queue, which may work in other thread. Results
+ * are delivered to handlers in thread of AsyncClient through its event loop,
+ * so one thread can keep many requests to many lines without blocking.
+ *
+ * Request may have timeout, which includes time in queue. When timeout expires
+ * or request is cancelled in thread of AsyncClient handler is called at once;
+ * request cancelled from other thread is finished through event loop of
+ * AsyncClient. Request which is not started yet is removed from queue; result
+ * of request which is already on line is ignored.
+ *
+ * Requests may be submitted and cancelled from any thread. Methods returning
+ * QFuture complete futures in thread of AsyncClient, cancelled ones too;
+ * create it in thread of queue to complete them right from I/O thread.
+ * Futures may be waited for, watched by QFutureWatcher, chained by then()
+ * (Qt 6) and cancelled.
+ *
+ * @ru Запросы выполняются очередью, которая может работать в другом потоке.
+ * Результаты передаются получателям в потоке AsyncClient через его цикл
+ * обработки событий, поэтому один поток может выполнять множество запросов
+ * к множеству линий без блокировки.
+ *
+ * Запрос может иметь время ожидания, включающее время нахождения в очереди.
+ * При его истечении или отмене запроса в потоке AsyncClient получатель
+ * вызывается сразу; запрос, отмененный из другого потока, завершается через
+ * цикл обработки событий AsyncClient. Еще не начатый запрос удаляется из
+ * очереди; результат запроса, уже переданного в линию, игнорируется.
+ */
+class MODBUS4QT_EXPORT AsyncClient : public QObject
+{
+    Q_OBJECT
+
+    private:
+
+        struct PendingRequest
+        {
+            AsyncRequestHandler* handler;
+
+            quint8 unitID;
+
+            ProtocolDataUnit pdu;
+
+            //! @en Deadline, ns of clock_; 0 - no timeout @ru Крайний срок, нс по clock_; 0 - без ограничения
+            qint64 deadline;
+        };
+
+        RequestQueue* queue_;
+
+        //! @en Protects pending_, deadlines_ and finished_ @ru Защищает pending_, deadlines_ и finished_
+        mutable QMutex mutex_;
+
+        QHash<quint64, PendingRequest> pending_;
+
+        //! @en Deadline -> request id @ru Крайний срок -> идентификатор запроса
+        QMultiMap<qint64, quint64> deadlines_;
+
+        //! @en Requests finished in other threads, waiting for delivery @ru Запросы, завершенные в других потоках и ожидающие передачи
+        QList<QPair<AsyncRequestHandler*, RequestResult> > finished_;
+
+        QTimer deadlineTimer_;
+
+        QElapsedTimer clock_;
+
+        //! @en Finish request, handler is called in thread of AsyncClient @ru Завершает запрос, получатель вызывается в потоке AsyncClient
+        void finish_(quint64 id, Client::RequestError error);
+
+        template<class T>
+        QFuture<AsyncResult<T> > submitFuture_(quint8 unitID, const ProtocolDataUnit& pdu, int pduSize, quint16 regQty,
+                                               bool (*decoder)(const ProtocolDataUnit&, quint16, T&),
+                                               RequestQueue::Priority priority, int timeout);
+
+    public:
+
+        /**
+         * @brief
+         * @en Constructor
+         * @ru Конструктор
+         *
+         * @param
+         * @en queue - queue of line. AsyncClient does not own queue
+         * @ru queue - очередь линии. AsyncClient не владеет очередью
+         */
+        explicit AsyncClient(RequestQueue* queue, QObject* parent = 0);
+
+        RequestQueue* queue() const
+        {
+            return queue_;
+        }
+
+        /**
+         * @brief
+         * @en Send request
+         * @ru Отправляет запрос
+         *
+         * @param
+         * @en handler - receiver of result. Must exist until result is delivered
+         * @ru handler - получатель результата. Должен существовать до получения результата
+         *
+         * @param
+         * @en timeout - time limit including time in queue, ms; 0 - no limit
+         * @ru timeout - ограничение времени, включая время в очереди, мс; 0 - без ограничения
+         *
+         * @return
+         * @en Request identifier
+         * @ru Идентификатор запроса
+         */
+        quint64 submit(quint8 unitID, const ProtocolDataUnit& pdu, int pduSize, AsyncRequestHandler* handler,
+                       RequestQueue::Priority priority = RequestQueue::NormalPriority, int timeout = 0);
+
+        /**
+         * @brief
+         * @en Cancel request, handler is called with CancelledError
+         * @ru Отменяет запрос, получатель вызывается с ошибкой CancelledError
+         *
+         * @return
+         * @en false if request is already finished
+         * @ru false если запрос уже завершен
+         */
+        bool cancel(quint64 id);
+
+        //! @en Cancel all requests @ru Отменяет все запросы
+        void cancelAll();
+
+        int pendingCount() const;
+
+        /**
+         * @brief
+         * @en Read coils
+         * @ru Читает дискретные выходы
+         *
+         * @en Future is completed with decoded values, error and timing. Cancel of
+         * future cancels request. Future is finished in thread of AsyncClient
+         * even when it is cancelled from other thread.
+         *
+         * @ru Результат содержит прочитанные значения, ошибку и время выполнения.
+         * Отмена QFuture отменяет запрос. QFuture завершается в потоке
+         * AsyncClient, даже если он отменен из другого потока.
+         *
+         * @param
+         * @en timeout - time limit including time in queue, ms; 0 - no limit
+         * @ru timeout - ограничение времени, включая время в очереди, мс; 0 - без ограничения
+         */
+        QFuture<AsyncResult<QVector<bool> > > readCoils(quint8 unitID, quint16 regStart, quint16 regQty,
+                                                         RequestQueue::Priority priority = RequestQueue::NormalPriority,
+                                                         int timeout = 0);
+
+        QFuture<AsyncResult<QVector<bool> > > readDescreteInputs(quint8 unitID, quint16 regStart, quint16 regQty,
+                                                                  RequestQueue::Priority priority = RequestQueue::NormalPriority,
+                                                                  int timeout = 0);
+
+        QFuture<AsyncResult<QVector<quint16> > > readHoldingRegisters(quint8 unitID, quint16 regStart, quint16 regQty,
+                                                                       RequestQueue::Priority priority = RequestQueue::NormalPriority,
+                                                                       int timeout = 0);
+
+        QFuture<AsyncResult<QVector<quint16> > > readInputRegisters(quint8 unitID, quint16 regStart, quint16 regQty,
+                                                                     RequestQueue::Priority priority = RequestQueue::NormalPriority,
+                                                                     int timeout = 0);
+
+        QFuture<AsyncResult<bool> > writeSingleCoil(quint8 unitID, quint16 regAddress, bool value,
+                                                    RequestQueue::Priority priority = RequestQueue::NormalPriority,
+                                                    int timeout = 0);
+
+        QFuture<AsyncResult<bool> > writeSingleRegister(quint8 unitID, quint16 regAddress, quint16 value,
+                                                        RequestQueue::Priority priority = RequestQueue::NormalPriority,
+                                                        int timeout = 0);
+
+        QFuture<AsyncResult<bool> > writeMultipleCoils(quint8 unitID, quint16 regStart, const QVector<bool>& values,
+                                                       RequestQueue::Priority priority = RequestQueue::NormalPriority,
+                                                       int timeout = 0);
+
+        QFuture<AsyncResult<bool> > writeMultipleRegisters(quint8 unitID, quint16 regStart, const QVector<quint16>& values,
+                                                           RequestQueue::Priority priority = RequestQueue::NormalPriority,
+                                                           int timeout = 0);
+
+        /**
+         * @brief
+         * @en Form request for reading coils, inputs or registers
+         * @ru Формирует запрос чтения дискретных выходов, входов или регистров
+         *
+         * @return
+         * @en Size of protocol data unit
+         * @ru Размер блока данных протокола
+         */
+        static int readRequest(quint8 function, quint16 regStart, quint16 regQty, ProtocolDataUnit& pdu);
+
+        static int writeSingleCoilRequest(quint16 regAddress, bool value, ProtocolDataUnit& pdu);
+
+        static int writeSingleRegisterRequest(quint16 regAddress, quint16 value, ProtocolDataUnit& pdu);
+
+        static int writeMultipleCoilsRequest(quint16 regStart, const QVector<bool>& values, ProtocolDataUnit& pdu);
+
+        static int writeMultipleRegistersRequest(quint16 regStart, const QVector<quint16>& values, ProtocolDataUnit& pdu);
+
+        /**
+         * @brief
+         * @en Decode values of coils or inputs from response
+         * @ru Извлекает значения дискретных выходов или входов из ответа
+         *
+         * @return
+         * @en false if response is too short
+         * @ru false если ответ слишком короткий
+         */
+        static bool decodeCoils(const ProtocolDataUnit& response, quint16 regQty, QVector<bool>& values);
+
+        static bool decodeRegisters(const ProtocolDataUnit& response, quint16 regQty, QVector<quint16>& values);
+
+        //! @en Decoder of write responses, value is always true @ru Обработка ответов на запись, значение всегда true
+        static bool decodeWrite(const ProtocolDataUnit& response, quint16 regQty, bool& value);
+
+        /**
+         * @brief
+         * @en Fill error, exception code and timing of typed result
+         * @ru Заполняет ошибку, код исключения и время типизированного результата
+         */
+        template<class T>
+        static void fillResult(const RequestResult& result, AsyncResult<T>& typed)
+        {
+            typed.error = result.error;
+            typed.exceptionCode = result.error == Client::ExceptionError ? result.response.data[0] : 0;
+            typed.queueTime = result.queueTime;
+            typed.transactionTime = result.transactionTime;
+        }
+
+    private slots:
+
+        void queueFinished_(const modbus4qt::RequestResult& result);
+
+        void checkDeadlines_();
+
+        //! @en Call handlers of requests finished in other threads @ru Вызывает получателей запросов, завершенных в других потоках
+        void deliverFinished_();
+
+        void scheduleDeadlineTimer_();
+
+        //! @en QFuture of request is cancelled by user @ru QFuture запроса отменен пользователем
+        void futureCanceled_();
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_ASYNC_CLIENT_H
@@ -0,0 +1,408 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_AWAITABLE_CLIENT_H
+#define MODBUS4QT_AWAITABLE_CLIENT_H
+
+//
+// C++20 coroutine interface for asynchronous client. The library itself does
+// not require C++20, this header is used only by applications built with
+// coroutine support (qmake: CONFIG += c++2a).
+//
+// Интерфейс сопрограмм C++20 для асинхронного клиента. Сама библиотека не
+// требует C++20, этот заголовочный файл используется только приложениями,
+// собираемыми с поддержкой сопрограмм (qmake: CONFIG += c++2a).
+//
+
+#if !defined(__cpp_impl_coroutine) && !defined(__cpp_coroutines)
+#error "awaitable_client.h requires compiler with C++20 coroutine support"
+#endif
+
+#include "async_client.h"
+
+#include <QTimer>
+
+#include <coroutine>
+#include <exception>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Return type of coroutine which runs by itself and returns nothing
+ * @ru Тип возвращаемого значения сопрограммы, которая выполняется самостоятельно и ничего не возвращает
+ *
+ * @en Coroutine starts at once and runs until first co_await, then continues
+ * from event loop of its thread.
+ *
+ * @ru Сопрограмма запускается сразу и выполняется до первого co_await, затем
+ * продолжается из цикла обработки событий своего потока.
+ */
+struct AsyncTask
+{
+    struct promise_type
+    {
+        AsyncTask get_return_object()
+        {
+            return AsyncTask();
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+/**
+ * @brief
+ * @en Awaitable request
+ * @ru Ожидаемый запрос
+ *
+ * @en Result of co_await is AsyncResult<T>. Request is sent when coroutine is
+ * suspended and coroutine is resumed from event loop when result is ready.
+ *
+ * @ru Результатом co_await является AsyncResult<T>. Запрос отправляется при
+ * приостановке сопрограммы, сопрограмма продолжается из цикла обработки
+ * событий, когда результат готов.
+ */
+template<class T>
+class RequestAwaiter : public AsyncRequestHandler
+{
+    public:
+
+        //! @en Function to decode value from response @ru Функция извлечения значения из ответа
+        typedef bool (*Decoder)(const ProtocolDataUnit& response, quint16 regQty, T& value);
+
+    private:
+
+        AsyncClient* client_;
+
+        quint8 unitID_;
+
+        ProtocolDataUnit pdu_;
+
+        int pduSize_;
+
+        quint16 regQty_;
+
+        Decoder decoder_;
+
+        RequestQueue::Priority priority_;
+
+        int timeout_;
+
+        CancellationToken* token_;
+
+        quint64 id_;
+
+        AsyncResult<T> result_;
+
+        std::coroutine_handle<> handle_;
+
+    public:
+
+        RequestAwaiter(AsyncClient* client, quint8 unitID, const ProtocolDataUnit& pdu, int pduSize, quint16 regQty,
+                       Decoder decoder, RequestQueue::Priority priority, int timeout)
+            : client_(client),
+              unitID_(unitID),
+              pdu_(pdu),
+              pduSize_(pduSize),
+              regQty_(regQty),
+              decoder_(decoder),
+              priority_(priority),
+              timeout_(timeout),
+              token_(0),
+              id_(0)
+        {
+        }
+
+        //! @en Set priority class of request @ru Устанавливает класс приоритета запроса
+        RequestAwaiter& withPriority(RequestQueue::Priority priority)
+        {
+            priority_ = priority;
+            return *this;
+        }
+
+        //! @en Set time limit including time in queue, ms @ru Устанавливает ограничение времени, включая время в очереди, мс
+        RequestAwaiter& withTimeout(int timeout)
+        {
+            timeout_ = timeout;
+            return *this;
+        }
+
+        //! @en Register request in cancellation token @ru Регистрирует запрос в объекте отмены
+        RequestAwaiter& withCancellation(CancellationToken& token)
+        {
+            token_ = &token;
+            return *this;
+        }
+
+        bool await_ready()
+        {
+            if (token_ && token_->isCancelled())
+            {
+                result_.error = Client::CancelledError;
+                return true;
+            }
+
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            handle_ = handle;
+            id_ = client_->submit(unitID_, pdu_, pduSize_, this, priority_, timeout_);
+
+            if (token_)
+                token_->add(client_, id_);
+        }
+
+        AsyncResult<T> await_resume()
+        {
+            return result_;
+        }
+
+        virtual void requestFinished(const RequestResult& result)
+        {
+            if (token_)
+                token_->remove(client_, id_);
+
+            AsyncClient::fillResult(result, result_);
+
+            if (result_.isOk() && !decoder_(result.response, regQty_, result_.value))
+                result_.error = Client::ResponseError;
+
+            handle_.resume();
+        }
+};
+
+/**
+ * @brief
+ * @en Awaitable pause
+ * @ru Ожидаемая пауза
+ *
+ * @en Coroutine is resumed by timer of its thread.
+ * @ru Сопрограмма продолжается по таймеру своего потока.
+ */
+class DelayAwaiter
+{
+    private:
+
+        int msec_;
+
+    public:
+
+        explicit DelayAwaiter(int msec)
+            : msec_(msec)
+        {
+        }
+
+        bool await_ready() const
+        {
+            return msec_ <= 0;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            QTimer::singleShot(msec_, [handle]() { handle.resume(); });
+        }
+
+        void await_resume()
+        {
+        }
+};
+
+//! @en Pause coroutine, e.g. between polling cycles @ru Приостанавливает сопрограмму, например между циклами опроса
+inline DelayAwaiter
+delay(int msec)
+{
+    return DelayAwaiter(msec);
+}
+
+/**
+ * @brief
+ * @en Awaitable operations with one unit
+ * @ru Ожидаемые операции с одним устройством
+ *
+ * @en Example:
+ * @ru Пример:
+ *
+ * @code
+ * AsyncTask poll(AwaitableClient meter)
+ * {
+ *     forever
+ *     {
+ *         AsyncResult<QVector<quint16> > result = co_await meter.readHoldingRegistersAsync(0, 10).withTimeout(200);
+ *
+ *         if (result.isOk())
+ *             process(result.value);
+ *         else if (result.error == Client::ExceptionError)
+ *             report(result.exceptionCode);
+ *
+ *         co_await delay(1000);
+ *     }
+ * }
+ * @endcode
+ */
+class AwaitableClient
+{
+    private:
+
+        AsyncClient* client_;
+
+        quint8 unitID_;
+
+        RequestQueue::Priority priority_;
+
+        int timeout_;
+
+    public:
+
+        /**
+         * @brief
+         * @en Constructor
+         * @ru Конструктор
+         *
+         * @param
+         * @en timeout - default time limit of requests, ms; 0 - no limit
+         * @ru timeout - ограничение времени запросов по умолчанию, мс; 0 - без ограничения
+         */
+        AwaitableClient(AsyncClient* client, quint8 unitID,
+                        RequestQueue::Priority priority = RequestQueue::NormalPriority, int timeout = 0)
+            : client_(client),
+              unitID_(unitID),
+              priority_(priority),
+              timeout_(timeout)
+        {
+        }
+
+        quint8 unitID() const
+        {
+            return unitID_;
+        }
+
+        RequestAwaiter<QVector<bool> > readCoilsAsync(quint16 regStart, quint16 regQty)
+        {
+            return readBits_(Functions::ReadCoils, regStart, regQty);
+        }
+
+        RequestAwaiter<QVector<bool> > readDescreteInputsAsync(quint16 regStart, quint16 regQty)
+        {
+            return readBits_(Functions::ReadDescereteInputs, regStart, regQty);
+        }
+
+        RequestAwaiter<QVector<quint16> > readHoldingRegistersAsync(quint16 regStart, quint16 regQty)
+        {
+            return readRegisters_(Functions::ReadHoldingRegisters, regStart, regQty);
+        }
+
+        RequestAwaiter<QVector<quint16> > readInputRegistersAsync(quint16 regStart, quint16 regQty)
+        {
+            return readRegisters_(Functions::ReadInputRegisters, regStart, regQty);
+        }
+
+        RequestAwaiter<bool> writeSingleCoilAsync(quint16 regAddress, bool value)
+        {
+            ProtocolDataUnit pdu;
+            int pduSize = AsyncClient::writeSingleCoilRequest(regAddress, value, pdu);
+
+            return write_(pdu, pduSize);
+        }
+
+        RequestAwaiter<bool> writeSingleRegisterAsync(quint16 regAddress, quint16 value)
+        {
+            ProtocolDataUnit pdu;
+            int pduSize = AsyncClient::writeSingleRegisterRequest(regAddress, value, pdu);
+
+            return write_(pdu, pduSize);
+        }
+
+        RequestAwaiter<bool> writeMultipleCoilsAsync(quint16 regStart, const QVector<bool>& values)
+        {
+            ProtocolDataUnit pdu;
+            int pduSize = AsyncClient::writeMultipleCoilsRequest(regStart, values, pdu);
+
+            return write_(pdu, pduSize);
+        }
+
+        RequestAwaiter<bool> writeMultipleRegistersAsync(quint16 regStart, const QVector<quint16>& values)
+        {
+            ProtocolDataUnit pdu;
+            int pduSize = AsyncClient::writeMultipleRegistersRequest(regStart, values, pdu);
+
+            return write_(pdu, pduSize);
+        }
+
+    private:
+
+        RequestAwaiter<QVector<bool> > readBits_(quint8 function, quint16 regStart, quint16 regQty)
+        {
+            regQty = qMin(regQty, quint16(MaxCoilsForRead));
+
+            ProtocolDataUnit pdu;
+            int pduSize = AsyncClient::readRequest(function, regStart, regQty, pdu);
+
+            return RequestAwaiter<QVector<bool> >(client_, unitID_, pdu, pduSize, regQty,
+                                                  &AsyncClient::decodeCoils, priority_, timeout_);
+        }
+
+        RequestAwaiter<QVector<quint16> > readRegisters_(quint8 function, quint16 regStart, quint16 regQty)
+        {
+            regQty = qMin(regQty, quint16(MaxRegistersForRead));
+
+            ProtocolDataUnit pdu;
+            int pduSize = AsyncClient::readRequest(function, regStart, regQty, pdu);
+
+            return RequestAwaiter<QVector<quint16> >(client_, unitID_, pdu, pduSize, regQty,
+                                                     &AsyncClient::decodeRegisters, priority_, timeout_);
+        }
+
+        RequestAwaiter<bool> write_(const ProtocolDataUnit& pdu, int pduSize)
+        {
+            return RequestAwaiter<bool>(client_, unitID_, pdu, pduSize, 0,
+                                        &AsyncClient::decodeWrite, priority_, timeout_);
+        }
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_AWAITABLE_CLIENT_H
@@ -32,6 +32,7 @@
 #include "utils.h"
 
 #include <QDataStream>
+#include <QElapsedTimer>
 #include <QIODevice>
 #include <QVector>
 
@@ -40,12 +41,71 @@
 namespace modbus4qt
 {
 
+/**
+ * @brief
+ * @en Read block by several requests of blockSize items
+ * @ru Читает блок несколькими запросами по blockSize элементов
+ */
+template<typename T>
+static bool
+readInBlocks(Client* client, bool (Client::*read)(quint16, quint16, QVector<T>&),
+             quint16 regStart, quint16 regQty, int blockSize, QVector<T>& values)
+{
+    QVector<T> result;
+    result.reserve(regQty);
+
+    for (int offset = 0; offset < regQty; offset += blockSize)
+    {
+        QVector<T> block;
+
+        if (!(client->*read)(regStart + offset, qMin(blockSize, regQty - offset), block))
+            return false;
+
+        result += block;
+    }
+
+    values = result;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief
+ * @en Write block by several requests of blockSize items
+ * @ru Записывает блок несколькими запросами по blockSize элементов
+ */
+template<typename T>
+static bool
+writeInBlocks(Client* client, bool (Client::*write)(quint16, const QVector<T>&),
+              quint16 regStart, const QVector<T>& values, int blockSize)
+{
+    for (int offset = 0; offset < values.size(); offset += blockSize)
+    {
+        if (!(client->*write)(regStart + offset, values.mid(offset, blockSize)))
+            return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
 Client::Client(QObject *parent) :
     QObject(parent),
     ioDevice_(NULL),
     readTimeout_(5000),
     writeTimeout_(5000),
-    unitID_(0)
+    unitID_(0),
+    adaptiveTimeout_(false),
+    quarantineEnabled_(false),
+    lastError_(NoError),
+    lastExceptionCode_(Exceptions::Ok),
+    scatterReadFunction_(DefaultScatterReadFunction),
+    readCoalescingGap_(0),
+    trafficCapture_(NULL),
+    capturePeer_(0)
 {
 }
 
@@ -68,6 +128,11 @@ Client::readCoil(quint16 regNo, bool& value)
 bool
 Client::readCoils(quint16 regStart, quint16 regQty, QVector<bool>& values)
 {
+    const DeviceProfile* profile = deviceProfile(unitID_);
+
+    if (profile && (regQty > profile->maxReadQuantity(DeviceProfile::Coils)))
+        return readInBlocks<bool>(this, &Client::readCoils, regStart, regQty, profile->maxReadQuantity(DeviceProfile::Coils), values);
+
     ProtocolDataUnit requestPDU;
     int requestPDUSize = 0;
 
@@ -110,6 +175,11 @@ Client::readCoils(quint16 regStart, quint16 regQty, QVector<bool>& values)
 bool
 Client::readDescreteInputs(quint16 regStart, quint16 regQty, QVector<bool>& values)
 {
+    const DeviceProfile* profile = deviceProfile(unitID_);
+
+    if (profile && (regQty > profile->maxReadQuantity(DeviceProfile::DiscreteInputs)))
+        return readInBlocks<bool>(this, &Client::readDescreteInputs, regStart, regQty, profile->maxReadQuantity(DeviceProfile::DiscreteInputs), values);
+
     ProtocolDataUnit requestPDU;
     int requestPDUSize = 0;
 
@@ -207,6 +277,11 @@ Client::readHoldingRegister(quint16 regNo, quint16& value)
 bool
 Client::readHoldingRegisters(quint16 regStart, quint16 regQty, QVector<quint16>& values)
 {
+    const DeviceProfile* profile = deviceProfile(unitID_);
+
+    if (profile && (regQty > profile->maxReadQuantity(DeviceProfile::HoldingRegisters)))
+        return readInBlocks<quint16>(this, &Client::readHoldingRegisters, regStart, regQty, profile->maxReadQuantity(DeviceProfile::HoldingRegisters), values);
+
     ProtocolDataUnit requestPDU;
     int requestPDUSize = 0;
 
@@ -267,6 +342,11 @@ Client::readInputRegister(quint16 regNo, quint16& value)
 bool
 Client::readInputRegisters(quint16 regStart, quint16 regQty, QVector<quint16>& values)
 {
+    const DeviceProfile* profile = deviceProfile(unitID_);
+
+    if (profile && (regQty > profile->maxReadQuantity(DeviceProfile::InputRegisters)))
+        return readInBlocks<quint16>(this, &Client::readInputRegisters, regStart, regQty, profile->maxReadQuantity(DeviceProfile::InputRegisters), values);
+
     ProtocolDataUnit requestPDU;
     int requestPDUSize = 0;
 
@@ -365,57 +445,41 @@ Client::readInputRegisters(quint16 regStart, quint16 regQty, QVector<quint16>& v
 //-----------------------------------------------------------------------------
 
 bool
-Client::sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUSize, ProtocolDataUnit* responsePDU)
+Client::admitRequest_()
 {
-    QByteArray adu = prepareADU_(requestPDU, requestPDUSize);
-
-    qDebug() << "Sending data: " << adu.toHex();
-
-    qint64 bytesWritten = ioDevice_->write(adu);
-    if (bytesWritten <= 0)
-    {
-        emit errorMessage(tr("Failed to write data for unit %2, error: %1").arg(ioDevice_->errorString()).arg(unitID_));
-        return false;
-    }
-    else if (bytesWritten < adu.size())
-    {
-        emit errorMessage(tr("Failed to write all data unit %2, error: %1").arg(ioDevice_->errorString()).arg(unitID_));
-        return false;
-    }
-    else if (!ioDevice_->waitForBytesWritten(writeTimeout_))
-    {
-        qDebug() << "Write timeout!";
-        emit errorMessage(tr("Write timeout for unit #%2, error: %1").arg(ioDevice_->errorString()).arg(unitID_));
-        return false;
-    }
-
-    qDebug() << "Read timeout: " << readTimeout_ << " ms";
+    // Broadcast requests have no response, so health of unit is unknown
+    if (!quarantineEnabled_ || unitID_ == BroadcastUnitId)
+        return true;
 
-    bool result = ioDevice_->waitForReadyRead(readTimeout_);
-    if (!result)
-    {
-        emit errorMessage(tr("Read timeout for unit #%2, error: %1").arg(ioDevice_->errorString()).arg(unitID_));
-        return false;
-    }
+    if (unitHealth_.admit(unitID_))
+        return true;
 
-    QByteArray inArray = readResponse_();
+    lastError_ = QuarantineError;
+    emit errorMessage(unitID_, tr("Unit #%1 is in quarantine, next probe in %2 ms!").arg(unitID_).arg(unitHealth_.timeToProbe(unitID_)));
 
-    qDebug() << "Readed data: " << inArray.toHex();
+    return false;
+}
 
-    *responsePDU = processADU_(inArray);
+//-----------------------------------------------------------------------------
 
-    if (requestPDU.functionCode == responsePDU->functionCode)
+bool
+Client::checkResponse_(const ProtocolDataUnit& requestPDU, const ProtocolDataUnit& responsePDU)
+{
+    if (requestPDU.functionCode == responsePDU.functionCode)
     {
         return true;
     }
     else
     {
-        if ((requestPDU.functionCode | 0x80) == responsePDU->functionCode)
+        if ((requestPDU.functionCode | 0x80) == responsePDU.functionCode)
         {
-            switch (responsePDU->functionCode - 0x80)
+            lastError_ = ExceptionError;
+            lastExceptionCode_ = responsePDU.data[0];
+
+            switch (responsePDU.data[0])
             {
                 case Exceptions::IllegalFunction :
-                    emit errorMessage(tr("Illegal function for unit #1%1!").arg(unitID_));
+                    emit errorMessage(tr("Illegal function for unit #%1!").arg(unitID_));
                 break;
                 case Exceptions::IllegalDataAddress :
                     emit errorMessage(tr("Illegal data address for unit #%1!").arg(unitID_));
@@ -447,6 +511,7 @@ Client::sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUS
         }
         else
         {
+            lastError_ = ResponseError;
             emit errorMessage(tr("Response mismatch for unit #%1!").arg(unitID_));
         }
         return false;
@@ -455,6 +520,77 @@ Client::sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUS
 
 //-----------------------------------------------------------------------------
 
+bool
+Client::sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUSize, ProtocolDataUnit* responsePDU)
+{
+    if (!admitRequest_())
+        return false;
+
+    lastError_ = NoError;
+    lastExceptionCode_ = Exceptions::Ok;
+
+    // Request is admitted, so its failure is registered as well, otherwise
+    // probe of unit in quarantine will never finish
+    //
+    // Запрос разрешен, поэтому его ошибка тоже учитывается, иначе проверка
+    // устройства в карантине никогда не завершится
+    //
+    if (!writeRequest_(requestPDU, requestPDUSize))
+    {
+        updateUnitHealth_(false);
+        return false;
+    }
+
+    int timeout = responseTimeout(unitID_);
+
+    qDebug() << "Read timeout: " << timeout << " ms";
+
+    QElapsedTimer clock;
+    clock.start();
+
+    bool result = ioDevice_->waitForReadyRead(timeout);
+
+    QByteArray inArray;
+    if (result)
+        inArray = readResponse_(qMax(0, timeout - int(clock.elapsed())));
+
+    if (inArray.isEmpty())
+    {
+        if (adaptiveTimeout_)
+            rttEstimator_.addTimeout(unitID_, timeout);
+
+        updateUnitHealth_(false);
+
+        lastError_ = TimeoutError;
+        emit errorMessage(tr("Read timeout for unit #%2, error: %1").arg(ioDevice_->errorString()).arg(unitID_));
+        return false;
+    }
+
+    qDebug() << "Readed data: " << inArray.toHex();
+
+    captureFrame_(false, inArray);
+
+    *responsePDU = processADU_(inArray);
+
+    // Exception is valid response too, so it is counted in round trip time
+    // and unit is alive
+    if ((responsePDU->functionCode & 0x7F) == requestPDU.functionCode)
+    {
+        if (adaptiveTimeout_)
+            rttEstimator_.addSample(unitID_, clock.nsecsElapsed() / 1000);
+
+        updateUnitHealth_(true);
+    }
+    else
+    {
+        updateUnitHealth_(false);
+    }
+
+    return checkResponse_(requestPDU, *responsePDU);
+}
+
+//-----------------------------------------------------------------------------
+
 bool
 Client::sendRequestToServer_(const ProtocolDataUnit &pdu, int pduSize)
 {
@@ -464,9 +600,89 @@ Client::sendRequestToServer_(const ProtocolDataUnit &pdu, int pduSize)
 
 //-----------------------------------------------------------------------------
 
+void
+Client::updateUnitHealth_(bool responded)
+{
+    if (!quarantineEnabled_ || unitID_ == BroadcastUnitId)
+        return;
+
+    if (responded)
+    {
+        bool wasQuarantined = unitHealth_.isQuarantined(unitID_);
+        unitHealth_.addSuccess(unitID_);
+
+        if (wasQuarantined)
+            emit unitRecovered(unitID_);
+    }
+    else if (unitHealth_.addFailure(unitID_))
+    {
+        emit unitQuarantined(unitID_);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Client::writeRequest_(const ProtocolDataUnit& requestPDU, int requestPDUSize)
+{
+    QByteArray adu = prepareADU_(requestPDU, requestPDUSize);
+
+    qDebug() << "Sending data: " << adu.toHex();
+
+    captureFrame_(true, adu);
+
+    qint64 bytesWritten = ioDevice_->write(adu);
+    if (bytesWritten <= 0)
+    {
+        lastError_ = WriteError;
+        emit errorMessage(tr("Failed to write data for unit %2, error: %1").arg(ioDevice_->errorString()).arg(unitID_));
+        return false;
+    }
+    else if (bytesWritten < adu.size())
+    {
+        lastError_ = WriteError;
+        emit errorMessage(tr("Failed to write all data unit %2, error: %1").arg(ioDevice_->errorString()).arg(unitID_));
+        return false;
+    }
+    else if (!ioDevice_->waitForBytesWritten(writeTimeout_))
+    {
+        qDebug() << "Write timeout!";
+        lastError_ = WriteError;
+        emit errorMessage(tr("Write timeout for unit #%2, error: %1").arg(ioDevice_->errorString()).arg(unitID_));
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
 bool
 Client::writeMultipleCoils(quint16 regStart, const QVector<bool>& values)
 {
+    const DeviceProfile* profile = deviceProfile(unitID_);
+
+    if (profile)
+    {
+        // Unit without function 0x0F is written coil by coil
+        //
+        // Устройство без функции 0x0F записывается по одному выходу
+        //
+        if (!profile->isFunctionSupported(Functions::WriteMultipleCoils))
+        {
+            for (int i = 0; i < values.size(); ++i)
+            {
+                if (!writeSingleCoil(regStart + i, values[i]))
+                    return false;
+            }
+
+            return true;
+        }
+
+        if (values.size() > profile->maxWriteQuantity(DeviceProfile::Coils))
+            return writeInBlocks<bool>(this, &Client::writeMultipleCoils, regStart, values, profile->maxWriteQuantity(DeviceProfile::Coils));
+    }
+
     ProtocolDataUnit requestPDU;
     int requestPDUSize = 0;
 
@@ -491,7 +707,7 @@ Client::writeMultipleCoils(quint16 regStart, const QVector<bool>& values)
     requestPDU.data[4] = (regQty + 7) / 8;
 
     // Values
-    putCoilsIntoBuffer(requestPDU.data + 5, values);
+    putCoilsIntoBuffer(requestPDU.data + 5, values.mid(0, regQty));
 
     // PDU size: 6 bytes + bytes needed for values to write
     requestPDUSize = 6 + requestPDU.data[4];
@@ -504,6 +720,30 @@ Client::writeMultipleCoils(quint16 regStart, const QVector<bool>& values)
 bool
 Client::writeMultipleRegisters(quint16 regStart, const QVector<quint16> &values)
 {
+    const DeviceProfile* profile = deviceProfile(unitID_);
+
+    if (profile)
+    {
+        // Unit without function 0x10 is written register by register
+        //
+        // Устройство без функции 0x10 записывается по одному регистру
+        //
+        if (!profile->isFunctionSupported(Functions::WriteMultipleRegisters))
+        {
+            for (int i = 0; i < values.size(); ++i)
+            {
+                if (!writeSingleRegister(regStart + i, values[i]))
+                    return false;
+            }
+
+            return true;
+        }
+
+        if (values.size() > profile->maxWriteQuantity(DeviceProfile::HoldingRegisters))
+            return writeInBlocks<quint16>(this, &Client::writeMultipleRegisters, regStart, values,
+                                          profile->maxWriteQuantity(DeviceProfile::HoldingRegisters));
+    }
+
     ProtocolDataUnit requestPDU;
     int requestPDUSize = 0;
 
@@ -528,7 +768,7 @@ Client::writeMultipleRegisters(quint16 regStart, const QVector<quint16> &values)
     requestPDU.data[4] = regQty * 2;
 
     // Values
-    putRegistersIntoBuffer(requestPDU.data + 5, values);
+    putRegistersIntoBuffer(requestPDU.data + 5, values.mid(0, regQty));
 
     // PDU size: 6 bytes + bytes needed for values to write
     requestPDUSize = 6 + requestPDU.data[4];
@@ -648,6 +888,78 @@ Client::writeSingleRegister(quint16 regAddress, quint16 value)
 
 //-----------------------------------------------------------------------------
 
+bool
+Client::readDeviceIdentification(QMap<quint8, QByteArray>& objects, quint8 readCode)
+{
+    objects.clear();
+
+    quint8 objectId = 0;
+
+    forever
+    {
+        ProtocolDataUnit requestPDU;
+
+        requestPDU.functionCode = Functions::EncapsulatedInterfaceTransport;
+        requestPDU.data[0] = MeiReadDeviceIdentification;
+        requestPDU.data[1] = readCode;
+        requestPDU.data[2] = objectId;
+
+        ProtocolDataUnit responsePDU;
+
+        if (!sendRequestToServer_(requestPDU, 4, &responsePDU))
+            return false;
+
+        /*
+         * +------+------+-------------+------------+----------+-------+-----------------+
+         * | MEI  | Code | Conformity  | More       | Next     | Count | Id, Len, Value  |
+         * +------+------+-------------+------------+----------+-------+-----------------+
+         */
+        if (responsePDU.data[0] != MeiReadDeviceIdentification)
+        {
+            lastError_ = ResponseError;
+            emit errorMessage(tr("Response mismatch for unit #%1!").arg(unitID_));
+            return false;
+        }
+
+        bool moreFollows = (responsePDU.data[3] == 0xFF);
+        quint8 nextObjectId = responsePDU.data[4];
+        int count = responsePDU.data[5];
+
+        int offset = 6;
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (offset + 2 > PDUDataMaxSize)
+                break;
+
+            quint8 id = responsePDU.data[offset];
+            int length = responsePDU.data[offset + 1];
+            offset += 2;
+
+            if (offset + length > PDUDataMaxSize)
+            {
+                lastError_ = ResponseError;
+                emit errorMessage(tr("Wrong device identification object from unit #%1!").arg(unitID_));
+                return false;
+            }
+
+            objects.insert(id, QByteArray((const char*)responsePDU.data + offset, length));
+            offset += length;
+        }
+
+        // Next object ID must grow, otherwise device would be asked forever
+        //
+        // Идентификатор следующего объекта должен расти, иначе устройство опрашивалось бы бесконечно
+        //
+        if (!moreFollows || (nextObjectId <= objectId))
+            return true;
+
+        objectId = nextObjectId;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
 bool
 Client::userDefinedFunction(quint8 function, const QVector<quint8>& data, QVector<quint8>& retData)
 {
@@ -660,7 +972,7 @@ Client::userDefinedFunction(quint8 function, const QVector<quint8>& data, QVecto
     for (quint16 i = 0; (i < data.size()) && (i < PDUDataMaxSize); ++i)
         pdu.data[i] = data[i];
 
-    pduSize = 1 + data.size();
+    pduSize = 1 + qMin(data.size(), PDUDataMaxSize);
 
     ProtocolDataUnit replyPdu;
     bool isOk = sendRequestToServer_(pdu, pduSize, &replyPdu);
@@ -671,7 +983,7 @@ Client::userDefinedFunction(quint8 function, const QVector<quint8>& data, QVecto
     {
         retData.clear();
         for (int i = 0; i < PDUDataMaxSize; ++i)
-            retData.append(pdu.data[i]);
+            retData.append(replyPdu.data[i]);
 
         return true;
     }
@@ -692,7 +1004,7 @@ Client::userDefinedFunction(quint8 function, quint8 subFunction, const QVector<q
     for (quint16 i = 0; (i < data.size()) && (i < (PDUDataMaxSize - 1)); ++i)
         pdu.data[i + 1] = data[i];
 
-    pduSize = 2 + data.size();
+    pduSize = 2 + qMin(data.size(), PDUDataMaxSize - 1);
 
     ProtocolDataUnit replyPdu;
     bool isOk = sendRequestToServer_(pdu, pduSize, &replyPdu);
@@ -711,4 +1023,219 @@ Client::userDefinedFunction(quint8 function, quint8 subFunction, const QVector<q
 
 //-----------------------------------------------------------------------------
 
+/**
+ * @en Read one range by standard function
+ * @ru Читает один диапазон стандартной функцией
+ */
+static bool
+readRange(Client* client, ReadRange& range)
+{
+    switch (range.function)
+    {
+        case Functions::ReadCoils :
+            return client->readCoils(range.start, range.quantity, range.bits);
+
+        case Functions::ReadDescereteInputs :
+            return client->readDescreteInputs(range.start, range.quantity, range.bits);
+
+        case Functions::ReadHoldingRegisters :
+            return client->readHoldingRegisters(range.start, range.quantity, range.registers);
+
+        default :
+            return client->readInputRegisters(range.start, range.quantity, range.registers);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @en Coalesce and split ranges of every table by profile of unit
+ * @ru Объединяет и разделяет диапазоны каждой таблицы по профилю устройства
+ */
+static QList<ReadRange>
+planRanges(const DeviceProfile& profile, const QList<ReadRange>& ranges, int maxGap)
+{
+    QList<ReadRange> blocks;
+
+    for (int table = 0; table < DeviceProfile::TableCount; ++table)
+    {
+        const quint8 function = DeviceProfile::readFunction(DeviceProfile::Table(table));
+
+        QList<DeviceProfile::Range> wanted;
+        foreach (const ReadRange& range, ranges)
+        {
+            if (range.function == function)
+                wanted.append(DeviceProfile::Range(range.start, range.start + range.quantity - 1));
+        }
+
+        if (wanted.isEmpty())
+            continue;
+
+        foreach (const DeviceProfile::Range& block, profile.planReads(DeviceProfile::Table(table), wanted, maxGap))
+            blocks.append(ReadRange(function, block.start, block.count()));
+    }
+
+    return blocks;
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @en Take values of range from blocks read
+ * @ru Берет значения диапазона из прочитанных блоков
+ */
+static void
+fillFromBlocks(const QList<ReadRange>& blocks, ReadRange& range)
+{
+    if (range.isBits())
+        range.bits.resize(range.quantity);
+    else
+        range.registers.resize(range.quantity);
+
+    const int end = range.start + range.quantity;
+
+    foreach (const ReadRange& block, blocks)
+    {
+        if (block.function != range.function)
+            continue;
+
+        const int from = qMax(int(range.start), int(block.start));
+        const int to = qMin(end, block.start + block.quantity);
+
+        for (int address = from; address < to; ++address)
+        {
+            if (range.isBits())
+                range.bits[address - range.start] = block.bits.at(address - block.start);
+            else
+                range.registers[address - range.start] = block.registers.at(address - block.start);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Client::readRanges(QList<ReadRange>& ranges)
+{
+    for (int i = 0; i < ranges.size(); ++i)
+    {
+        if (!ranges.at(i).isValid())
+        {
+            lastError_ = ResponseError;
+            emit errorMessage(tr("Invalid range #%1 for unit #%2!").arg(i).arg(unitID_));
+            return false;
+        }
+    }
+
+    const DeviceProfile* profile = deviceProfile(unitID_);
+    bool useScatter = profile && (profile->functionSupport(scatterReadFunction_) == DeviceProfile::Supported);
+
+    // Ranges of unit with profile are coalesced and split by its limits, then
+    // blocks planned are read instead of ranges
+    //
+    // Диапазоны устройства с профилем объединяются и разделяются по его
+    // ограничениям, после чего вместо диапазонов читаются запланированные блоки
+    //
+    const bool isPlanned = (profile != 0);
+
+    QList<ReadRange> planned;
+    if (isPlanned)
+        planned = planRanges(*profile, ranges, readCoalescingGap_);
+
+    QList<ReadRange>& requests = isPlanned ? planned : ranges;
+
+    int first = 0;
+
+    while (first < requests.size())
+    {
+        if (!useScatter)
+        {
+            if (!readRange(this, requests[first]))
+                return false;
+
+            ++first;
+            continue;
+        }
+
+        // Pack as many ranges as fit into request and response
+        //
+        // Упаковываем столько диапазонов, сколько умещается в запрос и ответ
+        //
+        QVector<quint8> request;
+        request.append(0);
+
+        int byteCount = 0;
+        int last = first;
+
+        while ((last < requests.size()) && (last - first < ScatterReadMaxRanges) &&
+               (2 + byteCount + requests.at(last).responseSize() <= PDUMaxSize))
+        {
+            const ReadRange& range = requests.at(last);
+
+            request.append(range.function);
+            request.append(hi(range.start));
+            request.append(lo(range.start));
+            request.append(hi(range.quantity));
+            request.append(lo(range.quantity));
+
+            byteCount += range.responseSize();
+            ++last;
+        }
+
+        request[0] = last - first;
+
+        QVector<quint8> response;
+
+        if (!userDefinedFunction(scatterReadFunction_, request, response))
+        {
+            // Unit has lost the function, e.g. after firmware update
+            //
+            // Устройство утратило функцию, например после обновления прошивки
+            //
+            if ((lastError_ == ExceptionError) && (lastExceptionCode_ == Exceptions::IllegalFunction))
+            {
+                deviceProfiles_[unitID_].setFunctionSupport(scatterReadFunction_, DeviceProfile::Unsupported);
+                useScatter = false;
+                continue;
+            }
+
+            return false;
+        }
+
+        if (response.at(0) != byteCount)
+        {
+            lastError_ = ResponseError;
+            emit errorMessage(tr("Response mismatch for unit #%1!").arg(unitID_));
+            return false;
+        }
+
+        int offset = 1;
+
+        for (int i = first; i < last; ++i)
+        {
+            ReadRange& range = requests[i];
+            QByteArray buffer((const char*)response.constData() + offset, range.responseSize());
+
+            if (range.isBits())
+                range.bits = getCoilsFromBuffer(buffer, range.quantity);
+            else
+                range.registers = getRegistersFromBuffer(buffer, range.quantity);
+
+            offset += range.responseSize();
+        }
+
+        first = last;
+    }
+
+    if (isPlanned)
+    {
+        for (int i = 0; i < ranges.size(); ++i)
+            fillFromBlocks(planned, ranges[i]);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
 } // namespace modbus4qt
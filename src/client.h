@@ -31,11 +31,18 @@
 #ifndef MODBUS4QT_CLIENT_H
 #define MODBUS4QT_CLIENT_H
 
+#include <QHash>
+#include <QMap>
 #include <QObject>
 
 #include "global.h"
 #include "consts.h"
+#include "device_profile.h"
+#include "rtt_estimator.h"
+#include "scatter_read.h"
+#include "traffic_capture.h"
 #include "types.h"
+#include "unit_health.h"
 
 class QIODevice;
 
@@ -79,6 +86,40 @@ class MODBUS4QT_EXPORT Client : public QObject
 {
     Q_OBJECT
 
+    public:
+
+        /**
+         * @brief
+         * @en Result of last request
+         * @ru Результат последнего запроса
+         */
+        enum RequestError
+        {
+            //! @en Request successful @ru Запрос выполнен успешно
+            NoError,
+
+            //! @en Port is not open or not connected to server @ru Порт не открыт или нет подключения к серверу
+            ConnectionError,
+
+            //! @en Request was not written @ru Запрос не передан
+            WriteError,
+
+            //! @en No response from unit @ru Нет ответа от устройства
+            TimeoutError,
+
+            //! @en Response does not match request @ru Ответ не соответствует запросу
+            ResponseError,
+
+            //! @en Unit responded with exception @ru Устройство ответило исключением
+            ExceptionError,
+
+            //! @en Unit is in quarantine, request was not sent @ru Устройство в карантине, запрос не отправлялся
+            QuarantineError,
+
+            //! @en Asynchronous request was cancelled @ru Асинхронный запрос отменен
+            CancelledError
+        };
+
     protected:
 
         /**
@@ -124,8 +165,130 @@ class MODBUS4QT_EXPORT Client : public QObject
          */
         quint8 unitID_;
 
+        /**
+         * @brief
+         * @en Use timeout calculated from round trip time of every unit
+         * @ru Использовать время ожидания, вычисленное по времени обмена с каждым устройством
+         *
+         * @en Default value: false
+         * @ru Значение по умолчанию: ложь
+         */
+        bool adaptiveTimeout_;
+
+        /**
+         * @brief
+         * @en Round trip time statistics of units
+         * @ru Статистика времени обмена с устройствами
+         */
+        RttEstimator rttEstimator_;
+
+        /**
+         * @brief
+         * @en Move units without response to quarantine
+         * @ru Помещать не отвечающие устройства в карантин
+         *
+         * @en Default value: false
+         * @ru Значение по умолчанию: ложь
+         */
+        bool quarantineEnabled_;
+
+        /**
+         * @brief
+         * @en Health of units
+         * @ru Работоспособность устройств
+         */
+        UnitHealth unitHealth_;
+
+        /**
+         * @brief
+         * @en Result of last request
+         * @ru Результат последнего запроса
+         */
+        RequestError lastError_;
+
+        /**
+         * @brief
+         * @en Exception code of last request, Exceptions::Ok if there was no exception
+         * @ru Код исключения последнего запроса, Exceptions::Ok, если исключения не было
+         */
+        quint8 lastExceptionCode_;
+
+        /**
+         * @brief
+         * @en Profiles of units used to split requests
+         * @ru Профили устройств, используемые для разделения запросов
+         */
+        QHash<quint8, DeviceProfile> deviceProfiles_;
+
+        /**
+         * @brief
+         * @en Code of vendor scatter read function
+         * @ru Код функции производителя для чтения нескольких диапазонов
+         */
+        quint8 scatterReadFunction_;
+
+        /**
+         * @brief
+         * @en Longest gap between ranges of unit with profile read in one block
+         * @ru Наибольший промежуток между диапазонами устройства с профилем, читаемыми одним блоком
+         */
+        int readCoalescingGap_;
+
+        /**
+         * @brief
+         * @en Capture of sent and received frames, NULL if not used
+         * @ru Запись переданных и принятых кадров, NULL, если не используется
+         */
+        TrafficCapture* trafficCapture_;
+
+        //! @en Peer identifier written to capture @ru Идентификатор абонента, сохраняемый в записи
+        quint32 capturePeer_;
+
     protected :
 
+        /**
+         * @brief
+         * @en Write frame to traffic capture if it is set
+         * @ru Сохраняет кадр в записи трафика, если она установлена
+         */
+        void captureFrame_(bool sent, const QByteArray& adu)
+        {
+            if (trafficCapture_)
+                trafficCapture_->record((sent ? TrafficRecord::Sent : 0) | captureFraming_(), capturePeer_, adu.constData(), adu.size());
+        }
+
+        /**
+         * @brief
+         * @en Framing flag of captured frames, TrafficRecord::RtuFraming for RTU clients
+         * @ru Флаг формата записываемых кадров, TrafficRecord::RtuFraming для клиентов RTU
+         */
+        virtual quint8 captureFraming_() const
+        {
+            return 0;
+        }
+
+        /**
+         * @brief
+         * @en Check quarantine of current unit before sending request
+         * @ru Проверяет карантин текущего устройства перед отправкой запроса
+         *
+         * @return
+         * @en false if request must not be sent
+         * @ru false если запрос не должен отправляться
+         */
+        bool admitRequest_();
+
+        /**
+         * @brief
+         * @en Register result of request in unit health
+         * @ru Учитывает результат запроса в работоспособности устройства
+         *
+         * @param
+         * @en responded - true if unit responded
+         * @ru responded - true если устройство ответило
+         */
+        void updateUnitHealth_(bool responded);
+
         /**
          * @brief
          * @en Forms protocol data unit
@@ -191,12 +354,16 @@ class MODBUS4QT_EXPORT Client : public QObject
          * @en Readed data array
          * @ru Массив прочитанных данных
          *
+         * @param
+         * @en timeout - time left to wait for response, ms
+         * @ru timeout - оставшееся время ожидания ответа, мс
+         *
          * @en As timeout processing is differ for RTU and TCP we need to implement
          * method in descendance.
          * @ru Так как обработка времени задержки чтения разная для RTU и TCP
          * метод должен быть реализован в классе-потомке.
          */
-        virtual QByteArray readResponse_() = 0;
+        virtual QByteArray readResponse_(int timeout) = 0;
 
         /**
          * @brief sendRequestToServer_
@@ -226,6 +393,44 @@ class MODBUS4QT_EXPORT Client : public QObject
          */
         virtual bool sendRequestToServer_(const ProtocolDataUnit& requestPDU,  int requestPDUSize);
 
+        /**
+         * @brief
+         * @en Form application data unit for request and write it to the IO device
+         * @ru Формирует блок данных приложения для запроса и передает его в устройство ввода-вывода
+         *
+         * @param
+         * @en requestPDU - protocol data unit of request
+         * @ru requestPDU - блок данных протокола запроса
+         *
+         * @param
+         * @en requestPDUSize - size of protocol data unit (in bytes)
+         * @ru requestPDUSize - размер в байтах блока данных протокола
+         *
+         * @return
+         * @en true if all data was written; false otherwise
+         * @ru true если все данные переданы; false в случае возникновения ошибки
+         */
+        virtual bool writeRequest_(const ProtocolDataUnit& requestPDU, int requestPDUSize);
+
+        /**
+         * @brief
+         * @en Check response from server against request and report exception if any
+         * @ru Проверяет соответствие ответа сервера запросу и сообщает о полученном исключении
+         *
+         * @param
+         * @en requestPDU - protocol data unit of request
+         * @ru requestPDU - блок данных протокола запроса
+         *
+         * @param
+         * @en responsePDU - protocol data unit of response
+         * @ru responsePDU - блок данных протокола ответа
+         *
+         * @return
+         * @en true if server answered with the same function code; false otherwise
+         * @ru true если сервер ответил тем же кодом функции; false в противном случае
+         */
+        bool checkResponse_(const ProtocolDataUnit& requestPDU, const ProtocolDataUnit& responsePDU);
+
     public:
         /**
          * @brief
@@ -483,6 +688,339 @@ class MODBUS4QT_EXPORT Client : public QObject
             readTimeout_ = readTimeout;
         }
 
+        /**
+         * @brief
+         * @en Send request with prepared protocol data unit to current unit
+         * @ru Отправляет запрос с готовым блоком данных протокола текущему устройству
+         *
+         * @param
+         * @en requestPDU, requestPDUSize - request protocol data unit and its size
+         * @ru requestPDU, requestPDUSize - блок данных протокола запроса и его размер
+         *
+         * @param
+         * @en responsePDU - response protocol data unit
+         * @ru responsePDU - блок данных протокола ответа
+         *
+         * @return
+         * @en true if request is successfull; false otherwise, see lastError()
+         * @ru true если запрос прошел успешно; false в случае ошибки, см. lastError()
+         */
+        bool sendRequest(const ProtocolDataUnit& requestPDU, int requestPDUSize, ProtocolDataUnit& responsePDU)
+        {
+            return sendRequestToServer_(requestPDU, requestPDUSize, &responsePDU);
+        }
+
+        /**
+         * @brief
+         * @en Return result of last request
+         * @ru Возвращает результат последнего запроса
+         */
+        RequestError lastError() const
+        {
+            return lastError_;
+        }
+
+        /**
+         * @brief
+         * @en Return exception code of last request
+         * @ru Возвращает код исключения последнего запроса
+         *
+         * @return
+         * @en Exception code if lastError() is ExceptionError; Exceptions::Ok otherwise
+         * @ru Код исключения, если lastError() равен ExceptionError; иначе Exceptions::Ok
+         */
+        quint8 lastExceptionCode() const
+        {
+            return lastExceptionCode_;
+        }
+
+        /**
+         * @brief
+         * @en Set profile of unit profile.unitId()
+         * @ru Устанавливает профиль устройства profile.unitId()
+         *
+         * @en Block requests to unit with profile are split by its maximum block
+         * sizes, so request for any quantity is served by several transactions.
+         * Unit without functions 0x0F or 0x10 is written by single coil or
+         * register requests. Without profile requests are truncated to protocol
+         * maximum as before.
+         *
+         * @ru Блочные запросы к устройству с профилем разделяются по его
+         * максимальным размерам блоков, поэтому запрос любого количества
+         * элементов выполняется несколькими транзакциями. Устройство без
+         * функций 0x0F или 0x10 записывается запросами для одного дискретного
+         * выхода или регистра. Без профиля запросы, как и прежде, усекаются до
+         * максимума протокола.
+         *
+         * @sa DeviceDiscovery
+         */
+        void setDeviceProfile(const DeviceProfile& profile)
+        {
+            deviceProfiles_.insert(profile.unitId(), profile);
+        }
+
+        void removeDeviceProfile(quint8 unitId)
+        {
+            deviceProfiles_.remove(unitId);
+        }
+
+        //! @en Profile of unit, 0 if it is not set @ru Профиль устройства, 0, если он не задан
+        const DeviceProfile* deviceProfile(quint8 unitId) const
+        {
+            QHash<quint8, DeviceProfile>::const_iterator i = deviceProfiles_.constFind(unitId);
+            return (i == deviceProfiles_.constEnd()) ? 0 : &i.value();
+        }
+
+        /**
+         * @brief
+         * @en Read device identification objects (function 0x2B/0x0E)
+         * @ru Читает объекты идентификации устройства (функция 0x2B/0x0E)
+         *
+         * @en Objects which do not fit into one response are read by next requests.
+         * @ru Объекты, не поместившиеся в один ответ, читаются следующими запросами.
+         *
+         * @param
+         * @en objects - object ID and value of every object received
+         * @ru objects - идентификатор и значение каждого полученного объекта
+         *
+         * @param
+         * @en readCode - 1 basic, 2 regular, 3 extended identification
+         * @ru readCode - 1 основная, 2 обычная, 3 расширенная идентификация
+         *
+         * @return
+         * @en true if request is successfull; false otherwise, see lastError()
+         * @ru true если запрос прошел успешно; false в случае ошибки, см. lastError()
+         */
+        bool readDeviceIdentification(QMap<quint8, QByteArray>& objects, quint8 readCode = 1);
+
+        /**
+         * @brief
+         * @en Read several ranges of any tables
+         * @ru Читает несколько диапазонов любых таблиц
+         *
+         * @en If unit has profile, ranges of every table are coalesced and split
+         * by DeviceProfile::planReads() first: overlapping and adjacent ranges,
+         * or ranges separated by valid gap not longer than readCoalescingGap(),
+         * are read as one block within maximum read quantity of unit.
+         *
+         * If profile of unit marks scatter read function as supported, ranges
+         * are packed into as few requests of this function as fit into protocol
+         * data unit. Otherwise, or if unit rejects the function, every range is
+         * read by standard function.
+         *
+         * @ru Если у устройства есть профиль, диапазоны каждой таблицы сначала
+         * объединяются и разделяются методом DeviceProfile::planReads():
+         * пересекающиеся и смежные диапазоны, а также разделенные допустимым
+         * промежутком не длиннее readCoalescingGap(), читаются одним блоком в
+         * пределах максимального количества элементов чтения устройства.
+         *
+         * Если в профиле устройства функция чтения нескольких диапазонов
+         * отмечена как поддерживаемая, диапазоны упаковываются в наименьшее
+         * количество запросов этой функции, умещающихся в блок данных протокола.
+         * Иначе, а также если устройство отвергает функцию, каждый диапазон
+         * читается стандартной функцией.
+         *
+         * @param
+         * @en ranges - ranges to read, values are placed into them
+         * @ru ranges - читаемые диапазоны, значения помещаются в них
+         *
+         * @return
+         * @en true if request is successfull; false otherwise, see lastError()
+         * @ru true если запрос прошел успешно; false в случае ошибки, см. lastError()
+         *
+         * @sa ReadRange, ScatterReadHandler
+         */
+        bool readRanges(QList<ReadRange>& ranges);
+
+        //! @en Code of scatter read function, DefaultScatterReadFunction by default @ru Код функции чтения нескольких диапазонов, по умолчанию DefaultScatterReadFunction
+        quint8 scatterReadFunction() const
+        {
+            return scatterReadFunction_;
+        }
+
+        void setScatterReadFunction(quint8 function)
+        {
+            scatterReadFunction_ = function;
+        }
+
+        //! @en Longest gap read to join ranges in readRanges(), 0 by default @ru Наибольший промежуток, читаемый для объединения диапазонов в readRanges(), по умолчанию 0
+        int readCoalescingGap() const
+        {
+            return readCoalescingGap_;
+        }
+
+        void setReadCoalescingGap(int gap)
+        {
+            readCoalescingGap_ = qMax(0, gap);
+        }
+
+        /**
+         * @brief
+         * @en Record all sent and received frames into capture
+         * @ru Сохраняет все переданные и принятые кадры в записи трафика
+         *
+         * @param
+         * @en capture - opened capture, NULL turns recording off. Client does not own it.
+         * @ru capture - открытая запись, NULL выключает запись. Клиент не владеет ей.
+         *
+         * @param
+         * @en peer - identifier of this client in capture
+         * @ru peer - идентификатор этого клиента в записи
+         *
+         * @sa TrafficCapture
+         */
+        void setTrafficCapture(TrafficCapture* capture, quint32 peer = 0)
+        {
+            trafficCapture_ = capture;
+            capturePeer_ = peer;
+        }
+
+        TrafficCapture* trafficCapture() const
+        {
+            return trafficCapture_;
+        }
+
+        /**
+         * @brief
+         * @en Return true if units without response are moved to quarantine
+         * @ru Возвращает true, если не отвечающие устройства помещаются в карантин
+         */
+        bool isQuarantineEnabled() const
+        {
+            return quarantineEnabled_;
+        }
+
+        /**
+         * @brief
+         * @en Turn on or off quarantine of units without response
+         * @ru Включает или выключает карантин не отвечающих устройств
+         *
+         * @en After several requests in a row without response unit is moved to
+         * quarantine. Requests to it fail at once with QuarantineError and do not
+         * use line, except single probe request sent with growing interval.
+         *
+         * @ru После нескольких запросов подряд без ответа устройство помещается
+         * в карантин. Запросы к нему сразу завершаются с ошибкой QuarantineError
+         * и не занимают линию, кроме одного пробного запроса, отправляемого с
+         * растущим интервалом.
+         *
+         * @sa UnitHealth
+         */
+        void setQuarantineEnabled(bool enabled = true)
+        {
+            quarantineEnabled_ = enabled;
+        }
+
+        /**
+         * @brief
+         * @en Set parameters of quarantine
+         * @ru Устанавливает параметры карантина
+         *
+         * @param
+         * @en failureThreshold - requests without response in a row to move unit to quarantine. Default value 3
+         * @ru failureThreshold - количество запросов без ответа подряд для помещения в карантин. Значение по умолчанию 3
+         *
+         * @param
+         * @en probeInterval, maxProbeInterval - initial and maximum probe interval, ms. Default values 1000 and 60000 ms
+         * @ru probeInterval, maxProbeInterval - начальный и максимальный интервал проверки, мс. Значения по умолчанию 1000 и 60000 мс
+         */
+        void setQuarantineParameters(int failureThreshold, int probeInterval, int maxProbeInterval)
+        {
+            unitHealth_.setParameters(failureThreshold, probeInterval, maxProbeInterval);
+        }
+
+        /**
+         * @brief
+         * @en Return health of units
+         * @ru Возвращает работоспособность устройств
+         */
+        const UnitHealth& unitHealth() const
+        {
+            return unitHealth_;
+        }
+
+        /**
+         * @brief
+         * @en Return unit from quarantine
+         * @ru Выводит устройство из карантина
+         */
+        void releaseQuarantine(quint8 unitID)
+        {
+            unitHealth_.release(unitID);
+        }
+
+        /**
+         * @brief
+         * @en Return true if timeout is calculated for every unit from its round trip time
+         * @ru Возвращает true, если время ожидания вычисляется для каждого устройства по времени обмена с ним
+         */
+        bool isAdaptiveTimeout() const
+        {
+            return adaptiveTimeout_;
+        }
+
+        /**
+         * @brief
+         * @en Turn on or off adaptive timeout
+         * @ru Включает или выключает адаптивное время ожидания
+         *
+         * @en When adaptive timeout is on, read timeout is used only for units
+         * without history. Timeout of every other unit is calculated from its
+         * own round trip time and limited by values set with setAdaptiveTimeoutLimits().
+         * So one failing unit does not slow down polling of other units.
+         *
+         * @ru Если адаптивное время ожидания включено, время ожидания чтения
+         * используется только для устройств без истории. Для остальных устройств
+         * время ожидания вычисляется по времени обмена с каждым из них и
+         * ограничивается значениями, заданными setAdaptiveTimeoutLimits().
+         * Таким образом одно неисправное устройство не замедляет опрос остальных.
+         *
+         * @sa RttEstimator
+         */
+        void setAdaptiveTimeout(bool adaptiveTimeout = true)
+        {
+            adaptiveTimeout_ = adaptiveTimeout;
+        }
+
+        /**
+         * @brief
+         * @en Set limits for adaptive timeout
+         * @ru Устанавливает ограничения адаптивного времени ожидания
+         *
+         * @param
+         * @en floor, ceiling - minimum and maximum timeout, ms. Default values 20 and 1000 ms,
+         * ceiling applies to units without history too
+         * @ru floor, ceiling - минимальное и максимальное время ожидания, мс. Значения по умолчанию 20 и 1000 мс,
+         * верхняя граница применяется и к устройствам без истории
+         */
+        void setAdaptiveTimeoutLimits(int floor, int ceiling)
+        {
+            rttEstimator_.setLimits(floor, ceiling);
+        }
+
+        /**
+         * @brief
+         * @en Return round trip time statistics of units
+         * @ru Возвращает статистику времени обмена с устройствами
+         */
+        const RttEstimator& rttEstimator() const
+        {
+            return rttEstimator_;
+        }
+
+        /**
+         * @brief
+         * @en Return timeout which will be used for unit, ms
+         * @ru Возвращает время ожидания, которое будет использовано для устройства, мс
+         */
+        int responseTimeout(quint8 unitID) const
+        {
+            if (adaptiveTimeout_)
+                return rttEstimator_.timeout(unitID, readTimeout_);
+
+            return readTimeout_;
+        }
+
         /**
          * @brief
          * @en Set current value of server unit ID
@@ -876,6 +1414,20 @@ class MODBUS4QT_EXPORT Client : public QObject
          * @ru msg - Строка с описанием ошибки
          */
         void infoMessage(quint8 unitID, const QString& msg);
+
+        /**
+         * @brief
+         * @en Unit has been moved to quarantine
+         * @ru Устройство помещено в карантин
+         */
+        void unitQuarantined(quint8 unitID);
+
+        /**
+         * @brief
+         * @en Unit in quarantine responded and returned to normal state
+         * @ru Устройство в карантине ответило и возвращено в нормальное состояние
+         */
+        void unitRecovered(quint8 unitID);
 };
 
 } // namespace modbus4qt
@@ -97,6 +97,13 @@ const int PDUMaxSize = 253;
  */
 const int PDUDataMaxSize = PDUMaxSize - 1;
 
+/**
+ * @brief
+ * @en Max size of MODBUS/TCP application data unit: MBAP header and protocol data unit, bytes
+ * @ru Максимальный размер блока данных приложения MODBUS/TCP: заголовок MBAP и блок данных протокола, байт
+ */
+const int TcpADUMaxSize = 7 + PDUMaxSize;
+
 /**
  * @brief
  * @en Default port for MODBUS/TCP
@@ -156,7 +163,7 @@ const int MaxRegistersForRead = 125;
  * @en  See also: Modbus Protocol Specification v1.1b3, p. 30
  * @ru Подробнее: Modbus Protocol Specification v1.1b3, стр. 30
  */
-const int MaxRegistersForWrite = 23;
+const int MaxRegistersForWrite = 123;
 
 /**
  * @brief
@@ -366,12 +373,43 @@ struct Functions
 //     */
 //    static const quint8 ReadFIFOQueue = 0x18;
 
-//    /**
-//     * @brief EncapsulatedInterfaceTransport
-//     */
-//    static const quint8 EncapsulatedInterfaceTransport = 0x2B;
+    /**
+     * @brief
+     * @en Encapsulated interface transport, used for Read Device Identification
+     * @ru Инкапсулированный транспорт интерфейса, используется для чтения идентификации устройства
+     */
+    static const quint8 EncapsulatedInterfaceTransport = 0x2B;
 };
 
+/**
+ * @brief
+ * @en MEI type of Read Device Identification request of function 0x2B
+ * @ru Тип MEI запроса чтения идентификации устройства функции 0x2B
+ *
+ * @en See also: Modbus Protocol Specification v1.1b3, p. 43
+ * @ru Подробнее: Modbus Protocol Specification v1.1b3, стр. 43
+ */
+const quint8 MeiReadDeviceIdentification = 0x0E;
+
+/**
+ * @brief
+ * @en Default code of vendor function for reading several ranges by one request
+ * @ru Код по умолчанию функции производителя для чтения нескольких диапазонов одним запросом
+ *
+ * @en Code is from user defined range 65..72.
+ * @ru Код из диапазона пользовательских функций 65..72.
+ *
+ * @sa ScatterReadHandler, Client::readRanges()
+ */
+const quint8 DefaultScatterReadFunction = 0x41;
+
+/**
+ * @brief
+ * @en Maximum ranges in one scatter read request, 5 bytes per range
+ * @ru Максимальное количество диапазонов в одном запросе чтения диапазонов, 5 байт на диапазон
+ */
+const int ScatterReadMaxRanges = (PDUDataMaxSize - 1) / 5;
+
 } // namespace modbus
 
 #endif // CONSTS_H
@@ -1,5 +1,9 @@
 #include "device.h"
 
+#include <QMutexLocker>
+
+#include <algorithm>
+
 namespace modbus4qt
 {
 
@@ -11,5 +15,210 @@ Device::Device(int readTimeout, int writeTimeout, QObject *parent)
 
 }
 
+//-----------------------------------------------------------------------------
+
+bool
+Device::readCoils(quint16 regStart, quint16 regQty, QVector<bool> &values)
+{
+    values.resize(regQty);
+    return readCoils(regStart, regQty, values.data());
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::readDescreteInputs(quint16 regStart, quint16 regQty, QVector<bool> &values)
+{
+    values.resize(regQty);
+    return readDescreteInputs(regStart, regQty, values.data());
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::readInputRegisters(quint16 regStart, quint16 regQty, QVector<quint16> &values)
+{
+    values.resize(regQty);
+    return readInputRegisters(regStart, regQty, values.data());
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::readHoldingRegisters(quint16 regStart, quint16 regQty, QVector<quint16> &values)
+{
+    values.resize(regQty);
+    return readHoldingRegisters(regStart, regQty, values.data());
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::writeCoils(quint16 regStart, const bool* values, quint16 regQty)
+{
+    for (int i = 0; i < regQty; ++i)
+    {
+        if (!writeCoil(regStart + i, values[i]))
+            return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::writeCoils(quint16 regStart, const QVector<bool>& values)
+{
+    return writeCoils(regStart, values.constData(), values.size());
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::writeHoldingRegisters(quint16 regStart, const quint16* values, quint16 regQty)
+{
+    for (int i = 0; i < regQty; ++i)
+    {
+        if (!writeHoldingRegister(regStart + i, values[i]))
+            return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::writeHoldingRegisters(quint16 regStart, const QVector<quint16>& values)
+{
+    return writeHoldingRegisters(regStart, values.constData(), values.size());
 }
 
+//-----------------------------------------------------------------------------
+
+bool
+Device::commitCoils(quint16 regStart, const bool* values, quint16 regQty)
+{
+    if (!writeCoils(regStart, values, regQty))
+        return false;
+
+    markDirty_(Coils, regStart, regQty);
+
+    // Signal with values is the only reason to allocate memory here
+    //
+    // Сигнал со значениями - единственная причина выделять здесь память
+    //
+    if (receivers(SIGNAL(coilsWritten(quint16,QVector<bool>))) > 0)
+    {
+        QVector<bool> written(regQty);
+        std::copy(values, values + regQty, written.begin());
+        emit coilsWritten(regStart, written);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::commitCoils(quint16 regStart, const QVector<bool>& values)
+{
+    if (!writeCoils(regStart, values.constData(), values.size()))
+        return false;
+
+    markDirty_(Coils, regStart, values.size());
+    emit coilsWritten(regStart, values);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::commitHoldingRegisters(quint16 regStart, const quint16* values, quint16 regQty)
+{
+    if (!writeHoldingRegisters(regStart, values, regQty))
+        return false;
+
+    markDirty_(HoldingRegisters, regStart, regQty);
+
+    if (receivers(SIGNAL(holdingRegistersWritten(quint16,QVector<quint16>))) > 0)
+    {
+        QVector<quint16> written(regQty);
+        std::copy(values, values + regQty, written.begin());
+        emit holdingRegistersWritten(regStart, written);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Device::commitHoldingRegisters(quint16 regStart, const QVector<quint16>& values)
+{
+    if (!writeHoldingRegisters(regStart, values.constData(), values.size()))
+        return false;
+
+    markDirty_(HoldingRegisters, regStart, values.size());
+    emit holdingRegistersWritten(regStart, values);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+Device::markDirty_(Table table, quint16 regStart, int regQty)
+{
+    if (regQty < 1)
+        return;
+
+    bool wasEmpty;
+
+    {
+        QMutexLocker locker(&dirtyMutex_);
+
+        QList<Range>& ranges = dirtyRanges_[table];
+        wasEmpty = ranges.isEmpty();
+
+        Range range(regStart, regStart + regQty - 1);
+
+        // Skip ranges before new one, then absorb overlapping and adjacent ones
+        //
+        // Пропускаем диапазоны перед новым, затем поглощаем пересекающиеся и смежные
+        //
+        int i = 0;
+        while ((i < ranges.size()) && (ranges.at(i).end + 1 < range.start))
+            ++i;
+
+        while ((i < ranges.size()) && (ranges.at(i).start <= range.end + 1))
+        {
+            range.start = qMin(range.start, ranges.at(i).start);
+            range.end = qMax(range.end, ranges.at(i).end);
+            ranges.removeAt(i);
+        }
+
+        ranges.insert(i, range);
+    }
+
+    if (wasEmpty)
+        emit dirtyRangesAvailable();
+}
+
+//-----------------------------------------------------------------------------
+
+QList<Device::Range>
+Device::takeDirtyRanges(Table table)
+{
+    QMutexLocker locker(&dirtyMutex_);
+
+    QList<Range> ranges = dirtyRanges_[table];
+    dirtyRanges_[table].clear();
+
+    return ranges;
+}
+
+} // namespace modbus4qt
+
@@ -1,8 +1,12 @@
 #ifndef DEVICE_H
 #define DEVICE_H
 
+#include <QList>
+#include <QMutex>
 #include <QObject>
+#include <QVector>
 
+#include "global.h"
 #include "types.h"
 
 namespace modbus4qt
@@ -26,11 +30,53 @@ namespace modbus4qt
  * указатель ioDevice_, присвоив его значение указателю на экземпляр реального объекта, отвечающего
  * за обмен данными.
  */
-class Device : public QObject
+class MODBUS4QT_EXPORT Device : public QObject
 {
     Q_OBJECT
 
-    friend class Server;
+    public:
+
+        /**
+         * @brief
+         * @en Tables written by clients
+         * @ru Таблицы, записываемые клиентами
+         */
+        enum Table
+        {
+            Coils,
+            HoldingRegisters,
+            TableCount
+        };
+
+        /**
+         * @brief
+         * @en Range of addresses, end is inclusive
+         * @ru Диапазон адресов, конец включается
+         */
+        struct Range
+        {
+            quint16 start;
+
+            quint16 end;
+
+            Range(quint16 start = 0, quint16 end = 0)
+                : start(start),
+                  end(end)
+            {
+            }
+
+            int count() const
+            {
+                return end - start + 1;
+            }
+        };
+
+    private:
+
+        QMutex dirtyMutex_;
+
+        //! @en Sorted disjoint ranges written since last takeDirtyRanges() @ru Упорядоченные непересекающиеся диапазоны, записанные после последнего вызова takeDirtyRanges()
+        QList<Range> dirtyRanges_[TableCount];
 
     protected:
 
@@ -79,27 +125,119 @@ class Device : public QObject
         inline int writeTimeout() const;
         inline void setWriteTimeout(int writeTimeout);
 
-    protected :
+        /**
+         * @brief
+         * @en Return ranges written by clients since last call and clear them
+         * @ru Возвращает диапазоны, записанные клиентами с момента последнего вызова, и очищает их
+         *
+         * @en Ranges of all writes are merged, so observer which handles
+         * dirtyRangesAvailable() runs once for any number of writes and sees
+         * every changed address once. May be called from any thread.
+         *
+         * @ru Диапазоны всех записей объединяются, поэтому наблюдатель,
+         * обрабатывающий dirtyRangesAvailable(), выполняется один раз для любого
+         * количества записей и видит каждый измененный адрес один раз. Может
+         * вызываться из любого потока.
+         */
+        QList<Range> takeDirtyRanges(Table table);
 
         virtual bool readCoil(quint16 regNo, bool &value) = 0;
 
-        virtual bool readCoils(quint16 regStart, quint16 regQty, QVector<bool> &values) = 0;
+        /**
+         * @brief
+         * @en Read block of coils into buffer of regQty values
+         * @ru Читает блок дискретных выходов в буфер из regQty значений
+         *
+         * @en Server reads through this method, so request is served without
+         * memory allocation. Methods with QVector call it.
+         *
+         * @ru Сервер читает через этот метод, поэтому запрос обслуживается без
+         * выделения памяти. Методы с QVector вызывают его.
+         */
+        virtual bool readCoils(quint16 regStart, quint16 regQty, bool* values) = 0;
+
+        virtual bool readCoils(quint16 regStart, quint16 regQty, QVector<bool> &values);
 
         virtual bool readDescreteInput(quint16 regNo, bool &value) = 0;
 
-        virtual bool readDescreteInputs(quint16 regStart, quint16 regQty, QVector<bool> &values) = 0;
+        //! @sa readCoils()
+        virtual bool readDescreteInputs(quint16 regStart, quint16 regQty, bool* values) = 0;
+
+        virtual bool readDescreteInputs(quint16 regStart, quint16 regQty, QVector<bool> &values);
 
         virtual bool readInputRegister(quint16 regNo, quint16 &value) = 0;
 
-        virtual bool readInputRegisters(quint16 regStart, quint16 regQty, QVector<quint16> &values) = 0;
+        //! @sa readCoils()
+        virtual bool readInputRegisters(quint16 regStart, quint16 regQty, quint16* values) = 0;
+
+        virtual bool readInputRegisters(quint16 regStart, quint16 regQty, QVector<quint16> &values);
 
         virtual bool readHoldingRegister(quint16 regNo, quint16 &value) = 0;
 
-        virtual bool readHoldingRegisters(quint16 regStart, quint16 regQty, QVector<quint16> &values) = 0;
+        //! @sa readCoils()
+        virtual bool readHoldingRegisters(quint16 regStart, quint16 regQty, quint16* values) = 0;
+
+        virtual bool readHoldingRegisters(quint16 regStart, quint16 regQty, QVector<quint16> &values);
 
         virtual bool writeCoil(quint16 regNo, bool value) = 0;
 
-        virtual bool writeHoldingRegister(quint16 regNo, bool value) = 0;
+        virtual bool writeHoldingRegister(quint16 regNo, quint16 value) = 0;
+
+        /**
+         * @brief
+         * @en Write block of coils from one request
+         * @ru Записывает блок дискретных выходов из одного запроса
+         *
+         * @en Default implementation calls writeCoil() for every value. Device
+         * should override it to apply block at once, so readers never see part
+         * of request written.
+         *
+         * @ru Реализация по умолчанию вызывает writeCoil() для каждого значения.
+         * Устройству следует переопределить метод, чтобы применять блок целиком
+         * и читатели никогда не видели частично записанный запрос.
+         */
+        virtual bool writeCoils(quint16 regStart, const bool* values, quint16 regQty);
+
+        virtual bool writeCoils(quint16 regStart, const QVector<bool>& values);
+
+        /**
+         * @brief
+         * @en Write block of holding registers from one request
+         * @ru Записывает блок регистров хранения из одного запроса
+         *
+         * @en Default implementation calls writeHoldingRegister() for every value.
+         * @ru Реализация по умолчанию вызывает writeHoldingRegister() для каждого значения.
+         *
+         * @sa writeCoils()
+         */
+        virtual bool writeHoldingRegisters(quint16 regStart, const quint16* values, quint16 regQty);
+
+        virtual bool writeHoldingRegisters(quint16 regStart, const QVector<quint16>& values);
+
+        /**
+         * @brief
+         * @en Write block and notify observers once
+         * @ru Записывает блок и однократно уведомляет наблюдателей
+         *
+         * @en Used by server for every write request. Values are copied into
+         * QVector only if coilsWritten() has receivers.
+         *
+         * @ru Используется сервером для каждого запроса записи. Значения
+         * копируются в QVector, только если у coilsWritten() есть получатели.
+         */
+        bool commitCoils(quint16 regStart, const bool* values, quint16 regQty);
+
+        bool commitCoils(quint16 regStart, const QVector<bool>& values);
+
+        //! @sa commitCoils()
+        bool commitHoldingRegisters(quint16 regStart, const quint16* values, quint16 regQty);
+
+        bool commitHoldingRegisters(quint16 regStart, const QVector<quint16>& values);
+
+    private:
+
+        //! @en Merge range into dirty ranges of table @ru Объединяет диапазон с измененными диапазонами таблицы
+        void markDirty_(Table table, quint16 regStart, int regQty);
 
     signals:
 
@@ -136,6 +274,32 @@ class Device : public QObject
          */
         void infoMessage(const QString& msg);
 
+        /**
+         * @brief
+         * @en Coils were written by one client request
+         * @ru Дискретные выходы записаны одним запросом клиента
+         */
+        void coilsWritten(quint16 regStart, const QVector<bool>& values);
+
+        /**
+         * @brief
+         * @en Holding registers were written by one client request
+         * @ru Регистры хранения записаны одним запросом клиента
+         *
+         * @en Emitted after whole block is written, so values are consistent.
+         * @ru Выдается после записи всего блока, поэтому значения согласованы.
+         */
+        void holdingRegistersWritten(quint16 regStart, const QVector<quint16>& values);
+
+        /**
+         * @brief
+         * @en Dirty ranges appeared, emitted only when table had none before
+         * @ru Появились измененные диапазоны, выдается, только если в таблице их ранее не было
+         *
+         * @sa takeDirtyRanges()
+         */
+        void dirtyRangesAvailable();
+
     public slots:
 };
 
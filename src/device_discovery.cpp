@@ -0,0 +1,314 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "device_discovery.h"
+#include "client.h"
+#include "utils.h"
+
+#include <QDateTime>
+
+namespace modbus4qt
+{
+
+DeviceDiscovery::DeviceDiscovery(Client* client)
+    : client_(client),
+      scanStart_(0),
+      scanEnd_(9999),
+      probeWrites_(true),
+      requestCount_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DeviceDiscovery::discover(DeviceProfile& profile)
+{
+    requestCount_ = 0;
+    profile = DeviceProfile(client_->unitID());
+
+    // Identification
+    //
+    // Идентификация
+    //
+    QMap<quint8, QByteArray> objects;
+    ++requestCount_;
+
+    if (client_->readDeviceIdentification(objects))
+    {
+        profile.setIdentification(objects);
+        profile.setFunctionSupport(Functions::EncapsulatedInterfaceTransport, DeviceProfile::Supported);
+    }
+    else if (client_->lastError() == Client::ExceptionError)
+    {
+        bool rejected = (client_->lastExceptionCode() == Exceptions::IllegalFunction);
+        profile.setFunctionSupport(Functions::EncapsulatedInterfaceTransport,
+                                   rejected ? DeviceProfile::Unsupported : DeviceProfile::Supported);
+    }
+    else
+    {
+        return false;
+    }
+
+    // Read functions, valid ranges and block limits
+    //
+    // Функции чтения, допустимые диапазоны и пределы блоков
+    //
+    for (int i = 0; i < DeviceProfile::TableCount; ++i)
+    {
+        DeviceProfile::Table table = static_cast<DeviceProfile::Table>(i);
+        quint8 function = DeviceProfile::readFunction(table);
+
+        ProbeResult result = read_(table, scanStart_, 1);
+
+        if (result == NoAnswer)
+            return false;
+
+        if (result == Rejected)
+        {
+            profile.setFunctionSupport(function, DeviceProfile::Unsupported);
+            continue;
+        }
+
+        profile.setFunctionSupport(function, DeviceProfile::Supported);
+
+        QList<DeviceProfile::Range> ranges;
+        const int blockSize = DeviceProfile::protocolMaxRead(table);
+
+        for (int start = scanStart_; start <= scanEnd_; start += blockSize)
+        {
+            if (!scanBlock_(table, start, qMin(start + blockSize - 1, int(scanEnd_)), ranges))
+                return false;
+        }
+
+        profile.setValidRanges(table, ranges);
+
+        // Limit is searched in the longest range, as only there it can be
+        // distinguished from end of valid addresses
+        //
+        // Предел ищется в самом длинном диапазоне, так как только там его можно
+        // отличить от конца допустимых адресов
+        //
+        ranges = profile.validRanges(table);
+
+        if (ranges.isEmpty())
+            continue;
+
+        DeviceProfile::Range longest = ranges.first();
+        foreach (const DeviceProfile::Range& range, ranges)
+        {
+            if (range.count() > longest.count())
+                longest = range;
+        }
+
+        int maxQuantity = findMaxQuantity_(table, longest);
+        if (maxQuantity < 0)
+            return false;
+
+        profile.setMaxReadQuantity(table, maxQuantity);
+    }
+
+    // Scatter read is probed by first valid address of any table
+    //
+    // Чтение нескольких диапазонов проверяется по первому допустимому адресу любой таблицы
+    //
+    for (int i = 0; i < DeviceProfile::TableCount; ++i)
+    {
+        DeviceProfile::Table table = static_cast<DeviceProfile::Table>(i);
+        QList<DeviceProfile::Range> ranges = profile.validRanges(table);
+
+        if (!profile.isFunctionSupported(DeviceProfile::readFunction(table)) || ranges.isEmpty())
+            continue;
+
+        ProtocolDataUnit request;
+        request.functionCode = client_->scatterReadFunction();
+        request.data[0] = 1;
+        request.data[1] = DeviceProfile::readFunction(table);
+        request.data[2] = hi(ranges.first().start);
+        request.data[3] = lo(ranges.first().start);
+        request.data[4] = 0;
+        request.data[5] = 1;
+
+        // Unit may silently drop unknown vendor function, support stays unknown then
+        //
+        // Устройство может молча отбросить неизвестную функцию производителя, тогда поддержка остается неизвестной
+        //
+        ProbeResult result = probe_(request, 7);
+
+        if (result == Rejected)
+            profile.setFunctionSupport(request.functionCode, DeviceProfile::Unsupported);
+        else if (result != NoAnswer)
+            profile.setFunctionSupport(request.functionCode, DeviceProfile::Supported);
+
+        break;
+    }
+
+    // Write functions are probed by zero quantity, which must be rejected with
+    // "illegal data value" and does not change anything
+    //
+    // Функции записи проверяются нулевым количеством, которое должно быть
+    // отвергнуто с исключением "недопустимое значение" и ничего не меняет
+    //
+    if (probeWrites_)
+    {
+        const quint8 functions[] = { Functions::WriteMultipleCoils, Functions::WriteMultipleRegisters };
+
+        for (int i = 0; i < 2; ++i)
+        {
+            ProtocolDataUnit request;
+            request.functionCode = functions[i];
+            request.data[0] = hi(scanStart_);
+            request.data[1] = lo(scanStart_);
+            request.data[2] = 0;
+            request.data[3] = 0;
+            request.data[4] = 0;
+
+            // Unit may silently drop malformed request, support stays unknown then
+            //
+            // Устройство может молча отбросить неверный запрос, тогда поддержка остается неизвестной
+            //
+            ProbeResult result = probe_(request, 6);
+
+            if (result == Rejected)
+                profile.setFunctionSupport(functions[i], DeviceProfile::Unsupported);
+            else if (result != NoAnswer)
+                profile.setFunctionSupport(functions[i], DeviceProfile::Supported);
+        }
+    }
+
+    profile.setDiscovered(QDateTime::currentDateTimeUtc());
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+DeviceDiscovery::ProbeResult
+DeviceDiscovery::probe_(const ProtocolDataUnit& request, int requestSize)
+{
+    ++requestCount_;
+
+    ProtocolDataUnit response;
+
+    if (client_->sendRequest(request, requestSize, response))
+        return Accepted;
+
+    if (client_->lastError() != Client::ExceptionError)
+        return NoAnswer;
+
+    return (client_->lastExceptionCode() == Exceptions::IllegalFunction) ? Rejected : Refused;
+}
+
+//-----------------------------------------------------------------------------
+
+DeviceDiscovery::ProbeResult
+DeviceDiscovery::read_(DeviceProfile::Table table, quint16 start, int quantity)
+{
+    ProtocolDataUnit request;
+
+    request.functionCode = DeviceProfile::readFunction(table);
+    request.data[0] = hi(start);
+    request.data[1] = lo(start);
+    request.data[2] = hi(quantity);
+    request.data[3] = lo(quantity);
+
+    return probe_(request, 5);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DeviceDiscovery::scanBlock_(DeviceProfile::Table table, quint16 start, quint16 end, QList<DeviceProfile::Range>& ranges)
+{
+    ProbeResult result = read_(table, start, end - start + 1);
+
+    if (result == NoAnswer)
+        return false;
+
+    if (result == Accepted)
+    {
+        ranges.append(DeviceProfile::Range(start, end));
+        return true;
+    }
+
+    // Single rejected address is a hole
+    //
+    // Одиночный отвергнутый адрес - пропуск
+    //
+    if (start == end)
+        return true;
+
+    quint16 middle = start + (end - start) / 2;
+
+    return scanBlock_(table, start, middle, ranges) && scanBlock_(table, middle + 1, end, ranges);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+DeviceDiscovery::findMaxQuantity_(DeviceProfile::Table table, const DeviceProfile::Range& range)
+{
+    const int protocolMax = DeviceProfile::protocolMaxRead(table);
+    int high = qMin(protocolMax, range.count());
+
+    ProbeResult result = read_(table, range.start, high);
+
+    if (result == NoAnswer)
+        return -1;
+
+    // Whole range is read at once, limit is not reached
+    //
+    // Весь диапазон читается сразу, предел не достигнут
+    //
+    if (result == Accepted)
+        return (high == range.count()) ? protocolMax : high;
+
+    // Every address of range is valid, so single item is always accepted
+    //
+    // Все адреса диапазона допустимы, поэтому один элемент всегда принимается
+    //
+    int low = 1;
+    --high;
+
+    while (low < high)
+    {
+        int middle = (low + high + 1) / 2;
+
+        result = read_(table, range.start, middle);
+
+        if (result == NoAnswer)
+            return -1;
+
+        if (result == Accepted)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+
+    return low;
+}
+
+} // namespace modbus4qt
@@ -0,0 +1,152 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_DEVICE_DISCOVERY_H
+#define MODBUS4QT_DEVICE_DISCOVERY_H
+
+#include "device_profile.h"
+#include "types.h"
+
+namespace modbus4qt
+{
+
+class Client;
+
+/**
+ * @brief
+ * @en Discovery of unit capabilities
+ * @ru Определение возможностей устройства
+ *
+ * @en Fills DeviceProfile of current unit of client:
+ * - identification objects are read by function 0x2B/0x0E, if unit supports it;
+ * - every read function is probed with one item, exception "illegal function"
+ *   means function is not supported;
+ * - addresses of scan window are read by maximum blocks, rejected blocks are
+ *   halved until valid ranges and holes are found;
+ * - maximum read block is found by binary search in the longest valid range;
+ * - scatter read function of client is probed by reading one valid item;
+ * - functions 0x0F and 0x10 are probed by requests with zero quantity, which
+ *   unit must reject without writing anything.
+ *
+ * Addresses outside scan window are treated by profile as invalid, so window
+ * should cover whole map of unit. Write limits can not be found without
+ * writing and stay at protocol maximum.
+ *
+ * @ru Заполняет DeviceProfile текущего устройства клиента:
+ * - объекты идентификации читаются функцией 0x2B/0x0E, если устройство ее поддерживает;
+ * - каждая функция чтения проверяется запросом одного элемента, исключение
+ *   "недопустимая функция" означает, что функция не поддерживается;
+ * - адреса окна сканирования читаются блоками максимального размера,
+ *   отвергнутые блоки делятся пополам, пока не будут найдены допустимые
+ *   диапазоны и пропуски;
+ * - максимальный блок чтения находится двоичным поиском в самом длинном
+ *   допустимом диапазоне;
+ * - функция чтения нескольких диапазонов клиента проверяется чтением одного
+ *   допустимого элемента;
+ * - функции 0x0F и 0x10 проверяются запросами с нулевым количеством, которые
+ *   устройство должно отвергнуть, ничего не записывая.
+ *
+ * Адреса вне окна сканирования профиль считает недопустимыми, поэтому окно
+ * должно охватывать всю карту устройства. Пределы записи невозможно
+ * определить без записи, они остаются равными максимуму протокола.
+ */
+class MODBUS4QT_EXPORT DeviceDiscovery
+{
+    private:
+
+        enum ProbeResult
+        {
+            //! @en Unit answered normally @ru Устройство ответило нормально
+            Accepted,
+
+            //! @en Exception "illegal function" @ru Исключение "недопустимая функция"
+            Rejected,
+
+            //! @en Other exception @ru Другое исключение
+            Refused,
+
+            //! @en No valid answer @ru Нет правильного ответа
+            NoAnswer
+        };
+
+        Client* client_;
+
+        quint16 scanStart_;
+
+        quint16 scanEnd_;
+
+        bool probeWrites_;
+
+        int requestCount_;
+
+        ProbeResult probe_(const ProtocolDataUnit& request, int requestSize);
+
+        ProbeResult read_(DeviceProfile::Table table, quint16 start, int quantity);
+
+        //! @en Find valid ranges of block, false if unit stops answering @ru Находит допустимые диапазоны блока, false, если устройство перестало отвечать
+        bool scanBlock_(DeviceProfile::Table table, quint16 start, quint16 end, QList<DeviceProfile::Range>& ranges);
+
+        //! @en -1 if unit stops answering @ru -1, если устройство перестало отвечать
+        int findMaxQuantity_(DeviceProfile::Table table, const DeviceProfile::Range& range);
+
+    public:
+
+        explicit DeviceDiscovery(Client* client);
+
+        //! @en Window of addresses to scan, default 0..9999 @ru Окно сканируемых адресов, по умолчанию 0..9999
+        void setScanRange(quint16 start, quint16 end)
+        {
+            scanStart_ = start;
+            scanEnd_ = qMax(start, end);
+        }
+
+        //! @en Probe write functions, default true @ru Проверять функции записи, по умолчанию true
+        void setProbeWrites(bool probeWrites)
+        {
+            probeWrites_ = probeWrites;
+        }
+
+        /**
+         * @brief
+         * @en Discover current unit of client
+         * @ru Определяет возможности текущего устройства клиента
+         *
+         * @return
+         * @en false if unit does not answer, profile is not complete then
+         * @ru false, если устройство не отвечает, профиль в этом случае неполон
+         */
+        bool discover(DeviceProfile& profile);
+
+        //! @en Requests sent by last discover() @ru Количество запросов, отправленных последним вызовом discover()
+        int requestCount() const
+        {
+            return requestCount_;
+        }
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_DEVICE_DISCOVERY_H
@@ -0,0 +1,421 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "device_profile.h"
+#include "consts.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <string.h>
+
+namespace modbus4qt
+{
+
+//! @en Names of tables in JSON @ru Имена таблиц в JSON
+static const char* const TableNames[DeviceProfile::TableCount] =
+{
+    "coils",
+    "discreteInputs",
+    "holdingRegisters",
+    "inputRegisters"
+};
+
+static const char* const SupportNames[] =
+{
+    "unknown",
+    "supported",
+    "unsupported"
+};
+
+//-----------------------------------------------------------------------------
+
+static bool
+rangeLessThan(const DeviceProfile::Range& left, const DeviceProfile::Range& right)
+{
+    return left.start < right.start;
+}
+
+//-----------------------------------------------------------------------------
+
+DeviceProfile::DeviceProfile(quint8 unitId)
+    : unitId_(unitId)
+{
+    memset(functions_, Unknown, sizeof(functions_));
+
+    for (int table = 0; table < TableCount; ++table)
+    {
+        maxReadQuantity_[table] = protocolMaxRead(static_cast<Table>(table));
+        maxWriteQuantity_[table] = protocolMaxWrite(static_cast<Table>(table));
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+DeviceProfile::setMaxReadQuantity(Table table, int quantity)
+{
+    maxReadQuantity_[table] = qBound(1, quantity, protocolMaxRead(table));
+}
+
+//-----------------------------------------------------------------------------
+
+void
+DeviceProfile::setMaxWriteQuantity(Table table, int quantity)
+{
+    // Tables which can not be written keep zero limit
+    //
+    // Таблицы, недоступные для записи, сохраняют нулевой предел
+    //
+    if (protocolMaxWrite(table) > 0)
+        maxWriteQuantity_[table] = qBound(1, quantity, protocolMaxWrite(table));
+}
+
+//-----------------------------------------------------------------------------
+
+void
+DeviceProfile::setValidRanges(Table table, const QList<Range>& ranges)
+{
+    QList<Range> sorted = ranges;
+    std::sort(sorted.begin(), sorted.end(), rangeLessThan);
+
+    QList<Range>& result = validRanges_[table];
+    result.clear();
+
+    foreach (const Range& range, sorted)
+    {
+        if (range.end < range.start)
+            continue;
+
+        // Overlapping and adjacent ranges are joined
+        //
+        // Перекрывающиеся и смежные диапазоны объединяются
+        //
+        if (!result.isEmpty() && (range.start <= result.last().end + 1))
+            result.last().end = qMax(result.last().end, range.end);
+        else
+            result.append(range);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DeviceProfile::isValid(Table table, quint16 start, int quantity) const
+{
+    const QList<Range>& ranges = validRanges_[table];
+
+    if (ranges.isEmpty())
+        return true;
+
+    int end = start + quantity - 1;
+
+    foreach (const Range& range, ranges)
+    {
+        if ((start >= range.start) && (end <= range.end))
+            return true;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+
+QList<DeviceProfile::Range>
+DeviceProfile::planReads(Table table, const QList<Range>& wanted, int maxGap) const
+{
+    QList<Range> sorted = wanted;
+    std::sort(sorted.begin(), sorted.end(), rangeLessThan);
+
+    QList<Range> joined;
+
+    foreach (const Range& range, sorted)
+    {
+        if (!joined.isEmpty())
+        {
+            Range& last = joined.last();
+
+            int gap = range.start - last.end - 1;
+            quint16 end = qMax(last.end, range.end);
+
+            // Gap is read too, so it must not contain invalid addresses
+            //
+            // Промежуток тоже читается, поэтому он не должен содержать недопустимых адресов
+            //
+            if ((gap <= 0) || ((gap <= maxGap) && isValid(table, last.start, end - last.start + 1)))
+            {
+                last.end = end;
+                continue;
+            }
+        }
+
+        joined.append(range);
+    }
+
+    QList<Range> result;
+    const int maxQuantity = maxReadQuantity_[table];
+
+    foreach (const Range& range, joined)
+    {
+        for (int start = range.start; start <= range.end; start += maxQuantity)
+            result.append(Range(start, qMin(start + maxQuantity - 1, int(range.end))));
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+QJsonObject
+DeviceProfile::toJson() const
+{
+    QJsonObject json;
+    json["unitId"] = unitId_;
+
+    if (discovered_.isValid())
+        json["discovered"] = discovered_.toString(Qt::ISODate);
+
+    QJsonObject functions;
+    for (int function = 0; function < 256; ++function)
+    {
+        if (functions_[function] != Unknown)
+            functions[QString::number(function)] = QString(SupportNames[functions_[function]]);
+    }
+    json["functions"] = functions;
+
+    QJsonObject tables;
+    for (int table = 0; table < TableCount; ++table)
+    {
+        QJsonObject tableJson;
+        tableJson["maxRead"] = maxReadQuantity_[table];
+
+        if ((table == Coils) || (table == HoldingRegisters))
+            tableJson["maxWrite"] = maxWriteQuantity_[table];
+
+        QJsonArray ranges;
+        foreach (const Range& range, validRanges_[table])
+        {
+            QJsonArray pair;
+            pair.append(range.start);
+            pair.append(range.end);
+            ranges.append(pair);
+        }
+        tableJson["ranges"] = ranges;
+
+        tables[TableNames[table]] = tableJson;
+    }
+    json["tables"] = tables;
+
+    QJsonObject identification;
+    for (QMap<quint8, QByteArray>::const_iterator i = identification_.constBegin(); i != identification_.constEnd(); ++i)
+        identification[QString::number(i.key())] = QString::fromLatin1(i.value());
+    json["identification"] = identification;
+
+    return json;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DeviceProfile::fromJson(const QJsonObject& json)
+{
+    if (!json.contains("unitId") || !json.contains("tables"))
+        return false;
+
+    *this = DeviceProfile(json["unitId"].toInt());
+
+    discovered_ = QDateTime::fromString(json["discovered"].toString(), Qt::ISODate);
+
+    QJsonObject functions = json["functions"].toObject();
+    foreach (const QString& key, functions.keys())
+    {
+        int function = key.toInt();
+        QString support = functions[key].toString();
+
+        if ((function < 0) || (function > 255))
+            continue;
+
+        if (support == SupportNames[Supported])
+            functions_[function] = Supported;
+        else if (support == SupportNames[Unsupported])
+            functions_[function] = Unsupported;
+    }
+
+    QJsonObject tables = json["tables"].toObject();
+    for (int table = 0; table < TableCount; ++table)
+    {
+        QJsonObject tableJson = tables[TableNames[table]].toObject();
+
+        if (tableJson.contains("maxRead"))
+            setMaxReadQuantity(static_cast<Table>(table), tableJson["maxRead"].toInt());
+
+        if (tableJson.contains("maxWrite"))
+            setMaxWriteQuantity(static_cast<Table>(table), tableJson["maxWrite"].toInt());
+
+        QList<Range> ranges;
+        foreach (const QJsonValue& value, tableJson["ranges"].toArray())
+        {
+            QJsonArray pair = value.toArray();
+            if (pair.size() == 2)
+                ranges.append(Range(pair[0].toInt(), pair[1].toInt()));
+        }
+        setValidRanges(static_cast<Table>(table), ranges);
+    }
+
+    QJsonObject identification = json["identification"].toObject();
+    foreach (const QString& key, identification.keys())
+        identification_.insert(key.toInt(), identification[key].toString().toLatin1());
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+quint8
+DeviceProfile::readFunction(Table table)
+{
+    switch (table)
+    {
+        case Coils :
+            return Functions::ReadCoils;
+
+        case DiscreteInputs :
+            return Functions::ReadDescereteInputs;
+
+        case HoldingRegisters :
+            return Functions::ReadHoldingRegisters;
+
+        default :
+            return Functions::ReadInputRegisters;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int
+DeviceProfile::protocolMaxRead(Table table)
+{
+    return ((table == Coils) || (table == DiscreteInputs)) ? MaxCoilsForRead : MaxRegistersForRead;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+DeviceProfile::protocolMaxWrite(Table table)
+{
+    switch (table)
+    {
+        case Coils :
+            return MaxCoilsForWrite;
+
+        case HoldingRegisters :
+            return MaxRegistersForWrite;
+
+        default :
+            return 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DeviceProfileCache::load(const QString& fileName)
+{
+    profiles_.clear();
+
+    QFile file(fileName);
+
+    if (!file.exists())
+        return true;
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        errorString_ = file.errorString();
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+
+    if (document.isNull())
+    {
+        errorString_ = error.errorString();
+        return false;
+    }
+
+    QJsonObject profiles = document.object()["profiles"].toObject();
+
+    foreach (const QString& key, profiles.keys())
+    {
+        DeviceProfile profile;
+        if (profile.fromJson(profiles[key].toObject()))
+            profiles_.insert(key, profile);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DeviceProfileCache::save(const QString& fileName)
+{
+    QJsonObject profiles;
+
+    for (QMap<QString, DeviceProfile>::const_iterator i = profiles_.constBegin(); i != profiles_.constEnd(); ++i)
+        profiles[i.key()] = i.value().toJson();
+
+    QJsonObject root;
+    root["version"] = 1;
+    root["profiles"] = profiles;
+
+    // File is replaced only after new contents are written completely
+    //
+    // Файл заменяется только после полной записи нового содержимого
+    //
+    QSaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        errorString_ = file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+
+    if (!file.commit())
+    {
+        errorString_ = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace modbus4qt
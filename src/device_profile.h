@@ -0,0 +1,315 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_DEVICE_PROFILE_H
+#define MODBUS4QT_DEVICE_PROFILE_H
+
+#include "global.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Capabilities and transfer limits of one unit
+ * @ru Возможности и ограничения обмена данными одного устройства
+ *
+ * @en Profile holds supported function codes, maximum block sizes and valid
+ * address ranges of unit tables, as well as identification objects read by
+ * function 0x2B/0x0E. Profile is filled by DeviceDiscovery or by application
+ * and is used by Client to split requests (see Client::setDeviceProfile()).
+ * Unknown values are treated optimistically: function is supported, limit
+ * is protocol maximum, all addresses are valid.
+ *
+ * @ru Профиль содержит поддерживаемые коды функций, максимальные размеры
+ * блоков и допустимые диапазоны адресов таблиц устройства, а также объекты
+ * идентификации, прочитанные функцией 0x2B/0x0E. Профиль заполняется
+ * DeviceDiscovery или приложением и используется Client для разделения
+ * запросов (см. Client::setDeviceProfile()). Неизвестные значения
+ * трактуются оптимистично: функция поддерживается, предел равен максимуму
+ * протокола, все адреса допустимы.
+ */
+class MODBUS4QT_EXPORT DeviceProfile
+{
+    public:
+
+        //! @en Data tables of unit @ru Таблицы данных устройства
+        enum Table
+        {
+            Coils,
+            DiscreteInputs,
+            HoldingRegisters,
+            InputRegisters,
+            TableCount
+        };
+
+        enum Support
+        {
+            Unknown,
+            Supported,
+            Unsupported
+        };
+
+        //! @en Standard identification objects @ru Стандартные объекты идентификации
+        enum ObjectId
+        {
+            VendorName = 0x00,
+            ProductCode = 0x01,
+            MajorMinorRevision = 0x02,
+            VendorUrl = 0x03,
+            ProductName = 0x04,
+            ModelName = 0x05
+        };
+
+        /**
+         * @brief
+         * @en Range of addresses, end is inclusive
+         * @ru Диапазон адресов, конец включается в диапазон
+         */
+        struct Range
+        {
+            quint16 start;
+
+            quint16 end;
+
+            Range(quint16 s = 0, quint16 e = 0)
+                : start(s),
+                  end(e)
+            {
+            }
+
+            int count() const
+            {
+                return end - start + 1;
+            }
+        };
+
+    private:
+
+        quint8 unitId_;
+
+        quint8 functions_[256];
+
+        int maxReadQuantity_[TableCount];
+
+        int maxWriteQuantity_[TableCount];
+
+        //! @en Valid addresses; empty list means all addresses are valid @ru Допустимые адреса; пустой список означает, что допустимы все адреса
+        QList<Range> validRanges_[TableCount];
+
+        QMap<quint8, QByteArray> identification_;
+
+        QDateTime discovered_;
+
+    public:
+
+        explicit DeviceProfile(quint8 unitId = 0);
+
+        quint8 unitId() const
+        {
+            return unitId_;
+        }
+
+        void setUnitId(quint8 unitId)
+        {
+            unitId_ = unitId;
+        }
+
+        Support functionSupport(quint8 function) const
+        {
+            return static_cast<Support>(functions_[function]);
+        }
+
+        void setFunctionSupport(quint8 function, Support support)
+        {
+            functions_[function] = support;
+        }
+
+        //! @en True unless function is known to be unsupported @ru True, если не известно, что функция не поддерживается
+        bool isFunctionSupported(quint8 function) const
+        {
+            return functions_[function] != Unsupported;
+        }
+
+        //! @en Maximum items for one read request @ru Максимальное количество элементов для одного запроса чтения
+        int maxReadQuantity(Table table) const
+        {
+            return maxReadQuantity_[table];
+        }
+
+        //! @en Value is bounded by protocol maximum @ru Значение ограничивается максимумом протокола
+        void setMaxReadQuantity(Table table, int quantity);
+
+        //! @en Maximum items for one write request, coils and holding registers only @ru Максимальное количество элементов для одного запроса записи, только для дискретных выходов и регистров вывода
+        int maxWriteQuantity(Table table) const
+        {
+            return maxWriteQuantity_[table];
+        }
+
+        void setMaxWriteQuantity(Table table, int quantity);
+
+        QList<Range> validRanges(Table table) const
+        {
+            return validRanges_[table];
+        }
+
+        //! @en Set valid ranges, they are sorted and merged @ru Устанавливает допустимые диапазоны, они сортируются и объединяются
+        void setValidRanges(Table table, const QList<Range>& ranges);
+
+        //! @en True if all addresses of block are valid @ru True, если все адреса блока допустимы
+        bool isValid(Table table, quint16 start, int quantity) const;
+
+        /**
+         * @brief
+         * @en Form read requests for set of wanted blocks
+         * @ru Формирует запросы чтения для набора нужных блоков
+         *
+         * @en Wanted blocks are sorted and joined if the gap between them is not
+         * longer than maxGap and the joined block stays inside one valid range.
+         * Resulting blocks are split by maximum read quantity.
+         *
+         * @ru Нужные блоки сортируются и объединяются, если промежуток между ними
+         * не длиннее maxGap и объединенный блок остается внутри одного допустимого
+         * диапазона. Полученные блоки разделяются по максимальному количеству
+         * элементов для чтения.
+         */
+        QList<Range> planReads(Table table, const QList<Range>& wanted, int maxGap = 0) const;
+
+        QMap<quint8, QByteArray> identification() const
+        {
+            return identification_;
+        }
+
+        void setIdentification(const QMap<quint8, QByteArray>& objects)
+        {
+            identification_ = objects;
+        }
+
+        //! @en Identification object as text @ru Объект идентификации в виде текста
+        QString identificationString(quint8 objectId) const
+        {
+            return QString::fromLatin1(identification_.value(objectId));
+        }
+
+        QDateTime discovered() const
+        {
+            return discovered_;
+        }
+
+        void setDiscovered(const QDateTime& time)
+        {
+            discovered_ = time;
+        }
+
+        QJsonObject toJson() const;
+
+        //! @en Fill profile from JSON, false if object is not a profile @ru Заполняет профиль из JSON, false, если объект не является профилем
+        bool fromJson(const QJsonObject& json);
+
+        //! @en Function reading table @ru Функция чтения таблицы
+        static quint8 readFunction(Table table);
+
+        //! @en Protocol maximum of items for one read request @ru Максимум протокола для количества элементов одного запроса чтения
+        static int protocolMaxRead(Table table);
+
+        static int protocolMaxWrite(Table table);
+};
+
+/**
+ * @brief
+ * @en Set of device profiles stored in file
+ * @ru Набор профилей устройств, хранящийся в файле
+ *
+ * @en Profiles are stored by key, which is usually formed by key() from
+ * address of server or port name and unit ID. File is JSON document and is
+ * replaced atomically by save().
+ *
+ * @ru Профили хранятся по ключу, который обычно формируется функцией key()
+ * из адреса сервера или имени порта и номера устройства. Файл - документ
+ * JSON, save() заменяет его атомарно.
+ */
+class MODBUS4QT_EXPORT DeviceProfileCache
+{
+    private:
+
+        QMap<QString, DeviceProfile> profiles_;
+
+        QString errorString_;
+
+    public:
+
+        //! @en Load profiles, missing file is not an error @ru Загружает профили, отсутствие файла не является ошибкой
+        bool load(const QString& fileName);
+
+        bool save(const QString& fileName);
+
+        bool contains(const QString& key) const
+        {
+            return profiles_.contains(key);
+        }
+
+        DeviceProfile profile(const QString& key) const
+        {
+            return profiles_.value(key);
+        }
+
+        void insert(const QString& key, const DeviceProfile& profile)
+        {
+            profiles_.insert(key, profile);
+        }
+
+        void remove(const QString& key)
+        {
+            profiles_.remove(key);
+        }
+
+        QList<QString> keys() const
+        {
+            return profiles_.keys();
+        }
+
+        QString errorString() const
+        {
+            return errorString_;
+        }
+
+        //! @en Key for unit behind endpoint, e.g. "192.168.0.10:502#1" @ru Ключ устройства за конечной точкой, например "192.168.0.10:502#1"
+        static QString key(const QString& endpoint, quint8 unitId)
+        {
+            return QString("%1#%2").arg(endpoint).arg(unitId);
+        }
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_DEVICE_PROFILE_H
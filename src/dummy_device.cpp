@@ -13,12 +13,311 @@
 namespace modbus4qt
 {
 
-DummyDevice::DummyDevice()
+// Tables cover full MODBUS address space: 0x0000..0xFFFF
+//
+// Таблицы охватывают все адресное пространство MODBUS: 0x0000..0xFFFF
+//
+static const int TableSize = 0x10000;
+
+//-----------------------------------------------------------------------------
+
+DummyDevice::DummyDevice(QObject *parent)
+    : Device(500, 500, parent),
+      registerImage_(0),
+      flushTimer_(this)
 {
+    connect(&flushTimer_, SIGNAL(timeout()), this, SLOT(flushImage_()));
+}
+
+//-----------------------------------------------------------------------------
 
+DummyDevice::~DummyDevice()
+{
+    flushTimer_.stop();
+    delete registerImage_;
 }
 
-} // namespace modbus4qt
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::enableSharedImage(const QString& name)
+{
+    disableRegisterImage();
+
+    registerImage_ = new SharedRegisterImage(name);
+
+    if (!registerImage_->create())
+    {
+        emit errorMessage(registerImage_->errorString());
+        return false;
+    }
+
+    copyTablesToImage_();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::enablePersistentImage(const QString& fileName, int flushInterval)
+{
+    disableRegisterImage();
+
+    registerImage_ = new SharedRegisterImage();
+
+    if (!registerImage_->openFile(fileName))
+    {
+        emit errorMessage(registerImage_->errorString());
+        return false;
+    }
+
+    if (registerImage_->isRestored())
+        emit infoMessage(QString("Register image restored from %1, generation %2").arg(fileName).arg(registerImage_->generation()));
+    else
+        copyTablesToImage_();
+
+    flushTimer_.start(flushInterval);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+DummyDevice::disableRegisterImage()
+{
+    if (!registerImage_)
+        return;
+
+    flushTimer_.stop();
+
+    if (registerImage_->isAttached())
+    {
+        // Zero ranges of image do not allocate pages
+        //
+        // Нулевые диапазоны образа не выделяют страниц
+        //
+        QVector<bool> bits(TableSize);
+        QVector<quint16> registers(TableSize);
+
+        registerImage_->readBits(SharedRegisterImage::Coils, 0, TableSize, bits.data());
+        coils_.write(0, TableSize, bits.constData());
 
+        registerImage_->readBits(SharedRegisterImage::DiscreteInputs, 0, TableSize, bits.data());
+        discreteInputs_.write(0, TableSize, bits.constData());
+
+        registerImage_->readRegisters(SharedRegisterImage::HoldingRegisters, 0, TableSize, registers.data());
+        holdingRegisters_.write(0, TableSize, registers.constData());
+
+        registerImage_->readRegisters(SharedRegisterImage::InputRegisters, 0, TableSize, registers.data());
+        inputRegisters_.write(0, TableSize, registers.constData());
+    }
+
+    // File image is flushed when detached
+    delete registerImage_;
+    registerImage_ = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+DummyDevice::flushImage_()
+{
+    if (registerImage_ && !registerImage_->flush())
+        emit errorMessage(registerImage_->errorString());
+}
+
+//-----------------------------------------------------------------------------
+
+void
+DummyDevice::copyTablesToImage_()
+{
+    QVector<bool> bits(TableSize);
+    QVector<quint16> registers(TableSize);
+
+    coils_.read(0, TableSize, bits.data());
+    registerImage_->writeBits(SharedRegisterImage::Coils, 0, TableSize, bits.constData());
+
+    discreteInputs_.read(0, TableSize, bits.data());
+    registerImage_->writeBits(SharedRegisterImage::DiscreteInputs, 0, TableSize, bits.constData());
+
+    holdingRegisters_.read(0, TableSize, registers.data());
+    registerImage_->writeRegisters(SharedRegisterImage::HoldingRegisters, 0, TableSize, registers.constData());
+
+    inputRegisters_.read(0, TableSize, registers.data());
+    registerImage_->writeRegisters(SharedRegisterImage::InputRegisters, 0, TableSize, registers.constData());
+
+    // Values live in image now
+    //
+    // Теперь значения хранятся в образе
+    //
+    coils_.clear();
+    discreteInputs_.clear();
+    holdingRegisters_.clear();
+    inputRegisters_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::readCoil(quint16 regNo, bool &value)
+{
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->readBits(SharedRegisterImage::Coils, regNo, 1, &value);
+
+    value = coils_.value(regNo);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::readCoils(quint16 regStart, quint16 regQty, bool* values)
+{
+    if (regStart + regQty > TableSize)
+        return false;
+
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->readBits(SharedRegisterImage::Coils, regStart, regQty, values);
+
+    coils_.read(regStart, regQty, values);
+    return true;
+}
 
+//-----------------------------------------------------------------------------
 
+bool
+DummyDevice::readDescreteInput(quint16 regNo, bool &value)
+{
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->readBits(SharedRegisterImage::DiscreteInputs, regNo, 1, &value);
+
+    value = discreteInputs_.value(regNo);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::readDescreteInputs(quint16 regStart, quint16 regQty, bool* values)
+{
+    if (regStart + regQty > TableSize)
+        return false;
+
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->readBits(SharedRegisterImage::DiscreteInputs, regStart, regQty, values);
+
+    discreteInputs_.read(regStart, regQty, values);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::readInputRegister(quint16 regNo, quint16 &value)
+{
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->readRegisters(SharedRegisterImage::InputRegisters, regNo, 1, &value);
+
+    value = inputRegisters_.value(regNo);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::readInputRegisters(quint16 regStart, quint16 regQty, quint16* values)
+{
+    if (regStart + regQty > TableSize)
+        return false;
+
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->readRegisters(SharedRegisterImage::InputRegisters, regStart, regQty, values);
+
+    inputRegisters_.read(regStart, regQty, values);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::readHoldingRegister(quint16 regNo, quint16 &value)
+{
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->readRegisters(SharedRegisterImage::HoldingRegisters, regNo, 1, &value);
+
+    value = holdingRegisters_.value(regNo);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::readHoldingRegisters(quint16 regStart, quint16 regQty, quint16* values)
+{
+    if (regStart + regQty > TableSize)
+        return false;
+
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->readRegisters(SharedRegisterImage::HoldingRegisters, regStart, regQty, values);
+
+    holdingRegisters_.read(regStart, regQty, values);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::writeCoil(quint16 regNo, bool value)
+{
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->writeBits(SharedRegisterImage::Coils, regNo, 1, &value);
+
+    coils_.setValue(regNo, value);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::writeHoldingRegister(quint16 regNo, quint16 value)
+{
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->writeRegisters(SharedRegisterImage::HoldingRegisters, regNo, 1, &value);
+
+    holdingRegisters_.setValue(regNo, value);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::writeCoils(quint16 regStart, const bool* values, quint16 regQty)
+{
+    if (regStart + regQty > TableSize)
+        return false;
+
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->writeBits(SharedRegisterImage::Coils, regStart, regQty, values);
+
+    coils_.write(regStart, regQty, values);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+DummyDevice::writeHoldingRegisters(quint16 regStart, const quint16* values, quint16 regQty)
+{
+    if (regStart + regQty > TableSize)
+        return false;
+
+    if (registerImage_ && registerImage_->isAttached())
+        return registerImage_->writeRegisters(SharedRegisterImage::HoldingRegisters, regStart, regQty, values);
+
+    holdingRegisters_.write(regStart, regQty, values);
+    return true;
+}
+
+} // namespace modbus4qt
@@ -12,7 +12,10 @@
 #define DUMMYDEVICE_H
 
 #include "device.h"
+#include "paged_table.h"
+#include "shared_register_image.h"
 
+#include <QTimer>
 #include <QVector>
 
 namespace modbus4qt
@@ -26,7 +29,7 @@ namespace modbus4qt
  * @en Class is intented for testing purposes
  * @ru Класс предназначен для тестирования
  */
-class DummyDevice : public Device
+class MODBUS4QT_EXPORT DummyDevice : public Device
 {
     Q_OBJECT
 
@@ -37,31 +40,136 @@ class DummyDevice : public Device
          * @en Array for coils
          * @ru Массив для хранения значений дискретных выходов
          */
-        QVector<bool> coils_;
+        PagedTable<bool> coils_;
 
         /**
          * @brief
          * @en Array for descrete inputs
          * @ru Массив для хранения значений дискретных входов
          */
-        QVector<bool> discreteInputs_;
+        PagedTable<bool> discreteInputs_;
 
         /**
          * @brief
          * @en Array for input registers
          * @ru Массив для хранения значений регистров ввода
          */
-        QVector<quint16> holdingRegisters_;
+        PagedTable<quint16> holdingRegisters_;
 
         /**
          * @brief
          * @en Array for holding registers
          * @ru Массив для храненения значений регистров вывода
          */
-        QVector<quint16> inputRegisters_;
+        PagedTable<quint16> inputRegisters_;
+
+        /**
+         * @brief
+         * @en Image in shared memory or file which replaces tables, if enabled
+         * @ru Образ в разделяемой памяти или файле, заменяющий таблицы, если включен
+         */
+        SharedRegisterImage* registerImage_;
+
+        //! @en Timer for flushing file image @ru Таймер сброса образа в файл
+        QTimer flushTimer_;
 
     public:
-        DummyDevice();
+
+        /**
+         * @brief
+         * @en Default constructor. Tables cover full address space and read as zeros;
+         * memory is taken only by pages written.
+         * @ru Конструктор по умолчанию. Таблицы охватывают все адресное пространство
+         * и читаются как нули; память занимают только записанные страницы.
+         *
+         * @param
+         * @en parent - parent object
+         * @ru parent - указатель на объект-родитель
+         */
+        explicit DummyDevice(QObject *parent = 0);
+
+        virtual ~DummyDevice();
+
+        /**
+         * @brief
+         * @en Move tables into named POSIX shared memory segment
+         * @ru Переносит таблицы в именованный сегмент разделяемой памяти POSIX
+         *
+         * @en Current values are copied into segment, then device reads and
+         * writes segment only. Other processes may attach to segment by
+         * SharedRegisterImage::attach() and read values without copying them
+         * through MODBUS or other IPC.
+         *
+         * @ru Текущие значения копируются в сегмент, после чего устройство
+         * читает и записывает только сегмент. Другие процессы могут
+         * подключиться к сегменту через SharedRegisterImage::attach() и читать
+         * значения без передачи через MODBUS или другие средства IPC.
+         *
+         * @return
+         * @en false if segment can not be created; see registerImage()->errorString()
+         * @ru false, если сегмент не удалось создать; см. registerImage()->errorString()
+         */
+        bool enableSharedImage(const QString& name);
+
+        /**
+         * @brief
+         * @en Keep tables in memory mapped file, so values survive restart
+         * @ru Хранит таблицы в отображаемом в память файле, чтобы значения сохранялись при перезапуске
+         *
+         * @en If file contains image saved before, values are restored from it
+         * at once, otherwise current values are copied into file. Changed pages
+         * are written to disk in batches every flushInterval ms and when image
+         * is disabled.
+         *
+         * @ru Если файл содержит ранее сохраненный образ, значения сразу
+         * восстанавливаются из него, иначе в файл копируются текущие значения.
+         * Измененные страницы записываются на диск пакетами каждые
+         * flushInterval мс и при отключении образа.
+         */
+        bool enablePersistentImage(const QString& fileName, int flushInterval = 100);
+
+        //! @en Copy values back into tables and release image @ru Копирует значения обратно в таблицы и освобождает образ
+        void disableRegisterImage();
+
+        SharedRegisterImage* registerImage() const
+        {
+            return registerImage_;
+        }
+
+    protected:
+
+        virtual bool readCoil(quint16 regNo, bool &value);
+
+        virtual bool readCoils(quint16 regStart, quint16 regQty, bool* values);
+
+        virtual bool readDescreteInput(quint16 regNo, bool &value);
+
+        virtual bool readDescreteInputs(quint16 regStart, quint16 regQty, bool* values);
+
+        virtual bool readInputRegister(quint16 regNo, quint16 &value);
+
+        virtual bool readInputRegisters(quint16 regStart, quint16 regQty, quint16* values);
+
+        virtual bool readHoldingRegister(quint16 regNo, quint16 &value);
+
+        virtual bool readHoldingRegisters(quint16 regStart, quint16 regQty, quint16* values);
+
+        virtual bool writeCoil(quint16 regNo, bool value);
+
+        virtual bool writeHoldingRegister(quint16 regNo, quint16 value);
+
+        virtual bool writeCoils(quint16 regStart, const bool* values, quint16 regQty);
+
+        virtual bool writeHoldingRegisters(quint16 regStart, const quint16* values, quint16 regQty);
+
+    private slots:
+
+        void flushImage_();
+
+    private:
+
+        //! @en Copy tables into image just created @ru Копирует таблицы в только что созданный образ
+        void copyTablesToImage_();
 };
 
 } // namespace modbus4qt
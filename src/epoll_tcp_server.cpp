@@ -0,0 +1,456 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "epoll_tcp_server.h"
+
+#ifdef Q_OS_LINUX
+    #include "native_socket.h"
+
+    #include <QSocketNotifier>
+
+    #include <errno.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <string.h>
+    #include <sys/epoll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace modbus4qt
+{
+
+// Buffers hold several maximum size ADUs, so pipelined requests are served
+// by one read and their responses are sent by one write
+//
+// Буферы вмещают несколько ADU максимального размера, поэтому конвейерные
+// запросы обслуживаются одним чтением, а ответы на них передаются одной записью
+//
+static const int InBufferSize = 4 * TcpADUMaxSize;
+static const int OutBufferSize = 4 * TcpADUMaxSize;
+
+//! @en Events handled per epoll_wait() call @ru Количество событий, обрабатываемых за один вызов epoll_wait()
+static const int MaxEvents = 256;
+
+struct EpollTcpServer::Connection
+{
+    int fd;
+
+    //! @en Received bytes in input buffer @ru Количество полученных байт во входном буфере
+    int inSize;
+
+    //! @en Bytes already written from output buffer @ru Количество байт, уже записанных из выходного буфера
+    int outOffset;
+
+    int outSize;
+
+    quint8 in[InBufferSize];
+
+    quint8 out[OutBufferSize];
+};
+
+//-----------------------------------------------------------------------------
+
+EpollTcpServer::EpollTcpServer(QObject *parent)
+    : Server(parent),
+      listenFd_(-1),
+      port_(0),
+      connectionCount_(0),
+      maxConnections_(16384),
+      epollFd_(-1),
+      notifier_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+EpollTcpServer::~EpollTcpServer()
+{
+    close();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+EpollTcpServer::listen(const QHostAddress& address, quint16 port)
+{
+    close();
+
+#ifdef Q_OS_LINUX
+    QString error;
+    listenFd_ = openNativeSocket(address, port, true, &port_, &error);
+
+    if (listenFd_ < 0)
+    {
+        emit errorMessage(error);
+        return false;
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+
+    // Listening socket is marked by null pointer
+    //
+    // Сокет, ожидающий подключений, обозначается нулевым указателем
+    //
+    epoll_event event;
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = 0;
+
+    if ((epollFd_ < 0) || (epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event) != 0))
+    {
+        emit errorMessage(tr("Can not create epoll instance: %1").arg(strerror(errno)));
+        close();
+        return false;
+    }
+
+    notifier_ = new QSocketNotifier(epollFd_, QSocketNotifier::Read, this);
+    connect(notifier_, SIGNAL(activated(int)), this, SLOT(processEvents_()));
+
+    return true;
+#else
+    Q_UNUSED(address)
+    Q_UNUSED(port)
+
+    emit errorMessage(tr("EpollTcpServer is available on Linux only, use TcpServer"));
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+EpollTcpServer::close()
+{
+#ifdef Q_OS_LINUX
+    delete notifier_;
+    notifier_ = 0;
+
+    foreach (Connection* connection, connections_)
+    {
+        if (connection->fd >= 0)
+            ::close(connection->fd);
+    }
+
+    qDeleteAll(connections_);
+    connections_.clear();
+    freeConnections_.clear();
+    connectionCount_ = 0;
+
+    if (epollFd_ >= 0)
+        ::close(epollFd_);
+
+    if (listenFd_ >= 0)
+        ::close(listenFd_);
+
+    epollFd_ = -1;
+    listenFd_ = -1;
+    port_ = 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+EpollTcpServer::processEvents_()
+{
+#ifdef Q_OS_LINUX
+    epoll_event events[MaxEvents];
+
+    forever
+    {
+        int count = epoll_wait(epollFd_, events, MaxEvents, 0);
+
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        for (int i = 0; i < count; ++i)
+        {
+            Connection* connection = static_cast<Connection*>(events[i].data.ptr);
+
+            if (!connection)
+            {
+                accept_();
+                continue;
+            }
+
+            // Connection may be closed by previous event of this batch
+            //
+            // Подключение могло быть закрыто предыдущим событием этого пакета
+            //
+            if (connection->fd < 0)
+                continue;
+
+            if (events[i].events & EPOLLERR)
+            {
+                closeConnection_(connection);
+                continue;
+            }
+
+            // Hang up is noticed by serve_() when read returns 0
+            //
+            // Закрытие подключения обнаруживается в serve_(), когда чтение возвращает 0
+            //
+            serve_(connection);
+        }
+
+        if (count < MaxEvents)
+            break;
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+EpollTcpServer::accept_()
+{
+#ifdef Q_OS_LINUX
+    forever
+    {
+        int fd = accept4(listenFd_, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+                emit errorMessage(tr("Can not accept connection: %1").arg(strerror(errno)));
+
+            return;
+        }
+
+        if (connectionCount_ >= maxConnections_)
+        {
+            ::close(fd);
+            continue;
+        }
+
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        Connection* connection;
+
+        if (freeConnections_.isEmpty())
+        {
+            connection = new Connection;
+            connections_.append(connection);
+        }
+        else
+        {
+            connection = freeConnections_.takeLast();
+        }
+
+        connection->fd = fd;
+        connection->inSize = 0;
+        connection->outOffset = 0;
+        connection->outSize = 0;
+
+        // Readiness at the moment of registration is reported at once, so
+        // requests recieved before it are not lost
+        //
+        // Готовность в момент регистрации сообщается сразу, поэтому запросы,
+        // полученные до нее, не теряются
+        //
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        event.data.ptr = connection;
+
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            emit errorMessage(tr("Can not watch connection: %1").arg(strerror(errno)));
+            ::close(fd);
+            connection->fd = -1;
+            freeConnections_.append(connection);
+            continue;
+        }
+
+        ++connectionCount_;
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+EpollTcpServer::serve_(Connection* connection)
+{
+#ifdef Q_OS_LINUX
+    // In edge-triggered mode socket must be read until it would block,
+    // otherwise no new event comes. The only exception is full output buffer:
+    // reading continues on EPOLLOUT event when client reads responses.
+    //
+    // В режиме срабатывания по фронту сокет необходимо читать, пока он не
+    // заблокируется, иначе новое событие не придет. Единственное исключение -
+    // заполненный выходной буфер: чтение продолжается по событию EPOLLOUT,
+    // когда клиент прочитает ответы.
+    //
+    forever
+    {
+        if (!processInput_(connection) || !flushOutput_(connection))
+        {
+            closeConnection_(connection);
+            return false;
+        }
+
+        if (OutBufferSize - connection->outSize < TcpADUMaxSize)
+            return true;
+
+        ssize_t received = recv(connection->fd, connection->in + connection->inSize,
+                                InBufferSize - connection->inSize, 0);
+
+        if (received > 0)
+        {
+            connection->inSize += received;
+            continue;
+        }
+
+        if (received < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+        }
+
+        closeConnection_(connection);
+        return false;
+    }
+#else
+    Q_UNUSED(connection)
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+EpollTcpServer::processInput_(Connection* connection)
+{
+    const int headerSize = sizeof(TcpDataHeader);
+
+    int offset = 0;
+
+    while (connection->inSize - offset >= headerSize)
+    {
+        const quint8* adu = connection->in + offset;
+
+        int frameSize = tcpADUSize_(adu);
+
+        if (frameSize < 0)
+        {
+            emit errorMessage(tr("Wrong application data unit recieved, connection closed!"));
+            return false;
+        }
+
+        if (connection->inSize - offset < frameSize)
+            break;
+
+        if (OutBufferSize - connection->outSize < TcpADUMaxSize)
+            break;
+
+        connection->outSize += processTcpADU_(adu, frameSize, connection->out + connection->outSize, connection->fd);
+        offset += frameSize;
+    }
+
+    // Rest of incomplete request is moved to the beginning of buffer,
+    // it is shorter than one ADU
+    //
+    // Остаток неполного запроса переносится в начало буфера, он короче одного ADU
+    //
+    if (offset > 0)
+    {
+        connection->inSize -= offset;
+        memmove(connection->in, connection->in + offset, connection->inSize);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+EpollTcpServer::flushOutput_(Connection* connection)
+{
+#ifdef Q_OS_LINUX
+    while (connection->outOffset < connection->outSize)
+    {
+        ssize_t sent = send(connection->fd, connection->out + connection->outOffset,
+                            connection->outSize - connection->outOffset, MSG_NOSIGNAL);
+
+        if (sent > 0)
+        {
+            connection->outOffset += sent;
+            continue;
+        }
+
+        if (errno == EINTR)
+            continue;
+
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return false;
+
+        // Rest is written on EPOLLOUT event
+        //
+        // Остаток записывается по событию EPOLLOUT
+        //
+        connection->outSize -= connection->outOffset;
+        memmove(connection->out, connection->out + connection->outOffset, connection->outSize);
+        connection->outOffset = 0;
+
+        return true;
+    }
+
+    connection->outOffset = 0;
+    connection->outSize = 0;
+
+    return true;
+#else
+    Q_UNUSED(connection)
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+EpollTcpServer::closeConnection_(Connection* connection)
+{
+#ifdef Q_OS_LINUX
+    // Closed descriptor is removed from epoll set automatically
+    //
+    // Закрытый дескриптор автоматически удаляется из набора epoll
+    //
+    ::close(connection->fd);
+#endif
+
+    connection->fd = -1;
+    freeConnections_.append(connection);
+    --connectionCount_;
+}
+
+} // namespace modbus4qt
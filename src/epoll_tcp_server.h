@@ -0,0 +1,183 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_EPOLL_TCP_SERVER_H
+#define MODBUS4QT_EPOLL_TCP_SERVER_H
+
+#include "server.h"
+
+#include <QHostAddress>
+#include <QVector>
+
+class QSocketNotifier;
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en MODBUS/TCP server on Linux epoll
+ * @ru Сервер MODBUS/TCP на основе epoll в Linux
+ *
+ * @en Server for large number of connections. All sockets are registered in one
+ * epoll instance in edge-triggered mode and Qt event loop watches only its
+ * descriptor. Every connection has fixed input and output buffers, requests
+ * are parsed in place and responses are formed directly in output buffer.
+ * Device is read and written through its methods with plain buffers, so
+ * serving requests needs no memory allocation as long as device itself does
+ * not allocate (DummyDevice does not) and nobody is connected to signals with
+ * written values. Connection structures are reused after disconnect. Device
+ * is accessed by the same interface as TcpServer uses.
+ *
+ * When client does not read responses and output buffer is full, requests of
+ * this client are not processed until buffer is drained.
+ *
+ * On other systems listen() fails, TcpServer should be used instead.
+ *
+ * @ru Сервер для большого количества подключений. Все сокеты регистрируются
+ * в одном экземпляре epoll в режиме срабатывания по фронту, цикл событий Qt
+ * следит только за его дескриптором. Каждое подключение имеет входной и
+ * выходной буферы постоянного размера, запросы разбираются на месте, а ответы
+ * формируются прямо в выходном буфере. Чтение и запись устройства выполняются
+ * через его методы с простыми буферами, поэтому обслуживание запросов не
+ * требует выделения памяти, если его не выделяет само устройство (DummyDevice
+ * не выделяет) и к сигналам с записанными значениями никто не подключен.
+ * Структуры подключений повторно используются после отключения. Обращение
+ * к устройству выполняется так же, как в TcpServer.
+ *
+ * Если клиент не читает ответы и выходной буфер заполнен, запросы этого
+ * клиента не обрабатываются до освобождения буфера.
+ *
+ * В других системах listen() завершается с ошибкой, следует использовать TcpServer.
+ */
+class MODBUS4QT_EXPORT EpollTcpServer : public Server
+{
+    Q_OBJECT
+
+    protected:
+
+        int listenFd_;
+
+        quint16 port_;
+
+        int connectionCount_;
+
+        int maxConnections_;
+
+    private:
+
+        struct Connection;
+
+        int epollFd_;
+
+        QSocketNotifier* notifier_;
+
+        //! @en All allocated connections @ru Все выделенные подключения
+        QVector<Connection*> connections_;
+
+        //! @en Connections ready for reuse @ru Подключения, готовые к повторному использованию
+        QVector<Connection*> freeConnections_;
+
+        //! @en Accept all pending connections @ru Принимает все ожидающие подключения
+        void accept_();
+
+        /**
+         * @brief
+         * @en Read, process and answer requests until socket would block
+         * @ru Читает, обрабатывает запросы и отвечает на них, пока сокет не заблокируется
+         *
+         * @return
+         * @en false if connection has been closed
+         * @ru false, если подключение было закрыто
+         */
+        bool serve_(Connection* connection);
+
+        //! @en Process complete requests while there is room for response @ru Обрабатывает полученные запросы, пока есть место для ответа
+        bool processInput_(Connection* connection);
+
+        //! @en Write output buffer until socket would block @ru Записывает выходной буфер, пока сокет не заблокируется
+        bool flushOutput_(Connection* connection);
+
+        void closeConnection_(Connection* connection);
+
+    public:
+
+        explicit EpollTcpServer(QObject *parent = 0);
+
+        virtual ~EpollTcpServer();
+
+        bool isListening() const
+        {
+            return listenFd_ >= 0;
+        }
+
+        quint16 serverPort() const
+        {
+            return port_;
+        }
+
+        //! @en Number of connected clients @ru Количество подключенных клиентов
+        int connectionCount() const
+        {
+            return connectionCount_;
+        }
+
+        int maxConnections() const
+        {
+            return maxConnections_;
+        }
+
+        //! @en Connections over limit are closed at once, default 16384 @ru Подключения сверх предела сразу закрываются, по умолчанию 16384
+        void setMaxConnections(int maxConnections)
+        {
+            maxConnections_ = qMax(1, maxConnections);
+        }
+
+    public slots:
+
+        /**
+         * @brief
+         * @en Start listening for incoming connections
+         * @ru Начинает ожидание подключений клиентов
+         *
+         * @param
+         * @en port - TCP port. If 0 is passed port is chosen automatically.
+         * @ru port - номер TCP порта. Если передан 0, то порт выбирается автоматически.
+         */
+        virtual bool listen(const QHostAddress& address = QHostAddress::Any, quint16 port = DefaultTcpPort);
+
+        //! @en Stop listening and close all client connections @ru Прекращает ожидание подключений и закрывает все подключения клиентов
+        virtual void close();
+
+    private slots:
+
+        //! @en Handle all ready epoll events @ru Обрабатывает все готовые события epoll
+        void processEvents_();
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_EPOLL_TCP_SERVER_H
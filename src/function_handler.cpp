@@ -0,0 +1,234 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "function_handler.h"
+#include "device.h"
+#include "utils.h"
+
+namespace modbus4qt
+{
+
+int
+ReadBitsHandler::processRequest(Device* device, const PduView& request, quint8* response)
+{
+    if (!device)
+        return exception(Exceptions::ServerDeviceFailure);
+
+    if (request.dataSize() < 4)
+        return exception(Exceptions::IllegalDataValue);
+
+    const quint16 regStart = request.word(0);
+    const quint16 regQty = request.word(2);
+
+    if ((regQty < 1) || (regQty > MaxCoilsForRead))
+        return exception(Exceptions::IllegalDataValue);
+
+    if (regStart + regQty > 0x10000)
+        return exception(Exceptions::IllegalDataAddress);
+
+    // Values are read into stack and packed straight into response
+    //
+    // Значения читаются в стек и упаковываются прямо в ответ
+    //
+    bool values[MaxCoilsForRead];
+    bool isOk = (request.functionCode() == Functions::ReadCoils)
+            ? device->readCoils(regStart, regQty, values)
+            : device->readDescreteInputs(regStart, regQty, values);
+
+    if (!isOk)
+        return exception(Exceptions::IllegalDataAddress);
+
+    response[1] = (regQty + 7) / 8;
+    putCoilsIntoBuffer(response + 2, values, regQty);
+
+    return 2 + response[1];
+}
+
+//-----------------------------------------------------------------------------
+
+int
+ReadRegistersHandler::processRequest(Device* device, const PduView& request, quint8* response)
+{
+    if (!device)
+        return exception(Exceptions::ServerDeviceFailure);
+
+    if (request.dataSize() < 4)
+        return exception(Exceptions::IllegalDataValue);
+
+    const quint16 regStart = request.word(0);
+    const quint16 regQty = request.word(2);
+
+    if ((regQty < 1) || (regQty > MaxRegistersForRead))
+        return exception(Exceptions::IllegalDataValue);
+
+    if (regStart + regQty > 0x10000)
+        return exception(Exceptions::IllegalDataAddress);
+
+    quint16 values[MaxRegistersForRead];
+    bool isOk = (request.functionCode() == Functions::ReadHoldingRegisters)
+            ? device->readHoldingRegisters(regStart, regQty, values)
+            : device->readInputRegisters(regStart, regQty, values);
+
+    if (!isOk)
+        return exception(Exceptions::IllegalDataAddress);
+
+    response[1] = regQty * 2;
+    putRegistersIntoBuffer(response + 2, values, regQty);
+
+    return 2 + response[1];
+}
+
+//-----------------------------------------------------------------------------
+
+int
+WriteSingleCoilHandler::processRequest(Device* device, const PduView& request, quint8* response)
+{
+    if (!device)
+        return exception(Exceptions::ServerDeviceFailure);
+
+    if (request.dataSize() < 4)
+        return exception(Exceptions::IllegalDataValue);
+
+    // 0xFF00 - on, 0x0000 - off
+    // See: Modbus Protocol Specification v1.1b3, p. 17
+    const quint16 value = request.word(2);
+
+    if ((value != 0xFF00) && (value != 0x0000))
+        return exception(Exceptions::IllegalDataValue);
+
+    const bool coil = (value == 0xFF00);
+
+    if (!device->commitCoils(request.word(0), &coil, 1))
+        return exception(Exceptions::IllegalDataAddress);
+
+    // Normal response is an echo of request
+    std::copy(request.data(), request.data() + 4, response + 1);
+
+    return 5;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+WriteSingleRegisterHandler::processRequest(Device* device, const PduView& request, quint8* response)
+{
+    if (!device)
+        return exception(Exceptions::ServerDeviceFailure);
+
+    if (request.dataSize() < 4)
+        return exception(Exceptions::IllegalDataValue);
+
+    const quint16 reg = request.word(2);
+
+    if (!device->commitHoldingRegisters(request.word(0), &reg, 1))
+        return exception(Exceptions::IllegalDataAddress);
+
+    // Normal response is an echo of request
+    std::copy(request.data(), request.data() + 4, response + 1);
+
+    return 5;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+WriteMultipleCoilsHandler::processRequest(Device* device, const PduView& request, quint8* response)
+{
+    if (!device)
+        return exception(Exceptions::ServerDeviceFailure);
+
+    if (request.dataSize() < 5)
+        return exception(Exceptions::IllegalDataValue);
+
+    const quint16 regStart = request.word(0);
+    const quint16 regQty = request.word(2);
+    const int byteCount = request.data()[4];
+
+    if ((regQty < 1) || (regQty > MaxCoilsForWrite) ||
+            (byteCount != (regQty + 7) / 8) || (request.dataSize() < 5 + byteCount))
+        return exception(Exceptions::IllegalDataValue);
+
+    if (regStart + regQty > 0x10000)
+        return exception(Exceptions::IllegalDataAddress);
+
+    // Bits are taken from request buffer, LSB of first byte is first coil
+    //
+    // Биты берутся из буфера запроса, младший бит первого байта - первый выход
+    //
+    const quint8* bits = request.data() + 5;
+    bool values[MaxCoilsForWrite];
+
+    for (int i = 0; i < regQty; ++i)
+        values[i] = (bits[i / 8] >> (i % 8)) & 1;
+
+    // Whole request is one write, so observers never see part of it
+    //
+    // Весь запрос - одна запись, поэтому наблюдатели никогда не видят его часть
+    //
+    if (!device->commitCoils(regStart, values, regQty))
+        return exception(Exceptions::IllegalDataAddress);
+
+    std::copy(request.data(), request.data() + 4, response + 1);
+
+    return 5;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+WriteMultipleRegistersHandler::processRequest(Device* device, const PduView& request, quint8* response)
+{
+    if (!device)
+        return exception(Exceptions::ServerDeviceFailure);
+
+    if (request.dataSize() < 5)
+        return exception(Exceptions::IllegalDataValue);
+
+    const quint16 regStart = request.word(0);
+    const quint16 regQty = request.word(2);
+    const int byteCount = request.data()[4];
+
+    if ((regQty < 1) || (regQty > MaxRegistersForWrite) ||
+            (byteCount != regQty * 2) || (request.dataSize() < 5 + byteCount))
+        return exception(Exceptions::IllegalDataValue);
+
+    if (regStart + regQty > 0x10000)
+        return exception(Exceptions::IllegalDataAddress);
+
+    quint16 values[MaxRegistersForWrite];
+
+    for (int i = 0; i < regQty; ++i)
+        values[i] = request.word(5 + i * 2);
+
+    if (!device->commitHoldingRegisters(regStart, values, regQty))
+        return exception(Exceptions::IllegalDataAddress);
+
+    std::copy(request.data(), request.data() + 4, response + 1);
+
+    return 5;
+}
+
+} // namespace modbus4qt
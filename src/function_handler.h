@@ -0,0 +1,211 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_FUNCTION_HANDLER_H
+#define MODBUS4QT_FUNCTION_HANDLER_H
+
+#include "global.h"
+#include "types.h"
+
+namespace modbus4qt
+{
+
+class Device;
+
+/**
+ * @brief
+ * @en Handler of one function code on server side
+ * @ru Обработчик одного кода функции на стороне сервера
+ *
+ * @en Server keeps table of 256 handlers indexed by function code, so standard
+ * functions can be replaced and user defined functions (see
+ * Client::userDefinedFunction) can be added without subclassing of server.
+ * Handler may be shared by several servers and function codes, it should keep
+ * no state of request.
+ *
+ * @ru Сервер хранит таблицу из 256 обработчиков, индексированную кодом функции,
+ * поэтому стандартные функции можно заменять, а пользовательские функции (см.
+ * Client::userDefinedFunction) добавлять без наследования от сервера.
+ * Обработчик может использоваться несколькими серверами и кодами функций, он
+ * не должен хранить состояние запроса.
+ */
+class MODBUS4QT_EXPORT FunctionHandler
+{
+    public:
+
+        virtual ~FunctionHandler()
+        {
+        }
+
+        /**
+         * @brief
+         * @en Process request and form response
+         * @ru Обрабатывает запрос и формирует ответ
+         *
+         * @param
+         * @en device - device of server, may be NULL
+         * @ru device - устройство сервера, может быть NULL
+         *
+         * @param
+         * @en request - request in receive buffer
+         * @ru request - запрос в буфере приема
+         *
+         * @param
+         * @en response - buffer of PDUMaxSize bytes for response protocol data unit,
+         * function code is already placed into response[0]
+         * @ru response - буфер размером PDUMaxSize байт для блока данных протокола
+         * ответа, код функции уже помещен в response[0]
+         *
+         * @return
+         * @en Size of response including function code; exception(code) to send
+         * exception response
+         * @ru Размер ответа, включая код функции; exception(code) для передачи
+         * ответа-исключения
+         */
+        virtual int processRequest(Device* device, const PduView& request, quint8* response) = 0;
+
+        //! @en Return value for exception response @ru Возвращаемое значение для ответа-исключения
+        static int exception(quint8 exceptionCode)
+        {
+            return -int(exceptionCode);
+        }
+};
+
+/**
+ * @brief
+ * @en Forwarder of requests for unit behind gateway
+ * @ru Передатчик запросов для устройства за шлюзом
+ *
+ * @en Server routes all requests for unit to forwarder instead of device, e.g.
+ * to pass them to serial line by Client. Forwarding is synchronous, so slow
+ * target delays other requests of the same server thread.
+ *
+ * @ru Сервер направляет все запросы для устройства передатчику вместо
+ * устройства, например для передачи их в последовательную линию через Client.
+ * Передача синхронная, поэтому медленное устройство задерживает другие запросы
+ * того же потока сервера.
+ *
+ * @sa Server::setUnitForwarder()
+ */
+class MODBUS4QT_EXPORT UnitForwarder
+{
+    public:
+
+        virtual ~UnitForwarder()
+        {
+        }
+
+        /**
+         * @brief
+         * @en Forward request and form response
+         * @ru Передает запрос и формирует ответ
+         *
+         * @return
+         * @en Size of response including function code; FunctionHandler::exception(code)
+         * to send exception response, e.g. GatewayTargetDeviceFailedToResponse
+         * @ru Размер ответа, включая код функции; FunctionHandler::exception(code)
+         * для передачи ответа-исключения, например GatewayTargetDeviceFailedToResponse
+         *
+         * @sa FunctionHandler::processRequest()
+         */
+        virtual int forwardRequest(quint8 unitId, const PduView& request, quint8* response) = 0;
+};
+
+/**
+ * @brief
+ * @en Read coils (0x01) and discrete inputs (0x02)
+ * @ru Чтение дискретных выходов (0x01) и дискретных входов (0x02)
+ */
+class MODBUS4QT_EXPORT ReadBitsHandler : public FunctionHandler
+{
+    public:
+
+        virtual int processRequest(Device* device, const PduView& request, quint8* response);
+};
+
+/**
+ * @brief
+ * @en Read holding (0x03) and input (0x04) registers
+ * @ru Чтение регистров хранения (0x03) и входных регистров (0x04)
+ */
+class MODBUS4QT_EXPORT ReadRegistersHandler : public FunctionHandler
+{
+    public:
+
+        virtual int processRequest(Device* device, const PduView& request, quint8* response);
+};
+
+/**
+ * @brief
+ * @en Write single coil (0x05)
+ * @ru Запись одного дискретного выхода (0x05)
+ */
+class MODBUS4QT_EXPORT WriteSingleCoilHandler : public FunctionHandler
+{
+    public:
+
+        virtual int processRequest(Device* device, const PduView& request, quint8* response);
+};
+
+/**
+ * @brief
+ * @en Write single holding register (0x06)
+ * @ru Запись одного регистра хранения (0x06)
+ */
+class MODBUS4QT_EXPORT WriteSingleRegisterHandler : public FunctionHandler
+{
+    public:
+
+        virtual int processRequest(Device* device, const PduView& request, quint8* response);
+};
+
+/**
+ * @brief
+ * @en Write multiple coils (0x0F)
+ * @ru Запись нескольких дискретных выходов (0x0F)
+ */
+class MODBUS4QT_EXPORT WriteMultipleCoilsHandler : public FunctionHandler
+{
+    public:
+
+        virtual int processRequest(Device* device, const PduView& request, quint8* response);
+};
+
+/**
+ * @brief
+ * @en Write multiple holding registers (0x10)
+ * @ru Запись нескольких регистров хранения (0x10)
+ */
+class MODBUS4QT_EXPORT WriteMultipleRegistersHandler : public FunctionHandler
+{
+    public:
+
+        virtual int processRequest(Device* device, const PduView& request, quint8* response);
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_FUNCTION_HANDLER_H
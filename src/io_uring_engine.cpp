@@ -0,0 +1,624 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "io_uring_engine.h"
+
+#ifdef Q_OS_LINUX
+    #include <linux/io_uring.h>
+#endif
+
+// Multishot receive and buffer rings appeared in headers of Linux 6.0
+//
+// Многократный прием и кольца буферов появились в заголовках Linux 6.0
+//
+#if defined(Q_OS_LINUX) && defined(IORING_RECV_MULTISHOT) && defined(IORING_SETUP_SINGLE_ISSUER)
+    #define MODBUS4QT_HAVE_IO_URING
+#endif
+
+#ifdef MODBUS4QT_HAVE_IO_URING
+    #include <errno.h>
+    #include <string.h>
+    #include <sys/eventfd.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace modbus4qt
+{
+
+#ifdef MODBUS4QT_HAVE_IO_URING
+
+//! @en Group of registered receive buffers @ru Группа зарегистрированных буферов приема
+static const int BufferGroup = 0;
+
+struct IoUringEngine::Ring
+{
+    int fd;
+
+    void* sqMap;
+
+    size_t sqMapSize;
+
+    void* cqMap;
+
+    size_t cqMapSize;
+
+    io_uring_sqe* sqes;
+
+    size_t sqesSize;
+
+    unsigned* sqHead;
+
+    unsigned* sqTail;
+
+    unsigned* sqArray;
+
+    unsigned sqMask;
+
+    unsigned sqEntries;
+
+    //! @en Tail of entries filled but not yet published @ru Хвост заполненных, но еще не опубликованных записей
+    unsigned sqLocalTail;
+
+    unsigned* cqHead;
+
+    unsigned* cqTail;
+
+    unsigned cqMask;
+
+    io_uring_cqe* cqes;
+
+    //! @en Buffer ring, tail of ring overlays resv field of first entry @ru Кольцо буферов, хвост кольца совмещен с полем resv первой записи
+    io_uring_buf* bufRing;
+
+    size_t bufRingSize;
+
+    quint8* buffers;
+
+    size_t buffersSize;
+
+    int bufferCount;
+
+    int bufferSize;
+
+    //! @en Tail of recycled buffers not yet published @ru Хвост возвращенных, но еще не опубликованных буферов
+    unsigned short bufLocalTail;
+};
+
+//-----------------------------------------------------------------------------
+
+static int
+ioUringSetup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+//-----------------------------------------------------------------------------
+
+static int
+ioUringEnter(int fd, unsigned toSubmit)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, 0, 0, 0, 0));
+}
+
+//-----------------------------------------------------------------------------
+
+static int
+ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+#endif // MODBUS4QT_HAVE_IO_URING
+
+//-----------------------------------------------------------------------------
+
+IoUringEngine::IoUringEngine()
+    : ring_(0),
+      eventFd_(-1)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+IoUringEngine::~IoUringEngine()
+{
+    close();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+IoUringEngine::open(int entries, int bufferCount, int bufferSize)
+{
+    close();
+
+#ifdef MODBUS4QT_HAVE_IO_URING
+    if ((bufferCount <= 0) || (bufferCount > 32768) || (bufferCount & (bufferCount - 1)))
+    {
+        errorString_ = "Number of buffers must be power of 2 up to 32768";
+        return false;
+    }
+
+    // Single issuer flag is checked only to refuse kernels older than 6.0,
+    // where multishot receive is not available
+    //
+    // Флаг единственного отправителя проверяется только для отказа от ядер
+    // старше 6.0, в которых нет многократного приема
+    //
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_CQSIZE;
+    params.cq_entries = 2 * entries;
+
+    int fd = ioUringSetup(entries, &params);
+    if (fd < 0)
+    {
+        errorString_ = QString("Can not create io_uring: %1").arg(strerror(errno));
+        return false;
+    }
+
+    Ring* ring = new Ring;
+    memset(ring, 0, sizeof(Ring));
+    ring->fd = fd;
+    ring_ = ring;
+
+    ring->sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        ring->sqMapSize = ring->cqMapSize = qMax(ring->sqMapSize, ring->cqMapSize);
+
+    ring->sqMap = mmap(0, ring->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        ring->cqMap = ring->sqMap;
+    else
+        ring->cqMap = mmap(0, ring->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+    ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqes = static_cast<io_uring_sqe*>(mmap(0, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                 fd, IORING_OFF_SQES));
+
+    if ((ring->sqMap == MAP_FAILED) || (ring->cqMap == MAP_FAILED) || (ring->sqes == MAP_FAILED))
+    {
+        errorString_ = QString("Can not map io_uring: %1").arg(strerror(errno));
+        close();
+        return false;
+    }
+
+    quint8* sq = static_cast<quint8*>(ring->sqMap);
+    ring->sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    ring->sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring->sqEntries = params.sq_entries;
+    ring->sqLocalTail = *ring->sqTail;
+
+    quint8* cq = static_cast<quint8*>(ring->cqMap);
+    ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring->cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Buffer ring and buffers are allocated once and registered in kernel,
+    // kernel picks free buffer for every received chunk
+    //
+    // Кольцо буферов и сами буферы выделяются один раз и регистрируются в
+    // ядре, ядро выбирает свободный буфер для каждой полученной порции данных
+    //
+    ring->bufferCount = bufferCount;
+    ring->bufferSize = bufferSize;
+    ring->bufRingSize = bufferCount * sizeof(io_uring_buf);
+    ring->buffersSize = static_cast<size_t>(bufferCount) * bufferSize;
+
+    void* bufRing = mmap(0, ring->bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void* buffers = mmap(0, ring->buffersSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    // io_uring_buf_ring is not used: its flexible array member is shifted
+    // in C++, where empty structure is not empty
+    //
+    // io_uring_buf_ring не используется: в C++ его гибкий массив смещен,
+    // поскольку пустая структура имеет ненулевой размер
+    //
+    ring->bufRing = (bufRing == MAP_FAILED) ? 0 : static_cast<io_uring_buf*>(bufRing);
+    ring->buffers = (buffers == MAP_FAILED) ? 0 : static_cast<quint8*>(buffers);
+
+    if (!ring->bufRing || !ring->buffers)
+    {
+        errorString_ = QString("Can not allocate receive buffers: %1").arg(strerror(errno));
+        close();
+        return false;
+    }
+
+    // Ring is filled before registration: kernel pins its pages, and page
+    // not touched yet would be pinned as shared zero page
+    //
+    // Кольцо заполняется до регистрации: ядро закрепляет его страницы, и
+    // еще не использованная страница была бы закреплена как общая нулевая
+    //
+    for (int i = 0; i < bufferCount; ++i)
+        recycleBuffer(i);
+
+    __atomic_store_n(&ring->bufRing[0].resv, ring->bufLocalTail, __ATOMIC_RELEASE);
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<quint64>(ring->bufRing);
+    reg.ring_entries = bufferCount;
+    reg.bgid = BufferGroup;
+
+    if (ioUringRegister(fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        errorString_ = QString("Can not register buffer ring: %1").arg(strerror(errno));
+        close();
+        return false;
+    }
+
+    eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if ((eventFd_ < 0) || (ioUringRegister(fd, IORING_REGISTER_EVENTFD, &eventFd_, 1) != 0))
+    {
+        errorString_ = QString("Can not register event descriptor: %1").arg(strerror(errno));
+        close();
+        return false;
+    }
+
+    return true;
+#else
+    Q_UNUSED(entries)
+    Q_UNUSED(bufferCount)
+    Q_UNUSED(bufferSize)
+
+    errorString_ = "io_uring is not supported";
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+IoUringEngine::close()
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    if (eventFd_ >= 0)
+        ::close(eventFd_);
+
+    eventFd_ = -1;
+
+    if (!ring_)
+        return;
+
+    // Closing ring cancels all its requests and unregisters buffers
+    //
+    // Закрытие кольца отменяет все его запросы и снимает регистрацию буферов
+    //
+    ::close(ring_->fd);
+
+    if (ring_->sqes && ring_->sqes != MAP_FAILED)
+        munmap(ring_->sqes, ring_->sqesSize);
+
+    if (ring_->cqMap && ring_->cqMap != MAP_FAILED && ring_->cqMap != ring_->sqMap)
+        munmap(ring_->cqMap, ring_->cqMapSize);
+
+    if (ring_->sqMap && ring_->sqMap != MAP_FAILED)
+        munmap(ring_->sqMap, ring_->sqMapSize);
+
+    if (ring_->bufRing)
+        munmap(ring_->bufRing, ring_->bufRingSize);
+
+    if (ring_->buffers)
+        munmap(ring_->buffers, ring_->buffersSize);
+
+    delete ring_;
+    ring_ = 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+IoUringEngine::isSupported()
+{
+    IoUringEngine engine;
+    return engine.open(8, 1, 64);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+IoUringEngine::clearEvent()
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    eventfd_t value;
+    eventfd_read(eventFd_, &value);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void*
+IoUringEngine::nextEntry_()
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    unsigned head = __atomic_load_n(ring_->sqHead, __ATOMIC_ACQUIRE);
+
+    // Queue is passed to kernel when it is full
+    //
+    // Заполненная очередь передается ядру
+    //
+    if (ring_->sqLocalTail - head >= ring_->sqEntries)
+    {
+        submit();
+        head = __atomic_load_n(ring_->sqHead, __ATOMIC_ACQUIRE);
+
+        if (ring_->sqLocalTail - head >= ring_->sqEntries)
+            return 0;
+    }
+
+    unsigned index = ring_->sqLocalTail & ring_->sqMask;
+    ring_->sqArray[index] = index;
+    ++ring_->sqLocalTail;
+
+    io_uring_sqe* entry = ring_->sqes + index;
+    memset(entry, 0, sizeof(io_uring_sqe));
+
+    return entry;
+#else
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+IoUringEngine::accept(int fd, quint64 userData)
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    io_uring_sqe* entry = static_cast<io_uring_sqe*>(nextEntry_());
+    if (!entry)
+        return false;
+
+    entry->opcode = IORING_OP_ACCEPT;
+    entry->fd = fd;
+    entry->ioprio = IORING_ACCEPT_MULTISHOT;
+    entry->accept_flags = SOCK_CLOEXEC;
+    entry->user_data = userData;
+
+    return true;
+#else
+    Q_UNUSED(fd)
+    Q_UNUSED(userData)
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+IoUringEngine::receive(int fd, quint64 userData)
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    io_uring_sqe* entry = static_cast<io_uring_sqe*>(nextEntry_());
+    if (!entry)
+        return false;
+
+    entry->opcode = IORING_OP_RECV;
+    entry->fd = fd;
+    entry->ioprio = IORING_RECV_MULTISHOT;
+    entry->flags = IOSQE_BUFFER_SELECT;
+    entry->buf_group = BufferGroup;
+    entry->user_data = userData;
+
+    return true;
+#else
+    Q_UNUSED(fd)
+    Q_UNUSED(userData)
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+IoUringEngine::send(int fd, const void* data, int size, quint64 userData)
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    io_uring_sqe* entry = static_cast<io_uring_sqe*>(nextEntry_());
+    if (!entry)
+        return false;
+
+    entry->opcode = IORING_OP_SEND;
+    entry->fd = fd;
+    entry->addr = reinterpret_cast<quint64>(data);
+    entry->len = size;
+    entry->msg_flags = MSG_NOSIGNAL;
+    entry->user_data = userData;
+
+    return true;
+#else
+    Q_UNUSED(fd)
+    Q_UNUSED(data)
+    Q_UNUSED(size)
+    Q_UNUSED(userData)
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+IoUringEngine::cancel(quint64 targetUserData, quint64 userData)
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    io_uring_sqe* entry = static_cast<io_uring_sqe*>(nextEntry_());
+    if (!entry)
+        return false;
+
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->fd = -1;
+    entry->addr = targetUserData;
+    entry->user_data = userData;
+
+    return true;
+#else
+    Q_UNUSED(targetUserData)
+    Q_UNUSED(userData)
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+int
+IoUringEngine::submit()
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    if (!ring_)
+        return 0;
+
+    __atomic_store_n(&ring_->bufRing[0].resv, ring_->bufLocalTail, __ATOMIC_RELEASE);
+
+    unsigned tail = *ring_->sqTail;
+    unsigned toSubmit = ring_->sqLocalTail - tail;
+
+    if (toSubmit == 0)
+        return 0;
+
+    __atomic_store_n(ring_->sqTail, ring_->sqLocalTail, __ATOMIC_RELEASE);
+
+    int result;
+    do
+    {
+        result = ioUringEnter(ring_->fd, toSubmit);
+    }
+    while (result < 0 && errno == EINTR);
+
+    return result;
+#else
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+int
+IoUringEngine::takeCompletions(Completion* completions, int maxCount)
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    unsigned head = *ring_->cqHead;
+    unsigned tail = __atomic_load_n(ring_->cqTail, __ATOMIC_ACQUIRE);
+
+    int count = 0;
+
+    while ((head != tail) && (count < maxCount))
+    {
+        const io_uring_cqe& cqe = ring_->cqes[head & ring_->cqMask];
+
+        completions[count].userData = cqe.user_data;
+        completions[count].result = cqe.res;
+        completions[count].flags = cqe.flags;
+
+        ++count;
+        ++head;
+    }
+
+    __atomic_store_n(ring_->cqHead, head, __ATOMIC_RELEASE);
+
+    return count;
+#else
+    Q_UNUSED(completions)
+    Q_UNUSED(maxCount)
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+IoUringEngine::hasMore(const Completion& completion)
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    return (completion.flags & IORING_CQE_F_MORE) != 0;
+#else
+    Q_UNUSED(completion)
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+int
+IoUringEngine::bufferId(const Completion& completion)
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    if (completion.flags & IORING_CQE_F_BUFFER)
+        return completion.flags >> IORING_CQE_BUFFER_SHIFT;
+#else
+    Q_UNUSED(completion)
+#endif
+
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+const quint8*
+IoUringEngine::buffer(int bufferId) const
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    return ring_->buffers + static_cast<size_t>(bufferId) * ring_->bufferSize;
+#else
+    Q_UNUSED(bufferId)
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+IoUringEngine::recycleBuffer(int bufferId)
+{
+#ifdef MODBUS4QT_HAVE_IO_URING
+    // Ring size is power of 2, so mask is size - 1
+    //
+    // Размер кольца - степень 2, поэтому маска равна размеру минус 1
+    //
+    io_uring_buf& buf = ring_->bufRing[ring_->bufLocalTail & (ring_->bufferCount - 1)];
+
+    buf.addr = reinterpret_cast<quint64>(buffer(bufferId));
+    buf.len = ring_->bufferSize;
+    buf.bid = bufferId;
+
+    ++ring_->bufLocalTail;
+#else
+    Q_UNUSED(bufferId)
+#endif
+}
+
+} // namespace modbus4qt
@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_IO_URING_ENGINE_H
+#define MODBUS4QT_IO_URING_ENGINE_H
+
+#include "global.h"
+
+#include <QString>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Minimal io_uring submission and completion engine for sockets
+ * @ru Минимальный механизм отправки и завершения операций io_uring для сокетов
+ *
+ * @en Ring is used through system calls directly, no external library is needed.
+ * Received data is placed by kernel into buffers from registered buffer ring,
+ * so one multishot receive request serves connection until it is closed.
+ * Requests are queued by accept(), receive(), send() and cancel() and passed
+ * to kernel by one submit() call. Completions are signalled by eventFd(),
+ * which can be watched by QSocketNotifier.
+ *
+ * Engine requires Linux 6.0 or later (multishot receive and buffer rings);
+ * open() fails on older kernels or when io_uring is disabled.
+ *
+ * @ru Кольцо используется напрямую через системные вызовы, внешняя библиотека
+ * не требуется. Полученные данные размещаются ядром в буферах из
+ * зарегистрированного кольца буферов, поэтому один многократный запрос приема
+ * обслуживает подключение до его закрытия. Запросы ставятся в очередь методами
+ * accept(), receive(), send() и cancel() и передаются ядру одним вызовом
+ * submit(). О завершении операций сообщает eventFd(), за которым может
+ * следить QSocketNotifier.
+ *
+ * Требуется Linux 6.0 или новее (многократный прием и кольца буферов); на более
+ * старых ядрах или при отключенном io_uring open() завершается с ошибкой.
+ */
+class MODBUS4QT_EXPORT IoUringEngine
+{
+    public:
+
+        /**
+         * @brief
+         * @en Completion of one operation
+         * @ru Завершение одной операции
+         */
+        struct Completion
+        {
+            quint64 userData;
+
+            //! @en Result of operation, negative errno in case of error @ru Результат операции, отрицательный errno в случае ошибки
+            qint32 result;
+
+            quint32 flags;
+        };
+
+    private:
+
+        struct Ring;
+
+        Ring* ring_;
+
+        int eventFd_;
+
+        QString errorString_;
+
+        Q_DISABLE_COPY(IoUringEngine)
+
+    public:
+
+        IoUringEngine();
+
+        ~IoUringEngine();
+
+        /**
+         * @brief
+         * @en Create ring and register receive buffers
+         * @ru Создает кольцо и регистрирует буферы приема
+         *
+         * @param
+         * @en entries - size of submission queue, completion queue is twice larger
+         * @ru entries - размер очереди отправки, очередь завершения вдвое больше
+         *
+         * @param
+         * @en bufferCount - number of receive buffers, power of 2 up to 32768
+         * @ru bufferCount - количество буферов приема, степень 2 не более 32768
+         */
+        bool open(int entries = 1024, int bufferCount = 4096, int bufferSize = 2048);
+
+        void close();
+
+        bool isOpen() const
+        {
+            return ring_ != 0;
+        }
+
+        //! @en Check that kernel supports all features used @ru Проверяет, поддерживает ли ядро все используемые возможности
+        static bool isSupported();
+
+        //! @en Descriptor readable when completions are posted @ru Дескриптор, доступный для чтения при появлении завершений
+        int eventFd() const
+        {
+            return eventFd_;
+        }
+
+        //! @en Reset eventFd() after it is signalled @ru Сбрасывает eventFd() после срабатывания
+        void clearEvent();
+
+        QString errorString() const
+        {
+            return errorString_;
+        }
+
+        //! @en Queue multishot accept on listening socket @ru Ставит в очередь многократный прием подключений
+        bool accept(int fd, quint64 userData);
+
+        //! @en Queue multishot receive into registered buffers @ru Ставит в очередь многократный прием данных в зарегистрированные буферы
+        bool receive(int fd, quint64 userData);
+
+        //! @en Queue send, data must stay valid until completion @ru Ставит в очередь отправку, данные должны оставаться доступными до завершения
+        bool send(int fd, const void* data, int size, quint64 userData);
+
+        //! @en Queue cancellation of request with given user data @ru Ставит в очередь отмену запроса с заданными данными пользователя
+        bool cancel(quint64 targetUserData, quint64 userData);
+
+        //! @en Pass all queued requests and recycled buffers to kernel @ru Передает ядру все запросы из очереди и возвращенные буферы
+        int submit();
+
+        /**
+         * @brief
+         * @en Take posted completions
+         * @ru Забирает готовые завершения
+         *
+         * @return
+         * @en Number of completions copied, up to maxCount
+         * @ru Количество скопированных завершений, не более maxCount
+         */
+        int takeCompletions(Completion* completions, int maxCount);
+
+        //! @en True if multishot request stays active after this completion @ru True, если многократный запрос остается активным после этого завершения
+        static bool hasMore(const Completion& completion);
+
+        //! @en Id of receive buffer, -1 if completion has no buffer @ru Номер буфера приема, -1, если завершение не содержит буфера
+        static int bufferId(const Completion& completion);
+
+        const quint8* buffer(int bufferId) const;
+
+        //! @en Return receive buffer to kernel on next submit() @ru Возвращает буфер приема ядру при следующем вызове submit()
+        void recycleBuffer(int bufferId);
+
+    private:
+
+        //! @en Next free submission entry, 0 if queue is full @ru Следующая свободная запись очереди отправки, 0, если очередь заполнена
+        void* nextEntry_();
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_IO_URING_ENGINE_H
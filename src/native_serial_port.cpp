@@ -0,0 +1,630 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "native_serial_port.h"
+
+#include <QFile>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+    // termios2 from kernel headers conflicts with <termios.h> of libc, so all
+    // port settings are made by ioctl()
+    #include <asm/termbits.h>
+    #include <linux/serial.h>
+
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <string.h>
+    #include <sys/ioctl.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+namespace modbus4qt
+{
+
+NativeSerialPort::NativeSerialPort(QObject* parent)
+    : QIODevice(parent),
+      fd_(-1),
+      baudRate_(QSerialPort::Baud9600),
+      dataBits_(QSerialPort::Data8),
+      stopBits_(QSerialPort::OneStop),
+      parity_(QSerialPort::EvenParity),
+      lowLatency_(true),
+      lowLatencyActive_(false),
+      rs485Active_(false),
+      firstByteTime_(0),
+      lastByteTime_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+NativeSerialPort::~NativeSerialPort()
+{
+    close();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+NativeSerialPort::setPortName(const QString& portName)
+{
+    portName_ = portName.startsWith('/') ? portName : QString("/dev/") + portName;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::setBaudRate(qint32 baudRate)
+{
+    baudRate_ = baudRate;
+    return (fd_ < 0) || applySettings_();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::setDataBits(QSerialPort::DataBits dataBits)
+{
+    dataBits_ = dataBits;
+    return (fd_ < 0) || applySettings_();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::setStopBits(QSerialPort::StopBits stopBits)
+{
+    stopBits_ = stopBits;
+    return (fd_ < 0) || applySettings_();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::setParity(QSerialPort::Parity parity)
+{
+    parity_ = parity;
+    return (fd_ < 0) || applySettings_();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+NativeSerialPort::setLowLatency(bool enabled)
+{
+    lowLatency_ = enabled;
+
+    if (fd_ >= 0)
+        applyLowLatency_();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::setRs485(const Rs485Settings& settings)
+{
+    rs485_ = settings;
+    return (fd_ < 0) || applyRs485_();
+}
+
+//-----------------------------------------------------------------------------
+
+qint64
+NativeSerialPort::monotonicTime()
+{
+#ifdef Q_OS_LINUX
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return qint64(now.tv_sec) * 1000000000 + now.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::open(OpenMode mode)
+{
+    close();
+
+#ifdef Q_OS_LINUX
+    int flags = O_NOCTTY | O_NONBLOCK | O_CLOEXEC;
+
+    if ((mode & QIODevice::ReadWrite) == QIODevice::ReadWrite)
+        flags |= O_RDWR;
+    else if (mode & QIODevice::WriteOnly)
+        flags |= O_WRONLY;
+    else
+        flags |= O_RDONLY;
+
+    setErrorString(QString());
+
+    fd_ = ::open(QFile::encodeName(portName_).constData(), flags);
+
+    if (fd_ < 0)
+    {
+        setErrorString(tr("Can not open %1: %2").arg(portName_).arg(strerror(errno)));
+        return false;
+    }
+
+    // Port is locked against other processes as QSerialPort does
+    //
+    // Порт блокируется от других процессов так же, как это делает QSerialPort
+    //
+    if (ioctl(fd_, TIOCEXCL) != 0)
+        setErrorString(tr("Can not lock %1: %2").arg(portName_).arg(strerror(errno)));
+
+    if (!errorString().isEmpty() || !applySettings_() || !applyRs485_())
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    applyLowLatency_();
+
+    ioctl(fd_, TCFLSH, TCIOFLUSH);
+
+    buffer_.clear();
+    firstByteTime_ = 0;
+    lastByteTime_ = 0;
+
+    // Data is buffered by port itself
+    //
+    // Данные буферизуются самим портом
+    //
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+#else
+    Q_UNUSED(mode)
+
+    setErrorString(tr("NativeSerialPort is available on Linux only, use QSerialPort"));
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+NativeSerialPort::close()
+{
+    if (isOpen())
+        QIODevice::close();
+
+#ifdef Q_OS_LINUX
+    if (fd_ >= 0)
+        ::close(fd_);
+#endif
+
+    fd_ = -1;
+    rs485Active_ = false;
+    lowLatencyActive_ = false;
+    buffer_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::applySettings_()
+{
+#ifdef Q_OS_LINUX
+    termios2 settings;
+
+    if (ioctl(fd_, TCGETS2, &settings) != 0)
+    {
+        setErrorString(tr("Can not get settings of %1: %2").arg(portName_).arg(strerror(errno)));
+        return false;
+    }
+
+    // Raw mode: no translation of characters, no echo and no signals; read()
+    // returns at once with what is received
+    //
+    // Режим без обработки: нет преобразования символов, эха и сигналов; read()
+    // сразу возвращает то, что получено
+    //
+    settings.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY | INPCK);
+    settings.c_oflag &= ~OPOST;
+    settings.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    settings.c_cflag &= ~(CSIZE | CSTOPB | PARENB | PARODD | CMSPAR | CRTSCTS | CBAUD | (CBAUD << IBSHIFT));
+    settings.c_cflag |= CREAD | CLOCAL | BOTHER | (BOTHER << IBSHIFT);
+    settings.c_cc[VMIN] = 0;
+    settings.c_cc[VTIME] = 0;
+
+    settings.c_ispeed = baudRate_;
+    settings.c_ospeed = baudRate_;
+
+    switch (dataBits_)
+    {
+        case QSerialPort::Data5: settings.c_cflag |= CS5; break;
+        case QSerialPort::Data6: settings.c_cflag |= CS6; break;
+        case QSerialPort::Data7: settings.c_cflag |= CS7; break;
+        default: settings.c_cflag |= CS8; break;
+    }
+
+    if (stopBits_ == QSerialPort::TwoStop)
+        settings.c_cflag |= CSTOPB;
+    else if (stopBits_ != QSerialPort::OneStop)
+    {
+        setErrorString(tr("Stop bits setting is not supported by %1").arg(portName_));
+        return false;
+    }
+
+    switch (parity_)
+    {
+        case QSerialPort::EvenParity: settings.c_cflag |= PARENB; break;
+        case QSerialPort::OddParity: settings.c_cflag |= PARENB | PARODD; break;
+        case QSerialPort::SpaceParity: settings.c_cflag |= PARENB | CMSPAR; break;
+        case QSerialPort::MarkParity: settings.c_cflag |= PARENB | PARODD | CMSPAR; break;
+        default: break;
+    }
+
+    if (settings.c_cflag & PARENB)
+        settings.c_iflag |= INPCK;
+
+    if (ioctl(fd_, TCSETS2, &settings) != 0)
+    {
+        setErrorString(tr("Can not set settings of %1: %2").arg(portName_).arg(strerror(errno)));
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::applyRs485_()
+{
+#ifdef Q_OS_LINUX
+    // Drivers without RS-485 support are not touched unless it is requested
+    //
+    // Драйверы без поддержки RS-485 не затрагиваются, пока она не запрошена
+    //
+    if (!rs485_.enabled && !rs485Active_)
+        return true;
+
+    serial_rs485 settings;
+    memset(&settings, 0, sizeof(settings));
+
+    if (rs485_.enabled)
+    {
+        settings.flags = SER_RS485_ENABLED;
+
+        if (rs485_.rtsOnSend)
+            settings.flags |= SER_RS485_RTS_ON_SEND;
+
+        if (rs485_.rtsAfterSend)
+            settings.flags |= SER_RS485_RTS_AFTER_SEND;
+
+        settings.delay_rts_before_send = rs485_.delayBeforeSend;
+        settings.delay_rts_after_send = rs485_.delayAfterSend;
+    }
+
+    if (ioctl(fd_, TIOCSRS485, &settings) != 0)
+    {
+        setErrorString(tr("Can not set RS-485 mode of %1: %2").arg(portName_).arg(strerror(errno)));
+        return false;
+    }
+
+    rs485Active_ = rs485_.enabled;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+NativeSerialPort::applyLowLatency_()
+{
+#ifdef Q_OS_LINUX
+    // Mode is a hint, drivers without it (e.g. pseudo terminals) work as usual
+    //
+    // Режим является подсказкой, драйверы без него (например, псевдотерминалы) работают как обычно
+    //
+    serial_struct serial;
+
+    lowLatencyActive_ = false;
+
+    if (ioctl(fd_, TIOCGSERIAL, &serial) != 0)
+        return;
+
+    if (lowLatency_)
+        serial.flags |= ASYNC_LOW_LATENCY;
+    else
+        serial.flags &= ~ASYNC_LOW_LATENCY;
+
+    lowLatencyActive_ = lowLatency_ && (ioctl(fd_, TIOCSSERIAL, &serial) == 0);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+int
+NativeSerialPort::fill_()
+{
+#ifdef Q_OS_LINUX
+    int total = 0;
+    char chunk[512];
+
+    forever
+    {
+        ssize_t size = ::read(fd_, chunk, sizeof(chunk));
+
+        if (size > 0)
+        {
+            qint64 now = monotonicTime();
+
+            if (buffer_.isEmpty())
+                firstByteTime_ = now;
+
+            lastByteTime_ = now;
+
+            buffer_.append(chunk, int(size));
+            total += int(size);
+            continue;
+        }
+
+        if ((size < 0) && (errno == EINTR))
+            continue;
+
+        // With VMIN = 0 terminal returns 0 instead of EAGAIN when there is no data
+        //
+        // При VMIN = 0 терминал возвращает 0 вместо EAGAIN, если данных нет
+        //
+        if ((size == 0) || (errno == EAGAIN) || (errno == EWOULDBLOCK))
+            return total;
+
+        setErrorString(tr("Can not read from %1: %2").arg(portName_).arg(strerror(errno)));
+
+        return total > 0 ? total : -1;
+    }
+#else
+    return -1;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::poll_(qint64 timeoutNs)
+{
+#ifdef Q_OS_LINUX
+    pollfd descriptor;
+    descriptor.fd = fd_;
+    descriptor.events = POLLIN;
+    descriptor.revents = 0;
+
+    // ppoll() is used for timeout finer than millisecond
+    //
+    // ppoll() используется для тайм-аута точнее миллисекунды
+    //
+    timespec timeout;
+    timeout.tv_sec = timeoutNs / 1000000000;
+    timeout.tv_nsec = timeoutNs % 1000000000;
+
+    int result;
+    do
+    {
+        result = ppoll(&descriptor, 1, timeoutNs < 0 ? NULL : &timeout, NULL);
+    }
+    while ((result < 0) && (errno == EINTR));
+
+    return result > 0;
+#else
+    Q_UNUSED(timeoutNs)
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray
+NativeSerialPort::readFrame(qint64 gapUs)
+{
+    if (fd_ < 0)
+        return QByteArray();
+
+    fill_();
+
+    if (buffer_.isEmpty())
+        return QByteArray();
+
+    const qint64 gapNs = gapUs * 1000;
+
+    forever
+    {
+        qint64 leftNs = gapNs - (monotonicTime() - lastByteTime_);
+
+        if (leftNs <= 0)
+            break;
+
+        if (poll_(leftNs) && (fill_() < 0))
+            break;
+    }
+
+    QByteArray frame = buffer_;
+    buffer_.clear();
+
+    return frame;
+}
+
+//-----------------------------------------------------------------------------
+
+qint64
+NativeSerialPort::bytesAvailable() const
+{
+    int pending = 0;
+
+#ifdef Q_OS_LINUX
+    if ((fd_ < 0) || (ioctl(fd_, FIONREAD, &pending) != 0))
+        pending = 0;
+#endif
+
+    return buffer_.size() + pending + QIODevice::bytesAvailable();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::waitForReadyRead(int msecs)
+{
+    if (!buffer_.isEmpty())
+        return true;
+
+    if (fd_ < 0)
+        return false;
+
+    if (!poll_(msecs < 0 ? -1 : qint64(msecs) * 1000000) || (fill_() <= 0))
+        return false;
+
+    emit readyRead();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+NativeSerialPort::waitForBytesWritten(int msecs)
+{
+    if (fd_ < 0)
+        return false;
+
+#ifdef Q_OS_LINUX
+    // tcdrain() can not be limited by time, so output queue is polled
+    // every character time until it is empty or timeout expires
+    //
+    // Время tcdrain() нельзя ограничить, поэтому очередь вывода
+    // проверяется каждое время передачи символа до ее опустошения
+    // или истечения времени ожидания
+    //
+    const qint64 deadline = monotonicTime() + qint64(qMax(0, msecs)) * 1000000;
+    const qint64 charTimeNs = 11 * Q_INT64_C(1000000000) / qMax(1, int(baudRate_));
+
+    forever
+    {
+        int queued = 0;
+        if (ioctl(fd_, TIOCOUTQ, &queued) != 0)
+        {
+            setErrorString(tr("Can not get output queue of %1: %2").arg(portName_).arg(strerror(errno)));
+            return false;
+        }
+
+        // Driver queue is empty, last character may still be in
+        // transmitter, it is checked if driver reports it (pty does not)
+        //
+        // Очередь драйвера пуста, последний символ еще может быть в
+        // передатчике, это проверяется, если драйвер сообщает об этом
+        // (pty не сообщает)
+        //
+        if (queued == 0)
+        {
+            unsigned int lineStatus = 0;
+            if ((ioctl(fd_, TIOCSERGETLSR, &lineStatus) != 0) || (lineStatus & TIOCSER_TEMT))
+                return true;
+        }
+
+        qint64 leftNs = deadline - monotonicTime();
+        if (leftNs <= 0)
+        {
+            setErrorString(tr("Output of %1 is not drained in %2 ms").arg(portName_).arg(msecs));
+            return false;
+        }
+
+        qint64 stepNs = qMin(leftNs, qMax(queued, 1) * charTimeNs);
+
+        timespec step;
+        step.tv_sec = stepNs / 1000000000;
+        step.tv_nsec = stepNs % 1000000000;
+        nanosleep(&step, NULL);
+    }
+#else
+    Q_UNUSED(msecs)
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+qint64
+NativeSerialPort::readData(char* data, qint64 maxSize)
+{
+    if (buffer_.isEmpty() && (fill_() < 0))
+        return -1;
+
+    int size = int(qMin(maxSize, qint64(buffer_.size())));
+
+    std::copy(buffer_.constData(), buffer_.constData() + size, data);
+    buffer_.remove(0, size);
+
+    return size;
+}
+
+//-----------------------------------------------------------------------------
+
+qint64
+NativeSerialPort::writeData(const char* data, qint64 maxSize)
+{
+#ifdef Q_OS_LINUX
+    // RTU frame is much smaller than output queue of driver, so it is written
+    // at once and never waits
+    //
+    // Пакет RTU намного меньше очереди вывода драйвера, поэтому он
+    // записывается сразу и никогда не ожидает
+    //
+    ssize_t size;
+    do
+    {
+        size = ::write(fd_, data, size_t(maxSize));
+    }
+    while ((size < 0) && (errno == EINTR));
+
+    if ((size < 0) && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+
+    if (size < 0)
+        setErrorString(tr("Can not write to %1: %2").arg(portName_).arg(strerror(errno)));
+
+    return size;
+#else
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+#endif
+}
+
+} // namespace modbus4qt
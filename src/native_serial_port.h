@@ -0,0 +1,297 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_NATIVE_SERIAL_PORT_H
+#define MODBUS4QT_NATIVE_SERIAL_PORT_H
+
+#include "global.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QSerialPort>
+#include <QString>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Serial port on Linux termios without QSerialPort
+ * @ru Последовательный порт на termios в Linux без QSerialPort
+ *
+ * @en Port is used by RtuClient in native mode (see RtuClient::setNativeBackend()).
+ * Reads are non-blocking and made directly from thread of caller, without event
+ * loop and internal buffering of QSerialPort. Any baud rate supported by driver
+ * can be set (termios2, BOTHER). Low latency mode (ASYNC_LOW_LATENCY) is turned
+ * on by default, for USB adapters it removes latency timer of several
+ * milliseconds. Kernel RS-485 mode (TIOCSRS485) switches direction of
+ * transceiver by RTS.
+ *
+ * Time of every received chunk of bytes is stored (CLOCK_MONOTONIC), so end of
+ * frame is detected by time passed since last byte, not since call.
+ *
+ * On other systems open() fails. Port can be tested without hardware on pair
+ * of pseudo terminals, e.g. made by "socat pty,raw,echo=0 pty,raw,echo=0";
+ * low latency mode is not supported by them and is silently skipped.
+ *
+ * @ru Порт используется RtuClient в собственном режиме (см.
+ * RtuClient::setNativeBackend()). Чтение неблокирующее и выполняется прямо в
+ * потоке вызывающего, без цикла событий и внутренней буферизации QSerialPort.
+ * Можно установить любую скорость, поддерживаемую драйвером (termios2, BOTHER).
+ * Режим низкой задержки (ASYNC_LOW_LATENCY) включен по умолчанию, для
+ * USB-адаптеров он убирает таймер задержки в несколько миллисекунд. Режим
+ * RS-485 ядра (TIOCSRS485) переключает направление приемопередатчика по RTS.
+ *
+ * Время получения каждой порции байт сохраняется (CLOCK_MONOTONIC), поэтому
+ * конец пакета определяется по времени, прошедшему с последнего байта, а не с
+ * момента вызова.
+ *
+ * В других системах open() завершается с ошибкой. Порт можно проверить без
+ * оборудования на паре псевдотерминалов, например созданной командой
+ * "socat pty,raw,echo=0 pty,raw,echo=0"; режим низкой задержки ими не
+ * поддерживается и молча пропускается.
+ */
+class MODBUS4QT_EXPORT NativeSerialPort : public QIODevice
+{
+    Q_OBJECT
+
+    public:
+
+        /**
+         * @brief
+         * @en Kernel RS-485 settings
+         * @ru Настройки RS-485 ядра
+         */
+        struct Rs485Settings
+        {
+            bool enabled;
+
+            //! @en RTS level while sending @ru Уровень RTS во время передачи
+            bool rtsOnSend;
+
+            //! @en RTS level after sending @ru Уровень RTS после передачи
+            bool rtsAfterSend;
+
+            //! @en Delay between RTS change and sending, ms @ru Задержка между переключением RTS и передачей, мс
+            int delayBeforeSend;
+
+            //! @en Delay between end of sending and RTS change, ms @ru Задержка между окончанием передачи и переключением RTS, мс
+            int delayAfterSend;
+
+            Rs485Settings()
+                : enabled(false),
+                  rtsOnSend(true),
+                  rtsAfterSend(false),
+                  delayBeforeSend(0),
+                  delayAfterSend(0)
+            {
+            }
+        };
+
+    private:
+
+        QString portName_;
+
+        int fd_;
+
+        qint32 baudRate_;
+
+        QSerialPort::DataBits dataBits_;
+
+        QSerialPort::StopBits stopBits_;
+
+        QSerialPort::Parity parity_;
+
+        bool lowLatency_;
+
+        bool lowLatencyActive_;
+
+        Rs485Settings rs485_;
+
+        bool rs485Active_;
+
+        //! @en Received bytes not read yet @ru Полученные, но еще не прочитанные байты
+        QByteArray buffer_;
+
+        qint64 firstByteTime_;
+
+        qint64 lastByteTime_;
+
+        //! @en Write termios settings into open port @ru Записывает настройки termios в открытый порт
+        bool applySettings_();
+
+        bool applyRs485_();
+
+        void applyLowLatency_();
+
+        /**
+         * @brief
+         * @en Read all received bytes into buffer
+         * @ru Читает все полученные байты в буфер
+         *
+         * @return
+         * @en Number of bytes read; -1 in case of error
+         * @ru Количество прочитанных байт; -1 в случае ошибки
+         */
+        int fill_();
+
+        //! @en Wait for input, negative timeout means forever @ru Ожидает входных данных, отрицательный тайм-аут - без ограничения
+        bool poll_(qint64 timeoutNs);
+
+    public:
+
+        explicit NativeSerialPort(QObject* parent = 0);
+
+        virtual ~NativeSerialPort();
+
+        //! @en Name of device, "/dev/" is added to short names like "ttyUSB0" @ru Имя устройства, к коротким именам вида "ttyUSB0" добавляется "/dev/"
+        void setPortName(const QString& portName);
+
+        QString portName() const
+        {
+            return portName_;
+        }
+
+        //! @en Descriptor of open port, -1 if port is closed @ru Дескриптор открытого порта, -1, если порт закрыт
+        int handle() const
+        {
+            return fd_;
+        }
+
+        /**
+         * @brief
+         * @en Set baud rate, non-standard values are allowed
+         * @ru Устанавливает скорость обмена, допускаются нестандартные значения
+         *
+         * @en Settings are applied at once if port is open.
+         * @ru Если порт открыт, настройки применяются сразу.
+         *
+         * @return
+         * @en false if driver rejected settings, see errorString()
+         * @ru false, если драйвер отклонил настройки, см. errorString()
+         */
+        bool setBaudRate(qint32 baudRate);
+
+        qint32 baudRate() const
+        {
+            return baudRate_;
+        }
+
+        bool setDataBits(QSerialPort::DataBits dataBits);
+
+        //! @en OneAndHalfStop is not supported by termios @ru OneAndHalfStop не поддерживается termios
+        bool setStopBits(QSerialPort::StopBits stopBits);
+
+        bool setParity(QSerialPort::Parity parity);
+
+        //! @en Turn on or off low latency mode, on by default @ru Включает или выключает режим низкой задержки, по умолчанию включен
+        void setLowLatency(bool enabled);
+
+        bool isLowLatency() const
+        {
+            return lowLatency_;
+        }
+
+        //! @en True if driver accepted low latency mode @ru True, если драйвер принял режим низкой задержки
+        bool isLowLatencyActive() const
+        {
+            return lowLatencyActive_;
+        }
+
+        /**
+         * @brief
+         * @en Set kernel RS-485 mode
+         * @ru Устанавливает режим RS-485 ядра
+         *
+         * @return
+         * @en false if port is open and driver does not support RS-485 mode
+         * @ru false, если порт открыт и драйвер не поддерживает режим RS-485
+         */
+        bool setRs485(const Rs485Settings& settings);
+
+        const Rs485Settings& rs485() const
+        {
+            return rs485_;
+        }
+
+        /**
+         * @brief
+         * @en Read frame ended by silence on line
+         * @ru Читает пакет, завершенный паузой в линии
+         *
+         * @en Bytes already received are taken first. Reading stops when no
+         * byte was received during gapUs since the last one.
+         *
+         * @ru Сначала берутся уже полученные байты. Чтение завершается, если в
+         * течение gapUs после последнего байта не было получено ни одного.
+         *
+         * @return
+         * @en Frame; empty if nothing was received
+         * @ru Пакет; пустой массив, если ничего не получено
+         */
+        QByteArray readFrame(qint64 gapUs);
+
+        //! @en Time of first byte in buffer, ns of CLOCK_MONOTONIC @ru Время первого байта в буфере, нс CLOCK_MONOTONIC
+        qint64 firstByteTime() const
+        {
+            return firstByteTime_;
+        }
+
+        //! @en Time of last received byte, ns of CLOCK_MONOTONIC @ru Время последнего полученного байта, нс CLOCK_MONOTONIC
+        qint64 lastByteTime() const
+        {
+            return lastByteTime_;
+        }
+
+        //! @en Current time of CLOCK_MONOTONIC, ns @ru Текущее время CLOCK_MONOTONIC, нс
+        static qint64 monotonicTime();
+
+        virtual bool open(OpenMode mode);
+
+        virtual void close();
+
+        virtual bool isSequential() const
+        {
+            return true;
+        }
+
+        virtual qint64 bytesAvailable() const;
+
+        virtual bool waitForReadyRead(int msecs);
+
+        //! @en Wait until driver has transmitted all data, like tcdrain() limited by msecs @ru Ожидает передачи драйвером всех данных, как tcdrain() с ограничением msecs
+        virtual bool waitForBytesWritten(int msecs);
+
+    protected:
+
+        virtual qint64 readData(char* data, qint64 maxSize);
+
+        virtual qint64 writeData(const char* data, qint64 maxSize);
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_NATIVE_SERIAL_PORT_H
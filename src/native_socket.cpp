@@ -0,0 +1,145 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "native_socket.h"
+
+#ifdef Q_OS_LINUX
+    #include <arpa/inet.h>
+    #include <errno.h>
+    #include <netinet/in.h>
+    #include <string.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace modbus4qt
+{
+
+#ifdef Q_OS_LINUX
+
+//-----------------------------------------------------------------------------
+
+static socklen_t
+toSockAddr(const QHostAddress& address, quint16 port, int family, sockaddr_storage* storage)
+{
+    memset(storage, 0, sizeof(*storage));
+
+    if (family == AF_INET)
+    {
+        sockaddr_in* in = reinterpret_cast<sockaddr_in*>(storage);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        in->sin_addr.s_addr = htonl(address.toIPv4Address());
+
+        return sizeof(sockaddr_in);
+    }
+
+    sockaddr_in6* in6 = reinterpret_cast<sockaddr_in6*>(storage);
+    in6->sin6_family = AF_INET6;
+    in6->sin6_port = htons(port);
+
+    Q_IPV6ADDR ip = address.toIPv6Address();
+    memcpy(&in6->sin6_addr, &ip, sizeof(in6->sin6_addr));
+
+    return sizeof(sockaddr_in6);
+}
+
+#endif // Q_OS_LINUX
+
+//-----------------------------------------------------------------------------
+
+int
+openNativeSocket(const QHostAddress& address, quint16 port, bool stream, quint16* boundPort, QString* errorString)
+{
+#ifdef Q_OS_LINUX
+    const int type = (stream ? SOCK_STREAM : SOCK_DGRAM) | SOCK_NONBLOCK | SOCK_CLOEXEC;
+
+    // IPv6 socket accepts IPv4 peers too, unless specific IPv4 address is given
+    int family = (address.protocol() == QAbstractSocket::IPv4Protocol) ? AF_INET : AF_INET6;
+
+    int fd = socket(family, type, 0);
+
+    if ((fd < 0) && (family == AF_INET6) && (address == QHostAddress::Any))
+    {
+        family = AF_INET;
+        fd = socket(family, type, 0);
+    }
+
+    if (fd < 0)
+    {
+        *errorString = QString("Can not create socket: %1").arg(strerror(errno));
+        return -1;
+    }
+
+    if (family == AF_INET6)
+    {
+        int v6only = (address.protocol() == QAbstractSocket::IPv6Protocol) ? 1 : 0;
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only));
+    }
+
+    if (stream)
+    {
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+
+    sockaddr_storage storage;
+    socklen_t length = toSockAddr(address, port, family, &storage);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&storage), length) != 0)
+    {
+        *errorString = QString("Can not bind socket to %1:%2: %3").arg(address.toString()).arg(port).arg(strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    if (stream && (::listen(fd, SOMAXCONN) != 0))
+    {
+        *errorString = QString("Can not listen on %1:%2: %3").arg(address.toString()).arg(port).arg(strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    length = sizeof(storage);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&storage), &length);
+
+    *boundPort = ntohs(family == AF_INET
+                       ? reinterpret_cast<sockaddr_in*>(&storage)->sin_port
+                       : reinterpret_cast<sockaddr_in6*>(&storage)->sin6_port);
+
+    return fd;
+#else
+    Q_UNUSED(address)
+    Q_UNUSED(port)
+    Q_UNUSED(stream)
+    Q_UNUSED(boundPort)
+
+    *errorString = "Native sockets are supported on Linux only";
+    return -1;
+#endif
+}
+
+} // namespace modbus4qt
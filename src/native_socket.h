@@ -0,0 +1,67 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_NATIVE_SOCKET_H
+#define MODBUS4QT_NATIVE_SOCKET_H
+
+#include "global.h"
+
+#include <QHostAddress>
+#include <QString>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Create non-blocking socket bound to address and port
+ * @ru Создает неблокирующий сокет, привязанный к адресу и порту
+ *
+ * @en Used by native Linux server backends. QHostAddress::Any gives dual
+ * stack IPv6 socket, which accepts IPv4 peers too. Stream socket is switched
+ * to listening state.
+ *
+ * @ru Используется собственными реализациями серверов для Linux.
+ * QHostAddress::Any дает сокет IPv6 с поддержкой IPv4. Потоковый сокет
+ * переводится в режим ожидания подключений.
+ *
+ * @param
+ * @en stream - true for TCP socket, false for UDP socket
+ * @ru stream - true для сокета TCP, false для сокета UDP
+ *
+ * @param
+ * @en boundPort - receives port socket is bound to
+ * @ru boundPort - получает номер порта, к которому привязан сокет
+ *
+ * @return
+ * @en Socket descriptor; -1 in case of error, errorString receives its description
+ * @ru Дескриптор сокета; -1 в случае ошибки, errorString получает ее описание
+ */
+int openNativeSocket(const QHostAddress& address, quint16 port, bool stream, quint16* boundPort, QString* errorString);
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_NATIVE_SOCKET_H
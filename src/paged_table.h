@@ -0,0 +1,208 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_PAGED_TABLE_H
+#define MODBUS4QT_PAGED_TABLE_H
+
+#include <QtGlobal>
+
+#include <algorithm>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Sparse table for full MODBUS address space
+ * @ru Разреженная таблица на все адресное пространство MODBUS
+ *
+ * @en Addresses are split into pages of PageSize items. Fixed directory keeps
+ * pointer to every page; page is allocated on first write of non zero value.
+ * Pages never written are read from one shared zero page, so device with few
+ * small ranges takes only directory and pages of these ranges. Range reads
+ * and writes copy whole parts of pages.
+ *
+ * @ru Адреса разбиты на страницы по PageSize элементов. Фиксированный каталог
+ * хранит указатель на каждую страницу; страница выделяется при первой записи
+ * ненулевого значения. Незаписанные страницы читаются из одной общей нулевой
+ * страницы, поэтому устройство с несколькими небольшими диапазонами занимает
+ * только каталог и страницы этих диапазонов. Чтение и запись диапазонов
+ * копируют целые части страниц.
+ */
+template <typename T>
+class PagedTable
+{
+    public:
+
+        enum
+        {
+            //! @en Items per page @ru Элементов на странице
+            PageSize = 256,
+
+            //! @en Pages in directory @ru Страниц в каталоге
+            PageCount = 0x10000 / PageSize
+        };
+
+    private:
+
+        T* pages_[PageCount];
+
+        int allocatedPages_;
+
+        static const T zeroPage_[PageSize];
+
+        const T* page_(int index) const
+        {
+            return pages_[index] ? pages_[index] : zeroPage_;
+        }
+
+        T* pageForWrite_(int index)
+        {
+            if (!pages_[index])
+            {
+                pages_[index] = new T[PageSize]();
+                ++allocatedPages_;
+            }
+
+            return pages_[index];
+        }
+
+        Q_DISABLE_COPY(PagedTable)
+
+    public:
+
+        PagedTable()
+            : allocatedPages_(0)
+        {
+            std::fill(pages_, pages_ + PageCount, static_cast<T*>(0));
+        }
+
+        ~PagedTable()
+        {
+            clear();
+        }
+
+        //! @en Release all pages, every item becomes zero @ru Освобождает все страницы, все элементы становятся нулевыми
+        void clear()
+        {
+            for (int i = 0; i < PageCount; ++i)
+            {
+                delete[] pages_[i];
+                pages_[i] = 0;
+            }
+
+            allocatedPages_ = 0;
+        }
+
+        T value(quint16 address) const
+        {
+            return page_(address / PageSize)[address % PageSize];
+        }
+
+        void setValue(quint16 address, T value)
+        {
+            write(address, 1, &value);
+        }
+
+        /**
+         * @brief
+         * @en Copy count items from start into values
+         * @ru Копирует count элементов начиная со start в values
+         *
+         * @en Range must not exceed address space.
+         * @ru Диапазон не должен выходить за адресное пространство.
+         */
+        void read(quint16 start, int count, T* values) const
+        {
+            int address = start;
+            const int end = qMin(address + count, int(0x10000));
+
+            while (address < end)
+            {
+                const int offset = address % PageSize;
+                const int chunk = qMin(PageSize - offset, end - address);
+                const T* page = page_(address / PageSize);
+
+                std::copy(page + offset, page + offset + chunk, values);
+
+                values += chunk;
+                address += chunk;
+            }
+        }
+
+        /**
+         * @brief
+         * @en Copy count items from values into table starting at start
+         * @ru Копирует count элементов из values в таблицу начиная со start
+         *
+         * @en Zeros written into page never allocated leave it unallocated.
+         * @ru Запись нулей в невыделенную страницу оставляет ее невыделенной.
+         */
+        void write(quint16 start, int count, const T* values)
+        {
+            int address = start;
+            const int end = qMin(address + count, int(0x10000));
+
+            while (address < end)
+            {
+                const int offset = address % PageSize;
+                const int chunk = qMin(PageSize - offset, end - address);
+                const int index = address / PageSize;
+
+                if (pages_[index] || (std::find_if(values, values + chunk, isNonZero_) != values + chunk))
+                    std::copy(values, values + chunk, pageForWrite_(index) + offset);
+
+                values += chunk;
+                address += chunk;
+            }
+        }
+
+        //! @en Pages allocated by writes @ru Страницы, выделенные при записи
+        int allocatedPages() const
+        {
+            return allocatedPages_;
+        }
+
+        //! @en Memory taken by directory and pages (in bytes) @ru Память, занятая каталогом и страницами, в байтах
+        int memoryUsage() const
+        {
+            return sizeof(*this) + allocatedPages_ * PageSize * sizeof(T);
+        }
+
+    private:
+
+        static bool isNonZero_(const T& value)
+        {
+            return value != T();
+        }
+};
+
+template <typename T>
+const T PagedTable<T>::zeroPage_[PagedTable<T>::PageSize] = {};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_PAGED_TABLE_H
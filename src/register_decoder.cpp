@@ -0,0 +1,415 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "register_decoder.h"
+
+#include "utils.h"
+
+#if defined(__SSSE3__)
+    #include <tmmintrin.h>
+    #define MODBUS4QT_SHUFFLE_SSSE3
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define MODBUS4QT_SHUFFLE_NEON
+#endif
+
+namespace modbus4qt
+{
+
+namespace
+{
+
+//! Values converted at once by RegisterSchema::decode()
+const int ChunkSize = 32;
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Build permutation which turns size bytes of value in wire format into value
+ * in host byte order: host byte j is taken from wire byte mask[j].
+ */
+void
+makeShuffle(int size, WordOrder order, quint8* mask)
+{
+    bool wordSwap = (order == CDAB || order == DCBA);
+    bool byteSwap = (order == BADC || order == DCBA);
+
+    int words = size / 2;
+
+    // i is significance of byte, 0 is the most significant one
+    for (int i = 0; i < size; ++i)
+    {
+        int word = i / 2;
+        int byte = i % 2;
+
+        if (wordSwap)
+            word = words - 1 - word;
+
+        if (byteSwap)
+            byte = 1 - byte;
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        mask[size - 1 - i] = quint8(word * 2 + byte);
+#else
+        mask[i] = quint8(word * 2 + byte);
+#endif
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Apply permutation to count values of Size bytes. Whole 16-byte vectors are
+ * shuffled by SIMD instruction, the rest by plain loop.
+ */
+template <int Size>
+void
+shuffle(const quint8* data, int count, const quint8* mask, quint8* values)
+{
+    int i = 0;
+
+#if defined(MODBUS4QT_SHUFFLE_SSSE3) || defined(MODBUS4QT_SHUFFLE_NEON)
+    const int perVector = 16 / Size;
+
+    quint8 wide[16];
+    for (int k = 0; k < 16; ++k)
+        wide[k] = quint8(mask[k % Size] + (k / Size) * Size);
+
+#if defined(MODBUS4QT_SHUFFLE_SSSE3)
+    const __m128i vectorMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(wide));
+
+    for (; i + perVector <= count; i += perVector)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * Size));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i * Size), _mm_shuffle_epi8(block, vectorMask));
+    }
+#else
+    const uint8x16_t vectorMask = vld1q_u8(wide);
+
+    for (; i + perVector <= count; i += perVector)
+        vst1q_u8(values + i * Size, vqtbl1q_u8(vld1q_u8(data + i * Size), vectorMask));
+#endif
+#endif // SIMD
+
+    for (; i < count; ++i)
+    {
+        for (int b = 0; b < Size; ++b)
+            values[i * Size + b] = data[i * Size + mask[b]];
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+void
+decodeBlock(const quint8* data, int count, WordOrder order, T* values)
+{
+    quint8 mask[sizeof(T)];
+    makeShuffle(sizeof(T), order, mask);
+
+    shuffle<sizeof(T)>(data, count, mask, reinterpret_cast<quint8*>(values));
+}
+
+//-----------------------------------------------------------------------------
+
+QVector<quint8>
+registersToWire(const QVector<quint16>& registers)
+{
+    QVector<quint8> result(registers.size() * 2);
+
+    for (int i = 0; i < registers.size(); ++i)
+    {
+        result[i * 2] = hi(registers.at(i));
+        result[i * 2 + 1] = lo(registers.at(i));
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+QVector<T>
+registersToValues(const QVector<quint16>& registers, WordOrder order)
+{
+    QVector<T> result(registers.size() * 2 / int(sizeof(T)));
+
+    if (!result.isEmpty())
+        decodeBlock(registersToWire(registers).constData(), result.size(), order, result.data());
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Decode run of tags of type T in chunks, so scaling is done while converted
+ * values are still in cache.
+ */
+template <typename T>
+void
+decodeRun(const quint8* data, const RegisterSchema::Tag* tags, int count, double* values)
+{
+    quint8 mask[sizeof(T)];
+    makeShuffle(sizeof(T), tags[0].order, mask);
+
+    T buffer[ChunkSize];
+
+    for (int first = 0; first < count; first += ChunkSize)
+    {
+        int size = qMin(ChunkSize, count - first);
+
+        shuffle<sizeof(T)>(data + first * sizeof(T), size, mask, reinterpret_cast<quint8*>(buffer));
+
+        for (int i = 0; i < size; ++i)
+        {
+            const RegisterSchema::Tag& tag = tags[first + i];
+            values[first + i] = double(buffer[i]) * tag.scale + tag.offset;
+        }
+    }
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+void
+decodeInt16(const quint8* data, int count, WordOrder order, qint16* values)
+{
+    decodeBlock(data, count, order, values);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+decodeUInt16(const quint8* data, int count, WordOrder order, quint16* values)
+{
+    decodeBlock(data, count, order, values);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+decodeInt32(const quint8* data, int count, WordOrder order, qint32* values)
+{
+    decodeBlock(data, count, order, values);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+decodeUInt32(const quint8* data, int count, WordOrder order, quint32* values)
+{
+    decodeBlock(data, count, order, values);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+decodeFloat32(const quint8* data, int count, WordOrder order, float* values)
+{
+    decodeBlock(data, count, order, values);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+decodeFloat64(const quint8* data, int count, WordOrder order, double* values)
+{
+    decodeBlock(data, count, order, values);
+}
+
+//-----------------------------------------------------------------------------
+
+QVector<qint32>
+registersToInt32(const QVector<quint16>& registers, WordOrder order)
+{
+    return registersToValues<qint32>(registers, order);
+}
+
+//-----------------------------------------------------------------------------
+
+QVector<quint32>
+registersToUInt32(const QVector<quint16>& registers, WordOrder order)
+{
+    return registersToValues<quint32>(registers, order);
+}
+
+//-----------------------------------------------------------------------------
+
+QVector<float>
+registersToFloat32(const QVector<quint16>& registers, WordOrder order)
+{
+    return registersToValues<float>(registers, order);
+}
+
+//-----------------------------------------------------------------------------
+
+QVector<double>
+registersToFloat64(const QVector<quint16>& registers, WordOrder order)
+{
+    return registersToValues<double>(registers, order);
+}
+
+//-----------------------------------------------------------------------------
+
+RegisterSchema::RegisterSchema()
+    : registerCount_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+int
+RegisterSchema::addTag(quint16 reg, DataType type, WordOrder order, double scale, double offset)
+{
+    Tag tag;
+    tag.reg = reg;
+    tag.type = type;
+    tag.order = order;
+    tag.scale = scale;
+    tag.offset = offset;
+
+    int size = registersOf(type);
+
+    // Tag continues last run if it has the same type and follows it in registers
+    bool merged = false;
+
+    if (!runs_.isEmpty())
+    {
+        const Tag& last = tags_.last();
+
+        if (last.type == type && last.order == order && int(last.reg) + size == int(reg))
+        {
+            ++runs_.last().count;
+            merged = true;
+        }
+    }
+
+    if (!merged)
+    {
+        Run run;
+        run.firstTag = tags_.size();
+        run.count = 1;
+
+        runs_.append(run);
+    }
+
+    tags_.append(tag);
+    registerCount_ = qMax(registerCount_, int(reg) + size);
+
+    return tags_.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RegisterSchema::clear()
+{
+    tags_.clear();
+    runs_.clear();
+    registerCount_ = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+RegisterSchema::registersOf(DataType type)
+{
+    switch (type)
+    {
+        case Int16 :
+        case UInt16 :
+            return 1;
+
+        case Int32 :
+        case UInt32 :
+        case Float32 :
+            return 2;
+
+        case Float64 :
+            return 4;
+    }
+
+    return 1;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RegisterSchema::decode(const quint8* data, int regCount, double* values) const
+{
+    if (regCount < registerCount_)
+        return false;
+
+    foreach (const Run& run, runs_)
+    {
+        const Tag* tags = tags_.constData() + run.firstTag;
+        const quint8* runData = data + tags[0].reg * 2;
+        double* runValues = values + run.firstTag;
+
+        switch (tags[0].type)
+        {
+            case Int16 :
+                decodeRun<qint16>(runData, tags, run.count, runValues);
+                break;
+
+            case UInt16 :
+                decodeRun<quint16>(runData, tags, run.count, runValues);
+                break;
+
+            case Int32 :
+                decodeRun<qint32>(runData, tags, run.count, runValues);
+                break;
+
+            case UInt32 :
+                decodeRun<quint32>(runData, tags, run.count, runValues);
+                break;
+
+            case Float32 :
+                decodeRun<float>(runData, tags, run.count, runValues);
+                break;
+
+            case Float64 :
+                decodeRun<double>(runData, tags, run.count, runValues);
+                break;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RegisterSchema::decode(const QVector<quint16>& registers, QVector<double>& values) const
+{
+    values.resize(tags_.size());
+
+    return decode(registersToWire(registers).constData(), registers.size(), values.data());
+}
+
+} // namespace modbus4qt
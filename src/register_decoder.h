@@ -0,0 +1,232 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_REGISTER_DECODER_H
+#define MODBUS4QT_REGISTER_DECODER_H
+
+#include "global.h"
+
+#include <QVector>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Order of bytes in values which occupy several registers
+ * @ru Порядок байтов в значениях, занимающих несколько регистров
+ *
+ * @en Letters show the order in which bytes of value are transmitted, A is the
+ * most significant byte. For 64-bit values word swap reverses order of all four
+ * registers.
+ *
+ * @ru Буквы показывают порядок передачи байтов значения, A - старший байт.
+ * Для 64-битных значений перестановка слов меняет порядок всех четырех
+ * регистров на обратный.
+ */
+enum WordOrder
+{
+    //! @en Big-endian, as in MODBUS specification @ru Старший байт первым, как в спецификации MODBUS
+    ABCD,
+
+    //! @en Words swapped @ru Переставлены слова
+    CDAB,
+
+    //! @en Bytes inside words swapped @ru Переставлены байты внутри слов
+    BADC,
+
+    //! @en Little-endian @ru Младший байт первым
+    DCBA
+};
+
+/**
+ * @brief
+ * @en Decode block of values from register data in wire format
+ * @ru Извлекает блок значений из данных регистров в формате передачи
+ *
+ * @en Values are converted by SIMD byte shuffle if compiler targets SSSE3
+ * or NEON, and by portable code otherwise.
+ *
+ * @ru Значения преобразуются перестановкой байтов командами SIMD, если
+ * компилятор поддерживает SSSE3 или NEON, иначе - переносимым кодом.
+ *
+ * @param
+ * @en data - register data as in response, e.g. ProtocolDataUnit::data + 1
+ * @ru data - данные регистров в том виде, как в ответе, например ProtocolDataUnit::data + 1
+ *
+ * @param
+ * @en count - number of values, not registers
+ * @ru count - количество значений, а не регистров
+ */
+void decodeInt16(const quint8* data, int count, WordOrder order, qint16* values);
+
+void decodeUInt16(const quint8* data, int count, WordOrder order, quint16* values);
+
+void decodeInt32(const quint8* data, int count, WordOrder order, qint32* values);
+
+void decodeUInt32(const quint8* data, int count, WordOrder order, quint32* values);
+
+void decodeFloat32(const quint8* data, int count, WordOrder order, float* values);
+
+void decodeFloat64(const quint8* data, int count, WordOrder order, double* values);
+
+/**
+ * @brief
+ * @en Decode values from registers returned by Client
+ * @ru Извлекает значения из регистров, возвращенных Client
+ *
+ * @en Incomplete value at the end of block is ignored.
+ * @ru Неполное значение в конце блока игнорируется.
+ */
+QVector<qint32> registersToInt32(const QVector<quint16>& registers, WordOrder order = ABCD);
+
+QVector<quint32> registersToUInt32(const QVector<quint16>& registers, WordOrder order = ABCD);
+
+QVector<float> registersToFloat32(const QVector<quint16>& registers, WordOrder order = ABCD);
+
+QVector<double> registersToFloat64(const QVector<quint16>& registers, WordOrder order = ABCD);
+
+/**
+ * @brief
+ * @en Layout of tags in block of registers
+ * @ru Расположение переменных в блоке регистров
+ *
+ * @en Every tag has register offset, type, word order, scale and offset.
+ * decode() calculates raw * scale + offset for all tags. Tags which are added
+ * one after another, have the same type and word order and follow each other
+ * in registers are decoded as one block.
+ *
+ * @ru Каждая переменная имеет смещение в регистрах, тип, порядок слов,
+ * масштаб и смещение значения. decode() вычисляет значение * масштаб +
+ * смещение для всех переменных. Переменные одного типа и порядка слов,
+ * добавленные подряд и расположенные в регистрах друг за другом,
+ * обрабатываются одним блоком.
+ */
+class MODBUS4QT_EXPORT RegisterSchema
+{
+    public:
+
+        enum DataType
+        {
+            Int16,
+            UInt16,
+            Int32,
+            UInt32,
+            Float32,
+            Float64
+        };
+
+        struct Tag
+        {
+            //! @en Offset from first register of block @ru Смещение от первого регистра блока
+            quint16 reg;
+
+            DataType type;
+
+            WordOrder order;
+
+            double scale;
+
+            double offset;
+        };
+
+    private:
+
+        //! @en Tags decoded as one block @ru Переменные, обрабатываемые одним блоком
+        struct Run
+        {
+            int firstTag;
+
+            int count;
+        };
+
+        QVector<Tag> tags_;
+
+        QVector<Run> runs_;
+
+        int registerCount_;
+
+    public:
+
+        RegisterSchema();
+
+        /**
+         * @brief
+         * @en Add tag
+         * @ru Добавляет переменную
+         *
+         * @return
+         * @en Index of tag value in results of decode()
+         * @ru Индекс значения переменной в результатах decode()
+         */
+        int addTag(quint16 reg, DataType type, WordOrder order = ABCD, double scale = 1.0, double offset = 0.0);
+
+        void clear();
+
+        int tagCount() const
+        {
+            return tags_.size();
+        }
+
+        const Tag& tag(int index) const
+        {
+            return tags_.at(index);
+        }
+
+        //! @en Registers needed to decode all tags @ru Количество регистров, необходимое для всех переменных
+        int registerCount() const
+        {
+            return registerCount_;
+        }
+
+        //! @en Number of registers occupied by type @ru Количество регистров, занимаемых типом
+        static int registersOf(DataType type);
+
+        /**
+         * @brief
+         * @en Decode all tags
+         * @ru Извлекает значения всех переменных
+         *
+         * @param
+         * @en data, regCount - register data in wire format and number of registers in it
+         * @ru data, regCount - данные регистров в формате передачи и количество регистров в них
+         *
+         * @param
+         * @en values - array for tagCount() values
+         * @ru values - массив для tagCount() значений
+         *
+         * @return
+         * @en false if block is shorter than registerCount()
+         * @ru false, если блок короче registerCount()
+         */
+        bool decode(const quint8* data, int regCount, double* values) const;
+
+        bool decode(const QVector<quint16>& registers, QVector<double>& values) const;
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_REGISTER_DECODER_H
@@ -0,0 +1,211 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "request_queue.h"
+
+#include <QMetaObject>
+#include <QMutexLocker>
+
+namespace modbus4qt
+{
+
+RequestQueue::RequestQueue(Client* client, QObject* parent)
+    : QObject(parent),
+      client_(client),
+      lastId_(0),
+      agingInterval_(1000),
+      processing_(false)
+{
+    qRegisterMetaType<modbus4qt::RequestResult>("modbus4qt::RequestResult");
+
+    clock_.start();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RequestQueue::cancel(quint64 id)
+{
+    QMutexLocker locker(&mutex_);
+
+    for (int priority = 0; priority < PriorityCount; ++priority)
+    {
+        QQueue<Request>& queue = queues_[priority];
+
+        for (int i = 0; i < queue.size(); ++i)
+        {
+            if (queue.at(i).id == id)
+            {
+                queue.removeAt(i);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+
+quint64
+RequestQueue::enqueue(quint8 unitID, const ProtocolDataUnit& pdu, int pduSize, Priority priority)
+{
+    Request request;
+    request.unitID = unitID;
+    request.pdu = pdu;
+    request.pduSize = pduSize;
+
+    bool wasEmpty;
+    {
+        QMutexLocker locker(&mutex_);
+
+        request.id = ++lastId_;
+        request.enqueued = clock_.nsecsElapsed();
+
+        wasEmpty = true;
+        for (int i = 0; i < PriorityCount; ++i)
+            wasEmpty = wasEmpty && queues_[i].isEmpty();
+
+        queues_[qBound(0, int(priority), PriorityCount - 1)].enqueue(request);
+    }
+
+    // Otherwise processing is already scheduled
+    if (wasEmpty)
+        QMetaObject::invokeMethod(this, "processQueue_", Qt::QueuedConnection);
+
+    return request.id;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+RequestQueue::pendingCount() const
+{
+    QMutexLocker locker(&mutex_);
+
+    int result = 0;
+    for (int i = 0; i < PriorityCount; ++i)
+        result += queues_[i].size();
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+RequestQueue::pendingCount(Priority priority) const
+{
+    QMutexLocker locker(&mutex_);
+
+    return queues_[qBound(0, int(priority), PriorityCount - 1)].size();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RequestQueue::processQueue_()
+{
+    // Client may process events while waiting for response
+    if (processing_)
+        return;
+
+    Request request;
+    if (!takeNext_(request))
+        return;
+
+    processing_ = true;
+
+    RequestResult result;
+    result.id = request.id;
+    result.unitID = request.unitID;
+    result.request = request.pdu;
+
+    qint64 started = clock_.nsecsElapsed();
+    result.queueTime = started - request.enqueued;
+
+    client_->setUnitID(request.unitID);
+    client_->sendRequest(request.pdu, request.pduSize, result.response);
+
+    result.error = client_->lastError();
+    result.transactionTime = clock_.nsecsElapsed() - started;
+
+    processing_ = false;
+
+    // One request per call, so requests added from this thread and other
+    // events are handled between transactions
+    if (pendingCount())
+        QMetaObject::invokeMethod(this, "processQueue_", Qt::QueuedConnection);
+
+    emit finished(result);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RequestQueue::takeNext_(Request& request)
+{
+    QMutexLocker locker(&mutex_);
+
+    qint64 now = clock_.nsecsElapsed();
+
+    int selected = -1;
+    int selectedLevel = PriorityCount;
+
+    // Heads of queues are the oldest requests of their classes
+    for (int priority = 0; priority < PriorityCount; ++priority)
+    {
+        const QQueue<Request>& queue = queues_[priority];
+        if (queue.isEmpty())
+            continue;
+
+        const Request& head = queue.head();
+
+        // Aging stops at alarm class, so no request ever ties with urgent one
+        //
+        // Старение останавливается на классе аварийных сигналов, поэтому ни
+        // один запрос не сравнивается по уровню со срочным
+        //
+        int level = priority;
+        if ((agingInterval_ > 0) && (priority > UrgentPriority))
+            level = qMax(int(AlarmPriority), priority - int((now - head.enqueued) / (qint64(agingInterval_) * 1000000)));
+
+        if (level < selectedLevel
+                || (level == selectedLevel && head.enqueued < queues_[selected].head().enqueued))
+        {
+            selected = priority;
+            selectedLevel = level;
+        }
+    }
+
+    if (selected < 0)
+        return false;
+
+    request = queues_[selected].dequeue();
+
+    return true;
+}
+
+} // namespace modbus4qt
@@ -0,0 +1,259 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_REQUEST_QUEUE_H
+#define MODBUS4QT_REQUEST_QUEUE_H
+
+#include "client.h"
+#include "global.h"
+#include "types.h"
+
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Result of request executed by RequestQueue
+ * @ru Результат запроса, выполненного RequestQueue
+ */
+struct RequestResult
+{
+    //! @en Request identifier returned by RequestQueue::enqueue() @ru Идентификатор запроса, возвращенный RequestQueue::enqueue()
+    quint64 id;
+
+    quint8 unitID;
+
+    //! @en Request protocol data unit @ru Блок данных протокола запроса
+    ProtocolDataUnit request;
+
+    //! @en Response protocol data unit @ru Блок данных протокола ответа
+    ProtocolDataUnit response;
+
+    Client::RequestError error;
+
+    //! @en Time in queue, ns @ru Время нахождения в очереди, нс
+    qint64 queueTime;
+
+    //! @en Time of transaction, ns @ru Время выполнения транзакции, нс
+    qint64 transactionTime;
+
+    RequestResult()
+        : id(0),
+          unitID(0),
+          error(Client::NoError),
+          queueTime(0),
+          transactionTime(0)
+    {
+    }
+
+    bool isOk() const
+    {
+        return error == Client::NoError;
+    }
+};
+
+/**
+ * @brief
+ * @en Queue of requests to one line with priority classes
+ * @ru Очередь запросов к одной линии с классами приоритета
+ *
+ * @en Requests are executed by client one by one in thread of queue. Request
+ * of higher class is always executed before requests of lower classes, so
+ * urgent write waits at most one transaction. To prevent starvation request
+ * is promoted one class up after every aging interval spent in queue, but not
+ * above alarm class. Requests of the same level are executed in order of
+ * arrival.
+ *
+ * Requests may be added from any thread. Queue and client must live in the
+ * same thread.
+ *
+ * @ru Запросы выполняются клиентом по одному в потоке очереди. Запрос более
+ * высокого класса всегда выполняется раньше запросов более низких классов,
+ * поэтому срочная запись ожидает не более одной транзакции. Чтобы запросы
+ * низких классов не ожидали бесконечно, запрос повышается на один класс за
+ * каждый интервал старения, проведенный в очереди, но не выше класса
+ * аварийных сигналов. Запросы одного уровня выполняются в порядке
+ * поступления.
+ *
+ * Запросы могут добавляться из любого потока. Очередь и клиент должны
+ * находиться в одном потоке.
+ */
+class MODBUS4QT_EXPORT RequestQueue : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        /**
+         * @brief
+         * @en Priority classes, from highest to lowest
+         * @ru Классы приоритета, от высшего к низшему
+         */
+        enum Priority
+        {
+            //! @en Operator commands, setpoint writes @ru Команды оператора, запись уставок
+            UrgentPriority,
+
+            //! @en Alarm polling @ru Опрос аварийных сигналов
+            AlarmPriority,
+
+            //! @en Cyclic polling @ru Циклический опрос
+            NormalPriority,
+
+            //! @en Diagnostics, bulk reads @ru Диагностика, чтение больших объемов
+            BackgroundPriority,
+
+            PriorityCount
+        };
+
+    private:
+
+        struct Request
+        {
+            quint64 id;
+
+            quint8 unitID;
+
+            ProtocolDataUnit pdu;
+
+            int pduSize;
+
+            //! @en Time request was added, ns of clock_ @ru Время добавления запроса, нс по clock_
+            qint64 enqueued;
+        };
+
+        Client* client_;
+
+        //! @en Protects queues_ and lastId_ @ru Защищает queues_ и lastId_
+        mutable QMutex mutex_;
+
+        QQueue<Request> queues_[PriorityCount];
+
+        quint64 lastId_;
+
+        QElapsedTimer clock_;
+
+        int agingInterval_;
+
+        bool processing_;
+
+        //! @en Take request to execute next @ru Извлекает следующий выполняемый запрос
+        bool takeNext_(Request& request);
+
+    public:
+
+        /**
+         * @brief
+         * @en Constructor
+         * @ru Конструктор
+         *
+         * @param
+         * @en client - client of line. Queue does not own client
+         * @ru client - клиент линии. Очередь не владеет клиентом
+         */
+        explicit RequestQueue(Client* client, QObject* parent = 0);
+
+        Client* client() const
+        {
+            return client_;
+        }
+
+        /**
+         * @brief
+         * @en Add request to queue
+         * @ru Добавляет запрос в очередь
+         *
+         * @return
+         * @en Request identifier, never 0
+         * @ru Идентификатор запроса, никогда не равен 0
+         */
+        quint64 enqueue(quint8 unitID, const ProtocolDataUnit& pdu, int pduSize, Priority priority = NormalPriority);
+
+        /**
+         * @brief
+         * @en Remove request which is not started yet
+         * @ru Удаляет запрос, выполнение которого еще не началось
+         *
+         * @return
+         * @en true if request was removed
+         * @ru true если запрос удален
+         */
+        bool cancel(quint64 id);
+
+        //! @en Number of requests waiting in queue @ru Количество ожидающих запросов
+        int pendingCount() const;
+
+        //! @en Number of requests of class waiting in queue @ru Количество ожидающих запросов класса
+        int pendingCount(Priority priority) const;
+
+        /**
+         * @brief
+         * @en Return aging interval, ms
+         * @ru Возвращает интервал старения, мс
+         */
+        int agingInterval() const
+        {
+            return agingInterval_;
+        }
+
+        /**
+         * @brief
+         * @en Set time after which waiting request is promoted one class up, ms
+         * @ru Устанавливает время, после которого ожидающий запрос повышается на один класс, мс
+         *
+         * @en Default value 1000 ms. 0 means strict priority without aging.
+         * @ru Значение по умолчанию 1000 мс. 0 означает строгий приоритет без старения.
+         */
+        void setAgingInterval(int agingInterval)
+        {
+            agingInterval_ = agingInterval;
+        }
+
+    signals:
+
+        /**
+         * @brief
+         * @en Request is executed
+         * @ru Запрос выполнен
+         */
+        void finished(const modbus4qt::RequestResult& result);
+
+    private slots:
+
+        void processQueue_();
+};
+
+} // namespace modbus4qt
+
+Q_DECLARE_METATYPE(modbus4qt::RequestResult)
+
+#endif // MODBUS4QT_REQUEST_QUEUE_H
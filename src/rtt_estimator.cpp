@@ -0,0 +1,156 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "rtt_estimator.h"
+
+#include <QtGlobal>
+
+namespace modbus4qt
+{
+
+RttEstimator::RttEstimator(int floor, int ceiling)
+    : units_(256),
+      floor_(floor),
+      ceiling_(ceiling),
+      granularity_(1)
+{
+    resetAll();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RttEstimator::addSample(quint8 unitId, qint64 rtt)
+{
+    UnitRtt& unit = units_[unitId];
+
+    if (unit.samples == 0)
+    {
+        unit.srtt = rtt;
+        unit.rttvar = rtt / 2;
+    }
+    else
+    {
+        qint64 delta = qAbs(unit.srtt - rtt);
+
+        unit.rttvar = (3 * unit.rttvar + delta) / 4;
+        unit.srtt = (7 * unit.srtt + rtt) / 8;
+    }
+
+    ++unit.samples;
+    unit.timeouts = 0;
+    unit.rto = calculateTimeout_(unit);
+    unit.baseRto = unit.rto;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RttEstimator::addTimeout(quint8 unitId, int current)
+{
+    UnitRtt& unit = units_[unitId];
+
+    ++unit.timeouts;
+
+    // Unit with history backs off only to a few of its usual timeouts
+    //
+    // Устройство с историей увеличивает время ожидания лишь до нескольких обычных
+    //
+    int limit = ceiling_;
+    if (unit.samples > 0)
+        limit = qBound(floor_, unit.baseRto * MaxBackoff, ceiling_);
+
+    unit.rto = qBound(floor_, current * 2, limit);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+RttEstimator::calculateTimeout_(const UnitRtt& unit) const
+{
+    // Round up to whole milliseconds
+    qint64 rto = unit.srtt + qMax(qint64(granularity_) * 1000, 4 * unit.rttvar);
+    rto = (rto + 999) / 1000;
+
+    return int(qBound(qint64(floor_), rto, qint64(ceiling_)));
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RttEstimator::reset(quint8 unitId)
+{
+    UnitRtt& unit = units_[unitId];
+
+    unit.srtt = 0;
+    unit.rttvar = 0;
+    unit.rto = 0;
+    unit.baseRto = 0;
+    unit.samples = 0;
+    unit.timeouts = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RttEstimator::resetAll()
+{
+    for (int i = 0; i < units_.size(); ++i)
+        reset(i);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RttEstimator::setLimits(int floor, int ceiling)
+{
+    floor_ = qMax(1, floor);
+    ceiling_ = qMax(floor_, ceiling);
+
+    for (int i = 0; i < units_.size(); ++i)
+    {
+        UnitRtt& unit = units_[i];
+
+        if (unit.rto)
+            unit.rto = qBound(floor_, unit.rto, ceiling_);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int
+RttEstimator::timeout(quint8 unitId, int initial) const
+{
+    const UnitRtt& unit = units_.at(unitId);
+
+    // Unit without history or timeouts uses initial value
+    if (unit.rto == 0)
+        return qBound(floor_, initial, ceiling_);
+
+    return unit.rto;
+}
+
+} // namespace modbus4qt
@@ -0,0 +1,222 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_RTT_ESTIMATOR_H
+#define MODBUS4QT_RTT_ESTIMATOR_H
+
+#include "global.h"
+
+#include <QVector>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Estimator of response timeout for every unit based on measured round trip time
+ * @ru Вычисление времени ожидания ответа для каждого устройства по измеренному времени обмена
+ *
+ * @en Smoothed round trip time (SRTT) and its variation (RTTVAR) are calculated
+ * as in TCP (Jacobson/Karels, RFC 6298):
+ *
+ *     RTTVAR = 3/4 * RTTVAR + 1/4 * |SRTT - R|
+ *     SRTT   = 7/8 * SRTT + 1/8 * R
+ *     RTO    = SRTT + max(G, 4 * RTTVAR)
+ *
+ * Result is limited by floor and ceiling values. Unit without history uses
+ * initial timeout limited by ceiling. After every timeout the value for unit
+ * is doubled until next successful response, so device which became slower
+ * does not time out forever. Doubling stops at MaxBackoff times the timeout
+ * calculated from round trip time (or at ceiling if it is less), so dead unit
+ * costs a few of its usual round trips per poll, not the fixed read timeout.
+ * Default ceiling is 1000 ms; slow lines, e.g. RTU below 9600 bps, need it
+ * raised by setLimits().
+ *
+ * @ru Сглаженное время обмена (SRTT) и его отклонение (RTTVAR) вычисляются
+ * так же, как в TCP (Jacobson/Karels, RFC 6298):
+ *
+ *     RTTVAR = 3/4 * RTTVAR + 1/4 * |SRTT - R|
+ *     SRTT   = 7/8 * SRTT + 1/8 * R
+ *     RTO    = SRTT + max(G, 4 * RTTVAR)
+ *
+ * Результат ограничивается снизу и сверху. Для устройства без истории
+ * используется начальное значение, ограниченное сверху. После каждого
+ * превышения времени ожидания значение для устройства удваивается до
+ * следующего успешного ответа, чтобы устройство, начавшее отвечать медленнее,
+ * не оставалось недоступным навсегда. Удвоение прекращается на значении,
+ * в MaxBackoff раз большем времени ожидания, вычисленного по времени обмена
+ * (или на верхней границе, если она меньше), поэтому неисправное устройство
+ * стоит при опросе нескольких своих обычных времен обмена, а не постоянного
+ * времени ожидания чтения. Верхняя граница по умолчанию 1000 мс; для
+ * медленных линий, например RTU ниже 9600 бит/с, ее нужно увеличить
+ * методом setLimits().
+ */
+class MODBUS4QT_EXPORT RttEstimator
+{
+    private:
+
+        struct UnitRtt
+        {
+            //! @en Smoothed round trip time, us @ru Сглаженное время обмена, мкс
+            qint64 srtt;
+
+            //! @en Round trip time variation, us @ru Отклонение времени обмена, мкс
+            qint64 rttvar;
+
+            //! @en Current timeout, ms @ru Текущее время ожидания, мс
+            int rto;
+
+            //! @en Timeout calculated from round trip time, ms @ru Время ожидания, вычисленное по времени обмена, мс
+            int baseRto;
+
+            int samples;
+
+            //! @en Timeouts since last response @ru Превышений времени ожидания с момента последнего ответа
+            int timeouts;
+        };
+
+        //! @en State for every possible unit ID @ru Состояние для каждого возможного адреса устройства
+        QVector<UnitRtt> units_;
+
+        int floor_;
+
+        int ceiling_;
+
+        int granularity_;
+
+        int calculateTimeout_(const UnitRtt& unit) const;
+
+    public:
+
+        //! @en Limit of timeout doubling relative to timeout calculated from round trip time @ru Предел удвоения времени ожидания относительно вычисленного по времени обмена
+        static const int MaxBackoff = 4;
+
+        /**
+         * @brief
+         * @en Constructor
+         * @ru Конструктор
+         *
+         * @param
+         * @en floor, ceiling - limits for timeout, ms
+         * @ru floor, ceiling - ограничения времени ожидания, мс
+         */
+        RttEstimator(int floor = 20, int ceiling = 1000);
+
+        /**
+         * @brief
+         * @en Return timeout for unit, ms
+         * @ru Возвращает время ожидания для устройства, мс
+         *
+         * @param
+         * @en initial - timeout for unit without history, ms
+         * @ru initial - время ожидания для устройства без истории, мс
+         */
+        int timeout(quint8 unitId, int initial) const;
+
+        /**
+         * @brief
+         * @en Register round trip time of successful transaction
+         * @ru Учитывает время обмена для успешной транзакции
+         *
+         * @param
+         * @en rtt - time from sending request to receiving response, us
+         * @ru rtt - время от отправки запроса до получения ответа, мкс
+         */
+        void addSample(quint8 unitId, qint64 rtt);
+
+        /**
+         * @brief
+         * @en Register transaction without response
+         * @ru Учитывает транзакцию без ответа
+         *
+         * @param
+         * @en current - timeout which was used, ms
+         * @ru current - использованное время ожидания, мс
+         */
+        void addTimeout(quint8 unitId, int current);
+
+        //! @en Forget history of unit @ru Удаляет историю устройства
+        void reset(quint8 unitId);
+
+        //! @en Forget history of all units @ru Удаляет историю всех устройств
+        void resetAll();
+
+        //! @en Smoothed round trip time of unit, us @ru Сглаженное время обмена для устройства, мкс
+        qint64 smoothedRtt(quint8 unitId) const
+        {
+            return units_.at(unitId).srtt;
+        }
+
+        //! @en Round trip time variation of unit, us @ru Отклонение времени обмена для устройства, мкс
+        qint64 rttVariation(quint8 unitId) const
+        {
+            return units_.at(unitId).rttvar;
+        }
+
+        //! @en Number of samples for unit @ru Количество замеров для устройства
+        int sampleCount(quint8 unitId) const
+        {
+            return units_.at(unitId).samples;
+        }
+
+        //! @en Number of timeouts in a row for unit @ru Количество превышений времени ожидания подряд для устройства
+        int timeoutCount(quint8 unitId) const
+        {
+            return units_.at(unitId).timeouts;
+        }
+
+        int floor() const
+        {
+            return floor_;
+        }
+
+        int ceiling() const
+        {
+            return ceiling_;
+        }
+
+        /**
+         * @brief
+         * @en Set limits for timeout, ms
+         * @ru Устанавливает ограничения времени ожидания, мс
+         */
+        void setLimits(int floor, int ceiling);
+
+        //! @en Clock granularity G, ms. Default value 1 ms @ru Разрешение часов G, мс. Значение по умолчанию 1 мс
+        int granularity() const
+        {
+            return granularity_;
+        }
+
+        void setGranularity(int granularity)
+        {
+            granularity_ = granularity;
+        }
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_RTT_ESTIMATOR_H
@@ -31,6 +31,7 @@ the GPL.
 */
 
 #include "rtu_client.h"
+#include "rtu_frame.h"
 #include "utils.h"
 
 #include <QDebug>
@@ -54,7 +55,9 @@ RtuClient::RtuClient(const QString& portName,
       parity_(parity),
       silenceTimer_(this),
       inSilenceState_(false),
-      silenceTime_(0)
+      silenceTime_(0),
+      silenceTimeUs_(0),
+      nativePort_(NULL)
 {
     ioDevice_ = new QSerialPort(this);
     serialPort_ = dynamic_cast<QSerialPort*>(ioDevice_);
@@ -81,7 +84,9 @@ RtuClient::RtuClient(const QString& portName,
       parity_(QSerialPort::EvenParity),
       silenceTimer_(this),
       inSilenceState_(false),
-      silenceTime_(0)
+      silenceTime_(0),
+      silenceTimeUs_(0),
+      nativePort_(NULL)
 {
     ioDevice_ = new QSerialPort(this);
     serialPort_ = dynamic_cast<QSerialPort*>(ioDevice_);
@@ -107,7 +112,9 @@ RtuClient::RtuClient(const QString& portName,
       parity_(QSerialPort::EvenParity),
       silenceTimer_(this),
       inSilenceState_(false),
-      silenceTime_(0)
+      silenceTime_(0),
+      silenceTimeUs_(0),
+      nativePort_(NULL)
 {
     ioDevice_ = new QSerialPort(this);
     serialPort_ = dynamic_cast<QSerialPort*>(ioDevice_);
@@ -132,7 +139,9 @@ RtuClient::RtuClient(const QString& portName,
       parity_(QSerialPort::EvenParity),
       silenceTimer_(this),
       inSilenceState_(false),
-      silenceTime_(0)
+      silenceTime_(0),
+      silenceTimeUs_(0),
+      nativePort_(NULL)
 {
     ioDevice_ = new QSerialPort(this);
     serialPort_ = dynamic_cast<QSerialPort*>(ioDevice_);
@@ -156,7 +165,9 @@ RtuClient::RtuClient(const QString& portName,
       parity_(QSerialPort::EvenParity),
       silenceTimer_(this),
       inSilenceState_(false),
-      silenceTime_(0)
+      silenceTime_(0),
+      silenceTimeUs_(0),
+      nativePort_(NULL)
 {
     ioDevice_ = new QSerialPort(this);
     serialPort_ = dynamic_cast<QSerialPort*>(ioDevice_);
@@ -172,7 +183,7 @@ RtuClient::RtuClient(const QString& portName,
 
 RtuClient::~RtuClient()
 {
-    serialPort_->close();
+    ioDevice_->close();
 }
 
 //-----------------------------------------------------------------------------
@@ -180,12 +191,22 @@ RtuClient::~RtuClient()
 bool
 RtuClient::configurePort_()
 {
-    if (!serialPort_->isOpen())
+    if (!ioDevice_->isOpen())
     {
         emit errorMessage(tr("Cannot configure port %1. The port is not open!").arg(portName_));
         return false;
     }
 
+    // Native port gets settings by setters and applies them while opening
+    //
+    // Собственный порт получает настройки через методы установки и применяет их при открытии
+    //
+    if (nativePort_)
+    {
+        setSilenceTime_();
+        return true;
+    }
+
     if (!serialPort_->setBaudRate(baudRate_))
     {
         emit errorMessage(serialPort_->errorString());
@@ -219,14 +240,14 @@ RtuClient::configurePort_()
 bool
 RtuClient::openPort()
 {
-    if (serialPort_->isOpen()) serialPort_->close();
+    if (ioDevice_->isOpen()) ioDevice_->close();
 
-    bool result = serialPort_->open(QIODevice::ReadWrite);
+    bool result = ioDevice_->open(QIODevice::ReadWrite);
 
     if (!result)
     {
-        emit errorMessage(serialPort_->errorString());
-        serialPort_->close();
+        emit errorMessage(ioDevice_->errorString());
+        ioDevice_->close();
         return false;
     }
     else
@@ -237,7 +258,7 @@ RtuClient::openPort()
         result = configurePort_();
 
         if (!result)
-            serialPort_->close();
+            ioDevice_->close();
         else
         {
             qDebug() << "Port configured!";
@@ -278,14 +299,7 @@ RtuClient::openPort()
 QByteArray
 RtuClient::prepareADU_(const ProtocolDataUnit &pdu, int pduSize)
 {
-    QByteArray result;
-
-    result[0] = unitID_;
-
-    result.insert(1, (char*)&pdu, pduSize);
-
-    quint16 crc = host2net(crc16(result));
-    result.append((char*)&crc, 2);
+    QByteArray result = makeRtuADU(unitID_, pdu, pduSize);
 
     qDebug() << "ADU: " << result.toHex();
     qDebug() << "ADU size: " << result.size();
@@ -376,8 +390,19 @@ RtuClient::processADU_(const QByteArray &buf)
 //-----------------------------------------------------------------------------
 
 QByteArray
-RtuClient::readResponse_()
+RtuClient::readResponse_(int timeout)
 {
+    Q_UNUSED(timeout)
+
+    // Silence is counted from time of last received byte, so time spent in
+    // this thread after receiving does not lengthen frame
+    //
+    // Тишина отсчитывается от времени получения последнего байта, поэтому
+    // время, затраченное этим потоком после приема, не удлиняет пакет
+    //
+    if (nativePort_)
+        return nativePort_->readFrame(silenceTimeUs_);
+
     QByteArray inArray;
     inArray.append(ioDevice_->readAll());
     while (ioDevice_->bytesAvailable() || ioDevice_->waitForReadyRead(silenceTime_ * 2))
@@ -392,22 +417,12 @@ RtuClient::readResponse_()
 bool
 RtuClient::sendRequestToServer_(const ProtocolDataUnit &requestPDU, int requestPDUSize, ProtocolDataUnit *responsePDU)
 {
-    if (inSilenceState_)
+    if (!ioDevice_->isOpen() && !openPort())
     {
-#ifdef DEBUG
-        qDebug() << "In silence state! Waiting...";
-        emit debugMessage("In silence state! Waiting...");
-#endif
-        wait(silenceTime_);
-
-#ifdef DEBUG
-        qDebug() << "Waiting's been finised";
-        emit debugMessage("Waiting's been finised");
-#endif
+        lastError_ = ConnectionError;
+        return false;
     }
 
-    if (!serialPort_->isOpen() && !openPort()) return false;
-
     bool result = Client::sendRequestToServer_(requestPDU, requestPDUSize, responsePDU);
 
     startSilence_();
@@ -418,13 +433,14 @@ RtuClient::sendRequestToServer_(const ProtocolDataUnit &requestPDU, int requestP
 //-----------------------------------------------------------------------------
 
 void
-RtuClient::setBaudRate(QSerialPort::BaudRate baudRate)
+RtuClient::setBaudRate(qint32 baudRate)
 {
     if (baudRate_ != baudRate)
     {
         baudRate_ = baudRate;
         setSilenceTime_();
-        if (serialPort_->isOpen()) serialPort_->setBaudRate(baudRate_);
+        if (nativePort_) nativePort_->setBaudRate(baudRate_);
+        else if (serialPort_->isOpen()) serialPort_->setBaudRate(baudRate_);
     }
 }
 
@@ -436,7 +452,8 @@ RtuClient::setDataBits(QSerialPort::DataBits dataBits)
     if (dataBits_ != dataBits)
     {
         dataBits_ = dataBits;
-        if (serialPort_->isOpen()) serialPort_->setDataBits(dataBits_);
+        if (nativePort_) nativePort_->setDataBits(dataBits_);
+        else if (serialPort_->isOpen()) serialPort_->setDataBits(dataBits_);
     }
 }
 
@@ -448,7 +465,8 @@ RtuClient::setParity(QSerialPort::Parity parity)
     if (parity_ != parity)
     {
         parity_ = parity;
-        if (serialPort_->isOpen()) serialPort_->setParity(parity_);
+        if (nativePort_) nativePort_->setParity(parity_);
+        else if (serialPort_->isOpen()) serialPort_->setParity(parity_);
 
     }
 }
@@ -460,9 +478,10 @@ RtuClient::setPortName(const QString& portName)
 {
     if (portName != portName_)
     {
-        if (serialPort_->isOpen()) serialPort_->close();
+        if (ioDevice_->isOpen()) ioDevice_->close();
         portName_ = portName;
         serialPort_->setPortName(portName_);
+        if (nativePort_) nativePort_->setPortName(portName_);
     }
 }
 
@@ -482,20 +501,81 @@ void RtuClient::setSilenceTime_()
         // Умножаем на 1000 и на всякий случай прибавляем единицу
         silenceTime_ = ((11.0 / baudRate_ ) * 3.5) * 1000 + 1;
 
+    silenceTimeUs_ = (baudRate_ > QSerialPort::Baud19200) ? 1750 : int(11.0 * 3.5 * 1000000 / baudRate_);
+
     qDebug() << QString("Silence time: %1 ms").arg(silenceTime_);
     emit infoMessage(tr("Silence time: %1 ms").arg(silenceTime_));
 }
 
 //-----------------------------------------------------------------------------
 
+void
+RtuClient::setNativeBackend(bool enabled)
+{
+    if (enabled == (nativePort_ != NULL))
+        return;
+
+    ioDevice_->close();
+
+    if (enabled)
+    {
+        nativePort_ = new NativeSerialPort(this);
+        nativePort_->setPortName(portName_);
+        nativePort_->setBaudRate(baudRate_);
+        nativePort_->setDataBits(dataBits_);
+        nativePort_->setStopBits(stopBits_);
+        nativePort_->setParity(parity_);
+
+        ioDevice_ = nativePort_;
+    }
+    else
+    {
+        delete nativePort_;
+        nativePort_ = NULL;
+
+        ioDevice_ = serialPort_;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
 void
 RtuClient::setStopBits(QSerialPort::StopBits stopBits)
 {
     if (stopBits_ != stopBits)
     {
         stopBits_ = stopBits;
-        if (serialPort_->isOpen()) serialPort_->setStopBits(stopBits_);
+        if (nativePort_) nativePort_->setStopBits(stopBits_);
+        else if (serialPort_->isOpen()) serialPort_->setStopBits(stopBits_);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RtuClient::writeRequest_(const ProtocolDataUnit& requestPDU, int requestPDUSize)
+{
+    // Silence is kept here, after quarantine check, so unit in quarantine
+    // does not cost silence time on line
+    //
+    // Тишина выдерживается здесь, после проверки карантина, чтобы
+    // устройство в карантине не занимало линию на время тишины
+    //
+    if (inSilenceState_)
+    {
+#ifdef DEBUG
+        qDebug() << "In silence state! Waiting...";
+        emit debugMessage("In silence state! Waiting...");
+#endif
+        wait(silenceTime_);
+
+#ifdef DEBUG
+        qDebug() << "Waiting's been finised";
+        emit debugMessage("Waiting's been finised");
+#endif
     }
+
+    return Client::writeRequest_(requestPDU, requestPDUSize);
 }
 
 } // namespace modbus4qt
@@ -34,6 +34,7 @@ the GPL.
 #define RTU_CLIENT_H
 
 #include "client.h"
+#include "native_serial_port.h"
 
 #include <QSerialPort>
 #include <QTimer>
@@ -71,7 +72,7 @@ class MODBUS4QT_EXPORT RtuClient : public Client
          * @en Default value: 9600
          * @ru Значение по умолчанию: 9600.
          */
-        QSerialPort::BaudRate baudRate_;
+        qint32 baudRate_;
 
         /**
          * @brief
@@ -130,6 +131,20 @@ class MODBUS4QT_EXPORT RtuClient : public Client
          */
         int silenceTime_;
 
+        /**
+         * @brief
+         * @en Exact silence time for native port, mcs
+         * @ru Точное время тишины для собственного порта, мкс
+         */
+        int silenceTimeUs_;
+
+        /**
+         * @brief
+         * @en Native port, NULL if QSerialPort is used
+         * @ru Собственный порт, NULL, если используется QSerialPort
+         */
+        NativeSerialPort* nativePort_;
+
         /**
          * @brief
          * @en If port is open set data exchange settings with current values
@@ -142,6 +157,8 @@ class MODBUS4QT_EXPORT RtuClient : public Client
          */
         bool configurePort_();
 
+    protected:
+
         /**
          * @brief
          * @en Prepare application data unit for MODBUS/RTU specification
@@ -176,17 +193,28 @@ class MODBUS4QT_EXPORT RtuClient : public Client
          */
         virtual ProtocolDataUnit processADU_(const QByteArray &buf);
 
+        virtual quint8 captureFraming_() const
+        {
+            return TrafficRecord::RtuFraming;
+        }
+
+    private:
+
         /**
          * @brief
          * @en Read response from slave device
          * @ru Читает ответ от сервера MODBUS
          *
+         * @param
+         * @en timeout - not used, end of frame is detected by silence on line
+         * @ru timeout - не используется, конец пакета определяется по паузе в линии
+         *
          * @return
          * @en Readed data array
          * @ru Массив прочитанных данных
          *
          */
-        virtual QByteArray readResponse_();
+        virtual QByteArray readResponse_(int timeout);
 
         virtual bool sendRequestToServer_(const ProtocolDataUnit& requestPDU,  int requestPDUSize, ProtocolDataUnit* responsePDU);
 
@@ -197,6 +225,13 @@ class MODBUS4QT_EXPORT RtuClient : public Client
          */
         void setSilenceTime_();
 
+        /**
+         * @brief
+         * @en Wait for end of silence and send request
+         * @ru Ожидает окончания периода тишины и отправляет запрос
+         */
+        virtual bool writeRequest_(const ProtocolDataUnit& requestPDU, int requestPDUSize);
+
     private slots:
 
         /**
@@ -421,10 +456,14 @@ class MODBUS4QT_EXPORT RtuClient : public Client
          * @ru baudRate - new baud rate
          * @ru baudRate - скорость обмена данными
          *
-         * @en If port is open then baud rate will be changed on fly.
+         * @en If port is open then baud rate will be changed on fly. Non-standard
+         * rates are accepted by native port and by QSerialPort where platform allows.
+         *
          * @ru Если порт открыт, то скорость обмена изменяется "на лету".
+         * Нестандартные скорости принимаются собственным портом и QSerialPort,
+         * если это позволяет платформа.
          */
-        void setBaudRate(QSerialPort::BaudRate baudRate);
+        void setBaudRate(qint32 baudRate);
 
         /**
          * @brief
@@ -496,6 +535,41 @@ class MODBUS4QT_EXPORT RtuClient : public Client
             return portName_;
         }
 
+        /**
+         * @brief
+         * @en Use NativeSerialPort instead of QSerialPort
+         * @ru Использует NativeSerialPort вместо QSerialPort
+         *
+         * @en Native port is available on Linux only. Responses are read in
+         * calling thread without event loop, end of frame is found by exact
+         * silence time since last received byte. Port is closed when backend
+         * is changed, it is opened again by next request or openPort().
+         *
+         * @ru Собственный порт доступен только в Linux. Ответы читаются в
+         * вызывающем потоке без цикла событий, конец пакета определяется по
+         * точному времени тишины после последнего полученного байта. При смене
+         * порта он закрывается и открывается снова следующим запросом или
+         * методом openPort().
+         *
+         * @sa nativePort()
+         */
+        void setNativeBackend(bool enabled = true);
+
+        bool isNativeBackend() const
+        {
+            return nativePort_ != NULL;
+        }
+
+        /**
+         * @brief
+         * @en Native port for setting low latency and RS-485 modes, NULL if it is not used
+         * @ru Собственный порт для настройки режимов низкой задержки и RS-485, NULL, если он не используется
+         */
+        NativeSerialPort* nativePort() const
+        {
+            return nativePort_;
+        }
+
     signals:
 
         /**
@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "rtu_frame.h"
+#include "utils.h"
+
+namespace modbus4qt
+{
+
+QByteArray
+makeRtuADU(quint8 unitId, const ProtocolDataUnit& pdu, int pduSize)
+{
+    QByteArray result;
+    result.reserve(1 + pduSize + 2);
+
+    result.append(char(unitId));
+    result.append((const char*)&pdu, pduSize);
+
+    quint16 crc = host2net(crc16(result));
+    result.append((const char*)&crc, 2);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+rtuResponseSize(const quint8* adu, int size)
+{
+    // Unit ID and function code
+    if (size < 2)
+        return 0;
+
+    const quint8 functionCode = adu[1];
+
+    // Exception: unit ID, function code, exception code and CRC
+    if (functionCode & 0x80)
+        return 5;
+
+    switch (functionCode)
+    {
+        case 0x01 : // Read coils
+        case 0x02 : // Read discrete inputs
+        case 0x03 : // Read holding registers
+        case 0x04 : // Read input registers
+        case 0x0C : // Get comm event log
+        case 0x11 : // Report server ID
+        case 0x14 : // Read file record
+        case 0x15 : // Write file record
+        case 0x17 : // Read/write multiple registers
+            if (size < 3)
+                return 0;
+
+            return 3 + adu[2] + 2;
+
+        case 0x05 : // Write single coil
+        case 0x06 : // Write single register
+        case 0x08 : // Diagnostics
+        case 0x0B : // Get comm event counter
+        case 0x0F : // Write multiple coils
+        case 0x10 : // Write multiple registers
+            return 8;
+
+        case 0x07 : // Read exception status
+            return 5;
+
+        case 0x16 : // Mask write register
+            return 10;
+
+        case 0x18 : // Read FIFO queue, byte count takes two bytes
+            if (size < 4)
+                return 0;
+
+            return 4 + ((adu[2] << 8) | adu[3]) + 2;
+
+        default :
+            return -1;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+isRtuCrcValid(const quint8* adu, int size)
+{
+    if (size < 4)
+        return false;
+
+    quint16 crc = crc16(QByteArray::fromRawData((const char*)adu, size - 2));
+
+    // crc16() returns CRC with bytes swapped, as in libmodbus, so high byte of result goes first
+    return (adu[size - 2] == hi(crc)) && (adu[size - 1] == lo(crc));
+}
+
+} // namespace modbus4qt
@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_RTU_FRAME_H
+#define MODBUS4QT_RTU_FRAME_H
+
+#include "types.h"
+
+#include <QByteArray>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Form MODBUS/RTU application data unit: unit ID, PDU and CRC
+ * @ru Формирует блок данных приложения MODBUS/RTU: адрес устройства, PDU и CRC
+ */
+QByteArray makeRtuADU(quint8 unitId, const ProtocolDataUnit& pdu, int pduSize);
+
+/**
+ * @brief
+ * @en Return expected size of RTU response frame from its first bytes
+ * @ru Возвращает ожидаемый размер кадра ответа RTU по его первым байтам
+ *
+ * @en Size is known from function code and byte count fields, so end of
+ * frame is found without silence timing.
+ *
+ * @ru Размер определяется по коду функции и полю количества байт, поэтому
+ * конец кадра находится без отсчета паузы.
+ *
+ * @return
+ * @en Size of frame including CRC; 0 if more bytes are needed; -1 if function code is unknown
+ * @ru Размер кадра вместе с CRC; 0, если нужно больше байт; -1, если код функции неизвестен
+ */
+int rtuResponseSize(const quint8* adu, int size);
+
+//! @en Check CRC of complete RTU frame @ru Проверяет CRC полного кадра RTU
+bool isRtuCrcValid(const quint8* adu, int size);
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_RTU_FRAME_H
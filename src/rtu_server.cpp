@@ -1,13 +1,74 @@
 #include "rtu_server.h"
+#include "utils.h"
 
 namespace modbus4qt
 {
 
 RtuServer::RtuServer(QObject *parent) :
-    Server()
+    Server(parent)
 {
 }
 
+//-----------------------------------------------------------------------------
 
-} // namespace modbus4qt
+QByteArray
+RtuServer::processADU(const QByteArray& adu)
+{
+    const int aduSize = adu.size();
+
+    captureFrame_(TrafficRecord::RtuFraming, 0, (const quint8*)adu.constData(), aduSize);
+
+    // Minimum ADU size is 4 bytes: address, function code and CRC
+    //
+    // Минимальный размер ADU 4 байта: адрес, код функции и CRC
+    //
+    if ((aduSize < 4) || (aduSize > PDUMaxSize + 3))
+        return QByteArray();
+
+    WordRec aduCrc;
+    aduCrc.bytes[0] = adu[aduSize - 2];
+    aduCrc.bytes[1] = adu[aduSize - 1];
+
+    if (net2host(aduCrc.word) != crc16(adu.left(aduSize - 2)))
+    {
+        emit errorMessage(tr("CRC mismatch!"));
+        return QByteArray();
+    }
+
+    const quint8 unitId = adu[0];
+    const bool isBroadcast = (unitId == BroadcastUnitId);
+
+    // Without route unit may be another slave on the same line
+    //
+    // Устройство без маршрута может быть другим ведомым на той же линии
+    //
+    if (isRouting())
+    {
+        if (!unitDevice(unitId) && !unitForwarder(unitId))
+            return QByteArray();
+    }
+    else if (!isBroadcast && (unitID_ != IgnoreUnitId) && (unitId != unitID_))
+        return QByteArray();
+
+    PduView request((const quint8*)adu.constData() + 1, aduSize - 3);
 
+    quint8 response[PDUMaxSize];
+    int responseSize = isRouting() ? routeRequest_(unitId, request, response) : processRequest_(request, response);
+
+    if (isBroadcast)
+        return QByteArray();
+
+    QByteArray result;
+    result.reserve(responseSize + 3);
+    result.append(char(unitId));
+    result.append((const char*)response, responseSize);
+
+    quint16 crc = host2net(crc16(result));
+    result.append((char*)&crc, 2);
+
+    captureFrame_(TrafficRecord::Sent | TrafficRecord::RtuFraming, 0, (const quint8*)result.constData(), result.size());
+
+    return result;
+}
+
+} // namespace modbus4qt
@@ -3,15 +3,43 @@
 
 #include "server.h"
 
+#include <QByteArray>
+
 namespace modbus4qt
 {
 
-class RtuServer : public Server
+/**
+ * @brief
+ * @en MODBUS/RTU server
+ * @ru Сервер MODBUS/RTU
+ */
+class MODBUS4QT_EXPORT RtuServer : public Server
 {
     Q_OBJECT
     public:
         explicit RtuServer(QObject *parent = 0);
 
+        /**
+         * @brief
+         * @en Process application data unit recieved from serial line and prepare response
+         * @ru Обрабатывает полученный из последовательной линии блок данных приложения и формирует ответ
+         *
+         * @param
+         * @en adu - complete request frame: unit ID, PDU and CRC
+         * @ru adu - полный кадр запроса: адрес устройства, PDU и CRC
+         *
+         * @return
+         * @en Response frame or empty array if no response should be sent
+         * @ru Кадр ответа или пустой массив, если ответ отправлять не нужно
+         *
+         * @en Frames with wrong CRC or addressed to other unit are ignored. Broadcast
+         * requests are executed without response.
+         *
+         * @ru Кадры с неверной контрольной суммой или адресованные другому устройству
+         * игнорируются. Широковещательные запросы выполняются без отправки ответа.
+         */
+        QByteArray processADU(const QByteArray& adu);
+
     signals:
 
     public slots:
@@ -0,0 +1,401 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "rtu_tcp_client.h"
+#include "rtu_frame.h"
+#include "utils.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTcpSocket>
+
+#include <algorithm>
+
+namespace modbus4qt
+{
+
+// Maximum size of RTU frame: unit ID, PDU and CRC
+//
+// Максимальный размер кадра RTU: адрес устройства, PDU и CRC
+//
+static const int RtuFrameMaxSize = 1 + PDUMaxSize + 2;
+
+//-----------------------------------------------------------------------------
+
+RtuTcpClient::RtuTcpClient(QObject *parent)
+    : Client(parent),
+      serverAddress_(QHostAddress::LocalHost),
+      port_(DefaultTcpPort),
+      autoConnect_(true),
+      connectTimeOut_(15000),
+      requestPending_(false),
+      pendingUnitID_(0)
+{
+    tcpSocket_ = new QTcpSocket(this);
+    ioDevice_ = tcpSocket_;
+
+    connect(tcpSocket_, SIGNAL(readyRead()), this, SLOT(readyRead_()));
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RtuTcpClient::connectToServer(int timeout)
+{
+    tcpSocket_->connectToHost(serverAddress_, port_);
+    if (!tcpSocket_->waitForConnected(timeout))
+        emit errorMessage(tcpSocket_->errorString());
+
+    tcpSocket_->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    inBuffer_.clear();
+    readyFrame_.clear();
+    requestPending_ = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RtuTcpClient::disconnectFromServer()
+{
+    tcpSocket_->disconnectFromHost();
+    requestPending_ = false;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RtuTcpClient::isConnected() const
+{
+    return tcpSocket_->state() == QAbstractSocket::ConnectedState;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RtuTcpClient::setServerAddress(const QHostAddress& serverAddress)
+{
+    if (serverAddress != serverAddress_)
+    {
+        if (isConnected()) disconnectFromServer();
+        serverAddress_ = serverAddress;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RtuTcpClient::setPort(quint16 port)
+{
+    if (port != port_)
+    {
+        if (isConnected()) disconnectFromServer();
+        port_ = port;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RtuTcpClient::ensureConnected_()
+{
+    if (!isConnected() && autoConnect_)
+        connectToServer(connectTimeOut_);
+
+    if (!isConnected())
+    {
+        emit errorMessage(tr("Not connected to server!"));
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RtuTcpClient::discardInput_()
+{
+    inBuffer_.clear();
+    readyFrame_.clear();
+    tcpSocket_->readAll();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RtuTcpClient::postRequest(const ProtocolDataUnit& pdu, int pduSize)
+{
+    if (requestPending_)
+    {
+        emit errorMessage(unitID_, tr("Previous request is still waiting for response!"));
+        return false;
+    }
+
+    if (!ensureConnected_())
+        return false;
+
+    discardInput_();
+
+    if (!writeRequest_(pdu, pduSize))
+        return false;
+
+    requestPending_ = (unitID_ != BroadcastUnitId);
+    pendingUnitID_ = unitID_;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RtuTcpClient::takeResponse(ProtocolDataUnit& pdu)
+{
+    if (readyFrame_.isEmpty())
+        return false;
+
+    pdu = processADU_(readyFrame_);
+    readyFrame_.clear();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RtuTcpClient::waitForResponse(ProtocolDataUnit& pdu, int timeout)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    // readyRead_() is called from waitForReadyRead()
+    forever
+    {
+        readyRead_();
+
+        if (takeResponse(pdu))
+            return true;
+
+        if (!requestPending_)
+            return false;
+
+        int timeLeft = timeout - int(clock.elapsed());
+        if (timeLeft <= 0 || !tcpSocket_->waitForReadyRead(timeLeft))
+            return false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RtuTcpClient::cancelRequest()
+{
+    requestPending_ = false;
+    discardInput_();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RtuTcpClient::readyRead_()
+{
+    // Blocking requests read socket by themselves
+    if (!requestPending_)
+        return;
+
+    inBuffer_.append(tcpSocket_->readAll());
+
+    QByteArray frame;
+
+    while (extractFrame_(frame))
+    {
+        if (quint8(frame.at(0)) != pendingUnitID_)
+            continue;
+
+        captureFrame_(false, frame);
+
+        readyFrame_ = frame;
+        requestPending_ = false;
+
+        emit responseReady();
+        return;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RtuTcpClient::extractFrame_(QByteArray& frame)
+{
+    while (!inBuffer_.isEmpty())
+    {
+        const quint8* data = (const quint8*)inBuffer_.constData();
+        const int size = inBuffer_.size();
+
+        int frameSize = rtuResponseSize(data, size);
+
+        if (frameSize == 0)
+            return false;
+
+        if (frameSize > 0 && frameSize <= RtuFrameMaxSize)
+        {
+            if (size < frameSize)
+                return false;
+
+            if (isRtuCrcValid(data, frameSize))
+            {
+                frame = inBuffer_.left(frameSize);
+                inBuffer_.remove(0, frameSize);
+                return true;
+            }
+        }
+        else if (frameSize < 0)
+        {
+            // Size of unknown function is found by CRC
+            //
+            // Размер кадра неизвестной функции определяется по CRC
+            //
+            for (int candidate = 4; candidate <= qMin(size, RtuFrameMaxSize); ++candidate)
+            {
+                if (isRtuCrcValid(data, candidate))
+                {
+                    frame = inBuffer_.left(candidate);
+                    inBuffer_.remove(0, candidate);
+                    return true;
+                }
+            }
+
+            if (size < RtuFrameMaxSize)
+                return false;
+        }
+
+        // Wrong CRC or impossible size: frame does not start here
+        //
+        // Неверная CRC или невозможный размер: кадр начинается не здесь
+        //
+        emit errorMessage(unitID_, tr("Wrong application data unit recieved!"));
+        inBuffer_.remove(0, 1);
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray
+RtuTcpClient::prepareADU_(const ProtocolDataUnit& pdu, int pduSize)
+{
+    return makeRtuADU(unitID_, pdu, pduSize);
+}
+
+//-----------------------------------------------------------------------------
+
+ProtocolDataUnit
+RtuTcpClient::processADU_(const QByteArray& buf)
+{
+    ProtocolDataUnit pdu;
+
+    // Unit ID, function code and CRC at least
+    //
+    // Как минимум адрес устройства, код функции и CRC
+    //
+    if (buf.size() < 4)
+    {
+        emit errorMessage(unitID_, tr("Wrong application data unit recieved!"));
+        return pdu;
+    }
+
+    const quint8* adu = (const quint8*)buf.constData();
+
+    if (!isRtuCrcValid(adu, buf.size()))
+        emit errorMessage(unitID_, tr("CRC mismatch!"));
+
+    int pduSize = qMin(buf.size() - 3, PDUMaxSize);
+
+    pdu.functionCode = adu[1];
+    std::copy(adu + 2, adu + 1 + pduSize, pdu.data);
+
+    return pdu;
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray
+RtuTcpClient::readResponse_(int timeout)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    QByteArray frame;
+
+    inBuffer_.append(tcpSocket_->readAll());
+
+    forever
+    {
+        // Frames from other units may be left after timeouts
+        //
+        // Кадры от других устройств могут остаться после истечения времени ожидания
+        //
+        while (extractFrame_(frame))
+        {
+            if (quint8(frame.at(0)) == unitID_)
+                return frame;
+        }
+
+        int timeLeft = timeout - int(clock.elapsed());
+        if (timeLeft <= 0 || !tcpSocket_->waitForReadyRead(timeLeft))
+            break;
+
+        inBuffer_.append(tcpSocket_->readAll());
+    }
+
+    return QByteArray();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RtuTcpClient::sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUSize, ProtocolDataUnit* responsePDU)
+{
+    if (requestPending_)
+    {
+        lastError_ = ConnectionError;
+        emit errorMessage(unitID_, tr("Posted request is still waiting for response!"));
+        return false;
+    }
+
+    if (!ensureConnected_())
+    {
+        lastError_ = ConnectionError;
+        return false;
+    }
+
+    discardInput_();
+
+    return Client::sendRequestToServer_(requestPDU, requestPDUSize, responsePDU);
+}
+
+} // namespace modbus4qt
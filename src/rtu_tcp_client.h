@@ -0,0 +1,215 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_RTU_TCP_CLIENT_H
+#define MODBUS4QT_RTU_TCP_CLIENT_H
+
+#include "client.h"
+
+#include <QHostAddress>
+
+class QTcpSocket;
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en MODBUS/RTU client over TCP connection
+ * @ru Клиент MODBUS/RTU через подключение TCP
+ *
+ * @en Serial device servers in transparent mode pass RTU frames with CRC
+ * through TCP connection. TCP splits and joins frames arbitrarily, so end of
+ * frame is found from function code and byte count instead of silence on
+ * line.
+ *
+ * @ru Преобразователи интерфейсов в прозрачном режиме передают кадры RTU вместе
+ * с CRC через подключение TCP. TCP произвольно разбивает и объединяет кадры,
+ * поэтому конец кадра определяется по коду функции и количеству байт, а не
+ * по паузе в линии.
+ *
+ * @en RTU frame has no transaction ID and serial line behind converter is
+ * half duplex, so only one request may be in flight on one client. Requests to
+ * several converters run concurrently in one thread with postRequest() and
+ * responseReady() signal, or with RequestQueue per converter.
+ *
+ * @ru Кадр RTU не содержит номера транзакции, а последовательная линия за
+ * преобразователем полудуплексная, поэтому у одного клиента может быть только
+ * один запрос в обработке. Запросы к нескольким преобразователям выполняются
+ * одновременно в одном потоке с помощью postRequest() и сигнала
+ * responseReady(), или с отдельной RequestQueue для каждого преобразователя.
+ */
+class MODBUS4QT_EXPORT RtuTcpClient : public Client
+{
+    Q_OBJECT
+
+    private:
+
+        QTcpSocket* tcpSocket_;
+
+        QHostAddress serverAddress_;
+
+        //! @en Default value: 502 @ru Значение по умолчанию: 502
+        quint16 port_;
+
+        //! @en Default value: true @ru Значение по умолчанию: истина
+        bool autoConnect_;
+
+        //! @en Default value 15000 ms @ru Значение по умолчанию 15000 мс
+        int connectTimeOut_;
+
+        /**
+         * @brief
+         * @en Buffer for data recieved from converter but not processed yet
+         * @ru Буфер для полученных от преобразователя, но еще не обработанных данных
+         */
+        QByteArray inBuffer_;
+
+        //! @en Request posted by postRequest() waits for response @ru Запрос, отправленный postRequest(), ожидает ответа
+        bool requestPending_;
+
+        quint8 pendingUnitID_;
+
+        //! @en Response to posted request @ru Ответ на отправленный запрос
+        QByteArray readyFrame_;
+
+    public:
+
+        explicit RtuTcpClient(QObject *parent = 0);
+
+        virtual void connectToServer(int timeout);
+
+        virtual void disconnectFromServer();
+
+        virtual bool isConnected() const;
+
+        bool isAutoConnect() const
+        {
+            return autoConnect_;
+        }
+
+        void setAutoConnect(bool autoConnect = true)
+        {
+            autoConnect_ = autoConnect;
+        }
+
+        QHostAddress serverAddress() const
+        {
+            return serverAddress_;
+        }
+
+        //! @en Close connection to other converter, if any @ru Закрывает подключение к другому преобразователю, если оно есть
+        void setServerAddress(const QHostAddress& serverAddress);
+
+        quint16 port() const
+        {
+            return port_;
+        }
+
+        void setPort(quint16 port);
+
+        /**
+         * @brief
+         * @en Send request without waiting for response
+         * @ru Отправляет запрос, не дожидаясь ответа
+         *
+         * @en responseReady() is emitted when response is recieved, then it is
+         * taken by takeResponse(). Broadcast request is not answered and is not
+         * counted as pending.
+         *
+         * @ru При получении ответа излучается сигнал responseReady(), после
+         * чего ответ забирается методом takeResponse(). Широковещательный
+         * запрос не имеет ответа и не считается ожидающим.
+         *
+         * @return
+         * @en false if other request is pending or request can not be sent
+         * @ru false, если другой запрос ожидает ответа или запрос не удалось отправить
+         */
+        bool postRequest(const ProtocolDataUnit& pdu, int pduSize);
+
+        bool isRequestPending() const
+        {
+            return requestPending_;
+        }
+
+        //! @en Take response to posted request if it is recieved @ru Забирает ответ на отправленный запрос, если он получен
+        bool takeResponse(ProtocolDataUnit& pdu);
+
+        //! @en Wait for response to posted request @ru Ожидает ответ на отправленный запрос
+        bool waitForResponse(ProtocolDataUnit& pdu, int timeout);
+
+        //! @en Forget posted request, e.g. after timeout @ru Забывает отправленный запрос, например по истечении времени ожидания
+        void cancelRequest();
+
+    signals:
+
+        //! @en Response to posted request is recieved @ru Получен ответ на отправленный запрос
+        void responseReady();
+
+    private:
+
+        /**
+         * @brief
+         * @en Extract first complete frame with valid CRC from input buffer
+         * @ru Извлекает из входного буфера первый полный кадр с правильной CRC
+         *
+         * @en Bytes which can not start valid frame are skipped one by one, so
+         * reading recovers after corrupted or foreign data.
+         *
+         * @ru Байты, с которых не может начинаться правильный кадр, пропускаются
+         * по одному, так что чтение восстанавливается после искаженных или
+         * посторонних данных.
+         */
+        bool extractFrame_(QByteArray& frame);
+
+        //! @en Drop data left from previous requests @ru Отбрасывает данные, оставшиеся от предыдущих запросов
+        void discardInput_();
+
+        bool ensureConnected_();
+
+    private slots:
+
+        void readyRead_();
+
+    protected:
+
+        virtual QByteArray prepareADU_(const ProtocolDataUnit& pdu, int pduSize);
+
+        virtual ProtocolDataUnit processADU_(const QByteArray& buf);
+
+        virtual quint8 captureFraming_() const
+        {
+            return TrafficRecord::RtuFraming;
+        }
+
+        virtual QByteArray readResponse_(int timeout);
+
+        virtual bool sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUSize, ProtocolDataUnit* responsePDU);
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_RTU_TCP_CLIENT_H
@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "scatter_read.h"
+#include "device.h"
+#include "utils.h"
+
+namespace modbus4qt
+{
+
+bool
+ReadRange::isValid() const
+{
+    switch (function)
+    {
+        case Functions::ReadCoils :
+        case Functions::ReadDescereteInputs :
+            return (quantity >= 1) && (quantity <= MaxCoilsForRead) && (start + quantity <= 0x10000);
+
+        case Functions::ReadHoldingRegisters :
+        case Functions::ReadInputRegisters :
+            return (quantity >= 1) && (quantity <= MaxRegistersForRead) && (start + quantity <= 0x10000);
+
+        default :
+            return false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int
+ScatterReadHandler::processRequest(Device* device, const PduView& request, quint8* response)
+{
+    if (!device)
+        return exception(Exceptions::ServerDeviceFailure);
+
+    if (request.dataSize() < 1)
+        return exception(Exceptions::IllegalDataValue);
+
+    const int count = request.data()[0];
+
+    if ((count < 1) || (count > ScatterReadMaxRanges) || (request.dataSize() < 1 + count * 5))
+        return exception(Exceptions::IllegalDataValue);
+
+    // Whole response is checked before reading, so device is not read in vain
+    //
+    // Весь ответ проверяется до чтения, чтобы не читать устройство напрасно
+    //
+    int byteCount = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int offset = 1 + i * 5;
+        ReadRange range(request.data()[offset], request.word(offset + 1), request.word(offset + 3));
+
+        if (!range.isValid())
+            return exception(Exceptions::IllegalDataValue);
+
+        byteCount += range.responseSize();
+    }
+
+    if (2 + byteCount > PDUMaxSize)
+        return exception(Exceptions::IllegalDataValue);
+
+    quint8* out = response + 2;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int offset = 1 + i * 5;
+        ReadRange range(request.data()[offset], request.word(offset + 1), request.word(offset + 3));
+        bool isOk = false;
+
+        switch (range.function)
+        {
+            case Functions::ReadCoils :
+                isOk = device->readCoils(range.start, range.quantity, range.bits);
+                break;
+
+            case Functions::ReadDescereteInputs :
+                isOk = device->readDescreteInputs(range.start, range.quantity, range.bits);
+                break;
+
+            case Functions::ReadHoldingRegisters :
+                isOk = device->readHoldingRegisters(range.start, range.quantity, range.registers);
+                break;
+
+            case Functions::ReadInputRegisters :
+                isOk = device->readInputRegisters(range.start, range.quantity, range.registers);
+                break;
+        }
+
+        if (!isOk)
+            return exception(Exceptions::IllegalDataAddress);
+
+        if (range.isBits())
+            putCoilsIntoBuffer(out, range.bits);
+        else
+            putRegistersIntoBuffer(out, range.registers);
+
+        out += range.responseSize();
+    }
+
+    response[1] = byteCount;
+
+    return 2 + byteCount;
+}
+
+} // namespace modbus4qt
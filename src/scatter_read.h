@@ -0,0 +1,136 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_SCATTER_READ_H
+#define MODBUS4QT_SCATTER_READ_H
+
+#include "function_handler.h"
+
+#include <QVector>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en One range of scatter read
+ * @ru Один диапазон чтения нескольких диапазонов
+ *
+ * @en Request of scatter read function carries up to ScatterReadMaxRanges ranges:
+ *
+ * @ru Запрос функции чтения нескольких диапазонов содержит до
+ * ScatterReadMaxRanges диапазонов:
+ *
+ * <pre>
+ * +------+-------+----------------------------------+-----+
+ * | Code | Count | Function (1) Start (2) Qty (2)   | ... |
+ * +------+-------+----------------------------------+-----+
+ * </pre>
+ *
+ * @en Function is standard read function 0x01..0x04. Response contains byte
+ * count and data of all ranges in order of request, packed as in responses of
+ * standard functions; it must fit into one protocol data unit:
+ *
+ * @ru Функция - стандартная функция чтения 0x01..0x04. Ответ содержит
+ * количество байт и данные всех диапазонов в порядке запроса, упакованные как
+ * в ответах стандартных функций; он должен умещаться в один блок данных протокола:
+ *
+ * <pre>
+ * +------+------------+--------------+--------------+-----+
+ * | Code | Byte count | Data range 1 | Data range 2 | ... |
+ * +------+------------+--------------+--------------+-----+
+ * </pre>
+ */
+struct ReadRange
+{
+    //! @en Standard read function @ru Стандартная функция чтения
+    quint8 function;
+
+    quint16 start;
+
+    quint16 quantity;
+
+    //! @en Values read by functions 0x01 and 0x02 @ru Значения, прочитанные функциями 0x01 и 0x02
+    QVector<bool> bits;
+
+    //! @en Values read by functions 0x03 and 0x04 @ru Значения, прочитанные функциями 0x03 и 0x04
+    QVector<quint16> registers;
+
+    ReadRange()
+        : function(Functions::ReadHoldingRegisters),
+          start(0),
+          quantity(0)
+    {
+    }
+
+    ReadRange(quint8 function, quint16 start, quint16 quantity)
+        : function(function),
+          start(start),
+          quantity(quantity)
+    {
+    }
+
+    //! @en True if function reads bits @ru True, если функция читает биты
+    bool isBits() const
+    {
+        return (function == Functions::ReadCoils) || (function == Functions::ReadDescereteInputs);
+    }
+
+    //! @en True if function and quantity are allowed by protocol @ru True, если функция и количество допустимы протоколом
+    bool isValid() const;
+
+    //! @en Size of range data in response (in bytes) @ru Размер данных диапазона в ответе в байтах
+    int responseSize() const
+    {
+        return isBits() ? (quantity + 7) / 8 : quantity * 2;
+    }
+};
+
+/**
+ * @brief
+ * @en Server handler of scatter read function
+ * @ru Серверный обработчик функции чтения нескольких диапазонов
+ *
+ * @en Install it by Server::setFunctionHandler() for DefaultScatterReadFunction
+ * or other user defined code. Ranges are read from device by standard read
+ * methods.
+ *
+ * @ru Устанавливается методом Server::setFunctionHandler() для кода
+ * DefaultScatterReadFunction или другого пользовательского кода. Диапазоны
+ * читаются из устройства стандартными методами чтения.
+ *
+ * @sa ReadRange
+ */
+class MODBUS4QT_EXPORT ScatterReadHandler : public FunctionHandler
+{
+    public:
+
+        virtual int processRequest(Device* device, const PduView& request, quint8* response);
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_SCATTER_READ_H
@@ -1,11 +1,237 @@
 #include "server.h"
+#include "device.h"
+#include "function_handler.h"
+#include "utils.h"
 
 namespace modbus4qt
 {
 
+// Standard handlers keep no state, so they are shared by all servers
+//
+// Стандартные обработчики не хранят состояния, поэтому общие для всех серверов
+//
+static ReadBitsHandler readBitsHandler;
+static ReadRegistersHandler readRegistersHandler;
+static WriteSingleCoilHandler writeSingleCoilHandler;
+static WriteSingleRegisterHandler writeSingleRegisterHandler;
+static WriteMultipleCoilsHandler writeMultipleCoilsHandler;
+static WriteMultipleRegistersHandler writeMultipleRegistersHandler;
+
+//-----------------------------------------------------------------------------
+
 Server::Server(QObject *parent)
-    : QObject(parent)
+    : QObject(parent),
+      device_(NULL),
+      ioDevice_(NULL),
+      readTimeout_(5000),
+      writeTimeout_(5000),
+      unitID_(IgnoreUnitId),
+      routeCount_(0),
+      trafficCapture_(NULL)
+{
+    std::fill(handlers_, handlers_ + 256, static_cast<FunctionHandler*>(NULL));
+    clearRoutes();
+
+    handlers_[Functions::ReadCoils] = &readBitsHandler;
+    handlers_[Functions::ReadDescereteInputs] = &readBitsHandler;
+    handlers_[Functions::ReadHoldingRegisters] = &readRegistersHandler;
+    handlers_[Functions::ReadInputRegisters] = &readRegistersHandler;
+    handlers_[Functions::WriteSingleCoil] = &writeSingleCoilHandler;
+    handlers_[Functions::WriteSingleRegister] = &writeSingleRegisterHandler;
+    handlers_[Functions::WriteMultipleCoils] = &writeMultipleCoilsHandler;
+    handlers_[Functions::WriteMultipleRegisters] = &writeMultipleRegistersHandler;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+Server::exceptionResponse_(quint8 functionCode, quint8 exceptionCode, quint8* response) const
 {
+    response[0] = functionCode | 0x80;
+    response[1] = exceptionCode;
+
+    return 2;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+Server::processRequest_(const PduView& request, quint8* response)
+{
+    return processRequest_(device_, request, response);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+Server::processRequest_(Device* device, const PduView& request, quint8* response)
+{
+    const quint8 functionCode = request.functionCode();
+    FunctionHandler* handler = handlers_[functionCode];
+
+    if (!handler)
+        return exceptionResponse_(functionCode, Exceptions::IllegalFunction, response);
+
+    response[0] = functionCode;
+
+    int responseSize = handler->processRequest(device, request, response);
+
+    if (responseSize < 0)
+        return exceptionResponse_(functionCode, -responseSize, response);
+
+    return responseSize;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+Server::setFunctionHandler(quint8 functionCode, FunctionHandler* handler)
+{
+    handlers_[functionCode] = handler;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+Server::routeRequest_(quint8 unitId, const PduView& request, quint8* response)
+{
+    const Route& route = routes_[unitId];
+
+    if (route.device)
+        return processRequest_(route.device, request, response);
+
+    if (!route.forwarder)
+        return exceptionResponse_(request.functionCode(), Exceptions::GatewayPathNotAvailable, response);
+
+    response[0] = request.functionCode();
+
+    int responseSize = route.forwarder->forwardRequest(unitId, request, response);
+
+    if (responseSize < 0)
+        return exceptionResponse_(request.functionCode(), -responseSize, response);
+
+    return responseSize;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+Server::setUnitDevice(quint8 unitId, Device* device)
+{
+    Route& route = routes_[unitId];
+    const bool hadRoute = route.device || route.forwarder;
+
+    route.device = device;
+    route.forwarder = NULL;
+
+    routeCount_ += int(device != NULL) - int(hadRoute);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+Server::setUnitForwarder(quint8 unitId, UnitForwarder* forwarder)
+{
+    Route& route = routes_[unitId];
+    const bool hadRoute = route.device || route.forwarder;
+
+    route.device = NULL;
+    route.forwarder = forwarder;
+
+    routeCount_ += int(forwarder != NULL) - int(hadRoute);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+Server::clearRoutes()
+{
+    for (int i = 0; i < 256; ++i)
+    {
+        routes_[i].device = NULL;
+        routes_[i].forwarder = NULL;
+    }
+
+    routeCount_ = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+Server::tcpADUSize_(const quint8* header)
+{
+    quint16 protocolId = (header[2] << 8) | header[3];
+    int length = (header[4] << 8) | header[5];
+
+    if ((protocolId != 0) || (length < 2) || (length > PDUMaxSize + 1))
+        return -1;
+
+    return sizeof(TcpDataHeader) - 1 + length;
+}
+
+//-----------------------------------------------------------------------------
+
+/*
+ * <------------------------ MODBUS TCP/IP ADU(1) ------------------------->
+ *              <----------- MODBUS PDU (1') ---------------->
+ *  +-----------+---------------+------------------------------------------+
+ *  | TID | PID | Length | UID  |Code | Data                               |
+ *  +-----------+---------------+------------------------------------------+
+ */
+
+int
+Server::processTcpADU_(const quint8* adu, int aduSize, quint8* response, quint32 peer)
+{
+    const int headerSize = sizeof(TcpDataHeader);
+
+    captureFrame_(0, peer, adu, aduSize);
+
+    if (aduSize < headerSize + 1)
+        return 0;
+
+    quint16 protocolId = (adu[2] << 8) | adu[3];
+    int length = (adu[4] << 8) | adu[5];
+
+    if ((protocolId != 0) || (length < 2) || (length > PDUMaxSize + 1) || (headerSize - 1 + length != aduSize))
+        return 0;
+
+    quint8 unitId = adu[6];
+
+    // Request is read in place from received buffer and response PDU is
+    // written straight into response buffer after header, so only header is
+    // copied
+    //
+    // Запрос читается на месте из буфера приема, а блок данных ответа
+    // записывается прямо в буфер ответа после заголовка, поэтому копируется
+    // только заголовок
+    //
+    PduView request(adu + headerSize, length - 1);
+    quint8* responsePDU = response + headerSize;
+    int responseSize = 0;
+
+    // When listening for a specific unit ID, only accept data for that ID
+    //
+    // Если задан идентификатор сервера, то обрабатываются только запросы для него
+    //
+    if (routeCount_ > 0)
+        responseSize = routeRequest_(unitId, request, responsePDU);
+    else if ((unitID_ != IgnoreUnitId) && (unitId != unitID_))
+        responseSize = exceptionResponse_(request.functionCode(), Exceptions::ServerDeviceFailure, responsePDU);
+    else
+        responseSize = processRequest_(request, responsePDU);
+
+    // Header of response is a copy of request header with new length
+    //
+    // Заголовок ответа - копия заголовка запроса с новой длиной
+    //
+    std::copy(adu, adu + 4, response);
+    response[4] = hi(responseSize + 1);
+    response[5] = lo(responseSize + 1);
+    response[6] = unitId;
+
+    captureFrame_(TrafficRecord::Sent, peer, response, headerSize + responseSize);
+
+    return headerSize + responseSize;
 }
 
 } // namespace modbus4qt
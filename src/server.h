@@ -15,6 +15,7 @@
 
 #include "global.h"
 #include "consts.h"
+#include "traffic_capture.h"
 #include "types.h"
 
 class QIODevice;
@@ -23,17 +24,19 @@ namespace modbus4qt
 {
 
 class Device;
+class FunctionHandler;
+class UnitForwarder;
 
 /**
 * @brief
 * @en Abtract modbus server
 * @ru Абстрактный сервер протокола modbus
  */
-class Server : public QObject
+class MODBUS4QT_EXPORT Server : public QObject
 {
     Q_OBJECT
 
-    private:
+    protected:
         /**
          * @brief
          * @en device_
@@ -75,6 +78,163 @@ class Server : public QObject
          */
         quint8 unitID_;
 
+        /**
+         * @brief
+         * @en Process request and form response protocol data unit
+         * @ru Обрабатывает запрос и формирует блок данных протокола для ответа
+         *
+         * @param
+         * @en request - protocol data unit recieved from client
+         * @ru request - блок данных протокола, полученный от клиента
+         *
+         * @param
+         * @en response - buffer of PDUMaxSize bytes for protocol data unit to send to client
+         * @ru response - буфер размером PDUMaxSize байт для блока данных протокола, передаваемого клиенту
+         *
+         * @return
+         * @en Size of response protocol data unit (in bytes)
+         * @ru Размер в байтах блока данных протокола ответа
+         *
+         * @en Request is passed to handler of its function code. Function without
+         * handler is answered by exception "illegal function".
+         *
+         * @ru Запрос передается обработчику его кода функции. На функцию без
+         * обработчика передается исключение "недопустимая функция".
+         */
+        int processRequest_(const PduView& request, quint8* response);
+
+        //! @en Process request with given device @ru Обрабатывает запрос заданным устройством
+        int processRequest_(Device* device, const PduView& request, quint8* response);
+
+        /**
+         * @brief
+         * @en Process request by route of unit
+         * @ru Обрабатывает запрос по маршруту устройства
+         *
+         * @return
+         * @en Size of response; exception "gateway path not available" for unit
+         * without route
+         * @ru Размер ответа; исключение "путь шлюза недоступен" для устройства
+         * без маршрута
+         */
+        int routeRequest_(quint8 unitId, const PduView& request, quint8* response);
+
+        /**
+         * @brief
+         * @en Form exception response
+         * @ru Формирует ответ-исключение
+         *
+         * @param
+         * @en functionCode - function code of request
+         * @ru functionCode - код функции запроса
+         *
+         * @param
+         * @en exceptionCode - exception code
+         * @ru exceptionCode - код исключения
+         *
+         * @param
+         * @en response - protocol data unit to send to client
+         * @ru response - блок данных протокола для передачи клиенту
+         *
+         * @return
+         * @en Size of response protocol data unit (in bytes)
+         * @ru Размер в байтах блока данных протокола ответа
+         */
+        int exceptionResponse_(quint8 functionCode, quint8 exceptionCode, quint8* response) const;
+
+        /**
+         * @brief
+         * @en Process MODBUS/TCP application data unit and form response one
+         * @ru Обрабатывает блок данных приложения MODBUS/TCP и формирует блок данных ответа
+         *
+         * @en Used by all transports with MBAP header.
+         * @ru Используется всеми транспортами с заголовком MBAP.
+         *
+         * @param
+         * @en adu, aduSize - complete application data unit of request
+         * @ru adu, aduSize - полный блок данных приложения запроса
+         *
+         * @param
+         * @en response - buffer for at least TcpADUMaxSize bytes, must not overlap adu
+         * @ru response - буфер размером не менее TcpADUMaxSize байт, не должен пересекаться с adu
+         *
+         * @param
+         * @en peer - identifier of connection or client for traffic capture
+         * @ru peer - идентификатор подключения или клиента для записи трафика
+         *
+         * @return
+         * @en Size of response application data unit; 0 if request is wrong
+         * @ru Размер блока данных приложения ответа; 0, если запрос неверен
+         */
+        int processTcpADU_(const quint8* adu, int aduSize, quint8* response, quint32 peer = 0);
+
+        /**
+         * @brief
+         * @en Write frame to traffic capture if it is set
+         * @ru Сохраняет кадр в записи трафика, если она установлена
+         *
+         * @param
+         * @en flags - TrafficRecord::Sent and framing flag; ServerSide is added
+         * @ru flags - TrafficRecord::Sent и флаг формата; ServerSide добавляется
+         */
+        void captureFrame_(quint8 flags, quint32 peer, const quint8* adu, int size)
+        {
+            if (trafficCapture_)
+                trafficCapture_->record(flags | TrafficRecord::ServerSide, peer, (const char*)adu, size);
+        }
+
+        /**
+         * @brief
+         * @en Return size of MODBUS/TCP application data unit by its header
+         * @ru Возвращает размер блока данных приложения MODBUS/TCP по его заголовку
+         *
+         * @en Used by stream transports to split input into requests.
+         * @ru Используется потоковыми транспортами для разделения входных данных на запросы.
+         *
+         * @param
+         * @en header - at least sizeof(TcpDataHeader) bytes of request
+         * @ru header - не менее sizeof(TcpDataHeader) байт запроса
+         *
+         * @return
+         * @en Size of application data unit; -1 if header is wrong
+         * @ru Размер блока данных приложения; -1, если заголовок неверен
+         */
+        static int tcpADUSize_(const quint8* header);
+
+    private:
+
+        /**
+         * @brief
+         * @en Handlers indexed by function code
+         * @ru Обработчики, индексированные кодом функции
+         */
+        FunctionHandler* handlers_[256];
+
+        //! @en Route of one unit ID @ru Маршрут одного идентификатора устройства
+        struct Route
+        {
+            Device* device;
+
+            UnitForwarder* forwarder;
+        };
+
+        /**
+         * @brief
+         * @en Routes indexed by unit ID
+         * @ru Маршруты, индексированные идентификатором устройства
+         */
+        Route routes_[256];
+
+        //! @en Units with route @ru Количество устройств с маршрутом
+        int routeCount_;
+
+        /**
+         * @brief
+         * @en Capture of received requests and sent responses, NULL if not used
+         * @ru Запись принятых запросов и переданных ответов, NULL, если не используется
+         */
+        TrafficCapture* trafficCapture_;
+
     public:
 
         /**
@@ -88,6 +248,165 @@ class Server : public QObject
          */
         explicit Server(QObject *parent = 0);
 
+        /**
+         * @brief
+         * @en Return device which serves requests
+         * @ru Возвращает устройство, обрабатывающее запросы
+         */
+        Device* device() const
+        {
+            return device_;
+        }
+
+        /**
+         * @brief
+         * @en Set device which serves requests
+         * @ru Устанавливает устройство, обрабатывающее запросы
+         *
+         * @param
+         * @en device - device for data exchange. Server does not take ownership.
+         * @ru device - устройство для обмена данными. Сервер не становится его владельцем.
+         */
+        void setDevice(Device* device)
+        {
+            device_ = device;
+        }
+
+        /**
+         * @brief
+         * @en Set server unit ID
+         * @ru Устанавливает идентификатор сервера
+         *
+         * @param
+         * @en unitID - server unit ID. IgnoreUnitId means any unit ID is accepted.
+         * @ru unitID - идентификатор сервера. Значение IgnoreUnitId означает прием запросов для любого устройства.
+         */
+        void setUnitID(quint8 unitID)
+        {
+            unitID_ = unitID;
+        }
+
+        /**
+         * @brief
+         * @en Return server unit ID
+         * @ru Возвращает идентификатор сервера
+         */
+        quint8 unitID() const
+        {
+            return unitID_;
+        }
+
+        /**
+         * @brief
+         * @en Set handler of function code
+         * @ru Устанавливает обработчик кода функции
+         *
+         * @en Standard read and write functions have handlers by default. Handler
+         * can be set for any other code, e.g. user defined function.
+         *
+         * @ru Стандартные функции чтения и записи имеют обработчики по умолчанию.
+         * Обработчик можно установить для любого другого кода, например для
+         * пользовательской функции.
+         *
+         * @param
+         * @en handler - handler of requests; NULL means function is not supported.
+         * Server does not take ownership.
+         * @ru handler - обработчик запросов; NULL означает, что функция не
+         * поддерживается. Сервер не становится его владельцем.
+         */
+        void setFunctionHandler(quint8 functionCode, FunctionHandler* handler);
+
+        /**
+         * @brief
+         * @en Return handler of function code, NULL if function is not supported
+         * @ru Возвращает обработчик кода функции, NULL, если функция не поддерживается
+         */
+        FunctionHandler* functionHandler(quint8 functionCode) const
+        {
+            return handlers_[functionCode];
+        }
+
+        /**
+         * @brief
+         * @en Serve unit ID by its own device
+         * @ru Обслуживает идентификатор устройства его собственным устройством
+         *
+         * @en Once any route is set, requests are dispatched by unit ID through
+         * routing table, and device() and unitID() are not used. Requests for
+         * unit without route are answered by exception "gateway path not
+         * available" on MODBUS/TCP and MODBUS/UDP and are ignored on serial line,
+         * where other slaves may answer them.
+         *
+         * @ru Как только задан любой маршрут, запросы распределяются по
+         * идентификатору устройства через таблицу маршрутов, а device() и
+         * unitID() не используются. На запросы для устройства без маршрута по
+         * MODBUS/TCP и MODBUS/UDP передается исключение "путь шлюза недоступен",
+         * в последовательной линии они игнорируются, так как на них могут
+         * ответить другие устройства.
+         *
+         * @param
+         * @en device - device for unit; NULL removes route. Server does not take ownership.
+         * @ru device - устройство; NULL удаляет маршрут. Сервер не становится его владельцем.
+         */
+        void setUnitDevice(quint8 unitId, Device* device);
+
+        /**
+         * @brief
+         * @en Pass requests for unit ID to forwarder
+         * @ru Передает запросы для идентификатора устройства передатчику
+         *
+         * @param
+         * @en forwarder - forwarder for unit; NULL removes route. Server does not take ownership.
+         * @ru forwarder - передатчик; NULL удаляет маршрут. Сервер не становится его владельцем.
+         *
+         * @sa setUnitDevice()
+         */
+        void setUnitForwarder(quint8 unitId, UnitForwarder* forwarder);
+
+        //! @en Remove all routes @ru Удаляет все маршруты
+        void clearRoutes();
+
+        //! @en Device of unit, NULL if unit has no device route @ru Устройство, NULL, если для него нет маршрута к устройству
+        Device* unitDevice(quint8 unitId) const
+        {
+            return routes_[unitId].device;
+        }
+
+        //! @en Forwarder of unit, NULL if unit has no forwarder route @ru Передатчик, NULL, если для устройства нет маршрута к передатчику
+        UnitForwarder* unitForwarder(quint8 unitId) const
+        {
+            return routes_[unitId].forwarder;
+        }
+
+        //! @en True if requests are dispatched by routing table @ru True, если запросы распределяются по таблице маршрутов
+        bool isRouting() const
+        {
+            return routeCount_ > 0;
+        }
+
+        /**
+         * @brief
+         * @en Record all received requests and sent responses into capture
+         * @ru Сохраняет все принятые запросы и переданные ответы в записи трафика
+         *
+         * @en Capture is written from threads of server, it must not be
+         * changed while server is running. Server does not own capture.
+         *
+         * @ru Запись производится из потоков сервера, ее нельзя менять во
+         * время работы сервера. Сервер не владеет записью.
+         *
+         * @sa TrafficCapture
+         */
+        void setTrafficCapture(TrafficCapture* capture)
+        {
+            trafficCapture_ = capture;
+        }
+
+        TrafficCapture* trafficCapture() const
+        {
+            return trafficCapture_;
+        }
+
     signals:
 
         /**
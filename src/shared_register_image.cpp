@@ -0,0 +1,620 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "shared_register_image.h"
+#include "utils.h"
+
+#include <QFile>
+#include <QThread>
+
+#include <atomic>
+
+#ifdef Q_OS_UNIX
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <stddef.h>
+    #include <string.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace modbus4qt
+{
+
+// Tables cover full MODBUS address space: 0x0000..0xFFFF
+//
+// Таблицы охватывают все адресное пространство MODBUS: 0x0000..0xFFFF
+//
+static const quint32 ImageTableSize = 0x10000;
+
+//-----------------------------------------------------------------------------
+
+SharedRegisterImage::SharedRegisterImage(const QString& name)
+    : name_(name),
+      fd_(-1),
+      data_(0),
+      size_(0),
+      owner_(false),
+      persistent_(false),
+      restored_(false),
+      dirty_(false),
+      pageSize_(4096),
+      readRetries_(1000)
+{
+    if (!name_.startsWith('/'))
+        name_.prepend('/');
+
+#ifdef Q_OS_UNIX
+    pageSize_ = int(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+SharedRegisterImage::~SharedRegisterImage()
+{
+    detach();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::create()
+{
+    detach();
+
+#ifdef Q_OS_UNIX
+    QByteArray posixName = QFile::encodeName(name_);
+
+    // Segment left by crashed process is replaced
+    shm_unlink(posixName.constData());
+
+    fd_ = shm_open(posixName.constData(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd_ < 0)
+    {
+        setError_(QString("Can not create shared memory segment %1: %2").arg(name_).arg(strerror(errno)));
+        return false;
+    }
+
+    owner_ = true;
+
+    quint32 offsets[SharedImageHeader::TableCount];
+    quint32 size = layout_(offsets);
+
+    // New segment is filled with zeros by ftruncate()
+    if (ftruncate(fd_, size) != 0)
+    {
+        setError_(QString("Can not set size of shared memory segment %1: %2").arg(name_).arg(strerror(errno)));
+        detach();
+        return false;
+    }
+
+    if (!map_(size, true))
+        return false;
+
+    initHeader_(size, offsets);
+
+    return true;
+#else
+    setError_("Shared register image is not supported on this platform");
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::attach()
+{
+    detach();
+
+#ifdef Q_OS_UNIX
+    fd_ = shm_open(QFile::encodeName(name_).constData(), O_RDONLY, 0);
+    if (fd_ < 0)
+    {
+        setError_(QString("Can not open shared memory segment %1: %2").arg(name_).arg(strerror(errno)));
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd_, &info) != 0 || info.st_size < qint64(sizeof(SharedImageHeader)))
+    {
+        setError_(QString("Shared memory segment %1 is too small").arg(name_));
+        detach();
+        return false;
+    }
+
+    if (!map_(info.st_size, false))
+        return false;
+
+    if (!isValidHeader_(size_))
+    {
+        setError_(QString("Shared memory segment %1 has unknown layout").arg(name_));
+        detach();
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return true;
+#else
+    setError_("Shared register image is not supported on this platform");
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::openFile(const QString& fileName)
+{
+    detach();
+
+    name_ = fileName;
+
+#ifdef Q_OS_UNIX
+    fd_ = open(QFile::encodeName(name_).constData(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd_ < 0)
+    {
+        setError_(QString("Can not open register image file %1: %2").arg(name_).arg(strerror(errno)));
+        return false;
+    }
+
+    owner_ = true;
+    persistent_ = true;
+
+    quint32 offsets[SharedImageHeader::TableCount];
+    quint32 size = layout_(offsets);
+
+    struct stat info;
+    bool sameSize = (fstat(fd_, &info) == 0 && info.st_size == qint64(size));
+
+    // File of wrong size can not contain our image, it is cleared and extended with zeros
+    if (!sameSize && (ftruncate(fd_, 0) != 0 || ftruncate(fd_, size) != 0))
+    {
+        setError_(QString("Can not set size of register image file %1: %2").arg(name_).arg(strerror(errno)));
+        detach();
+        return false;
+    }
+
+    if (!map_(size, true))
+        return false;
+
+    dirtyPages_.fill(false, (size + pageSize_ - 1) / pageSize_);
+    dirty_ = false;
+
+    if (sameSize && isValidHeader_(size) && header_()->checksum == headerChecksum_(header_()))
+    {
+        // Writer could be killed inside table, readers must not wait for it
+        for (int table = 0; table < SharedImageHeader::TableCount; ++table)
+            header_()->sequences[table].value.fetchAndAndOrdered(~1);
+
+        restored_ = true;
+        return true;
+    }
+
+    memset(data_, 0, size);
+    initHeader_(size, offsets);
+
+    markDirty_(data_, size);
+    flush(true);
+
+    return true;
+#else
+    setError_("Register image file is not supported on this platform");
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::flush(bool wait)
+{
+    if (!persistent_ || !isAttached())
+        return false;
+
+    if (!dirty_)
+        return true;
+
+#ifdef Q_OS_UNIX
+    int flags = wait ? MS_SYNC : MS_ASYNC;
+    bool result = true;
+
+    // Adjacent dirty pages are written by one call, header page is written last
+    int pageCount = dirtyPages_.size();
+    int page = 0;
+
+    while (page < pageCount)
+    {
+        if (!dirtyPages_.at(page))
+        {
+            ++page;
+            continue;
+        }
+
+        int first = page;
+        while (page < pageCount && dirtyPages_.at(page))
+        {
+            dirtyPages_[page] = false;
+            ++page;
+        }
+
+        quint32 offset = quint32(first) * pageSize_;
+        quint32 length = qMin(size_ - offset, quint32(page - first) * pageSize_);
+
+        if (msync(data_ + offset, length, flags) != 0)
+            result = false;
+    }
+
+    dirty_ = false;
+
+    SharedImageHeader* header = header_();
+    ++header->generation;
+    header->checksum = headerChecksum_(header);
+
+    if (msync(data_, pageSize_, flags) != 0)
+        result = false;
+
+    if (!result)
+        setError_(QString("Can not write register image file %1: %2").arg(name_).arg(strerror(errno)));
+
+    return result;
+#else
+    Q_UNUSED(wait)
+
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SharedRegisterImage::detach()
+{
+    if (persistent_)
+        flush(true);
+
+#ifdef Q_OS_UNIX
+    if (data_)
+        munmap(data_, size_);
+
+    if (fd_ >= 0)
+        close(fd_);
+
+    if (owner_ && !persistent_)
+        shm_unlink(QFile::encodeName(name_).constData());
+#endif
+
+    data_ = 0;
+    size_ = 0;
+    fd_ = -1;
+    owner_ = false;
+    persistent_ = false;
+    restored_ = false;
+    dirty_ = false;
+    dirtyPages_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+int
+SharedRegisterImage::tableSize() const
+{
+    return isAttached() ? int(header_()->tableSize) : 0;
+}
+
+//-----------------------------------------------------------------------------
+
+quint32
+SharedRegisterImage::generation() const
+{
+    return isAttached() ? header_()->generation : 0;
+}
+
+//-----------------------------------------------------------------------------
+
+quint32
+SharedRegisterImage::sequence(Table table) const
+{
+    if (!isAttached())
+        return 0;
+
+    return quint32(header_()->sequences[table].value.loadAcquire());
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::readBits(Table table, quint16 start, int count, bool* values) const
+{
+    if (!checkRange_(table, start, count, false))
+        return false;
+
+    const quint8* bits = data_ + header_()->tableOffsets[table] + start;
+    QBasicAtomicInt& sequence = header_()->sequences[table].value;
+
+    for (int attempt = 0; attempt < readRetries_; ++attempt)
+    {
+        int before = sequence.loadAcquire();
+
+        if (before & 1)
+        {
+            // Writer is inside the table, let it finish
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        for (int i = 0; i < count; ++i)
+            values[i] = bits[i] != 0;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence.loadAcquire() == before)
+            return true;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::readRegisters(Table table, quint16 start, int count, quint16* values) const
+{
+    if (!checkRange_(table, start, count, true))
+        return false;
+
+    const quint16* registers = reinterpret_cast<const quint16*>(data_ + header_()->tableOffsets[table]) + start;
+    QBasicAtomicInt& sequence = header_()->sequences[table].value;
+
+    for (int attempt = 0; attempt < readRetries_; ++attempt)
+    {
+        int before = sequence.loadAcquire();
+
+        if (before & 1)
+        {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        memcpy(values, registers, count * sizeof(quint16));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence.loadAcquire() == before)
+            return true;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::writeBits(Table table, quint16 start, int count, const bool* values)
+{
+    if (!owner_ || !checkRange_(table, start, count, false))
+        return false;
+
+    quint8* bits = data_ + header_()->tableOffsets[table] + start;
+
+    beginWrite_(table);
+
+    for (int i = 0; i < count; ++i)
+        bits[i] = values[i] ? 1 : 0;
+
+    endWrite_(table);
+
+    if (persistent_)
+        markDirty_(bits, count);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::writeRegisters(Table table, quint16 start, int count, const quint16* values)
+{
+    if (!owner_ || !checkRange_(table, start, count, true))
+        return false;
+
+    quint16* registers = reinterpret_cast<quint16*>(data_ + header_()->tableOffsets[table]) + start;
+
+    beginWrite_(table);
+    memcpy(registers, values, count * sizeof(quint16));
+    endWrite_(table);
+
+    if (persistent_)
+        markDirty_(registers, count * sizeof(quint16));
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::checkRange_(Table table, quint16 start, int count, bool registers) const
+{
+    if (!isAttached() || count < 0)
+        return false;
+
+    bool registerTable = (table == HoldingRegisters || table == InputRegisters);
+    if (registerTable != registers)
+        return false;
+
+    return quint32(start) + quint32(count) <= header_()->tableSize;
+}
+
+//-----------------------------------------------------------------------------
+
+quint32
+SharedRegisterImage::layout_(quint32* offsets)
+{
+    // Tables are aligned on cache lines
+    quint32 size = sizeof(SharedImageHeader);
+
+    for (int table = 0; table < SharedImageHeader::TableCount; ++table)
+    {
+        offsets[table] = size;
+
+        quint32 itemSize = (table == HoldingRegisters || table == InputRegisters) ? sizeof(quint16) : sizeof(quint8);
+        size += ImageTableSize * itemSize;
+        size = (size + SharedImageHeader::CacheLineSize - 1) & ~quint32(SharedImageHeader::CacheLineSize - 1);
+    }
+
+    return size;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SharedRegisterImage::initHeader_(quint32 size, const quint32* offsets)
+{
+    SharedImageHeader* header = header_();
+    header->version = SharedImageHeader::Version;
+    header->headerSize = sizeof(SharedImageHeader);
+    header->tableSize = ImageTableSize;
+    header->totalSize = size;
+    header->generation = 0;
+
+    for (int table = 0; table < SharedImageHeader::TableCount; ++table)
+        header->tableOffsets[table] = offsets[table];
+
+    // Readers check magic number, so it is written after the rest of header
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SharedImageHeader::Magic;
+
+    header->checksum = headerChecksum_(header);
+}
+
+//-----------------------------------------------------------------------------
+
+quint16
+SharedRegisterImage::headerChecksum_(const SharedImageHeader* header)
+{
+    int size = offsetof(SharedImageHeader, checksum);
+
+    return crc16(QByteArray::fromRawData(reinterpret_cast<const char*>(header), size));
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::isValidHeader_(quint32 mappedSize) const
+{
+    const SharedImageHeader* header = header_();
+
+    if (header->magic != quint32(SharedImageHeader::Magic)
+        || header->version != SharedImageHeader::Version
+        || header->headerSize != sizeof(SharedImageHeader)
+        || header->totalSize > mappedSize)
+    {
+        return false;
+    }
+
+    for (int table = 0; table < SharedImageHeader::TableCount; ++table)
+    {
+        quint32 itemSize = (table == HoldingRegisters || table == InputRegisters) ? sizeof(quint16) : sizeof(quint8);
+
+        if (quint64(header->tableOffsets[table]) + quint64(header->tableSize) * itemSize > header->totalSize)
+            return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SharedRegisterImage::markDirty_(const void* address, int size)
+{
+    if (size <= 0)
+        return;
+
+    int offset = static_cast<const quint8*>(address) - data_;
+
+    for (int page = offset / pageSize_; page <= (offset + size - 1) / pageSize_; ++page)
+        dirtyPages_[page] = true;
+
+    dirty_ = true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SharedRegisterImage::map_(int size, bool writable)
+{
+#ifdef Q_OS_UNIX
+    void* address = mmap(0, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+
+    if (address == MAP_FAILED)
+    {
+        setError_(QString("Can not map shared memory segment %1: %2").arg(name_).arg(strerror(errno)));
+        detach();
+        return false;
+    }
+
+    data_ = static_cast<quint8*>(address);
+    size_ = size;
+
+    return true;
+#else
+    Q_UNUSED(size)
+    Q_UNUSED(writable)
+
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SharedRegisterImage::setError_(const QString& text)
+{
+    errorString_ = text;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SharedRegisterImage::beginWrite_(Table table)
+{
+    // Counter becomes odd, readers started before will retry
+    header_()->sequences[table].value.fetchAndAddOrdered(1);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SharedRegisterImage::endWrite_(Table table)
+{
+    header_()->sequences[table].value.fetchAndAddOrdered(1);
+}
+
+} // namespace modbus4qt
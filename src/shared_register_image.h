@@ -0,0 +1,341 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_SHARED_REGISTER_IMAGE_H
+#define MODBUS4QT_SHARED_REGISTER_IMAGE_H
+
+#include "global.h"
+
+#include <QAtomicInt>
+#include <QString>
+#include <QVector>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Layout of shared register image
+ * @ru Структура разделяемого образа регистров
+ *
+ * @en Segment starts with this header, tables follow at given offsets. Coils
+ * and discrete inputs take one byte per item (0 or 1), registers are stored in
+ * host byte order. Every table has its own sequence counter: it is odd while
+ * table is being written and is incremented by two with every write.
+ *
+ * @en Generation and checksum are used by images stored in file: generation is
+ * incremented by every flush and checksum protects fixed part of header.
+ *
+ * @ru Сегмент начинается с этого заголовка, таблицы следуют за ним по
+ * указанным смещениям. Флаги и дискретные входы занимают один байт на
+ * значение (0 или 1), регистры хранятся в порядке байтов процессора. Каждая
+ * таблица имеет собственный счетчик последовательности: он нечетный во время
+ * записи таблицы и увеличивается на два при каждой записи.
+ *
+ * @ru Поколение и контрольная сумма используются образами, хранящимися в
+ * файле: поколение увеличивается при каждом сбросе на диск, а контрольная
+ * сумма защищает неизменную часть заголовка.
+ */
+struct SharedImageHeader
+{
+    enum
+    {
+        Magic = 0x5234514D, // "MQ4R"
+        Version = 1,
+        TableCount = 4,
+        CacheLineSize = 64
+    };
+
+    //! @en Sequence counter on its own cache line @ru Счетчик последовательности в отдельной строке кэша
+    struct Sequence
+    {
+        QBasicAtomicInt value;
+
+        char padding[CacheLineSize - sizeof(QBasicAtomicInt)];
+    };
+
+    quint32 magic;
+
+    quint16 version;
+
+    quint16 headerSize;
+
+    //! @en Items in every table @ru Количество значений в каждой таблице
+    quint32 tableSize;
+
+    //! @en Offsets of tables from start of segment @ru Смещения таблиц от начала сегмента
+    quint32 tableOffsets[TableCount];
+
+    quint32 totalSize;
+
+    //! @en Number of completed flushes of file image @ru Количество завершенных сбросов образа в файл
+    quint32 generation;
+
+    //! @en CRC of header up to this field @ru CRC заголовка до этого поля
+    quint16 checksum;
+
+    quint16 reserved;
+
+    char padding[CacheLineSize - 40];
+
+    Sequence sequences[TableCount];
+};
+
+/**
+ * @brief
+ * @en Register tables in named POSIX shared memory segment
+ * @ru Таблицы регистров в именованном сегменте разделяемой памяти POSIX
+ *
+ * @en Process which owns MODBUS server creates image and is the only writer.
+ * Other processes attach to image read-only and read consistent blocks of
+ * values without system calls: every table is protected by sequence lock, so
+ * reader repeats copying if table was changed meanwhile. Writer never waits
+ * for readers.
+ *
+ * @ru Процесс, в котором работает сервер MODBUS, создает образ и является
+ * единственным писателем. Другие процессы подключаются к образу только для
+ * чтения и читают согласованные блоки значений без системных вызовов: каждая
+ * таблица защищена блокировкой-последовательностью (seqlock), поэтому
+ * читатель повторяет копирование, если таблица за это время изменилась.
+ * Писатель никогда не ждет читателей.
+ *
+ * @en Image may also be stored in file instead of shared memory, so register
+ * values survive restart. Changed pages are written to disk in batches by
+ * flush(), which has to be called periodically.
+ *
+ * @ru Образ также может храниться в файле вместо разделяемой памяти, тогда
+ * значения регистров сохраняются при перезапуске. Измененные страницы
+ * записываются на диск пакетами функцией flush(), которую нужно вызывать
+ * периодически.
+ *
+ * @en Available on Unix systems only.
+ * @ru Доступен только в системах Unix.
+ */
+class MODBUS4QT_EXPORT SharedRegisterImage
+{
+    public:
+
+        enum Table
+        {
+            Coils,
+            DiscreteInputs,
+            HoldingRegisters,
+            InputRegisters
+        };
+
+    private:
+
+        QString name_;
+
+        int fd_;
+
+        quint8* data_;
+
+        quint32 size_;
+
+        bool owner_;
+
+        //! @en Image is stored in file @ru Образ хранится в файле
+        bool persistent_;
+
+        //! @en File contained valid image when it was opened @ru При открытии файл содержал корректный образ
+        bool restored_;
+
+        //! @en Pages changed since last flush @ru Страницы, измененные с момента последнего сброса
+        QVector<bool> dirtyPages_;
+
+        bool dirty_;
+
+        int pageSize_;
+
+        QString errorString_;
+
+        //! @en Attempts to read table before giving up @ru Количество попыток чтения таблицы
+        int readRetries_;
+
+    public:
+
+        /**
+         * @brief
+         * @en Constructor
+         * @ru Конструктор
+         *
+         * @param
+         * @en name - name of segment; leading slash is added if needed. Not used by openFile().
+         * @ru name - имя сегмента; начальная косая черта добавляется при необходимости. Не используется openFile().
+         */
+        explicit SharedRegisterImage(const QString& name = QString());
+
+        ~SharedRegisterImage();
+
+        /**
+         * @brief
+         * @en Create segment for writing, contents is set to zeros
+         * @ru Создает сегмент для записи, все значения обнуляются
+         *
+         * @en Existing segment with the same name is replaced. Segment is removed
+         * when image is detached.
+         *
+         * @ru Существующий сегмент с тем же именем заменяется. Сегмент удаляется
+         * при отключении от образа.
+         */
+        bool create();
+
+        //! @en Attach to existing segment for reading @ru Подключается к существующему сегменту для чтения
+        bool attach();
+
+        /**
+         * @brief
+         * @en Map image stored in file for writing
+         * @ru Отображает в память образ, хранящийся в файле, для записи
+         *
+         * @en If file contains valid image, values are restored from it at once.
+         * Otherwise file is created and contents is set to zeros. See isRestored().
+         *
+         * @ru Если файл содержит корректный образ, значения сразу
+         * восстанавливаются из него. Иначе файл создается, а все значения
+         * обнуляются. См. isRestored().
+         */
+        bool openFile(const QString& fileName);
+
+        /**
+         * @brief
+         * @en Write changed pages of file image to disk and increment generation
+         * @ru Записывает измененные страницы образа на диск и увеличивает поколение
+         *
+         * @param
+         * @en wait - wait until data is written; otherwise writing is only scheduled
+         * @ru wait - ждать окончания записи; иначе запись только планируется
+         */
+        bool flush(bool wait = false);
+
+        void detach();
+
+        bool isAttached() const
+        {
+            return data_ != 0;
+        }
+
+        bool isOwner() const
+        {
+            return owner_;
+        }
+
+        bool isPersistent() const
+        {
+            return persistent_;
+        }
+
+        //! @en Values were restored from file by openFile() @ru Значения были восстановлены из файла функцией openFile()
+        bool isRestored() const
+        {
+            return restored_;
+        }
+
+        //! @en Number of completed flushes of file image @ru Количество завершенных сбросов образа в файл
+        quint32 generation() const;
+
+        QString name() const
+        {
+            return name_;
+        }
+
+        QString errorString() const
+        {
+            return errorString_;
+        }
+
+        void setReadRetries(int readRetries)
+        {
+            readRetries_ = readRetries;
+        }
+
+        //! @en Items in every table @ru Количество значений в каждой таблице
+        int tableSize() const;
+
+        /**
+         * @brief
+         * @en Return sequence counter of table
+         * @ru Возвращает счетчик последовательности таблицы
+         *
+         * @en Reader may compare counter with saved value to find out if table was changed.
+         * @ru Читатель может сравнить счетчик с сохраненным значением, чтобы узнать, изменилась ли таблица.
+         */
+        quint32 sequence(Table table) const;
+
+        /**
+         * @brief
+         * @en Copy consistent block of coils or discrete inputs
+         * @ru Копирует согласованный блок флагов или дискретных входов
+         *
+         * @return
+         * @en false if range is wrong or table was changed during all attempts
+         * @ru false, если диапазон неверен или таблица менялась во время всех попыток
+         */
+        bool readBits(Table table, quint16 start, int count, bool* values) const;
+
+        //! @en Copy consistent block of registers @ru Копирует согласованный блок регистров
+        bool readRegisters(Table table, quint16 start, int count, quint16* values) const;
+
+        //! @en Write block of coils or discrete inputs, owner only @ru Записывает блок флагов или дискретных входов, только для владельца
+        bool writeBits(Table table, quint16 start, int count, const bool* values);
+
+        //! @en Write block of registers, owner only @ru Записывает блок регистров, только для владельца
+        bool writeRegisters(Table table, quint16 start, int count, const quint16* values);
+
+    private:
+
+        Q_DISABLE_COPY(SharedRegisterImage)
+
+        SharedImageHeader* header_() const
+        {
+            return reinterpret_cast<SharedImageHeader*>(data_);
+        }
+
+        bool checkRange_(Table table, quint16 start, int count, bool registers) const;
+
+        static quint32 layout_(quint32* offsets);
+
+        void initHeader_(quint32 size, const quint32* offsets);
+
+        static quint16 headerChecksum_(const SharedImageHeader* header);
+
+        bool isValidHeader_(quint32 mappedSize) const;
+
+        void markDirty_(const void* address, int size);
+
+        bool map_(int size, bool writable);
+
+        void setError_(const QString& text);
+
+        void beginWrite_(Table table);
+
+        void endWrite_(Table table);
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_SHARED_REGISTER_IMAGE_H
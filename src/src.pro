@@ -40,6 +40,9 @@ OBJECTS_DIR = $${OBJECTS_DIR}/src
 
 QT += network serialport
 
+# shm_open() is in librt with older glibc
+linux: LIBS += -lrt
+
 contains(MODBUS4QT_CONFIG, modbus4qt_dll) {
     CONFIG += dll
     win32: DEFINES += QT_DLL MODBUS4QT_DLL MODBUS4QT_MAKEDLL
@@ -53,18 +56,43 @@ else {
 #
 
 SOURCES += utils.cpp \
+    async_client.cpp \
+    native_serial_port.cpp \
+    native_socket.cpp \
     tcp_client.cpp \
     consts.cpp \
     client.cpp \
     rtu_client.cpp \
     server.cpp \
 #    tcp_server.cpp \
+    rtu_frame.cpp \
     rtu_server.cpp \
+    rtu_tcp_client.cpp \
     tcp_server.cpp \
+    udp_client.cpp \
+    udp_server.cpp \
     device.cpp \
-    dummy_device.cpp
+    device_discovery.cpp \
+    device_profile.cpp \
+    dummy_device.cpp \
+    epoll_tcp_server.cpp \
+    function_handler.cpp \
+    io_uring_engine.cpp \
+    register_decoder.cpp \
+    request_queue.cpp \
+    rtt_estimator.cpp \
+    scatter_read.cpp \
+    shared_register_image.cpp \
+    traffic_capture.cpp \
+    unit_health.cpp \
+    uring_tcp_server.cpp
 
 HEADERS += global.h \
+    async_client.h \
+    native_serial_port.h \
+    native_socket.h \
+    paged_table.h \
+    awaitable_client.h \
     consts.h \
     types.h \
     utils.h \
@@ -73,10 +101,27 @@ HEADERS += global.h \
     rtu_client.h \
     server.h \
 #    tcp_server.h \
+    rtu_frame.h \
     rtu_server.h \
+    rtu_tcp_client.h \
     tcp_server.h \
+    udp_client.h \
+    udp_server.h \
     device.h \
-    dummy_device.h
+    device_discovery.h \
+    device_profile.h \
+    dummy_device.h \
+    epoll_tcp_server.h \
+    function_handler.h \
+    io_uring_engine.h \
+    register_decoder.h \
+    request_queue.h \
+    rtt_estimator.h \
+    scatter_read.h \
+    shared_register_image.h \
+    traffic_capture.h \
+    unit_health.h \
+    uring_tcp_server.h
 
 #------------------------------------------------------------------------------
 # Install directives
@@ -37,6 +37,9 @@ from delhimodbus-1.5.0
 
 #include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
 
 namespace modbus4qt
 {
@@ -72,6 +75,143 @@ TcpClient::connectToServer(int timeout /* = IdTimeoutDefault*/ )
         emit errorMessage(tcpSocket_->errorString());
 
     lastTransactionID_ = 0;
+    inBuffer_.clear();
+    pendingTransactions_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+TcpClient::extractFrame_(QByteArray& frame)
+{
+    const int headerSize = sizeof(TcpDataHeader);
+
+    if (inBuffer_.size() < headerSize)
+        return false;
+
+    const quint8* header = (const quint8*)inBuffer_.constData();
+
+    // Length field counts unit id and PDU bytes
+    //
+    // Поле длины учитывает номер устройства и байты PDU
+    //
+    int length = (header[4] << 8) | header[5];
+
+    if ((length < 2) || (length > PDUMaxSize + 1))
+    {
+        emit errorMessage(unitID_, tr("Wrong application data unit recieved!"));
+        inBuffer_.clear();
+        return false;
+    }
+
+    int frameSize = headerSize - 1 + length;
+
+    if (inBuffer_.size() < frameSize)
+        return false;
+
+    frame = inBuffer_.left(frameSize);
+    inBuffer_.remove(0, frameSize);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+TcpClient::postRequest(const ProtocolDataUnit& pdu, int pduSize)
+{
+    if (!isConnected() && autoConnect_)
+        connectToServer(connectTimeOut_);
+
+    if (!isConnected())
+    {
+        emit errorMessage(tr("Not connected to server!"));
+        return -1;
+    }
+
+    QByteArray adu = prepareADU_(pdu, pduSize);
+
+    if (tcpSocket_->write(adu) != adu.size())
+    {
+        emit errorMessage(tr("Failed to write data for unit %2, error: %1").arg(tcpSocket_->errorString()).arg(unitID_));
+        return -1;
+    }
+    tcpSocket_->flush();
+
+    captureFrame_(true, adu);
+
+    pendingTransactions_.insert(lastTransactionID_);
+
+    return lastTransactionID_;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+TcpClient::sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUSize, ProtocolDataUnit* responsePDU)
+{
+    if (!isConnected() && autoConnect_)
+        connectToServer(connectTimeOut_);
+
+    if (!isConnected())
+    {
+        lastError_ = ConnectionError;
+        emit errorMessage(tr("Not connected to server!"));
+        return false;
+    }
+
+    return Client::sendRequestToServer_(requestPDU, requestPDUSize, responsePDU);
+}
+
+//-----------------------------------------------------------------------------
+
+quint16
+TcpClient::transactionId_(const QByteArray& frame)
+{
+    const quint8* header = (const quint8*)frame.constData();
+    return (header[0] << 8) | header[1];
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+TcpClient::waitForResponse(quint16& transactionId, ProtocolDataUnit& pdu, int timeout)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    QByteArray frame;
+
+    inBuffer_.append(tcpSocket_->readAll());
+
+    forever
+    {
+        while (extractFrame_(frame))
+        {
+            quint16 frameTransactionId = transactionId_(frame);
+
+            if (pendingTransactions_.remove(frameTransactionId))
+            {
+                captureFrame_(false, frame);
+
+                transactionId = frameTransactionId;
+                pdu = processADU_(frame);
+                return true;
+            }
+        }
+
+        // Timeout covers the whole wait, peer sending response by small parts
+        // can not prolong it
+        //
+        // Тайм-аут ограничивает все ожидание, абонент, передающий ответ
+        // небольшими частями, не может его продлить
+        //
+        int timeLeft = timeout - int(clock.elapsed());
+        if (timeLeft <= 0 || !tcpSocket_->waitForReadyRead(timeLeft))
+            return false;
+
+        inBuffer_.append(tcpSocket_->readAll());
+    }
 }
 
 ////-----------------------------------------------------------------------------
@@ -88,19 +228,105 @@ TcpClient::connectToServer(int timeout /* = IdTimeoutDefault*/ )
 //{
 //}
 
+//-----------------------------------------------------------------------------
+
+/*
+ * <------------------------ MODBUS TCP/IP ADU(1) ------------------------->
+ *              <----------- MODBUS PDU (1') ---------------->
+ *  +-----------+---------------+------------------------------------------+
+ *  | TID | PID | Length | UID  |Code | Data                               |
+ *  +-----------+---------------+------------------------------------------+
+ */
+
 QByteArray
-modbus4qt::TcpClient::prepareADU_(const ProtocolDataUnit& pdu, int pduSize)
+TcpClient::prepareADU_(const ProtocolDataUnit& pdu, int pduSize)
 {
+    QByteArray result;
+    result.reserve(sizeof(TcpDataHeader) + pduSize);
+
+    quint16 transactionId = getNewTransactionID_();
+
+    // All header fields are in net byte order
+    //
+    // Все поля заголовка передаются в сетевом порядке байт
+    //
+    result.append(char(hi(transactionId)));
+    result.append(char(lo(transactionId)));
+
+    // Protocol ID is always 0 for MODBUS
+    result.append(char(0));
+    result.append(char(0));
+
+    result.append(char(hi(pduSize + 1)));
+    result.append(char(lo(pduSize + 1)));
+
+    result.append(char(unitID_));
+
+    result.append((const char*)&pdu, pduSize);
+
+    return result;
 }
 
+//-----------------------------------------------------------------------------
+
 ProtocolDataUnit
-modbus4qt::TcpClient::processADU_(const QByteArray& buf)
+TcpClient::processADU_(const QByteArray& buf)
 {
+    ProtocolDataUnit pdu;
+
+    const int headerSize = sizeof(TcpDataHeader);
+
+    // Minimum ADU size: MBAP header and function code
+    //
+    // Минимальный размер ADU: заголовок MBAP и код функции
+    //
+    if (buf.size() < headerSize + 1)
+    {
+        emit errorMessage(unitID_, tr("Wrong application data unit recieved!"));
+        return pdu;
+    }
+
+    int pduSize = qMin(buf.size() - headerSize, PDUMaxSize);
+    const quint8* pduPtr = (const quint8*)buf.constData() + headerSize;
+
+    pdu.functionCode = pduPtr[0];
+    std::copy(pduPtr + 1, pduPtr + pduSize, pdu.data);
+
+    return pdu;
 }
 
+//-----------------------------------------------------------------------------
+
 QByteArray
-modbus4qt::TcpClient::readResponse_()
+TcpClient::readResponse_(int timeout)
 {
+    QByteArray frame;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    inBuffer_.append(tcpSocket_->readAll());
+
+    forever
+    {
+        // Responses for requests which were timed out earlier are dropped
+        //
+        // Ответы на запросы, время ожидания которых истекло ранее, отбрасываются
+        //
+        while (extractFrame_(frame))
+        {
+            if (transactionId_(frame) == lastTransactionID_)
+                return frame;
+        }
+
+        int timeLeft = timeout - int(clock.elapsed());
+        if (timeLeft <= 0 || !tcpSocket_->waitForReadyRead(timeLeft))
+            break;
+
+        inBuffer_.append(tcpSocket_->readAll());
+    }
+
+    return QByteArray();
 }
 
 } // namespace modbus4qt
@@ -37,6 +37,7 @@ from delhimodbus-1.5.0
 #include "client.h"
 
 #include <QHostAddress>
+#include <QSet>
 #include <QTcpSocket>
 #include <QVector>
 
@@ -89,6 +90,20 @@ class MODBUS4QT_EXPORT TcpClient : public Client
         */
         quint16 lastTransactionID_;
 
+        /**
+         * @brief
+         * @en Buffer for data recieved from server but not processed yet
+         * @ru Буфер для полученных от сервера, но еще не обработанных данных
+         */
+        QByteArray inBuffer_;
+
+        /**
+         * @brief
+         * @en Transactions posted by postRequest() and waiting for response
+         * @ru Транзакции, отправленные методом postRequest() и ожидающие ответа
+         */
+        QSet<quint16> pendingTransactions_;
+
     private:
         //! Возвращает номер следующей транзакции
         /**
@@ -108,6 +123,28 @@ class MODBUS4QT_EXPORT TcpClient : public Client
             return lastTransactionID_;
         }
 
+        /**
+         * @brief
+         * @en Extract first complete application data unit from input buffer
+         * @ru Извлекает из входного буфера первый полностью полученный блок данных приложения
+         *
+         * @param
+         * @en frame - extracted application data unit
+         * @ru frame - извлеченный блок данных приложения
+         *
+         * @return
+         * @en true if complete application data unit was found; false otherwise
+         * @ru true если в буфере найден полный блок данных приложения; false в противном случае
+         */
+        bool extractFrame_(QByteArray& frame);
+
+        /**
+         * @brief
+         * @en Return transaction ID from header of application data unit
+         * @ru Возвращает номер транзакции из заголовка блока данных приложения
+         */
+        static quint16 transactionId_(const QByteArray& frame);
+
     public: // Открытые методы класса
 
         //! Конструктор по умолчанию
@@ -145,6 +182,74 @@ class MODBUS4QT_EXPORT TcpClient : public Client
             return (tcpSocket_->state() == QAbstractSocket::ConnectedState);
         }
 
+        /**
+         * @brief
+         * @en Return number of requests posted by postRequest() and still waiting for response
+         * @ru Возвращает количество запросов, отправленных postRequest() и ожидающих ответа
+         */
+        int pendingRequests() const
+        {
+            return pendingTransactions_.size();
+        }
+
+        //! Возвращает номер TCP порта сервера
+        int port() const
+        {
+            return port_;
+        }
+
+        /**
+         * @brief
+         * @en Send request to server without waiting for response
+         * @ru Отправляет запрос серверу, не дожидаясь ответа
+         *
+         * @param
+         * @en pdu - protocol data unit of request
+         * @ru pdu - блок данных протокола запроса
+         *
+         * @param
+         * @en pduSize - size of protocol data unit (in bytes)
+         * @ru pduSize - размер в байтах блока данных протокола
+         *
+         * @return
+         * @en Transaction ID of request or -1 in case of error
+         * @ru Номер транзакции запроса или -1 в случае ошибки
+         *
+         * @en
+         * Several requests can be posted one after another (pipelining). Responses
+         * should be collected with waitForResponse(). Do not mix posted requests
+         * with blocking methods like readHoldingRegisters() on the same client.
+         *
+         * @ru
+         * Можно отправить несколько запросов подряд (конвейерный режим). Ответы
+         * необходимо получать методом waitForResponse(). Не смешивайте отправку
+         * запросов этим методом с блокирующими методами, например readHoldingRegisters().
+         */
+        int postRequest(const ProtocolDataUnit& pdu, int pduSize);
+
+        /**
+         * @brief
+         * @en Wait for response to any of posted requests
+         * @ru Ожидает ответ на любой из отправленных запросов
+         *
+         * @param
+         * @en transactionId - transaction ID of request answered
+         * @ru transactionId - номер транзакции, на которую получен ответ
+         *
+         * @param
+         * @en pdu - protocol data unit of response
+         * @ru pdu - блок данных протокола ответа
+         *
+         * @param
+         * @en timeout - maximum time to wait, ms
+         * @ru timeout - максимальное время ожидания, мс
+         *
+         * @return
+         * @en true if response was recieved; false in case of timeout
+         * @ru true если ответ получен; false если истекло время ожидания
+         */
+        bool waitForResponse(quint16& transactionId, ProtocolDataUnit& pdu, int timeout);
+
         //! Возвращает текущее значение адреса сервера
         QHostAddress serverAddress() const
         {
@@ -170,6 +275,19 @@ class MODBUS4QT_EXPORT TcpClient : public Client
             }
         }
 
+        //! Устанавливает номер TCP порта сервера
+        /**
+            Если ранее было установлено соединение с другим портом, то соединение будет закрыто.
+        */
+        void setPort(int port)
+        {
+            if (port != port_)
+            {
+                if (isConnected()) disconnectFromServer();
+                port_ = port;
+            }
+        }
+
     public slots:
 
 
@@ -177,7 +295,8 @@ class MODBUS4QT_EXPORT TcpClient : public Client
     protected:
         virtual QByteArray prepareADU_(const ProtocolDataUnit& pdu, int pduSize);
         virtual ProtocolDataUnit processADU_(const QByteArray& buf);
-        virtual QByteArray readResponse_();
+        virtual QByteArray readResponse_(int timeout);
+        virtual bool sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUSize, ProtocolDataUnit* responsePDU);
 };
 
 } // namespace modbus
@@ -1,12 +1,168 @@
 #include "tcp_server.h"
+#include "utils.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
 
 namespace modbus4qt
 {
 
-TcpServer::TcpServer()
+TcpServer::TcpServer(QObject *parent)
+    : Server(parent),
+      tcpServer_(new QTcpServer(this))
+{
+    connect(tcpServer_, SIGNAL(newConnection()), this, SLOT(incomingConnection_()));
+}
+
+//-----------------------------------------------------------------------------
+
+TcpServer::~TcpServer()
+{
+    close();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TcpServer::close()
+{
+    tcpServer_->close();
+
+    QList<QTcpSocket*> sockets = inBuffers_.keys();
+    inBuffers_.clear();
+
+    foreach (QTcpSocket* socket, sockets)
+    {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TcpServer::disconnected_()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket) return;
+
+    inBuffers_.remove(socket);
+    socket->deleteLater();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TcpServer::incomingConnection_()
+{
+    while (tcpServer_->hasPendingConnections())
+    {
+        QTcpSocket* socket = tcpServer_->nextPendingConnection();
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        inBuffers_.insert(socket, QByteArray());
+
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readyRead_()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(disconnected_()));
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+TcpServer::isListening() const
+{
+    return tcpServer_->isListening();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+TcpServer::listen(const QHostAddress& address, quint16 port)
 {
+    if (!tcpServer_->listen(address, port))
+    {
+        emit errorMessage(tcpServer_->errorString());
+        return false;
+    }
 
+    return true;
 }
 
+//-----------------------------------------------------------------------------
+
+/*
+ * <------------------------ MODBUS TCP/IP ADU(1) ------------------------->
+ *              <----------- MODBUS PDU (1') ---------------->
+ *  +-----------+---------------+------------------------------------------+
+ *  | TID | PID | Length | UID  |Code | Data                               |
+ *  +-----------+---------------+------------------------------------------+
+ */
+
+void
+TcpServer::processBuffer_(QTcpSocket* socket)
+{
+    QByteArray& buffer = inBuffers_[socket];
+
+    const int headerSize = sizeof(TcpDataHeader);
+
+    // All responses for recieved requests are sent by one write
+    //
+    // Все ответы на полученные запросы передаются одной записью
+    //
+    QByteArray out;
+
+    int offset = 0;
+
+    while (buffer.size() - offset >= headerSize)
+    {
+        const quint8* adu = (const quint8*)buffer.constData() + offset;
+
+        int frameSize = tcpADUSize_(adu);
+
+        if (frameSize < 0)
+        {
+            emit errorMessage(tr("Wrong application data unit recieved from %1!").arg(socket->peerAddress().toString()));
+            buffer.clear();
+            socket->abort();
+            return;
+        }
+
+        if (buffer.size() - offset < frameSize)
+            break;
+
+        quint8 response[TcpADUMaxSize];
+        out.append((const char*)response, processTcpADU_(adu, frameSize, response, quint32(socket->socketDescriptor())));
+
+        offset += frameSize;
+    }
+
+    buffer.remove(0, offset);
+
+    if (!out.isEmpty())
+        socket->write(out);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TcpServer::readyRead_()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !inBuffers_.contains(socket)) return;
+
+    inBuffers_[socket].append(socket->readAll());
+
+    processBuffer_(socket);
+}
+
+//-----------------------------------------------------------------------------
+
+quint16
+TcpServer::serverPort() const
+{
+    return tcpServer_->serverPort();
 }
 
+} // namespace modbus4qt
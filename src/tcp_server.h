@@ -3,16 +3,143 @@
 
 #include "server.h"
 
+#include <QHash>
+#include <QHostAddress>
+
+class QTcpServer;
+class QTcpSocket;
+
 namespace modbus4qt
 {
 
-class TcpServer : public Server
+/**
+ * @brief
+ * @en MODBUS/TCP server
+ * @ru Сервер MODBUS/TCP
+ *
+ * @en
+ * Accepts connections from clients and serves requests with device(). Every
+ * connection has its own input buffer, so clients may send several requests
+ * without waiting for responses (pipelining). Responses are sent in order of requests.
+ *
+ * @ru
+ * Принимает подключения клиентов и обрабатывает запросы с помощью device().
+ * Для каждого подключения используется свой входной буфер, поэтому клиент может
+ * отправить несколько запросов, не дожидаясь ответов (конвейерный режим).
+ * Ответы передаются в порядке поступления запросов.
+ */
+class MODBUS4QT_EXPORT TcpServer : public Server
 {
     Q_OBJECT
+
+    private:
+
+        /**
+         * @brief
+         * @en Server accepting connections
+         * @ru Сервер, принимающий подключения
+         */
+        QTcpServer* tcpServer_;
+
+        /**
+         * @brief
+         * @en Input buffers of connected clients
+         * @ru Входные буферы подключенных клиентов
+         */
+        QHash<QTcpSocket*, QByteArray> inBuffers_;
+
+        /**
+         * @brief
+         * @en Process all complete application data units in the input buffer of client
+         * @ru Обрабатывает все полностью полученные блоки данных приложения из входного буфера клиента
+         *
+         * @param
+         * @en socket - client connection
+         * @ru socket - подключение клиента
+         */
+        void processBuffer_(QTcpSocket* socket);
+
     public:
-        TcpServer();
+
+        /**
+         * @brief
+         * @en Default constructor
+         * @ru Конструктор по умолчанию
+         *
+         * @param
+         * @en parent - parent object
+         * @ru parent - указатель на объект-родитель.
+         */
+        explicit TcpServer(QObject *parent = 0);
+
+        virtual ~TcpServer();
+
+        /**
+         * @brief
+         * @en Return true if server is listening for incoming connections
+         * @ru Возвращает true, если сервер ожидает подключения клиентов
+         */
+        bool isListening() const;
+
+        /**
+         * @brief
+         * @en Return TCP port server is listening on
+         * @ru Возвращает номер TCP порта, на котором сервер ожидает подключения
+         */
+        quint16 serverPort() const;
+
+    public slots:
+
+        /**
+         * @brief
+         * @en Start listening for incoming connections
+         * @ru Начинает ожидание подключений клиентов
+         *
+         * @param
+         * @en address - address to listen on
+         * @ru address - адрес, на котором ожидаются подключения
+         *
+         * @param
+         * @en port - TCP port to listen on. If 0 is passed port is chosen automatically.
+         * @ru port - номер TCP порта. Если передан 0, то порт выбирается автоматически.
+         *
+         * @return
+         * @en true in success; false otherwise
+         * @ru true если сервер запущен; false в случае возникновения ошибки
+         */
+        bool listen(const QHostAddress& address = QHostAddress::Any, quint16 port = DefaultTcpPort);
+
+        /**
+         * @brief
+         * @en Stop listening and close all client connections
+         * @ru Прекращает ожидание подключений и закрывает все подключения клиентов
+         */
+        void close();
+
+    private slots:
+
+        /**
+         * @brief
+         * @en Accept pending connections
+         * @ru Принимает ожидающие подключения
+         */
+        void incomingConnection_();
+
+        /**
+         * @brief
+         * @en Read data from client
+         * @ru Читает данные от клиента
+         */
+        void readyRead_();
+
+        /**
+         * @brief
+         * @en Forget disconnected client
+         * @ru Удаляет отключившегося клиента
+         */
+        void disconnected_();
 };
 
-}
+} // namespace modbus4qt
 
 #endif // TCPSERVER_H
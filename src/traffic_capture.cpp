@@ -0,0 +1,168 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "traffic_capture.h"
+
+#include <QDateTime>
+#include <QMutexLocker>
+
+namespace modbus4qt
+{
+
+TrafficCapture::TrafficCapture()
+    : records_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+TrafficCapture::~TrafficCapture()
+{
+    close();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+TrafficCapture::open(const QString& fileName)
+{
+    QMutexLocker locker(&mutex_);
+
+    if (file_.isOpen())
+        file_.close();
+
+    file_.setFileName(fileName);
+
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    stream_.setDevice(&file_);
+    stream_ << Magic << Version << quint16(0) << qint64(QDateTime::currentMSecsSinceEpoch());
+
+    records_ = 0;
+    clock_.start();
+
+    return stream_.status() == QDataStream::Ok;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TrafficCapture::close()
+{
+    QMutexLocker locker(&mutex_);
+
+    if (!file_.isOpen())
+        return;
+
+    stream_.setDevice(0);
+    file_.close();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TrafficCapture::record(quint8 flags, quint32 peer, const char* adu, int size)
+{
+    // Timestamp is taken before lock, so waiting for other threads does not shift it
+    //
+    // Отметка времени берется до блокировки, чтобы ожидание других потоков не сдвигало ее
+    //
+    const qint64 timestampNs = clock_.nsecsElapsed();
+
+    QMutexLocker locker(&mutex_);
+
+    if (!file_.isOpen() || (size <= 0) || (size > 0xFFFF))
+        return;
+
+    stream_ << timestampNs << peer << flags << quint16(size);
+    stream_.writeRawData(adu, size);
+
+    ++records_;
+}
+
+//-----------------------------------------------------------------------------
+
+TrafficReader::TrafficReader()
+    : startTime_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+TrafficReader::open(const QString& fileName)
+{
+    file_.setFileName(fileName);
+
+    if (!file_.open(QIODevice::ReadOnly))
+    {
+        errorString_ = file_.errorString();
+        return false;
+    }
+
+    stream_.setDevice(&file_);
+
+    quint32 magic;
+    quint16 version;
+    quint16 reserved;
+
+    stream_ >> magic >> version >> reserved >> startTime_;
+
+    if ((stream_.status() != QDataStream::Ok) || (magic != TrafficCapture::Magic) || (version != TrafficCapture::Version))
+    {
+        errorString_ = QString("%1 is not a capture file").arg(fileName);
+        return false;
+    }
+
+    errorString_.clear();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+TrafficReader::next(TrafficRecord& record)
+{
+    if (stream_.atEnd())
+        return false;
+
+    quint16 size;
+    stream_ >> record.timestampNs >> record.peer >> record.flags >> size;
+
+    record.adu.resize(size);
+
+    if ((stream_.status() != QDataStream::Ok) || (stream_.readRawData(record.adu.data(), size) != size))
+    {
+        errorString_ = QString("Capture file is truncated");
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace modbus4qt
@@ -0,0 +1,218 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_TRAFFIC_CAPTURE_H
+#define MODBUS4QT_TRAFFIC_CAPTURE_H
+
+#include "global.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en One application data unit of capture
+ * @ru Один блок данных приложения записи трафика
+ */
+struct TrafficRecord
+{
+    enum Flags
+    {
+        //! @en Frame was sent, otherwise received @ru Кадр передан, иначе принят
+        Sent = 0x01,
+
+        //! @en Recorded by server, otherwise by client @ru Записан сервером, иначе клиентом
+        ServerSide = 0x02,
+
+        //! @en RTU framing (unit, PDU, CRC), otherwise MBAP header @ru Кадр RTU (устройство, PDU, CRC), иначе с заголовком MBAP
+        RtuFraming = 0x04
+    };
+
+    //! @en Monotonic time since capture start, ns @ru Монотонное время от начала записи, нс
+    qint64 timestampNs;
+
+    //! @en Connection or client identifier @ru Идентификатор подключения или клиента
+    quint32 peer;
+
+    quint8 flags;
+
+    QByteArray adu;
+
+    TrafficRecord()
+        : timestampNs(0),
+          peer(0),
+          flags(0)
+    {
+    }
+
+    //! @en True for request: sent by client or received by server @ru True для запроса: передан клиентом или принят сервером
+    bool isRequest() const
+    {
+        return bool(flags & Sent) != bool(flags & ServerSide);
+    }
+};
+
+/**
+ * @brief
+ * @en Binary capture of MODBUS traffic
+ * @ru Двоичная запись трафика MODBUS
+ *
+ * @en Clients and servers with capture set record every application data unit
+ * they send and receive, with monotonic nanosecond timestamp, direction and
+ * peer. File starts with header (magic "M4QC", version, wall clock time of
+ * start in ms since epoch), followed by records: timestamp (8 bytes), peer (4),
+ * flags (1), size (2) and frame itself; all numbers are big endian. One capture
+ * may be shared by several clients and servers in different threads.
+ *
+ * @ru Клиенты и серверы с установленной записью сохраняют каждый переданный и
+ * принятый блок данных приложения с монотонной отметкой времени в
+ * наносекундах, направлением и абонентом. Файл начинается с заголовка
+ * (сигнатура "M4QC", версия, астрономическое время начала в мс от начала
+ * эпохи), за которым следуют записи: отметка времени (8 байт), абонент (4),
+ * флаги (1), размер (2) и сам кадр; все числа в порядке big endian. Одна
+ * запись может использоваться несколькими клиентами и серверами в разных
+ * потоках.
+ *
+ * @sa Client::setTrafficCapture(), Server::setTrafficCapture(), TrafficReader
+ */
+class MODBUS4QT_EXPORT TrafficCapture
+{
+    private:
+
+        QFile file_;
+
+        QDataStream stream_;
+
+        QElapsedTimer clock_;
+
+        QMutex mutex_;
+
+        qint64 records_;
+
+        Q_DISABLE_COPY(TrafficCapture)
+
+    public:
+
+        static const quint32 Magic = 0x4D345143;
+
+        static const quint16 Version = 1;
+
+        TrafficCapture();
+
+        ~TrafficCapture();
+
+        //! @en Create file and write header @ru Создает файл и записывает заголовок
+        bool open(const QString& fileName);
+
+        void close();
+
+        bool isOpen() const
+        {
+            return file_.isOpen();
+        }
+
+        QString errorString() const
+        {
+            return file_.errorString();
+        }
+
+        //! @en Records written @ru Количество записанных кадров
+        qint64 records() const
+        {
+            return records_;
+        }
+
+        /**
+         * @brief
+         * @en Record application data unit
+         * @ru Записывает блок данных приложения
+         *
+         * @param
+         * @en flags - combination of TrafficRecord::Flags
+         * @ru flags - комбинация TrafficRecord::Flags
+         */
+        void record(quint8 flags, quint32 peer, const char* adu, int size);
+};
+
+/**
+ * @brief
+ * @en Reader of capture file
+ * @ru Чтение файла записи трафика
+ */
+class MODBUS4QT_EXPORT TrafficReader
+{
+    private:
+
+        QFile file_;
+
+        QDataStream stream_;
+
+        qint64 startTime_;
+
+        QString errorString_;
+
+        Q_DISABLE_COPY(TrafficReader)
+
+    public:
+
+        TrafficReader();
+
+        bool open(const QString& fileName);
+
+        //! @en Wall clock time of capture start, ms since epoch @ru Астрономическое время начала записи, мс от начала эпохи
+        qint64 startTime() const
+        {
+            return startTime_;
+        }
+
+        /**
+         * @brief
+         * @en Read next record
+         * @ru Читает следующую запись
+         *
+         * @return
+         * @en false at end of file or if file is damaged, see errorString()
+         * @ru false в конце файла или если файл поврежден, см. errorString()
+         */
+        bool next(TrafficRecord& record);
+
+        //! @en Empty at normal end of file @ru Пустая строка при нормальном окончании файла
+        QString errorString() const
+        {
+            return errorString_;
+        }
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_TRAFFIC_CAPTURE_H
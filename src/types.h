@@ -130,6 +130,58 @@ struct ProtocolDataUnit
 };
 #pragma pack()
 
+/**
+ * @brief
+ * @en View of protocol data unit in receive buffer
+ * @ru Представление блока данных протокола в буфере приема
+ *
+ * @en Refers to data without copying, so it is valid only while buffer exists.
+ * @ru Ссылается на данные без копирования, поэтому действительно, пока существует буфер.
+ */
+struct PduView
+{
+    /**
+     * @brief
+     * @en Function code followed by data
+     * @ru Код функции, за которым следуют данные
+     */
+    const quint8* pdu;
+
+    /**
+     * @brief
+     * @en Size of protocol data unit including function code (in bytes)
+     * @ru Размер блока данных протокола в байтах, включая код функции
+     */
+    int size;
+
+    PduView(const quint8* pdu, int size)
+        : pdu(pdu),
+          size(size)
+    {
+    }
+
+    quint8 functionCode() const
+    {
+        return pdu[0];
+    }
+
+    const quint8* data() const
+    {
+        return pdu + 1;
+    }
+
+    int dataSize() const
+    {
+        return size - 1;
+    }
+
+    //! @en Big endian word at offset of data @ru Слово в порядке big endian по смещению в данных
+    quint16 word(int offset) const
+    {
+        return (pdu[1 + offset] << 8) | pdu[2 + offset];
+    }
+};
+
 /**
  * @brief
  * @en Application data unit for MODBUS over serial line.
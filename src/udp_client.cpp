@@ -0,0 +1,314 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "udp_client.h"
+#include "utils.h"
+
+#include <QElapsedTimer>
+#include <QUdpSocket>
+
+#include <algorithm>
+
+namespace modbus4qt
+{
+
+UdpClient::UdpClient(QObject *parent)
+    : Client(parent),
+      serverAddress_(QHostAddress::LocalHost),
+      port_(DefaultTcpPort),
+      lastTransactionID_(0)
+{
+    unitID_ = IgnoreUnitId;
+
+    udpSocket_ = new QUdpSocket(this);
+    ioDevice_ = udpSocket_;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UdpClient::connectToServer()
+{
+    udpSocket_->connectToHost(serverAddress_, port_);
+
+    lastTransactionID_ = 0;
+    pendingTransactions_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UdpClient::disconnectFromServer()
+{
+    udpSocket_->abort();
+    pendingTransactions_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UdpClient::isConnected() const
+{
+    return udpSocket_->state() == QAbstractSocket::ConnectedState;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UdpClient::setServerAddress(const QHostAddress& serverAddress)
+{
+    if (serverAddress != serverAddress_)
+    {
+        if (isConnected()) disconnectFromServer();
+        serverAddress_ = serverAddress;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UdpClient::setPort(quint16 port)
+{
+    if (port != port_)
+    {
+        if (isConnected()) disconnectFromServer();
+        port_ = port;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int
+UdpClient::postRequest(const ProtocolDataUnit& pdu, int pduSize)
+{
+    if (!isConnected())
+        connectToServer();
+
+    if (!writeRequest_(pdu, pduSize))
+        return -1;
+
+    pendingTransactions_.insert(lastTransactionID_);
+
+    return lastTransactionID_;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UdpClient::waitForResponse(quint16& transactionId, ProtocolDataUnit& pdu, int timeout)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    QByteArray frame;
+
+    forever
+    {
+        while (readFrame_(frame))
+        {
+            quint16 frameTransactionId = (quint8(frame.at(0)) << 8) | quint8(frame.at(1));
+
+            if (pendingTransactions_.remove(frameTransactionId))
+            {
+                transactionId = frameTransactionId;
+                captureFrame_(false, frame);
+                pdu = processADU_(frame);
+                return true;
+            }
+        }
+
+        int timeLeft = timeout - int(clock.elapsed());
+        if (timeLeft <= 0 || !udpSocket_->waitForReadyRead(timeLeft))
+            return false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UdpClient::readFrame_(QByteArray& frame)
+{
+    const int headerSize = sizeof(TcpDataHeader);
+
+    while (udpSocket_->hasPendingDatagrams())
+    {
+        frame.resize(qMax(qint64(0), udpSocket_->pendingDatagramSize()));
+
+        qint64 size = udpSocket_->readDatagram(frame.data(), frame.size());
+        if (size < 0)
+            return false;
+
+        frame.resize(int(size));
+
+        if (size < headerSize + 1)
+            continue;
+
+        const quint8* header = (const quint8*)frame.constData();
+
+        // Datagram must contain exactly one ADU
+        //
+        // Датаграмма должна содержать ровно один ADU
+        //
+        quint16 protocolId = (header[2] << 8) | header[3];
+        int length = (header[4] << 8) | header[5];
+
+        if ((protocolId != 0) || (headerSize - 1 + length != size))
+        {
+            emit errorMessage(unitID_, tr("Wrong application data unit recieved!"));
+            continue;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray
+UdpClient::prepareADU_(const ProtocolDataUnit& pdu, int pduSize)
+{
+    QByteArray result;
+    result.reserve(sizeof(TcpDataHeader) + pduSize);
+
+    quint16 transactionId = getNewTransactionID_();
+
+    result.append(char(hi(transactionId)));
+    result.append(char(lo(transactionId)));
+
+    // Protocol ID is always 0 for MODBUS
+    result.append(char(0));
+    result.append(char(0));
+
+    result.append(char(hi(pduSize + 1)));
+    result.append(char(lo(pduSize + 1)));
+
+    result.append(char(unitID_));
+
+    result.append((const char*)&pdu, pduSize);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+ProtocolDataUnit
+UdpClient::processADU_(const QByteArray& buf)
+{
+    ProtocolDataUnit pdu;
+
+    const int headerSize = sizeof(TcpDataHeader);
+
+    if (buf.size() < headerSize + 1)
+    {
+        emit errorMessage(unitID_, tr("Wrong application data unit recieved!"));
+        return pdu;
+    }
+
+    int pduSize = qMin(buf.size() - headerSize, PDUMaxSize);
+    const quint8* pduPtr = (const quint8*)buf.constData() + headerSize;
+
+    pdu.functionCode = pduPtr[0];
+    std::copy(pduPtr + 1, pduPtr + pduSize, pdu.data);
+
+    return pdu;
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray
+UdpClient::readResponse_(int timeout)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    QByteArray frame;
+
+    forever
+    {
+        // Responses for requests which were timed out earlier are dropped
+        //
+        // Ответы на запросы, время ожидания которых истекло ранее, отбрасываются
+        //
+        while (readFrame_(frame))
+        {
+            quint16 frameTransactionId = (quint8(frame.at(0)) << 8) | quint8(frame.at(1));
+
+            if (frameTransactionId == lastTransactionID_)
+                return frame;
+        }
+
+        int timeLeft = timeout - int(clock.elapsed());
+        if (timeLeft <= 0 || !udpSocket_->waitForReadyRead(timeLeft))
+            break;
+    }
+
+    return QByteArray();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UdpClient::sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUSize, ProtocolDataUnit* responsePDU)
+{
+    if (!isConnected())
+        connectToServer();
+
+    if (!isConnected())
+    {
+        lastError_ = ConnectionError;
+        emit errorMessage(tr("Can not send datagrams to server: %1").arg(udpSocket_->errorString()));
+        return false;
+    }
+
+    return Client::sendRequestToServer_(requestPDU, requestPDUSize, responsePDU);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UdpClient::writeRequest_(const ProtocolDataUnit& requestPDU, int requestPDUSize)
+{
+    // Datagram is sent at once, there is nothing to wait for
+    //
+    // Датаграмма отправляется сразу, ожидать окончания записи не нужно
+    //
+    QByteArray adu = prepareADU_(requestPDU, requestPDUSize);
+
+    captureFrame_(true, adu);
+
+    if (udpSocket_->write(adu) != adu.size())
+    {
+        lastError_ = WriteError;
+        emit errorMessage(tr("Failed to send datagram for unit %2, error: %1").arg(udpSocket_->errorString()).arg(unitID_));
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace modbus4qt
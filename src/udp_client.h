@@ -0,0 +1,189 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_UDP_CLIENT_H
+#define MODBUS4QT_UDP_CLIENT_H
+
+#include "client.h"
+
+#include <QHostAddress>
+#include <QSet>
+
+class QUdpSocket;
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en MODBUS/UDP client
+ * @ru Клиент MODBUS/UDP
+ *
+ * @en Every request and response is one datagram with MBAP header, as in
+ * MODBUS/TCP. There is no connection setup, and lost or late datagram does
+ * not block following requests: responses are matched to requests by
+ * transaction ID and responses to requests which were timed out are dropped.
+ *
+ * @ru Каждый запрос и ответ передается одной датаграммой с заголовком MBAP,
+ * как в MODBUS/TCP. Установка соединения не требуется, а потерянная или
+ * опоздавшая датаграмма не задерживает следующие запросы: ответы
+ * сопоставляются с запросами по номеру транзакции, а ответы на запросы с
+ * истекшим временем ожидания отбрасываются.
+ */
+class MODBUS4QT_EXPORT UdpClient : public Client
+{
+    Q_OBJECT
+
+    private:
+
+        QUdpSocket* udpSocket_;
+
+        QHostAddress serverAddress_;
+
+        //! @en Default value: 502 @ru Значение по умолчанию: 502
+        quint16 port_;
+
+        quint16 lastTransactionID_;
+
+        /**
+         * @brief
+         * @en Transactions posted by postRequest() and waiting for response
+         * @ru Транзакции, отправленные методом postRequest() и ожидающие ответа
+         */
+        QSet<quint16> pendingTransactions_;
+
+    public:
+
+        explicit UdpClient(QObject *parent = 0);
+
+        /**
+         * @brief
+         * @en Set default destination of datagrams
+         * @ru Устанавливает адресата датаграмм по умолчанию
+         *
+         * @en Datagrams from other hosts are ignored after that.
+         * @ru После этого датаграммы от других узлов игнорируются.
+         */
+        virtual void connectToServer();
+
+        virtual void disconnectFromServer();
+
+        virtual bool isConnected() const;
+
+        QHostAddress serverAddress() const
+        {
+            return serverAddress_;
+        }
+
+        void setServerAddress(const QHostAddress& serverAddress);
+
+        quint16 port() const
+        {
+            return port_;
+        }
+
+        void setPort(quint16 port);
+
+        /**
+         * @brief
+         * @en Send request to server without waiting for response
+         * @ru Отправляет запрос серверу, не дожидаясь ответа
+         *
+         * @return
+         * @en Transaction ID of request or -1 in case of error
+         * @ru Номер транзакции запроса или -1 в случае ошибки
+         *
+         * @en Works as TcpClient::postRequest(). Responses are collected with
+         * waitForResponse(); requests which will never be answered should be
+         * removed by discardPendingRequests().
+         *
+         * @ru Работает так же, как TcpClient::postRequest(). Ответы получаются
+         * методом waitForResponse(); запросы, ответ на которые уже не придет,
+         * удаляются методом discardPendingRequests().
+         */
+        int postRequest(const ProtocolDataUnit& pdu, int pduSize);
+
+        /**
+         * @brief
+         * @en Wait for response to any of posted requests
+         * @ru Ожидает ответ на любой из отправленных запросов
+         *
+         * @return
+         * @en true if response was recieved; false in case of timeout
+         * @ru true если ответ получен; false если истекло время ожидания
+         */
+        bool waitForResponse(quint16& transactionId, ProtocolDataUnit& pdu, int timeout);
+
+        int pendingRequests() const
+        {
+            return pendingTransactions_.size();
+        }
+
+        //! @en Forget all posted requests @ru Забывает все отправленные запросы
+        void discardPendingRequests()
+        {
+            pendingTransactions_.clear();
+        }
+
+    private:
+
+        quint16 getNewTransactionID_()
+        {
+            if (lastTransactionID_ == 0xFFFF)
+                lastTransactionID_ = 0;
+            else
+                ++lastTransactionID_;
+
+            return lastTransactionID_;
+        }
+
+        /**
+         * @brief
+         * @en Read next datagram with valid MBAP header
+         * @ru Читает следующую датаграмму с правильным заголовком MBAP
+         *
+         * @return
+         * @en false if there are no more datagrams
+         * @ru false, если датаграмм больше нет
+         */
+        bool readFrame_(QByteArray& frame);
+
+    protected:
+
+        virtual QByteArray prepareADU_(const ProtocolDataUnit& pdu, int pduSize);
+
+        virtual ProtocolDataUnit processADU_(const QByteArray& buf);
+
+        virtual QByteArray readResponse_(int timeout);
+
+        virtual bool sendRequestToServer_(const ProtocolDataUnit& requestPDU, int requestPDUSize, ProtocolDataUnit* responsePDU);
+
+        virtual bool writeRequest_(const ProtocolDataUnit& requestPDU, int requestPDUSize);
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_UDP_CLIENT_H
@@ -0,0 +1,289 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "udp_server.h"
+
+#ifdef Q_OS_LINUX
+    #include "native_socket.h"
+
+    #include <QHash>
+    #include <QSocketNotifier>
+    #include <QVarLengthArray>
+
+    #include <errno.h>
+    #include <string.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#else
+    #include <QUdpSocket>
+#endif
+
+namespace modbus4qt
+{
+
+// Request buffer is one byte longer than maximum ADU, so too long datagram is noticed
+//
+// Буфер запроса на один байт длиннее максимального ADU, чтобы заметить слишком длинную датаграмму
+//
+static const int RequestBufferSize = TcpADUMaxSize + 1;
+
+//-----------------------------------------------------------------------------
+
+UdpServer::UdpServer(QObject *parent)
+    : Server(parent),
+#ifdef Q_OS_LINUX
+      fd_(-1),
+      notifier_(0),
+      port_(0),
+#else
+      udpSocket_(new QUdpSocket(this)),
+#endif
+      batchSize_(64)
+{
+#ifndef Q_OS_LINUX
+    connect(udpSocket_, SIGNAL(readyRead()), this, SLOT(readDatagrams_()));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+UdpServer::~UdpServer()
+{
+    close();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UdpServer::close()
+{
+#ifdef Q_OS_LINUX
+    delete notifier_;
+    notifier_ = 0;
+
+    if (fd_ >= 0)
+        ::close(fd_);
+
+    fd_ = -1;
+    port_ = 0;
+#else
+    udpSocket_->close();
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UdpServer::isListening() const
+{
+#ifdef Q_OS_LINUX
+    return fd_ >= 0;
+#else
+    return udpSocket_->state() == QAbstractSocket::BoundState;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UdpServer::listen(const QHostAddress& address, quint16 port)
+{
+    close();
+
+#ifdef Q_OS_LINUX
+    QString error;
+    fd_ = openNativeSocket(address, port, false, &port_, &error);
+
+    if (fd_ < 0)
+    {
+        emit errorMessage(error);
+        return false;
+    }
+
+    requestBuffers_.resize(batchSize_ * RequestBufferSize);
+    responseBuffers_.resize(batchSize_ * TcpADUMaxSize);
+
+    notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+    connect(notifier_, SIGNAL(activated(int)), this, SLOT(readDatagrams_()));
+
+    return true;
+#else
+    if (!udpSocket_->bind(address, port))
+    {
+        emit errorMessage(udpSocket_->errorString());
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UdpServer::readDatagrams_()
+{
+#ifdef Q_OS_LINUX
+    const int batchSize = requestBuffers_.size() / RequestBufferSize;
+
+    QVarLengthArray<mmsghdr, 64> requests(batchSize);
+    QVarLengthArray<mmsghdr, 64> responses(batchSize);
+    QVarLengthArray<iovec, 64> requestVectors(batchSize);
+    QVarLengthArray<iovec, 64> responseVectors(batchSize);
+    QVarLengthArray<sockaddr_storage, 64> peers(batchSize);
+
+    forever
+    {
+        for (int i = 0; i < batchSize; ++i)
+        {
+            requestVectors[i].iov_base = requestBuffers_.data() + i * RequestBufferSize;
+            requestVectors[i].iov_len = RequestBufferSize;
+
+            memset(&requests[i], 0, sizeof(mmsghdr));
+            requests[i].msg_hdr.msg_name = &peers[i];
+            requests[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+            requests[i].msg_hdr.msg_iov = &requestVectors[i];
+            requests[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int received = recvmmsg(fd_, requests.data(), batchSize, MSG_DONTWAIT, 0);
+
+        if (received <= 0)
+        {
+            if ((received < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+                emit errorMessage(tr("Can not receive datagrams: %1").arg(strerror(errno)));
+
+            break;
+        }
+
+        int responseCount = 0;
+
+        for (int i = 0; i < received; ++i)
+        {
+            quint8* response = responseBuffers_.data() + responseCount * TcpADUMaxSize;
+            int responseSize = 0;
+
+            if (!(requests[i].msg_hdr.msg_flags & MSG_TRUNC))
+            {
+                // Datagram clients are told apart in capture by hash of their address
+                //
+                // Клиенты датаграмм различаются в записи по хэшу их адреса
+                //
+                quint32 peerId = trafficCapture() ? qHash(QByteArray::fromRawData((const char*)&peers[i], requests[i].msg_hdr.msg_namelen)) : 0;
+
+                responseSize = processTcpADU_(requestBuffers_.constData() + i * RequestBufferSize, requests[i].msg_len, response, peerId);
+            }
+
+            if (responseSize == 0)
+            {
+                QHostAddress peer(reinterpret_cast<const sockaddr*>(&peers[i]));
+                emit errorMessage(tr("Wrong application data unit recieved from %1!").arg(peer.toString()));
+                continue;
+            }
+
+            responseVectors[responseCount].iov_base = response;
+            responseVectors[responseCount].iov_len = responseSize;
+
+            memset(&responses[responseCount], 0, sizeof(mmsghdr));
+            responses[responseCount].msg_hdr.msg_name = &peers[i];
+            responses[responseCount].msg_hdr.msg_namelen = requests[i].msg_hdr.msg_namelen;
+            responses[responseCount].msg_hdr.msg_iov = &responseVectors[responseCount];
+            responses[responseCount].msg_hdr.msg_iovlen = 1;
+
+            ++responseCount;
+        }
+
+        int sent = 0;
+
+        while (sent < responseCount)
+        {
+            int result = sendmmsg(fd_, responses.data() + sent, responseCount - sent, 0);
+
+            if (result < 0 && errno == EINTR)
+                continue;
+
+            // Responses which do not fit into send buffer are lost as any other datagram
+            //
+            // Ответы, не поместившиеся в буфер отправки, теряются, как и любые другие датаграммы
+            //
+            if (result <= 0)
+            {
+                if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+                    emit errorMessage(tr("Can not send datagrams: %1").arg(strerror(errno)));
+
+                break;
+            }
+
+            sent += result;
+        }
+
+        // Socket queue is empty
+        if (received < batchSize)
+            break;
+    }
+#else
+    QByteArray request;
+    quint8 response[TcpADUMaxSize];
+
+    while (udpSocket_->hasPendingDatagrams())
+    {
+        QHostAddress peer;
+        quint16 peerPort;
+
+        request.resize(RequestBufferSize);
+        qint64 size = udpSocket_->readDatagram(request.data(), request.size(), &peer, &peerPort);
+
+        if (size < 0)
+            break;
+
+        int responseSize = 0;
+        if (size < RequestBufferSize)
+            responseSize = processTcpADU_((const quint8*)request.constData(), int(size), response, trafficCapture() ? (qHash(peer) ^ peerPort) : 0);
+
+        if (responseSize == 0)
+        {
+            emit errorMessage(tr("Wrong application data unit recieved from %1!").arg(peer.toString()));
+            continue;
+        }
+
+        udpSocket_->writeDatagram((const char*)response, responseSize, peer, peerPort);
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+quint16
+UdpServer::serverPort() const
+{
+#ifdef Q_OS_LINUX
+    return port_;
+#else
+    return udpSocket_->localPort();
+#endif
+}
+
+} // namespace modbus4qt
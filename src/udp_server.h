@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_UDP_SERVER_H
+#define MODBUS4QT_UDP_SERVER_H
+
+#include "server.h"
+
+#include <QHostAddress>
+#include <QVector>
+
+class QSocketNotifier;
+class QUdpSocket;
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en MODBUS/UDP server
+ * @ru Сервер MODBUS/UDP
+ *
+ * @en Every datagram carries one request with MBAP header and is answered by
+ * one datagram to the sender. On Linux all datagrams queued in socket are
+ * received by recvmmsg() and answered by sendmmsg() in batches, so one
+ * system call serves many requests. On other systems QUdpSocket is used.
+ *
+ * @ru Каждая датаграмма содержит один запрос с заголовком MBAP, ответ
+ * передается отправителю одной датаграммой. В Linux все датаграммы из очереди
+ * сокета принимаются функцией recvmmsg() и отвечаются функцией sendmmsg()
+ * пакетами, так что один системный вызов обслуживает много запросов. В
+ * других системах используется QUdpSocket.
+ */
+class MODBUS4QT_EXPORT UdpServer : public Server
+{
+    Q_OBJECT
+
+    private:
+
+#ifdef Q_OS_LINUX
+        int fd_;
+
+        QSocketNotifier* notifier_;
+
+        quint16 port_;
+
+        //! @en Buffers for batch of requests and responses @ru Буферы для пакета запросов и ответов
+        QVector<quint8> requestBuffers_;
+
+        QVector<quint8> responseBuffers_;
+#else
+        QUdpSocket* udpSocket_;
+#endif
+
+        //! @en Maximum datagrams per system call, default 64 @ru Максимальное количество датаграмм за один системный вызов, по умолчанию 64
+        int batchSize_;
+
+    public:
+
+        explicit UdpServer(QObject *parent = 0);
+
+        virtual ~UdpServer();
+
+        bool isListening() const;
+
+        quint16 serverPort() const;
+
+        int batchSize() const
+        {
+            return batchSize_;
+        }
+
+        //! @en Takes effect on next listen() @ru Вступает в силу при следующем вызове listen()
+        void setBatchSize(int batchSize)
+        {
+            batchSize_ = qMax(1, batchSize);
+        }
+
+    public slots:
+
+        /**
+         * @brief
+         * @en Bind socket and start serving requests
+         * @ru Привязывает сокет и начинает обслуживание запросов
+         *
+         * @param
+         * @en port - UDP port. If 0 is passed port is chosen automatically.
+         * @ru port - номер UDP порта. Если передан 0, то порт выбирается автоматически.
+         */
+        bool listen(const QHostAddress& address = QHostAddress::Any, quint16 port = DefaultTcpPort);
+
+        void close();
+
+    private slots:
+
+        //! @en Answer all queued datagrams @ru Отвечает на все датаграммы в очереди
+        void readDatagrams_();
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_UDP_SERVER_H
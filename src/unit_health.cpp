@@ -0,0 +1,158 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "unit_health.h"
+
+#include <QtGlobal>
+
+namespace modbus4qt
+{
+
+UnitHealth::UnitHealth(int failureThreshold, int probeInterval, int maxProbeInterval)
+    : units_(256),
+      failureThreshold_(1),
+      probeInterval_(1),
+      maxProbeInterval_(1)
+{
+    setParameters(failureThreshold, probeInterval, maxProbeInterval);
+    releaseAll();
+
+    clock_.start();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UnitHealth::addFailure(quint8 unitId)
+{
+    UnitState& unit = units_[unitId];
+
+    ++unit.failures;
+
+    if (unit.quarantined)
+    {
+        // Probe failed, wait longer
+        unit.probing = false;
+        unit.probeInterval = qMin(unit.probeInterval * 2, maxProbeInterval_);
+        unit.nextProbe = clock_.elapsed() + unit.probeInterval;
+
+        return false;
+    }
+
+    if (unit.failures < failureThreshold_)
+        return false;
+
+    unit.quarantined = true;
+    unit.probing = false;
+    unit.probeInterval = probeInterval_;
+    unit.nextProbe = clock_.elapsed() + unit.probeInterval;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UnitHealth::addSuccess(quint8 unitId)
+{
+    release(unitId);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UnitHealth::admit(quint8 unitId)
+{
+    UnitState& unit = units_[unitId];
+
+    if (!unit.quarantined)
+        return true;
+
+    // Others wait for result of probe already sent
+    //
+    // Остальные запросы ждут результата уже отправленной проверки
+    //
+    if (unit.probing || clock_.elapsed() < unit.nextProbe)
+        return false;
+
+    // This request is the probe, its result must be registered by
+    // addSuccess() or addFailure()
+    //
+    // Этот запрос является проверкой, его результат должен быть учтен
+    // addSuccess() или addFailure()
+    //
+    unit.probing = true;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UnitHealth::release(quint8 unitId)
+{
+    UnitState& unit = units_[unitId];
+
+    unit.failures = 0;
+    unit.quarantined = false;
+    unit.probing = false;
+    unit.probeInterval = 0;
+    unit.nextProbe = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UnitHealth::releaseAll()
+{
+    for (int i = 0; i < units_.size(); ++i)
+        release(i);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UnitHealth::setParameters(int failureThreshold, int probeInterval, int maxProbeInterval)
+{
+    failureThreshold_ = qMax(1, failureThreshold);
+    probeInterval_ = qMax(1, probeInterval);
+    maxProbeInterval_ = qMax(probeInterval_, maxProbeInterval);
+}
+
+//-----------------------------------------------------------------------------
+
+qint64
+UnitHealth::timeToProbe(quint8 unitId) const
+{
+    const UnitState& unit = units_.at(unitId);
+
+    if (!unit.quarantined)
+        return 0;
+
+    return qMax(Q_INT64_C(0), unit.nextProbe - clock_.elapsed());
+}
+
+} // namespace modbus4qt
@@ -0,0 +1,183 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_UNIT_HEALTH_H
+#define MODBUS4QT_UNIT_HEALTH_H
+
+#include "global.h"
+
+#include <QElapsedTimer>
+#include <QVector>
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en Health tracker of units on one line
+ * @ru Отслеживание работоспособности устройств на одной линии
+ *
+ * @en Unit is moved to quarantine after given number of failures in a row.
+ * Requests to unit in quarantine are rejected without sending, except single
+ * probe request after probe interval. Probe interval is doubled after every
+ * failed probe up to maximum value. Any response from unit returns it to
+ * normal state.
+ *
+ * @ru Устройство помещается в карантин после заданного количества ошибок
+ * подряд. Запросы к устройству в карантине отклоняются без отправки, кроме
+ * одного пробного запроса по истечении интервала проверки. Интервал проверки
+ * удваивается после каждой неудачной проверки до максимального значения.
+ * Любой ответ устройства возвращает его в нормальное состояние.
+ */
+class MODBUS4QT_EXPORT UnitHealth
+{
+    private:
+
+        struct UnitState
+        {
+            //! @en Failures in a row @ru Ошибок подряд
+            int failures;
+
+            bool quarantined;
+
+            //! @en Probe request is sent and not finished yet @ru Пробный запрос отправлен и еще не завершен
+            bool probing;
+
+            //! @en Current probe interval, ms @ru Текущий интервал проверки, мс
+            int probeInterval;
+
+            //! @en Time of next probe, ms of clock_ @ru Время следующей проверки, мс по clock_
+            qint64 nextProbe;
+        };
+
+        QVector<UnitState> units_;
+
+        QElapsedTimer clock_;
+
+        int failureThreshold_;
+
+        int probeInterval_;
+
+        int maxProbeInterval_;
+
+    public:
+
+        /**
+         * @brief
+         * @en Constructor
+         * @ru Конструктор
+         *
+         * @param
+         * @en failureThreshold - failures in a row to move unit to quarantine
+         * @ru failureThreshold - количество ошибок подряд для помещения устройства в карантин
+         *
+         * @param
+         * @en probeInterval, maxProbeInterval - initial and maximum probe interval, ms
+         * @ru probeInterval, maxProbeInterval - начальный и максимальный интервал проверки, мс
+         */
+        UnitHealth(int failureThreshold = 3, int probeInterval = 1000, int maxProbeInterval = 60000);
+
+        /**
+         * @brief
+         * @en Check if request to unit can be sent
+         * @ru Проверяет, может ли быть отправлен запрос устройству
+         *
+         * @en Admitted probe request must be finished by addSuccess() or
+         * addFailure(), until then other requests to unit are rejected.
+         *
+         * @ru Разрешенный пробный запрос должен быть завершен вызовом
+         * addSuccess() или addFailure(), до этого остальные запросы к
+         * устройству отклоняются.
+         *
+         * @return
+         * @en true if unit is not in quarantine or probe is due
+         * @ru true если устройство не в карантине или пришло время проверки
+         */
+        bool admit(quint8 unitId);
+
+        //! @en Register response from unit @ru Учитывает ответ устройства
+        void addSuccess(quint8 unitId);
+
+        /**
+         * @brief
+         * @en Register request without response
+         * @ru Учитывает запрос без ответа
+         *
+         * @return
+         * @en true if unit has been moved to quarantine just now
+         * @ru true если устройство только что помещено в карантин
+         */
+        bool addFailure(quint8 unitId);
+
+        //! @en Return unit to normal state @ru Возвращает устройство в нормальное состояние
+        void release(quint8 unitId);
+
+        //! @en Return all units to normal state @ru Возвращает все устройства в нормальное состояние
+        void releaseAll();
+
+        bool isQuarantined(quint8 unitId) const
+        {
+            return units_.at(unitId).quarantined;
+        }
+
+        //! @en Failures in a row for unit @ru Количество ошибок подряд для устройства
+        int failureCount(quint8 unitId) const
+        {
+            return units_.at(unitId).failures;
+        }
+
+        //! @en Time until next probe of unit, ms @ru Время до следующей проверки устройства, мс
+        qint64 timeToProbe(quint8 unitId) const;
+
+        int failureThreshold() const
+        {
+            return failureThreshold_;
+        }
+
+        int probeInterval() const
+        {
+            return probeInterval_;
+        }
+
+        int maxProbeInterval() const
+        {
+            return maxProbeInterval_;
+        }
+
+        /**
+         * @brief
+         * @en Set parameters of quarantine
+         * @ru Устанавливает параметры карантина
+         *
+         * @en New values are applied to units moved to quarantine later.
+         * @ru Новые значения применяются к устройствам, помещенным в карантин позже.
+         */
+        void setParameters(int failureThreshold, int probeInterval, int maxProbeInterval);
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_UNIT_HEALTH_H
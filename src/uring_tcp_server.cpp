@@ -0,0 +1,631 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#include "uring_tcp_server.h"
+
+#include <QSocketNotifier>
+
+#include <string.h>
+
+#ifdef Q_OS_LINUX
+    #include "native_socket.h"
+
+    #include <errno.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace modbus4qt
+{
+
+// Input buffer keeps only request split between two received buffers;
+// output buffer is larger than one of EpollTcpServer, as it is not
+// available while send is in progress
+//
+// Входной буфер хранит только запрос, разделенный между двумя полученными
+// буферами; выходной буфер больше, чем в EpollTcpServer, так как он
+// недоступен во время отправки
+//
+static const int InBufferSize = TcpADUMaxSize;
+static const int OutBufferSize = 16 * TcpADUMaxSize;
+
+//! @en Received buffers held by throttled connection @ru Полученные буферы, удерживаемые приостановленным подключением
+static const int MaxHeldBuffers = 16;
+
+//! @en Completions handled per call @ru Количество завершений, обрабатываемых за один вызов
+static const int MaxCompletions = 256;
+
+// User data of request is address of connection with operation in lower bits
+//
+// Данные пользователя запроса - адрес подключения с операцией в младших битах
+//
+enum Operation
+{
+    AcceptOperation = 0,
+    ReceiveOperation = 1,
+    SendOperation = 2,
+    CancelOperation = 3,
+    OperationMask = 3
+};
+
+struct UringTcpServer::Connection
+{
+    struct HeldBuffer
+    {
+        int id;
+
+        int offset;
+
+        int size;
+    };
+
+    int fd;
+
+    //! @en Connection is shut down and waits for its requests to complete @ru Подключение закрыто и ожидает завершения своих запросов
+    bool closing;
+
+    bool receiving;
+
+    bool sending;
+
+    //! @en Receive request is cancelled until output buffer is drained @ru Запрос приема отменен до освобождения выходного буфера
+    bool throttled;
+
+    int inSize;
+
+    int outSize;
+
+    //! @en Queue of received buffers not processed yet @ru Очередь полученных, но еще не обработанных буферов
+    HeldBuffer held[MaxHeldBuffers];
+
+    int heldHead;
+
+    int heldCount;
+
+    quint8 in[InBufferSize];
+
+    quint8 out[OutBufferSize];
+
+    quint64 userData(Operation operation) const
+    {
+        return reinterpret_cast<quintptr>(this) | operation;
+    }
+};
+
+//-----------------------------------------------------------------------------
+
+UringTcpServer::UringTcpServer(QObject *parent)
+    : EpollTcpServer(parent),
+      uringNotifier_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+UringTcpServer::~UringTcpServer()
+{
+    close();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UringTcpServer::listen(const QHostAddress& address, quint16 port)
+{
+    close();
+
+    if (!engine_.open())
+    {
+        emit infoMessage(tr("io_uring is not available, epoll is used: %1").arg(engine_.errorString()));
+        return EpollTcpServer::listen(address, port);
+    }
+
+#ifdef Q_OS_LINUX
+    QString error;
+    listenFd_ = openNativeSocket(address, port, true, &port_, &error);
+
+    if (listenFd_ < 0)
+    {
+        emit errorMessage(error);
+        engine_.close();
+        return false;
+    }
+
+    engine_.accept(listenFd_, AcceptOperation);
+    engine_.submit();
+
+    uringNotifier_ = new QSocketNotifier(engine_.eventFd(), QSocketNotifier::Read, this);
+    connect(uringNotifier_, SIGNAL(activated(int)), this, SLOT(processCompletions_()));
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UringTcpServer::close()
+{
+    if (engine_.isOpen())
+    {
+        delete uringNotifier_;
+        uringNotifier_ = 0;
+
+        // Closing ring cancels all requests, so buffers are not used after it
+        //
+        // Закрытие кольца отменяет все запросы, поэтому буферы после него не используются
+        //
+        engine_.close();
+
+#ifdef Q_OS_LINUX
+        foreach (Connection* connection, uringConnections_)
+        {
+            if (connection->fd >= 0)
+                ::close(connection->fd);
+        }
+
+        if (listenFd_ >= 0)
+            ::close(listenFd_);
+#endif
+
+        qDeleteAll(uringConnections_);
+        uringConnections_.clear();
+        freeUringConnections_.clear();
+
+        listenFd_ = -1;
+        port_ = 0;
+        connectionCount_ = 0;
+    }
+
+    EpollTcpServer::close();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UringTcpServer::processCompletions_()
+{
+    engine_.clearEvent();
+
+    IoUringEngine::Completion completions[MaxCompletions];
+
+    forever
+    {
+        int count = engine_.takeCompletions(completions, MaxCompletions);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const IoUringEngine::Completion& completion = completions[i];
+
+            Connection* connection = reinterpret_cast<Connection*>(completion.userData & ~quint64(OperationMask));
+
+            switch (completion.userData & OperationMask)
+            {
+                case AcceptOperation :
+                    accepted_(completion);
+                    break;
+
+                case ReceiveOperation :
+                    received_(connection, completion);
+                    break;
+
+                case SendOperation :
+                    sent_(connection, completion);
+                    break;
+
+                default :
+                    break;
+            }
+        }
+
+        if (count < MaxCompletions)
+            break;
+    }
+
+    // Requests prepared for all completions are passed by one system call
+    //
+    // Запросы, подготовленные для всех завершений, передаются одним системным вызовом
+    //
+    engine_.submit();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UringTcpServer::accepted_(const IoUringEngine::Completion& completion)
+{
+#ifdef Q_OS_LINUX
+    if (completion.result >= 0)
+    {
+        int fd = completion.result;
+
+        if (connectionCount_ >= maxConnections_)
+        {
+            ::close(fd);
+        }
+        else
+        {
+            int noDelay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+            Connection* connection;
+
+            if (freeUringConnections_.isEmpty())
+            {
+                connection = new Connection;
+                uringConnections_.append(connection);
+            }
+            else
+            {
+                connection = freeUringConnections_.takeLast();
+            }
+
+            connection->fd = fd;
+            connection->closing = false;
+            connection->receiving = false;
+            connection->sending = false;
+            connection->throttled = false;
+            connection->inSize = 0;
+            connection->outSize = 0;
+            connection->heldHead = 0;
+            connection->heldCount = 0;
+
+            ++connectionCount_;
+
+            startReceive_(connection);
+        }
+    }
+    else
+    {
+        emit errorMessage(tr("Can not accept connection: %1").arg(strerror(-completion.result)));
+    }
+
+    // Multishot accept is stopped by kernel on error
+    //
+    // Многократный прием подключений останавливается ядром при ошибке
+    //
+    if (!IoUringEngine::hasMore(completion))
+        engine_.accept(listenFd_, AcceptOperation);
+#else
+    Q_UNUSED(completion)
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UringTcpServer::received_(Connection* connection, const IoUringEngine::Completion& completion)
+{
+    int bufferId = IoUringEngine::bufferId(completion);
+
+    if ((completion.result > 0) && (bufferId >= 0))
+    {
+        if (connection->closing)
+        {
+            engine_.recycleBuffer(bufferId);
+        }
+        else if (connection->heldCount == MaxHeldBuffers)
+        {
+            engine_.recycleBuffer(bufferId);
+            emit errorMessage(tr("Client does not read responses, connection closed!"));
+            closeConnection_(connection);
+        }
+        else
+        {
+            Connection::HeldBuffer& held = connection->held[(connection->heldHead + connection->heldCount) % MaxHeldBuffers];
+            held.id = bufferId;
+            held.offset = 0;
+            held.size = completion.result;
+
+            ++connection->heldCount;
+
+            processInput_(connection);
+        }
+    }
+
+    if (IoUringEngine::hasMore(completion))
+        return;
+
+    connection->receiving = false;
+
+    // Receive is stopped by kernel when peer closes connection, on error
+    // and when no free buffer is left
+    //
+    // Прием останавливается ядром при закрытии подключения клиентом, при
+    // ошибке и при отсутствии свободных буферов
+    //
+#ifdef Q_OS_LINUX
+    bool restart = (completion.result > 0) || (completion.result == -ENOBUFS) || (completion.result == -ECANCELED);
+#else
+    bool restart = false;
+#endif
+
+    if (!restart)
+        closeConnection_(connection);
+    else if (!connection->closing && !connection->throttled)
+        startReceive_(connection);
+
+    releaseConnection_(connection);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UringTcpServer::sent_(Connection* connection, const IoUringEngine::Completion& completion)
+{
+    connection->sending = false;
+
+    if (connection->closing)
+    {
+        releaseConnection_(connection);
+        return;
+    }
+
+    if (completion.result < 0)
+    {
+        closeConnection_(connection);
+        return;
+    }
+
+    // Short send leaves the rest at the beginning of buffer
+    //
+    // При неполной отправке остаток переносится в начало буфера
+    //
+    connection->outSize -= completion.result;
+    memmove(connection->out, connection->out + completion.result, connection->outSize);
+
+    processInput_(connection);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UringTcpServer::startReceive_(Connection* connection)
+{
+    if (engine_.receive(connection->fd, connection->userData(ReceiveOperation)))
+        connection->receiving = true;
+    else
+        closeConnection_(connection);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UringTcpServer::startSend_(Connection* connection)
+{
+    if (connection->sending || connection->closing || (connection->outSize == 0))
+        return;
+
+    // Responses formed while send is in progress are appended after sent data
+    //
+    // Ответы, сформированные во время отправки, добавляются после отправляемых данных
+    //
+    if (engine_.send(connection->fd, connection->out, connection->outSize, connection->userData(SendOperation)))
+        connection->sending = true;
+    else
+        closeConnection_(connection);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+UringTcpServer::processInput_(Connection* connection)
+{
+    const int headerSize = sizeof(TcpDataHeader);
+
+    while (connection->heldCount > 0)
+    {
+        Connection::HeldBuffer& held = connection->held[connection->heldHead];
+        const quint8* data = engine_.buffer(held.id) + held.offset;
+
+        if (connection->inSize > 0)
+        {
+            // Request started in previous buffer is completed in input buffer,
+            // header is completed first to know size of request
+            //
+            // Запрос, начатый в предыдущем буфере, дополняется во входном
+            // буфере, сначала дополняется заголовок, чтобы узнать размер запроса
+            //
+            int frameSize = (connection->inSize < headerSize) ? headerSize : tcpADUSize_(connection->in);
+
+            int copied = qMin(frameSize - connection->inSize, held.size);
+            memcpy(connection->in + connection->inSize, data, copied);
+            connection->inSize += copied;
+
+            held.offset += copied;
+            held.size -= copied;
+
+            if (connection->inSize >= headerSize)
+            {
+                frameSize = tcpADUSize_(connection->in);
+
+                if (frameSize < 0)
+                {
+                    emit errorMessage(tr("Wrong application data unit recieved, connection closed!"));
+                    closeConnection_(connection);
+                    return false;
+                }
+
+                if (connection->inSize == frameSize)
+                {
+                    // Zero means there is no room for response
+                    //
+                    // Ноль означает, что нет места для ответа
+                    //
+                    if (processRequests_(connection, connection->in, frameSize) == 0)
+                        break;
+
+                    connection->inSize = 0;
+                }
+            }
+        }
+        else
+        {
+            int processed = processRequests_(connection, data, held.size);
+
+            if (processed < 0)
+            {
+                emit errorMessage(tr("Wrong application data unit recieved, connection closed!"));
+                closeConnection_(connection);
+                return false;
+            }
+
+            held.offset += processed;
+            held.size -= processed;
+
+            if (held.size > 0)
+            {
+                if (OutBufferSize - connection->outSize < TcpADUMaxSize)
+                    break;
+
+                // Incomplete request is shorter than one ADU
+                //
+                // Неполный запрос короче одного ADU
+                //
+                memcpy(connection->in, data + processed, held.size);
+                connection->inSize = held.size;
+                held.size = 0;
+            }
+        }
+
+        if (held.size == 0)
+        {
+            engine_.recycleBuffer(held.id);
+            connection->heldHead = (connection->heldHead + 1) % MaxHeldBuffers;
+            --connection->heldCount;
+        }
+    }
+
+    // While client does not read responses receive is stopped, so unread
+    // data stays in socket and TCP flow control slows the client down
+    //
+    // Пока клиент не читает ответы, прием остановлен, поэтому непрочитанные
+    // данные остаются в сокете и управление потоком TCP замедляет клиента
+    //
+    if (connection->heldCount > 0)
+    {
+        if (!connection->throttled)
+        {
+            connection->throttled = true;
+
+            if (connection->receiving)
+                engine_.cancel(connection->userData(ReceiveOperation), connection->userData(CancelOperation));
+        }
+    }
+    else if (connection->throttled)
+    {
+        connection->throttled = false;
+
+        if (!connection->receiving)
+            startReceive_(connection);
+    }
+
+    startSend_(connection);
+
+    return !connection->closing;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+UringTcpServer::processRequests_(Connection* connection, const quint8* data, int size)
+{
+    const int headerSize = sizeof(TcpDataHeader);
+
+    int offset = 0;
+
+    while (size - offset >= headerSize)
+    {
+        int frameSize = tcpADUSize_(data + offset);
+        if (frameSize < 0)
+            return -1;
+
+        if (size - offset < frameSize)
+            break;
+
+        if (OutBufferSize - connection->outSize < TcpADUMaxSize)
+            break;
+
+        connection->outSize += processTcpADU_(data + offset, frameSize, connection->out + connection->outSize, connection->fd);
+        offset += frameSize;
+    }
+
+    return offset;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UringTcpServer::closeConnection_(Connection* connection)
+{
+    if (connection->closing)
+        return;
+
+    connection->closing = true;
+    --connectionCount_;
+
+    // Shutdown completes receive request; send request fails
+    //
+    // После shutdown запрос приема завершается, а запрос отправки - с ошибкой
+    //
+#ifdef Q_OS_LINUX
+    shutdown(connection->fd, SHUT_RDWR);
+#endif
+
+    if (connection->receiving)
+        engine_.cancel(connection->userData(ReceiveOperation), connection->userData(CancelOperation));
+
+    while (connection->heldCount > 0)
+    {
+        engine_.recycleBuffer(connection->held[connection->heldHead].id);
+        connection->heldHead = (connection->heldHead + 1) % MaxHeldBuffers;
+        --connection->heldCount;
+    }
+
+    releaseConnection_(connection);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+UringTcpServer::releaseConnection_(Connection* connection)
+{
+    if (!connection->closing || connection->receiving || connection->sending || (connection->fd < 0))
+        return;
+
+#ifdef Q_OS_LINUX
+    ::close(connection->fd);
+#endif
+
+    connection->fd = -1;
+    freeUringConnections_.append(connection);
+}
+
+} // namespace modbus4qt
@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2015
+ * http://www.modbus4qt.ru
+ *****************************************************************************/
+
+/*****************************************************************************
+* The contents of this file are subject to the Mozilla Public License Version 2.0
+* (the "License"); you may not use this file except in compliance with the
+* License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+*
+* Software distributed under the License is distributed on an "AS IS" basis,
+* WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+* the specific language governing rights and limitations under the License.
+*
+* Alternatively, the contents of this file may be used under the terms of the
+* GNU General Public License Version 2 or later (the "GPL"), in which case
+* the provisions of the GPL are applicable instead of those above. If you wish to
+* allow use of your version of this file only under the terms of the GPL and not
+* to allow others to use your version of this file under the MPL, indicate your
+* decision by deleting the provisions above and replace them with the notice and
+* other provisions required by the GPL. If you do not delete the provisions
+* above, a recipient may use your version of this file under either the MPL or
+* the GPL.
+*****************************************************************************/
+#ifndef MODBUS4QT_URING_TCP_SERVER_H
+#define MODBUS4QT_URING_TCP_SERVER_H
+
+#include "epoll_tcp_server.h"
+#include "io_uring_engine.h"
+
+namespace modbus4qt
+{
+
+/**
+ * @brief
+ * @en MODBUS/TCP server on Linux io_uring
+ * @ru Сервер MODBUS/TCP на основе io_uring в Linux
+ *
+ * @en Connections are accepted by one multishot accept request and every
+ * connection is served by one multishot receive request, which places data
+ * into registered buffer ring. Requests are parsed directly in received
+ * buffers, responses are formed in fixed output buffer of connection. All
+ * sends prepared while handling a batch of completions are passed to kernel
+ * by one system call.
+ *
+ * When client does not read responses, receive request of connection is
+ * cancelled and received buffers are held until output buffer is drained,
+ * so TCP flow control slows the client down.
+ *
+ * If kernel does not support io_uring (Linux older than 6.0 or io_uring is
+ * disabled) server falls back to epoll implementation of EpollTcpServer.
+ *
+ * @ru Подключения принимаются одним многократным запросом приема подключений,
+ * а каждое подключение обслуживается одним многократным запросом приема
+ * данных, который размещает данные в зарегистрированном кольце буферов.
+ * Запросы разбираются прямо в полученных буферах, ответы формируются в
+ * выходном буфере подключения постоянного размера. Все отправки,
+ * подготовленные при обработке пакета завершений, передаются ядру одним
+ * системным вызовом.
+ *
+ * Если клиент не читает ответы, запрос приема данных подключения отменяется,
+ * а полученные буферы удерживаются до освобождения выходного буфера, так что
+ * управление потоком TCP замедляет клиента.
+ *
+ * Если ядро не поддерживает io_uring (Linux старше 6.0 или io_uring отключен),
+ * сервер использует реализацию на основе epoll из EpollTcpServer.
+ */
+class MODBUS4QT_EXPORT UringTcpServer : public EpollTcpServer
+{
+    Q_OBJECT
+
+    private:
+
+        struct Connection;
+
+        IoUringEngine engine_;
+
+        QSocketNotifier* uringNotifier_;
+
+        QVector<Connection*> uringConnections_;
+
+        QVector<Connection*> freeUringConnections_;
+
+        //! @en Handle one completion @ru Обрабатывает одно завершение
+        void accepted_(const IoUringEngine::Completion& completion);
+
+        void received_(Connection* connection, const IoUringEngine::Completion& completion);
+
+        void sent_(Connection* connection, const IoUringEngine::Completion& completion);
+
+        void startReceive_(Connection* connection);
+
+        void startSend_(Connection* connection);
+
+        /**
+         * @brief
+         * @en Process held buffers while there is room for responses
+         * @ru Обрабатывает удерживаемые буферы, пока есть место для ответов
+         *
+         * @return
+         * @en false if connection has been closed
+         * @ru false, если подключение было закрыто
+         */
+        bool processInput_(Connection* connection);
+
+        /**
+         * @brief
+         * @en Process complete requests in data while there is room for response
+         * @ru Обрабатывает полные запросы из data, пока есть место для ответа
+         *
+         * @return
+         * @en Number of bytes processed; -1 if request is wrong
+         * @ru Количество обработанных байт; -1, если запрос неверен
+         */
+        int processRequests_(Connection* connection, const quint8* data, int size);
+
+        //! @en Shut connection down, it is released after all requests complete @ru Закрывает подключение, оно освобождается после завершения всех запросов
+        void closeConnection_(Connection* connection);
+
+        void releaseConnection_(Connection* connection);
+
+    public:
+
+        explicit UringTcpServer(QObject *parent = 0);
+
+        virtual ~UringTcpServer();
+
+        //! @en False if server has fallen back to epoll @ru False, если сервер перешел на использование epoll
+        bool isUsingIoUring() const
+        {
+            return engine_.isOpen();
+        }
+
+    public slots:
+
+        virtual bool listen(const QHostAddress& address = QHostAddress::Any, quint16 port = DefaultTcpPort);
+
+        virtual void close();
+
+    private slots:
+
+        //! @en Handle all posted completions and submit new requests @ru Обрабатывает все завершения и передает новые запросы
+        void processCompletions_();
+};
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_URING_TCP_SERVER_H
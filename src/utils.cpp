@@ -195,12 +195,12 @@ getRegistersFromBuffer(const QByteArray& buffer, quint16 regQty)
 //-----------------------------------------------------------------------------
 
 void
-putCoilsIntoBuffer(quint8* buffer, const QVector<bool>& values)
+putCoilsIntoBuffer(quint8* buffer, const bool* values, int regQty)
 {
     quint8 bitMask = 1;
     quint8* ptr = buffer;
 
-    int regQty = values.size();
+    regQty = qMin(regQty, MaxCoilsForRead);
 
     // Clear the buffer
     for (int i = 0; i < (regQty + 7) / 8; ++i)
@@ -221,28 +221,43 @@ putCoilsIntoBuffer(quint8* buffer, const QVector<bool>& values)
         }
         else
             bitMask = bitMask << 1;
-
-        if (i > MaxCoilsForWrite) break;
     }
 }
 
+//-----------------------------------------------------------------------------
+
+void
+putCoilsIntoBuffer(quint8* buffer, const QVector<bool>& values)
+{
+    putCoilsIntoBuffer(buffer, values.constData(), values.size());
+}
 
 //-----------------------------------------------------------------------------
 
 void
-putRegistersIntoBuffer(quint8* buffer, const QVector<quint16>& data)
+putRegistersIntoBuffer(quint8* buffer, const quint16* values, int regQty)
 {
-    quint16* ptr = (quint16*)buffer;
+    regQty = qMin(regQty, MaxRegistersForRead);
 
-    for (quint16 i = 0; i < data.size(); ++i)
+    // Buffer may be not aligned, so words are written by bytes
+    //
+    // Буфер может быть не выровнен, поэтому слова записываются побайтно
+    //
+    for (int i = 0; i < regQty; ++i)
     {
-        *ptr = host2net(data[i]);
-        ++ptr;
-
-        if (i > MaxRegistersForWrite) break;
+        buffer[i * 2] = hi(values[i]);
+        buffer[i * 2 + 1] = lo(values[i]);
     }
 }
 
+//-----------------------------------------------------------------------------
+
+void
+putRegistersIntoBuffer(quint8* buffer, const QVector<quint16>& data)
+{
+    putRegistersIntoBuffer(buffer, data.constData(), data.size());
+}
+
 } // namespace modbus
 
 
@@ -125,6 +125,12 @@ void putCoilsIntoBuffer(quint8* buffer, const QVector<bool>& data);
  */
 void putRegistersIntoBuffer(quint8* buffer, const QVector<quint16>& data);
 
+//! @sa putCoilsIntoBuffer()
+void putCoilsIntoBuffer(quint8* buffer, const bool* values, int regQty);
+
+//! @sa putRegistersIntoBuffer()
+void putRegistersIntoBuffer(quint8* buffer, const quint16* values, int regQty);
+
 /**
   * @brief
   * @en Retrun hi byte of word
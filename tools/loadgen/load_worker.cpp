@@ -0,0 +1,287 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "load_worker.h"
+
+#include "bench_requests.h"
+#include "bench_utils.h"
+
+#include "tcp_client.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+
+#include <random>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+RequestMix::RequestMix()
+    : totalWeight_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RequestMix::parse(const QString& text)
+{
+    specs_.clear();
+    totalWeight_ = 0;
+
+    foreach (const QString& item, splitNonEmpty(text, ','))
+    {
+        QStringList weightParts = item.split(':');
+        if (weightParts.size() > 2)
+            return false;
+
+        QStringList sizeParts = weightParts.at(0).split('/');
+        if (sizeParts.size() > 2)
+            return false;
+
+        bool ok = true;
+        RequestSpec spec;
+
+        spec.function = sizeParts.at(0).toUInt(&ok, 0);
+        spec.blockSize = ok && sizeParts.size() > 1 ? sizeParts.at(1).toInt(&ok, 0) : 1;
+        spec.weight = ok && weightParts.size() > 1 ? weightParts.at(1).toInt(&ok, 0) : 1;
+
+        if (!ok || spec.weight <= 0 || spec.blockSize <= 0)
+            return false;
+
+        ProtocolDataUnit probe;
+        if (!buildRequest(spec.function, 0, 1, 0, probe))
+            return false;
+
+        spec.blockSize = qMin(spec.blockSize, maxBlockSize(spec.function));
+
+        specs_.append(spec);
+        totalWeight_ += spec.weight;
+    }
+
+    return !specs_.isEmpty();
+}
+
+//-----------------------------------------------------------------------------
+
+const RequestSpec&
+RequestMix::pick(quint32 random) const
+{
+    int point = random % totalWeight_;
+
+    foreach (const RequestSpec& spec, specs_)
+    {
+        if (point < spec.weight)
+            return spec;
+
+        point -= spec.weight;
+    }
+
+    return specs_.last();
+}
+
+//-----------------------------------------------------------------------------
+
+QString
+RequestMix::toString() const
+{
+    QStringList items;
+
+    foreach (const RequestSpec& spec, specs_)
+        items << QString("%1/%2:%3").arg(spec.function).arg(spec.blockSize).arg(spec.weight);
+
+    return items.join(",");
+}
+
+//-----------------------------------------------------------------------------
+
+void
+LoadCounters::merge(const LoadCounters& other)
+{
+    latency.merge(other.latency);
+    exceptions += other.exceptions;
+    timeouts += other.timeouts;
+    errors += other.errors;
+}
+
+//-----------------------------------------------------------------------------
+
+LoadWorker::LoadWorker(const LoadConfig& config, int index)
+    : QThread(0),
+      config_(config),
+      index_(index),
+      stopped_(0),
+      connected_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+LoadCounters
+LoadWorker::takeCounters()
+{
+    QMutexLocker locker(&mutex_);
+
+    LoadCounters result = counters_;
+    counters_ = LoadCounters();
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+LoadWorker::run()
+{
+    TcpClient client;
+    client.setServerAddress(config_.host);
+    client.setPort(config_.port);
+    client.setUnitID(config_.unitId);
+    client.setReadTimeOut(config_.timeoutMs);
+    client.setWriteTimeOut(config_.timeoutMs);
+    client.setAutoConnect(false);
+
+    client.connectToServer(config_.timeoutMs);
+
+    if (!client.isConnected())
+        return;
+
+    connected_.fetchAndStoreOrdered(1);
+
+    std::mt19937 random(0x4d42 + index_);
+
+    const bool openLoop = config_.rate > 0;
+    const qint64 timeoutNs = qint64(config_.timeoutMs) * 1000000;
+
+    // In open loop every connection sends with the same interval, start times
+    // are spread evenly over the first interval.
+    const qint64 intervalNs = openLoop ? qint64(config_.connections * 1e9 / config_.rate) : 0;
+    qint64 nextSendNs = openLoop ? intervalNs * index_ / config_.connections : 0;
+
+    // Transaction ID -> time request was intended to be sent
+    QHash<quint16, qint64> inFlight;
+    inFlight.reserve(config_.depth * 2);
+
+    ProtocolDataUnit request;
+    ProtocolDataUnit response;
+    quint16 seed = 0;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    while (!stopped_.load() && client.isConnected())
+    {
+        qint64 now = clock.nsecsElapsed();
+
+        while (inFlight.size() < config_.depth && (!openLoop || nextSendNs <= now))
+        {
+            const RequestSpec& spec = config_.mix.pick(random());
+
+            // Every connection works with its own part of address space
+            quint16 regStart = config_.regStart + (index_ * spec.blockSize) % (0x10000 - config_.regStart - spec.blockSize);
+
+            int pduSize = buildRequest(spec.function, regStart, spec.blockSize, ++seed, request);
+            qint64 intendedNs = openLoop ? nextSendNs : now;
+
+            if (openLoop)
+                nextSendNs += intervalNs;
+
+            int transactionId = client.postRequest(request, pduSize);
+            if (transactionId < 0)
+            {
+                QMutexLocker locker(&mutex_);
+                ++counters_.errors;
+                break;
+            }
+
+            inFlight.insert(transactionId, intendedNs);
+        }
+
+        now = clock.nsecsElapsed();
+
+        // Expire requests without response
+        QMutableHashIterator<quint16, qint64> i(inFlight);
+        while (i.hasNext())
+        {
+            i.next();
+
+            if (now - i.value() > timeoutNs)
+            {
+                i.remove();
+
+                QMutexLocker locker(&mutex_);
+                ++counters_.timeouts;
+            }
+        }
+
+        // Wait for response until next request is due. Requests which became
+        // due while pipeline was full keep their intended send time, so their
+        // latency includes time spent in queue.
+        qint64 waitNs = 100 * 1000000;
+        if (openLoop && inFlight.size() < config_.depth)
+            waitNs = qBound(Q_INT64_C(0), nextSendNs - now, waitNs);
+
+        if (inFlight.isEmpty())
+        {
+            usleep(qMin(waitNs / 1000, Q_INT64_C(10000)));
+            continue;
+        }
+
+        quint16 transactionId;
+        if (!client.waitForResponse(transactionId, response, int(waitNs / 1000000)))
+            continue;
+
+        qint64 received = clock.nsecsElapsed();
+
+        // Response for expired request is ignored
+        if (!inFlight.contains(transactionId))
+            continue;
+
+        qint64 intendedNs = inFlight.take(transactionId);
+
+        QMutexLocker locker(&mutex_);
+
+        if (response.functionCode & 0x80)
+            ++counters_.exceptions;
+        else
+            counters_.latency.add(received - intendedNs);
+    }
+
+    connected_.fetchAndStoreOrdered(0);
+
+    client.disconnectFromServer();
+}
+
+} // namespace bench
+
+} // namespace modbus4qt
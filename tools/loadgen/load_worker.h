@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_LOAD_WORKER_H
+#define MODBUS4QT_LOAD_WORKER_H
+
+#include "bench_utils.h"
+
+#include <QAtomicInt>
+#include <QHostAddress>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+/**
+ * @brief
+ * @en One kind of request in request mix
+ * @ru Один вид запроса в наборе запросов
+ */
+struct RequestSpec
+{
+    quint8 function;
+
+    int blockSize;
+
+    int weight;
+};
+
+/**
+ * @brief
+ * @en Weighted set of requests
+ * @ru Набор запросов с весами
+ */
+class RequestMix
+{
+    private:
+
+        QList<RequestSpec> specs_;
+
+        int totalWeight_;
+
+    public:
+
+        RequestMix();
+
+        /**
+         * @brief
+         * @en Parse mix description
+         * @ru Разбирает описание набора запросов
+         *
+         * @en Format is comma separated items "function[/size][:weight]",
+         * e.g. "3/10:70,16/4:20,6:10". Default size is 1, default weight is 1.
+         *
+         * @ru Формат - список элементов "функция[/размер][:вес]", разделенных
+         * запятыми, например "3/10:70,16/4:20,6:10". По умолчанию размер 1, вес 1.
+         *
+         * @return
+         * @en false if description is wrong
+         * @ru false, если описание содержит ошибки
+         */
+        bool parse(const QString& text);
+
+        //! @en Select request by random number @ru Выбирает запрос по случайному числу
+        const RequestSpec& pick(quint32 random) const;
+
+        bool isEmpty() const
+        {
+            return specs_.isEmpty();
+        }
+
+        QString toString() const;
+};
+
+/**
+ * @brief
+ * @en Counters collected by worker during one report interval
+ * @ru Счетчики, собранные потоком за один интервал отчета
+ */
+struct LoadCounters
+{
+    //! @en Latency of successful responses @ru Задержка успешных ответов
+    LatencyStats latency;
+
+    //! @en Exception responses @ru Ответы с исключением
+    int exceptions;
+
+    //! @en Requests without response during timeout @ru Запросы без ответа в течение тайм-аута
+    int timeouts;
+
+    //! @en Requests which could not be sent @ru Запросы, которые не удалось отправить
+    int errors;
+
+    LoadCounters()
+        : exceptions(0),
+          timeouts(0),
+          errors(0)
+    {
+    }
+
+    void merge(const LoadCounters& other);
+};
+
+/**
+ * @brief
+ * @en Parameters of load
+ * @ru Параметры нагрузки
+ */
+struct LoadConfig
+{
+    QHostAddress host;
+
+    quint16 port;
+
+    quint8 unitId;
+
+    int connections;
+
+    //! @en Maximum requests in flight per connection @ru Максимальное количество запросов в обработке на соединение
+    int depth;
+
+    //! @en Total target rate, requests per second; 0 means closed loop @ru Суммарная целевая интенсивность, запросов в секунду; 0 - замкнутый цикл
+    double rate;
+
+    int timeoutMs;
+
+    quint16 regStart;
+
+    RequestMix mix;
+};
+
+/**
+ * @brief
+ * @en Thread with one TcpClient connection generating load
+ * @ru Поток с одним подключением TcpClient, создающий нагрузку
+ *
+ * @en In closed loop next request is sent as soon as number of requests in flight
+ * is below depth. In open loop requests are scheduled with fixed interval and
+ * latency is measured from scheduled time, so server stalls are not hidden by
+ * delayed sending.
+ *
+ * @ru В замкнутом цикле следующий запрос отправляется, как только количество
+ * запросов в обработке становится меньше глубины конвейера. В открытом цикле
+ * запросы планируются с постоянным интервалом, а задержка отсчитывается от
+ * запланированного времени, поэтому задержки сервера не скрываются отложенной
+ * отправкой.
+ */
+class LoadWorker : public QThread
+{
+    private:
+
+        LoadConfig config_;
+
+        int index_;
+
+        QAtomicInt stopped_;
+
+        QAtomicInt connected_;
+
+        QMutex mutex_;
+
+        LoadCounters counters_;
+
+    public:
+
+        LoadWorker(const LoadConfig& config, int index);
+
+        void stop()
+        {
+            stopped_.fetchAndStoreOrdered(1);
+        }
+
+        bool isConnected() const
+        {
+            return connected_.load() != 0;
+        }
+
+        //! @en Return counters collected since last call and reset them @ru Возвращает счетчики, собранные с момента последнего вызова, и обнуляет их
+        LoadCounters takeCounters();
+
+    protected:
+
+        virtual void run();
+};
+
+} // namespace bench
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_LOAD_WORKER_H
@@ -0,0 +1,13 @@
+include( $${PWD}/../tools.pri )
+
+TARGET = modbus4qt-loadgen
+
+MOC_DIR = $${MOC_DIR}/tools/loadgen
+OBJECTS_DIR = $${OBJECTS_DIR}/tools/loadgen
+
+SOURCES += \
+    main.cpp \
+    load_worker.cpp
+
+HEADERS += \
+    load_worker.h
@@ -0,0 +1,382 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+//
+// Load generator for MODBUS/TCP servers.
+//
+// Opens several connections, every one in its own thread, and sends weighted
+// mix of requests. Without --rate every connection keeps --depth requests in
+// flight (closed loop). With --rate requests are sent on fixed schedule (open
+// loop) and latency is measured from scheduled time, so slow server can not
+// reduce offered load and hide its own latency. Statistics are printed every
+// interval and summarized at the end.
+//
+// Example:
+//     modbus4qt-loadgen --host 192.168.1.10 --connections 8 --depth 4 --mix 3/10:70,16/4:20,6:10 --duration 60
+//     modbus4qt-loadgen --connections 16 --rate 5000 --output load.json
+//
+
+#include "bench_utils.h"
+#include "load_worker.h"
+
+#include "global.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+
+using namespace modbus4qt;
+using namespace modbus4qt::bench;
+
+//-----------------------------------------------------------------------------
+
+static void
+printHeader(QTextStream& out)
+{
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+           .arg("time,s", 7)
+           .arg("conn", 5)
+           .arg("tps", 9)
+           .arg("p50,us", 9)
+           .arg("p99,us", 9)
+           .arg("p99.9,us", 9)
+           .arg("max,us", 9)
+           .arg("exc", 6)
+           .arg("timeout", 7)
+           .arg("errors", 6)
+        << endl;
+}
+
+//-----------------------------------------------------------------------------
+
+static QJsonObject
+report(QTextStream& out, double timeS, double periodS, int connected, const LoadCounters& counters)
+{
+    double tps = periodS > 0 ? counters.latency.count() / periodS : 0;
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+           .arg(timeS, 7, 'f', 1)
+           .arg(connected, 5)
+           .arg(tps, 9, 'f', 1)
+           .arg(toUs(counters.latency.percentile(50)), 9, 'f', 1)
+           .arg(toUs(counters.latency.percentile(99)), 9, 'f', 1)
+           .arg(toUs(counters.latency.percentile(99.9)), 9, 'f', 1)
+           .arg(toUs(counters.latency.max()), 9, 'f', 1)
+           .arg(counters.exceptions, 6)
+           .arg(counters.timeouts, 7)
+           .arg(counters.errors, 6)
+        << endl;
+
+    QJsonObject result;
+    result["timeS"] = timeS;
+    result["connections"] = connected;
+    result["responses"] = counters.latency.count();
+    result["tps"] = tps;
+    result["meanUs"] = toUs(counters.latency.mean());
+    result["p50Us"] = toUs(counters.latency.percentile(50));
+    result["p99Us"] = toUs(counters.latency.percentile(99));
+    result["p999Us"] = toUs(counters.latency.percentile(99.9));
+    result["maxUs"] = toUs(counters.latency.max());
+    result["exceptions"] = counters.exceptions;
+    result["timeouts"] = counters.timeouts;
+    result["errors"] = counters.errors;
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Collects counters from workers by timer and stops application after
+ * duration is over.
+ */
+class LoadMonitor : public QObject
+{
+    Q_OBJECT
+
+    private:
+
+        QList<LoadWorker*> workers_;
+
+        QTextStream& out_;
+
+        qint64 durationNs_;
+
+        QElapsedTimer clock_;
+
+        qint64 lastReportNs_;
+
+        QTimer timer_;
+
+        LoadCounters total_;
+
+        QJsonArray intervals_;
+
+    public:
+
+        LoadMonitor(const QList<LoadWorker*>& workers, QTextStream& out, int durationS, int intervalMs)
+            : QObject(0),
+              workers_(workers),
+              out_(out),
+              durationNs_(qint64(durationS) * 1000000000),
+              lastReportNs_(0)
+        {
+            timer_.setInterval(intervalMs);
+            connect(&timer_, SIGNAL(timeout()), this, SLOT(tick()));
+        }
+
+        void start()
+        {
+            clock_.start();
+            timer_.start();
+        }
+
+        const LoadCounters& total() const
+        {
+            return total_;
+        }
+
+        const QJsonArray& intervals() const
+        {
+            return intervals_;
+        }
+
+        double elapsedS() const
+        {
+            return lastReportNs_ / 1e9;
+        }
+
+    public slots:
+
+        void tick()
+        {
+            qint64 now = clock_.nsecsElapsed();
+            bool finished = durationNs_ > 0 && now >= durationNs_;
+
+            if (finished)
+            {
+                foreach (LoadWorker* worker, workers_)
+                    worker->stop();
+
+                foreach (LoadWorker* worker, workers_)
+                    worker->wait();
+
+                now = clock_.nsecsElapsed();
+            }
+
+            LoadCounters counters;
+            int connected = 0;
+
+            foreach (LoadWorker* worker, workers_)
+            {
+                counters.merge(worker->takeCounters());
+
+                if (worker->isConnected())
+                    ++connected;
+            }
+
+            intervals_.append(report(out_, now / 1e9, (now - lastReportNs_) / 1e9, connected, counters));
+
+            total_.merge(counters);
+            lastReportNs_ = now;
+
+            if (finished || connected == 0)
+            {
+                timer_.stop();
+                QCoreApplication::quit();
+            }
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("modbus4qt-loadgen");
+    QCoreApplication::setApplicationVersion(MODBUS4QT_VERSION_STR);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("modbus4qt MODBUS/TCP load generator");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption hostOption("host", "Server address.", "address", "127.0.0.1");
+    QCommandLineOption portOption("port", "Server TCP port.", "port", "502");
+    QCommandLineOption unitOption("unit", "Unit ID.", "id", "1");
+    QCommandLineOption connectionsOption("connections", "Number of connections.", "n", "4");
+    QCommandLineOption depthOption("depth", "Requests in flight per connection.", "n", "1");
+    QCommandLineOption mixOption("mix", "Request mix \"function[/size][:weight],...\".", "mix", "3/10");
+    QCommandLineOption startOption("start", "First register or coil address.", "address", "0");
+    QCommandLineOption rateOption("rate", "Total request rate, requests per second (0 - closed loop).", "rps", "0");
+    QCommandLineOption durationOption("duration", "Test duration, s (0 - until interrupted).", "s", "10");
+    QCommandLineOption intervalOption("interval", "Report interval, ms.", "ms", "1000");
+    QCommandLineOption timeoutOption("timeout", "Response timeout, ms.", "ms", "1000");
+    QCommandLineOption outputOption("output", "Write JSON report to file (\"-\" for standard output).", "file");
+    QCommandLineOption verboseOption("verbose", "Do not suppress library debug output.");
+
+    parser.addOption(hostOption);
+    parser.addOption(portOption);
+    parser.addOption(unitOption);
+    parser.addOption(connectionsOption);
+    parser.addOption(depthOption);
+    parser.addOption(mixOption);
+    parser.addOption(startOption);
+    parser.addOption(rateOption);
+    parser.addOption(durationOption);
+    parser.addOption(intervalOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(outputOption);
+    parser.addOption(verboseOption);
+
+    parser.process(app);
+
+    LoadConfig config;
+    config.host = QHostAddress(parser.value(hostOption));
+    config.port = parser.value(portOption).toUShort();
+    config.unitId = parser.value(unitOption).toUShort();
+    config.connections = parser.value(connectionsOption).toInt();
+    config.depth = parser.value(depthOption).toInt();
+    config.rate = parser.value(rateOption).toDouble();
+    config.timeoutMs = parser.value(timeoutOption).toInt();
+    config.regStart = parser.value(startOption).toUShort();
+
+    bool mixOk = config.mix.parse(parser.value(mixOption));
+
+    int duration = parser.value(durationOption).toInt();
+    int interval = parser.value(intervalOption).toInt();
+
+    QTextStream out(parser.value(outputOption) == "-" ? stderr : stdout);
+
+    if (config.host.isNull() || config.port == 0 || config.connections <= 0 || config.depth <= 0 || config.rate < 0
+            || config.timeoutMs <= 0 || duration < 0 || interval <= 0 || config.regStart > 0xF000)
+    {
+        out << "Invalid arguments" << endl;
+        return 1;
+    }
+
+    if (!mixOk)
+    {
+        out << "Invalid request mix: " << parser.value(mixOption) << endl;
+        return 1;
+    }
+
+    if (!parser.isSet(verboseOption))
+        installQuietMessageHandler();
+
+    out << QString("Target %1:%2, unit %3, %4 connections, depth %5, %6, mix %7")
+           .arg(config.host.toString())
+           .arg(config.port)
+           .arg(config.unitId)
+           .arg(config.connections)
+           .arg(config.depth)
+           .arg(config.rate > 0 ? QString("open loop %1 rps").arg(config.rate) : QString("closed loop"))
+           .arg(config.mix.toString())
+        << endl;
+
+    QList<LoadWorker*> workers;
+    for (int i = 0; i < config.connections; ++i)
+        workers.append(new LoadWorker(config, i));
+
+    printHeader(out);
+
+    LoadMonitor monitor(workers, out, duration, interval);
+
+    foreach (LoadWorker* worker, workers)
+        worker->start();
+
+    monitor.start();
+
+    app.exec();
+
+    foreach (LoadWorker* worker, workers)
+    {
+        worker->stop();
+        worker->wait();
+    }
+
+    qDeleteAll(workers);
+
+    const LoadCounters& total = monitor.total();
+    double tps = monitor.elapsedS() > 0 ? total.latency.count() / monitor.elapsedS() : 0;
+
+    out << QString("Total: %1 responses, %2 tps, mean %3 us, p50 %4 us, p99 %5 us, p99.9 %6 us, max %7 us, "
+                   "%8 exceptions, %9 timeouts, %10 errors")
+           .arg(total.latency.count())
+           .arg(tps, 0, 'f', 1)
+           .arg(toUs(total.latency.mean()), 0, 'f', 1)
+           .arg(toUs(total.latency.percentile(50)), 0, 'f', 1)
+           .arg(toUs(total.latency.percentile(99)), 0, 'f', 1)
+           .arg(toUs(total.latency.percentile(99.9)), 0, 'f', 1)
+           .arg(toUs(total.latency.max()), 0, 'f', 1)
+           .arg(total.exceptions)
+           .arg(total.timeouts)
+           .arg(total.errors)
+        << endl;
+
+    if (parser.isSet(outputOption))
+    {
+        QJsonObject parameters;
+        parameters["host"] = config.host.toString();
+        parameters["port"] = config.port;
+        parameters["unitId"] = config.unitId;
+        parameters["connections"] = config.connections;
+        parameters["depth"] = config.depth;
+        parameters["mix"] = config.mix.toString();
+        parameters["rate"] = config.rate;
+        parameters["durationS"] = duration;
+        parameters["intervalMs"] = interval;
+        parameters["timeoutMs"] = config.timeoutMs;
+
+        QJsonObject summary;
+        summary["elapsedS"] = monitor.elapsedS();
+        summary["responses"] = total.latency.count();
+        summary["tps"] = tps;
+        summary["meanUs"] = toUs(total.latency.mean());
+        summary["p50Us"] = toUs(total.latency.percentile(50));
+        summary["p99Us"] = toUs(total.latency.percentile(99));
+        summary["p999Us"] = toUs(total.latency.percentile(99.9));
+        summary["maxUs"] = toUs(total.latency.max());
+        summary["exceptions"] = total.exceptions;
+        summary["timeouts"] = total.timeouts;
+        summary["errors"] = total.errors;
+
+        if (!writeJsonReport(parser.value(outputOption), "loadgen", parameters, monitor.intervals(), summary))
+            return 1;
+    }
+
+    return 0;
+}
+
+#include "main.moc"
@@ -0,0 +1,477 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+//
+// Replay of traffic captured by TrafficCapture.
+//
+// In client role requests of every captured peer are sent to server by its own
+// connection on original schedule, N times faster (--speed N) or as fast as
+// possible (--speed 0). Responses are compared with recorded ones, latency and
+// lateness of sending against schedule are reported.
+//
+// In server role tool listens for MODBUS/TCP clients and answers their
+// requests with recorded responses, delayed by recorded latency divided by
+// speed. Delay blocks the server, so requests of several clients are answered
+// one by one; use --speed 0 to answer at once.
+//
+// Example:
+//     modbus4qt-replay --host 192.168.1.10 --speed 2 plant.m4qc
+//     modbus4qt-replay --speed 0 --depth 8 --output replay.json plant.m4qc
+//     modbus4qt-replay --role server --listen-port 1502 plant.m4qc
+//
+
+#include "bench_utils.h"
+#include "replay_worker.h"
+
+#include "global.h"
+#include "tcp_server.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+
+using namespace modbus4qt;
+using namespace modbus4qt::bench;
+
+//-----------------------------------------------------------------------------
+
+static void
+printHeader(QTextStream& out)
+{
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+           .arg("time,s", 7)
+           .arg("sent", 9)
+           .arg("tps", 9)
+           .arg("p50,us", 9)
+           .arg("p99,us", 9)
+           .arg("max,us", 9)
+           .arg("late99,us", 9)
+           .arg("diff", 6)
+           .arg("timeout", 7)
+           .arg("errors", 6)
+        << endl;
+}
+
+//-----------------------------------------------------------------------------
+
+static QJsonObject
+report(QTextStream& out, double timeS, double periodS, int sent, const ReplayCounters& counters)
+{
+    double tps = periodS > 0 ? counters.latency.count() / periodS : 0;
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+           .arg(timeS, 7, 'f', 1)
+           .arg(sent, 9)
+           .arg(tps, 9, 'f', 1)
+           .arg(toUs(counters.latency.percentile(50)), 9, 'f', 1)
+           .arg(toUs(counters.latency.percentile(99)), 9, 'f', 1)
+           .arg(toUs(counters.latency.max()), 9, 'f', 1)
+           .arg(toUs(counters.lateness.percentile(99)), 9, 'f', 1)
+           .arg(counters.mismatches, 6)
+           .arg(counters.timeouts, 7)
+           .arg(counters.errors, 6)
+        << endl;
+
+    QJsonObject result;
+    result["timeS"] = timeS;
+    result["sent"] = sent;
+    result["responses"] = counters.latency.count();
+    result["tps"] = tps;
+    result["meanUs"] = toUs(counters.latency.mean());
+    result["p50Us"] = toUs(counters.latency.percentile(50));
+    result["p99Us"] = toUs(counters.latency.percentile(99));
+    result["maxUs"] = toUs(counters.latency.max());
+    result["lateP99Us"] = toUs(counters.lateness.percentile(99));
+    result["lateMaxUs"] = toUs(counters.lateness.max());
+    result["mismatches"] = counters.mismatches;
+    result["exceptions"] = counters.exceptions;
+    result["timeouts"] = counters.timeouts;
+    result["errors"] = counters.errors;
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Collects counters from workers by timer and stops application after all
+ * workers have replayed their requests.
+ */
+class ReplayMonitor : public QObject
+{
+    Q_OBJECT
+
+    private:
+
+        QList<ReplayWorker*> workers_;
+
+        QTextStream& out_;
+
+        QElapsedTimer clock_;
+
+        qint64 lastReportNs_;
+
+        QTimer timer_;
+
+        ReplayCounters total_;
+
+        QJsonArray intervals_;
+
+    public:
+
+        ReplayMonitor(const QList<ReplayWorker*>& workers, QTextStream& out, int intervalMs)
+            : QObject(0),
+              workers_(workers),
+              out_(out),
+              lastReportNs_(0)
+        {
+            timer_.setInterval(intervalMs);
+            connect(&timer_, SIGNAL(timeout()), this, SLOT(tick()));
+        }
+
+        void start()
+        {
+            clock_.start();
+            timer_.start();
+        }
+
+        const ReplayCounters& total() const
+        {
+            return total_;
+        }
+
+        const QJsonArray& intervals() const
+        {
+            return intervals_;
+        }
+
+        double elapsedS() const
+        {
+            return lastReportNs_ / 1e9;
+        }
+
+    public slots:
+
+        void tick()
+        {
+            bool finished = true;
+            int sent = 0;
+
+            foreach (ReplayWorker* worker, workers_)
+            {
+                if (!worker->isFinished())
+                    finished = false;
+
+                sent += worker->sent();
+            }
+
+            qint64 now = clock_.nsecsElapsed();
+
+            ReplayCounters counters;
+            foreach (ReplayWorker* worker, workers_)
+                counters.merge(worker->takeCounters());
+
+            intervals_.append(report(out_, now / 1e9, (now - lastReportNs_) / 1e9, sent, counters));
+
+            total_.merge(counters);
+            lastReportNs_ = now;
+
+            if (finished)
+            {
+                timer_.stop();
+                QCoreApplication::quit();
+            }
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Prints statistics of server role by timer and stops application after
+ * duration is over.
+ */
+class ResponderMonitor : public QObject
+{
+    Q_OBJECT
+
+    private:
+
+        const ReplayResponder& responder_;
+
+        QTextStream& out_;
+
+        qint64 durationNs_;
+
+        QElapsedTimer clock_;
+
+        QTimer timer_;
+
+    public:
+
+        ResponderMonitor(const ReplayResponder& responder, QTextStream& out, int durationS, int intervalMs)
+            : QObject(0),
+              responder_(responder),
+              out_(out),
+              durationNs_(qint64(durationS) * 1000000000)
+        {
+            timer_.setInterval(intervalMs);
+            connect(&timer_, SIGNAL(timeout()), this, SLOT(tick()));
+        }
+
+        void start()
+        {
+            clock_.start();
+            timer_.start();
+        }
+
+    public slots:
+
+        void tick()
+        {
+            qint64 now = clock_.nsecsElapsed();
+
+            out_ << QString("%1 s: %2 answered, %3 unknown requests")
+                    .arg(now / 1e9, 7, 'f', 1)
+                    .arg(responder_.hits())
+                    .arg(responder_.misses())
+                 << endl;
+
+            if (durationNs_ > 0 && now >= durationNs_)
+            {
+                timer_.stop();
+                QCoreApplication::quit();
+            }
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+static int
+runServer(QTextStream& out, const ReplayCapture& capture, const QHostAddress& address, quint16 port, double speed,
+          int duration, int interval)
+{
+    ReplayResponder responder(capture, speed);
+
+    TcpServer server;
+    for (int function = 0; function < 256; ++function)
+        server.setFunctionHandler(quint8(function), &responder);
+
+    if (!server.listen(address, port))
+    {
+        out << "Can not listen on " << address.toString() << ":" << port << endl;
+        return 1;
+    }
+
+    out << QString("Answering %1 different requests on %2:%3").arg(responder.size()).arg(address.toString()).arg(port) << endl;
+
+    ResponderMonitor monitor(responder, out, duration, interval);
+    monitor.start();
+
+    QCoreApplication::exec();
+
+    server.close();
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("modbus4qt-replay");
+    QCoreApplication::setApplicationVersion(MODBUS4QT_VERSION_STR);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("modbus4qt captured traffic replay");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("capture", "Capture file written by TrafficCapture.");
+
+    QCommandLineOption roleOption("role", "Replay requests as client or answer them as server.", "client|server", "client");
+    QCommandLineOption hostOption("host", "Server address (client role).", "address", "127.0.0.1");
+    QCommandLineOption portOption("port", "Server TCP port (client role).", "port", "502");
+    QCommandLineOption listenOption("listen", "Address to listen on (server role).", "address", "0.0.0.0");
+    QCommandLineOption listenPortOption("listen-port", "TCP port to listen on (server role).", "port", "502");
+    QCommandLineOption speedOption("speed", "Speed factor against capture (0 - as fast as possible).", "factor", "1");
+    QCommandLineOption depthOption("depth", "Requests in flight per connection (client role).", "n", "16");
+    QCommandLineOption timeoutOption("timeout", "Response timeout, ms (client role).", "ms", "1000");
+    QCommandLineOption durationOption("duration", "Run time, s (server role, 0 - until interrupted).", "s", "0");
+    QCommandLineOption intervalOption("interval", "Report interval, ms.", "ms", "1000");
+    QCommandLineOption outputOption("output", "Write JSON report to file (\"-\" for standard output, client role).", "file");
+    QCommandLineOption verboseOption("verbose", "Do not suppress library debug output.");
+
+    parser.addOption(roleOption);
+    parser.addOption(hostOption);
+    parser.addOption(portOption);
+    parser.addOption(listenOption);
+    parser.addOption(listenPortOption);
+    parser.addOption(speedOption);
+    parser.addOption(depthOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(durationOption);
+    parser.addOption(intervalOption);
+    parser.addOption(outputOption);
+    parser.addOption(verboseOption);
+
+    parser.process(app);
+
+    ReplayConfig config;
+    config.host = QHostAddress(parser.value(hostOption));
+    config.port = parser.value(portOption).toUShort();
+    config.speed = parser.value(speedOption).toDouble();
+    config.depth = parser.value(depthOption).toInt();
+    config.timeoutMs = parser.value(timeoutOption).toInt();
+
+    QString role = parser.value(roleOption);
+    QHostAddress listenAddress(parser.value(listenOption));
+    quint16 listenPort = parser.value(listenPortOption).toUShort();
+    int duration = parser.value(durationOption).toInt();
+    int interval = parser.value(intervalOption).toInt();
+
+    QTextStream out(parser.value(outputOption) == "-" ? stderr : stdout);
+
+    if (parser.positionalArguments().size() != 1 || (role != "client" && role != "server") || config.host.isNull()
+            || config.port == 0 || listenAddress.isNull() || config.speed < 0 || config.depth <= 0 || config.timeoutMs <= 0
+            || duration < 0 || interval <= 0)
+    {
+        out << "Invalid arguments" << endl;
+        return 1;
+    }
+
+    QString captureFile = parser.positionalArguments().at(0);
+
+    ReplayCapture capture;
+    QString error;
+
+    if (!capture.load(captureFile, error))
+    {
+        out << "Can not load " << captureFile << ": " << error << endl;
+        return 1;
+    }
+
+    if (!parser.isSet(verboseOption))
+        installQuietMessageHandler();
+
+    out << QString("Capture %1: %2 peers, %3 requests, %4 responses, %5 s")
+           .arg(captureFile)
+           .arg(capture.peers.size())
+           .arg(capture.requests)
+           .arg(capture.responses)
+           .arg(capture.durationNs / 1e9, 0, 'f', 1)
+        << endl;
+
+    if (role == "server")
+        return runServer(out, capture, listenAddress, listenPort, config.speed, duration, interval);
+
+    out << QString("Target %1:%2, %3, depth %4")
+           .arg(config.host.toString())
+           .arg(config.port)
+           .arg(config.speed > 0 ? QString("speed x%1").arg(config.speed) : QString("as fast as possible"))
+           .arg(config.depth)
+        << endl;
+
+    QList<ReplayWorker*> workers;
+    foreach (const QList<ReplayRequest>& requests, capture.peers)
+        workers.append(new ReplayWorker(config, requests));
+
+    printHeader(out);
+
+    ReplayMonitor monitor(workers, out, interval);
+
+    foreach (ReplayWorker* worker, workers)
+        worker->start();
+
+    monitor.start();
+
+    app.exec();
+
+    foreach (ReplayWorker* worker, workers)
+    {
+        worker->stop();
+        worker->wait();
+    }
+
+    qDeleteAll(workers);
+
+    const ReplayCounters& total = monitor.total();
+
+    out << QString("Total: %1 responses, mean %2 us, p99 %3 us, max %4 us, lateness p99 %5 us, max %6 us, "
+                   "%7 mismatches, %8 exceptions, %9 timeouts, %10 errors")
+           .arg(total.latency.count())
+           .arg(toUs(total.latency.mean()), 0, 'f', 1)
+           .arg(toUs(total.latency.percentile(99)), 0, 'f', 1)
+           .arg(toUs(total.latency.max()), 0, 'f', 1)
+           .arg(toUs(total.lateness.percentile(99)), 0, 'f', 1)
+           .arg(toUs(total.lateness.max()), 0, 'f', 1)
+           .arg(total.mismatches)
+           .arg(total.exceptions)
+           .arg(total.timeouts)
+           .arg(total.errors)
+        << endl;
+
+    if (parser.isSet(outputOption))
+    {
+        QJsonObject parameters;
+        parameters["capture"] = captureFile;
+        parameters["host"] = config.host.toString();
+        parameters["port"] = config.port;
+        parameters["speed"] = config.speed;
+        parameters["depth"] = config.depth;
+        parameters["timeoutMs"] = config.timeoutMs;
+        parameters["intervalMs"] = interval;
+
+        QJsonObject summary;
+        summary["elapsedS"] = monitor.elapsedS();
+        summary["captureS"] = capture.durationNs / 1e9;
+        summary["responses"] = total.latency.count();
+        summary["meanUs"] = toUs(total.latency.mean());
+        summary["p50Us"] = toUs(total.latency.percentile(50));
+        summary["p99Us"] = toUs(total.latency.percentile(99));
+        summary["maxUs"] = toUs(total.latency.max());
+        summary["lateP99Us"] = toUs(total.lateness.percentile(99));
+        summary["lateMaxUs"] = toUs(total.lateness.max());
+        summary["mismatches"] = total.mismatches;
+        summary["exceptions"] = total.exceptions;
+        summary["timeouts"] = total.timeouts;
+        summary["errors"] = total.errors;
+
+        if (!writeJsonReport(parser.value(outputOption), "replay", parameters, monitor.intervals(), summary))
+            return 1;
+    }
+
+    return 0;
+}
+
+#include "main.moc"
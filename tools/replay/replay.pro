@@ -0,0 +1,13 @@
+include( $${PWD}/../tools.pri )
+
+TARGET = modbus4qt-replay
+
+MOC_DIR = $${MOC_DIR}/tools/replay
+OBJECTS_DIR = $${OBJECTS_DIR}/tools/replay
+
+SOURCES += \
+    main.cpp \
+    replay_worker.cpp
+
+HEADERS += \
+    replay_worker.h
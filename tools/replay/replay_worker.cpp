@@ -0,0 +1,414 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "replay_worker.h"
+
+#include "consts.h"
+#include "tcp_client.h"
+#include "traffic_capture.h"
+#include "types.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+/**
+ * Split captured frame into unit ID, protocol data unit and transaction ID.
+ * RTU frames have no transaction ID, -1 is returned for them.
+ */
+static bool
+splitFrame(const TrafficRecord& record, quint8& unitId, QByteArray& pdu, int& transactionId)
+{
+    const quint8* adu = (const quint8*)record.adu.constData();
+    const int size = record.adu.size();
+
+    if (record.flags & TrafficRecord::RtuFraming)
+    {
+        // Unit ID, PDU and CRC
+        if (size < 4)
+            return false;
+
+        unitId = adu[0];
+        pdu = record.adu.mid(1, size - 3);
+        transactionId = -1;
+    }
+    else
+    {
+        const int headerSize = sizeof(TcpDataHeader);
+
+        if (size < headerSize + 1)
+            return false;
+
+        unitId = adu[6];
+        pdu = record.adu.mid(headerSize);
+        transactionId = (adu[0] << 8) | adu[1];
+    }
+
+    return pdu.size() <= PDUMaxSize;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+ReplayCapture::load(const QString& fileName, QString& error)
+{
+    TrafficReader reader;
+
+    if (!reader.open(fileName))
+    {
+        error = reader.errorString();
+        return false;
+    }
+
+    QList<TrafficRecord> records;
+    bool hasClientSide = false;
+
+    TrafficRecord record;
+    while (reader.next(record))
+    {
+        records.append(record);
+
+        if (!(record.flags & TrafficRecord::ServerSide))
+            hasClientSide = true;
+    }
+
+    if (!reader.errorString().isEmpty())
+    {
+        error = reader.errorString();
+        return false;
+    }
+
+    // Index of request waiting for response by peer and transaction ID. RTU
+    // has one request at a time, so its key is just peer.
+    QHash<quint64, int> pending;
+    qint64 firstNs = -1;
+
+    foreach (const TrafficRecord& record, records)
+    {
+        if (bool(record.flags & TrafficRecord::ServerSide) == hasClientSide)
+            continue;
+
+        quint8 unitId;
+        QByteArray pdu;
+        int transactionId;
+
+        if (!splitFrame(record, unitId, pdu, transactionId))
+            continue;
+
+        const quint64 key = (quint64(record.peer) << 32) | quint32(transactionId);
+        QList<ReplayRequest>& requests = peers[record.peer];
+
+        if (record.isRequest())
+        {
+            if (firstNs < 0)
+                firstNs = record.timestampNs;
+
+            ReplayRequest request;
+            request.timestampNs = record.timestampNs - firstNs;
+            request.unitId = unitId;
+            request.pdu = pdu;
+
+            pending.insert(key, requests.size());
+            requests.append(request);
+
+            durationNs = request.timestampNs;
+            ++this->requests;
+        }
+        else
+        {
+            QHash<quint64, int>::iterator i = pending.find(key);
+            if (i == pending.end())
+                continue;
+
+            ReplayRequest& request = requests[i.value()];
+            request.response = pdu;
+            request.latencyNs = record.timestampNs - firstNs - request.timestampNs;
+
+            pending.erase(i);
+            ++responses;
+        }
+    }
+
+    // Peers which only have responses are of no use
+    QMutableMapIterator<quint32, QList<ReplayRequest> > i(peers);
+    while (i.hasNext())
+    {
+        if (i.next().value().isEmpty())
+            i.remove();
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ReplayCounters::merge(const ReplayCounters& other)
+{
+    latency.merge(other.latency);
+    lateness.merge(other.lateness);
+    mismatches += other.mismatches;
+    exceptions += other.exceptions;
+    timeouts += other.timeouts;
+    errors += other.errors;
+}
+
+//-----------------------------------------------------------------------------
+
+ReplayWorker::ReplayWorker(const ReplayConfig& config, const QList<ReplayRequest>& requests)
+    : QThread(0),
+      config_(config),
+      requests_(requests),
+      stopped_(0),
+      sent_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+ReplayCounters
+ReplayWorker::takeCounters()
+{
+    QMutexLocker locker(&mutex_);
+
+    ReplayCounters result = counters_;
+    counters_ = ReplayCounters();
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+static bool
+sameResponse(const ProtocolDataUnit& response, const QByteArray& recorded)
+{
+    if (response.functionCode != quint8(recorded.at(0)))
+        return false;
+
+    return std::equal(recorded.constBegin() + 1, recorded.constEnd(), (const char*)response.data);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ReplayWorker::run()
+{
+    TcpClient client;
+    client.setServerAddress(config_.host);
+    client.setPort(config_.port);
+    client.setReadTimeOut(config_.timeoutMs);
+    client.setWriteTimeOut(config_.timeoutMs);
+    client.setAutoConnect(false);
+
+    client.connectToServer(config_.timeoutMs);
+
+    if (!client.isConnected())
+    {
+        QMutexLocker locker(&mutex_);
+        counters_.errors += requests_.size();
+        return;
+    }
+
+    const bool timed = config_.speed > 0;
+    const qint64 timeoutNs = qint64(config_.timeoutMs) * 1000000;
+
+    struct InFlight
+    {
+        int index;
+
+        qint64 sentNs;
+    };
+
+    // Transaction ID -> request in flight
+    QHash<quint16, InFlight> inFlight;
+    inFlight.reserve(config_.depth * 2);
+
+    ProtocolDataUnit request;
+    ProtocolDataUnit response;
+    int next = 0;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    while (!stopped_.load() && client.isConnected() && (next < requests_.size() || !inFlight.isEmpty()))
+    {
+        qint64 now = clock.nsecsElapsed();
+
+        while (next < requests_.size() && inFlight.size() < config_.depth)
+        {
+            const ReplayRequest& item = requests_.at(next);
+            qint64 dueNs = timed ? qint64(item.timestampNs / config_.speed) : now;
+
+            if (dueNs > now)
+                break;
+
+            request.functionCode = quint8(item.pdu.at(0));
+            std::copy(item.pdu.constBegin() + 1, item.pdu.constEnd(), (char*)request.data);
+
+            client.setUnitID(item.unitId);
+
+            int transactionId = client.postRequest(request, item.pdu.size());
+            qint64 sentNs = clock.nsecsElapsed();
+
+            ++next;
+            sent_.fetchAndAddOrdered(1);
+
+            QMutexLocker locker(&mutex_);
+
+            if (transactionId < 0)
+            {
+                ++counters_.errors;
+                continue;
+            }
+
+            InFlight sentRequest = {next - 1, sentNs};
+            inFlight.insert(transactionId, sentRequest);
+
+            counters_.lateness.add(qMax(Q_INT64_C(0), sentNs - dueNs));
+        }
+
+        now = clock.nsecsElapsed();
+
+        // Expire requests without response
+        QMutableHashIterator<quint16, InFlight> i(inFlight);
+        while (i.hasNext())
+        {
+            i.next();
+
+            if (now - i.value().sentNs > timeoutNs)
+            {
+                i.remove();
+
+                QMutexLocker locker(&mutex_);
+                ++counters_.timeouts;
+            }
+        }
+
+        // Wait for response until next request is due
+        qint64 waitNs = 100 * 1000000;
+        if (timed && next < requests_.size() && inFlight.size() < config_.depth)
+            waitNs = qBound(Q_INT64_C(0), qint64(requests_.at(next).timestampNs / config_.speed) - now, waitNs);
+
+        if (inFlight.isEmpty())
+        {
+            usleep(qMin(waitNs / 1000, Q_INT64_C(10000)));
+            continue;
+        }
+
+        quint16 transactionId;
+        if (!client.waitForResponse(transactionId, response, int(waitNs / 1000000)))
+            continue;
+
+        qint64 received = clock.nsecsElapsed();
+
+        // Response for expired request is ignored
+        if (!inFlight.contains(transactionId))
+            continue;
+
+        InFlight sentRequest = inFlight.take(transactionId);
+        const ReplayRequest& item = requests_.at(sentRequest.index);
+
+        QMutexLocker locker(&mutex_);
+
+        counters_.latency.add(received - sentRequest.sentNs);
+
+        if (response.functionCode & 0x80)
+            ++counters_.exceptions;
+
+        if (!item.response.isEmpty() && !sameResponse(response, item.response))
+            ++counters_.mismatches;
+    }
+
+    client.disconnectFromServer();
+}
+
+//-----------------------------------------------------------------------------
+
+ReplayResponder::ReplayResponder(const ReplayCapture& capture, double speed)
+    : speed_(speed),
+      hits_(0),
+      misses_(0)
+{
+    // Answer to repeated request may change with time, the last one is kept
+    foreach (const QList<ReplayRequest>& requests, capture.peers)
+    {
+        foreach (const ReplayRequest& request, requests)
+        {
+            if (request.response.isEmpty())
+                continue;
+
+            Response response;
+            response.pdu = request.response;
+            response.latencyNs = request.latencyNs;
+
+            responses_.insert(request.pdu, response);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int
+ReplayResponder::processRequest(Device* device, const PduView& request, quint8* response)
+{
+    Q_UNUSED(device)
+
+    QHash<QByteArray, Response>::const_iterator i = responses_.constFind(QByteArray::fromRawData((const char*)request.pdu, request.size));
+
+    if (i == responses_.constEnd())
+    {
+        misses_.fetchAndAddRelaxed(1);
+        return exception(Exceptions::ServerDeviceFailure);
+    }
+
+    hits_.fetchAndAddRelaxed(1);
+
+    // Blocks event loop of server, so peers are served one by one. See class
+    // description.
+    //
+    // Блокирует цикл обработки событий сервера, поэтому клиенты обслуживаются
+    // по очереди. См. описание класса.
+    //
+    if (speed_ > 0)
+        QThread::usleep(ulong(i->latencyNs / speed_ / 1000));
+
+    std::copy(i->pdu.constBegin(), i->pdu.constEnd(), (char*)response);
+
+    return i->pdu.size();
+}
+
+} // namespace bench
+
+} // namespace modbus4qt
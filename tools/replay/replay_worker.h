@@ -0,0 +1,294 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_REPLAY_WORKER_H
+#define MODBUS4QT_REPLAY_WORKER_H
+
+#include "bench_utils.h"
+
+#include "function_handler.h"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QThread>
+
+namespace modbus4qt
+{
+
+namespace bench
+{
+
+/**
+ * @brief
+ * @en Request taken from capture with its recorded response
+ * @ru Запрос, взятый из записи трафика, с записанным ответом
+ */
+struct ReplayRequest
+{
+    //! @en Time since first request of capture, ns @ru Время от первого запроса записи, нс
+    qint64 timestampNs;
+
+    quint8 unitId;
+
+    //! @en Request protocol data unit @ru Блок данных протокола запроса
+    QByteArray pdu;
+
+    //! @en Recorded response protocol data unit, empty if there was no response @ru Записанный блок данных протокола ответа, пустой, если ответа не было
+    QByteArray response;
+
+    //! @en Recorded time between request and response, ns @ru Записанное время между запросом и ответом, нс
+    qint64 latencyNs;
+
+    ReplayRequest()
+        : timestampNs(0),
+          unitId(0),
+          latencyNs(0)
+    {
+    }
+};
+
+/**
+ * @brief
+ * @en Requests of capture split by peer
+ * @ru Запросы записи трафика, разделенные по абонентам
+ */
+struct ReplayCapture
+{
+    QMap<quint32, QList<ReplayRequest> > peers;
+
+    //! @en Time between first and last request, ns @ru Время между первым и последним запросом, нс
+    qint64 durationNs;
+
+    int requests;
+
+    int responses;
+
+    ReplayCapture()
+        : durationNs(0),
+          requests(0),
+          responses(0)
+    {
+    }
+
+    /**
+     * @brief
+     * @en Load capture file
+     * @ru Загружает файл записи трафика
+     *
+     * @en If capture contains frames recorded by both client and server,
+     * client side frames are used, so every request is taken once.
+     *
+     * @ru Если запись содержит кадры, записанные и клиентом, и сервером,
+     * используются кадры клиента, чтобы каждый запрос был взят один раз.
+     */
+    bool load(const QString& fileName, QString& error);
+};
+
+/**
+ * @brief
+ * @en Counters collected by worker during one report interval
+ * @ru Счетчики, собранные потоком за один интервал отчета
+ */
+struct ReplayCounters
+{
+    //! @en Time between sending of request and response @ru Время между отправкой запроса и ответом
+    LatencyStats latency;
+
+    //! @en Delay of sending against schedule of capture @ru Задержка отправки относительно расписания записи
+    LatencyStats lateness;
+
+    //! @en Responses different from recorded ones @ru Ответы, отличающиеся от записанных
+    int mismatches;
+
+    int exceptions;
+
+    int timeouts;
+
+    int errors;
+
+    ReplayCounters()
+        : mismatches(0),
+          exceptions(0),
+          timeouts(0),
+          errors(0)
+    {
+    }
+
+    void merge(const ReplayCounters& other);
+};
+
+/**
+ * @brief
+ * @en Parameters of replay
+ * @ru Параметры воспроизведения
+ */
+struct ReplayConfig
+{
+    QHostAddress host;
+
+    quint16 port;
+
+    //! @en Speed factor; 0 means as fast as possible @ru Коэффициент скорости; 0 - максимально быстро
+    double speed;
+
+    //! @en Maximum requests in flight per connection @ru Максимальное количество запросов в обработке на соединение
+    int depth;
+
+    int timeoutMs;
+};
+
+/**
+ * @brief
+ * @en Thread replaying requests of one captured peer by TcpClient
+ * @ru Поток, воспроизводящий запросы одного записанного абонента через TcpClient
+ *
+ * @en Requests are sent on schedule of capture divided by speed factor, up to
+ * depth requests in flight. Lateness shows how much sending lagged behind
+ * schedule, so it is seen whether server or replay itself could not keep pace.
+ *
+ * @ru Запросы отправляются по расписанию записи, деленному на коэффициент
+ * скорости, не более depth запросов в обработке. Опоздание показывает, насколько
+ * отправка отстала от расписания, поэтому видно, кто не успевал - сервер или
+ * само воспроизведение.
+ */
+class ReplayWorker : public QThread
+{
+    private:
+
+        ReplayConfig config_;
+
+        QList<ReplayRequest> requests_;
+
+        QAtomicInt stopped_;
+
+        QAtomicInt sent_;
+
+        QMutex mutex_;
+
+        ReplayCounters counters_;
+
+    public:
+
+        ReplayWorker(const ReplayConfig& config, const QList<ReplayRequest>& requests);
+
+        void stop()
+        {
+            stopped_.fetchAndStoreOrdered(1);
+        }
+
+        //! @en Requests sent so far @ru Количество уже отправленных запросов
+        int sent() const
+        {
+            return sent_.load();
+        }
+
+        //! @en Return counters collected since last call and reset them @ru Возвращает счетчики, собранные с момента последнего вызова, и обнуляет их
+        ReplayCounters takeCounters();
+
+    protected:
+
+        virtual void run();
+};
+
+/**
+ * @brief
+ * @en Function handler answering with responses from capture
+ * @ru Обработчик функций, отвечающий ответами из записи трафика
+ *
+ * @en Installed for all function codes, it finds recorded response by request
+ * protocol data unit and sends it after recorded latency divided by speed
+ * factor. Unknown requests get ServerDeviceFailure exception.
+ *
+ * Function handlers answer synchronously, so latency is emulated by sleeping
+ * in thread of server. Requests of all peers are served one by one then:
+ * with several peers each of them waits for latencies of the others too.
+ * Use speed 0 to answer at once.
+ *
+ * @ru Устанавливается для всех кодов функций, находит записанный ответ по блоку
+ * данных протокола запроса и передает его через записанное время ответа,
+ * деленное на коэффициент скорости. На неизвестные запросы передается
+ * исключение ServerDeviceFailure.
+ *
+ * Обработчики функций отвечают синхронно, поэтому время ответа имитируется
+ * ожиданием в потоке сервера. Запросы всех клиентов при этом обслуживаются по
+ * очереди: при нескольких клиентах каждый из них ждет и ответов другим. Для
+ * ответа без задержки используется скорость 0.
+ */
+class ReplayResponder : public FunctionHandler
+{
+    private:
+
+        struct Response
+        {
+            QByteArray pdu;
+
+            qint64 latencyNs;
+        };
+
+        QHash<QByteArray, Response> responses_;
+
+        double speed_;
+
+        QAtomicInt hits_;
+
+        QAtomicInt misses_;
+
+    public:
+
+        ReplayResponder(const ReplayCapture& capture, double speed);
+
+        //! @en Number of different requests known @ru Количество известных различных запросов
+        int size() const
+        {
+            return responses_.size();
+        }
+
+        int hits() const
+        {
+            return hits_.load();
+        }
+
+        int misses() const
+        {
+            return misses_.load();
+        }
+
+        virtual int processRequest(Device* device, const PduView& request, quint8* response);
+};
+
+} // namespace bench
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_REPLAY_WORKER_H
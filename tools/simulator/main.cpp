@@ -0,0 +1,299 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+//
+// Headless simulator of many MODBUS/TCP slaves.
+//
+// Every port in --ports serves every unit ID in --units, each by its own
+// device with sparse tables described by register map. Values of dynamic
+// ranges are updated every tick by generators; devices differ in phase and
+// random seed. Ports are spread over threads, each thread owns its servers
+// and devices, so values are updated without locks between requests. Tick
+// statistics are printed every interval: if tick time approaches tick
+// interval, more threads are needed.
+//
+// Example:
+//     modbus4qt-simulator --map plant.json --ports 5020-5059 --units 1-247 --threads 8 --tick 100
+//
+
+#include "bench_utils.h"
+#include "sim_model.h"
+#include "sim_worker.h"
+
+#include "global.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+
+using namespace modbus4qt;
+using namespace modbus4qt::bench;
+using namespace modbus4qt::sim;
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Parse list like "1-10,15,20-22". Empty list means error.
+ */
+static QList<int>
+parseRangeList(const QString& text, int min, int max)
+{
+    QList<int> result;
+
+    foreach (const QString& item, splitNonEmpty(text, ','))
+    {
+        QStringList bounds = item.split('-');
+        bool firstOk = false;
+        bool lastOk = false;
+
+        int first = bounds.at(0).toInt(&firstOk, 0);
+        int last = bounds.size() == 2 ? bounds.at(1).toInt(&lastOk, 0) : first;
+
+        if (bounds.size() == 1)
+            lastOk = firstOk;
+
+        if (!firstOk || !lastOk || bounds.size() > 2 || first < min || last > max || first > last)
+            return QList<int>();
+
+        for (int i = first; i <= last; ++i)
+            result.append(i);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Prints tick statistics of workers and stops application after duration.
+ */
+class SimMonitor : public QObject
+{
+    Q_OBJECT
+
+    private:
+
+        QList<SimWorker*> workers_;
+
+        QTextStream& out_;
+
+        const QElapsedTimer& clock_;
+
+        qint64 durationNs_;
+
+        QTimer timer_;
+
+    public:
+
+        SimMonitor(const QList<SimWorker*>& workers, QTextStream& out, const QElapsedTimer& clock, int durationS, int intervalMs)
+            : QObject(0),
+              workers_(workers),
+              out_(out),
+              clock_(clock),
+              durationNs_(qint64(durationS) * 1000000000)
+        {
+            timer_.setInterval(intervalMs);
+            connect(&timer_, SIGNAL(timeout()), this, SLOT(tick()));
+        }
+
+        void start()
+        {
+            out_ << QString("%1 %2 %3 %4 %5").arg("time,s", 8).arg("ticks", 8).arg("mean,us", 10).arg("max,us", 10).arg("overruns", 9)
+                 << endl;
+
+            timer_.start();
+        }
+
+    public slots:
+
+        void tick()
+        {
+            TickCounters counters;
+
+            foreach (SimWorker* worker, workers_)
+                counters.merge(worker->takeCounters());
+
+            const qint64 now = clock_.nsecsElapsed();
+
+            out_ << QString("%1 %2 %3 %4 %5")
+                    .arg(now / 1e9, 8, 'f', 1)
+                    .arg(counters.ticks, 8)
+                    .arg(counters.ticks ? toUs(counters.totalNs / counters.ticks) : 0.0, 10, 'f', 1)
+                    .arg(toUs(counters.maxNs), 10, 'f', 1)
+                    .arg(counters.overruns, 9)
+                 << endl;
+
+            if (durationNs_ > 0 && now >= durationNs_)
+            {
+                timer_.stop();
+                QCoreApplication::quit();
+            }
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("modbus4qt-simulator");
+    QCoreApplication::setApplicationVersion(MODBUS4QT_VERSION_STR);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("modbus4qt headless MODBUS/TCP slave simulator");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption mapOption("map", "Register map, JSON file.", "file");
+    QCommandLineOption addressOption("address", "Address to listen on.", "address", "0.0.0.0");
+    QCommandLineOption portsOption("ports", "TCP ports, e.g. \"5020-5029,5100\".", "ports", "5020");
+    QCommandLineOption unitsOption("units", "Unit IDs served on every port, e.g. \"1-247\".", "ids", "1");
+    QCommandLineOption threadsOption("threads", "Number of server threads.", "n", QString::number(qMax(1, QThread::idealThreadCount())));
+    QCommandLineOption tickOption("tick", "Interval of value updates, ms.", "ms", "100");
+    QCommandLineOption backendOption("backend", "Server backend: epoll or qt.", "backend", "epoll");
+    QCommandLineOption intervalOption("interval", "Report interval, ms.", "ms", "5000");
+    QCommandLineOption durationOption("duration", "Run time, s (0 - until interrupted).", "s", "0");
+    QCommandLineOption verboseOption("verbose", "Do not suppress library debug output.");
+
+    parser.addOption(mapOption);
+    parser.addOption(addressOption);
+    parser.addOption(portsOption);
+    parser.addOption(unitsOption);
+    parser.addOption(threadsOption);
+    parser.addOption(tickOption);
+    parser.addOption(backendOption);
+    parser.addOption(intervalOption);
+    parser.addOption(durationOption);
+    parser.addOption(verboseOption);
+
+    parser.process(app);
+
+    QTextStream out(stdout);
+
+    QList<int> ports = parseRangeList(parser.value(portsOption), 1, 65535);
+    QList<int> units = parseRangeList(parser.value(unitsOption), 0, 255);
+
+    int threads = parser.value(threadsOption).toInt();
+    int tick = parser.value(tickOption).toInt();
+    int interval = parser.value(intervalOption).toInt();
+    int duration = parser.value(durationOption).toInt();
+    QString backend = parser.value(backendOption);
+
+    if (!parser.isSet(mapOption) || ports.isEmpty() || units.isEmpty() || threads <= 0 || tick <= 0 || interval <= 0
+            || duration < 0 || (backend != "epoll" && backend != "qt"))
+    {
+        out << "Invalid arguments" << endl;
+        return 1;
+    }
+
+    RegisterMap map;
+    if (!map.load(parser.value(mapOption)))
+    {
+        out << map.errorString() << endl;
+        return 1;
+    }
+
+    if (!parser.isSet(verboseOption))
+        installQuietMessageHandler();
+
+    SimConfig config;
+    config.address = QHostAddress(parser.value(addressOption));
+    config.units = units;
+    config.tickMs = tick;
+    config.backend = backend;
+    config.map = &map;
+
+    threads = qMin(threads, ports.size());
+
+    QElapsedTimer clock;
+    clock.start();
+
+    // Ports are dealt to threads in turn
+    //
+    // Порты раздаются потокам по очереди
+    //
+    QList<QList<quint16> > threadPorts;
+    for (int i = 0; i < threads; ++i)
+        threadPorts.append(QList<quint16>());
+
+    for (int i = 0; i < ports.size(); ++i)
+        threadPorts[i % threads].append(ports.at(i));
+
+    QList<SimWorker*> workers;
+    int firstDevice = 0;
+    bool isOk = true;
+
+    for (int i = 0; i < threads; ++i)
+    {
+        SimWorker* worker = new SimWorker(config, threadPorts.at(i), firstDevice, clock);
+        workers.append(worker);
+
+        firstDevice += threadPorts.at(i).size() * units.size();
+
+        if (!worker->startServers())
+        {
+            foreach (const QString& error, worker->errors())
+                out << error << endl;
+
+            isOk = false;
+        }
+    }
+
+    if (isOk)
+    {
+        out << QString("Simulating %1 devices: %2 ports x %3 units, %4 threads, %5 backend, "
+                       "%6 dynamic items per device, tick %7 ms")
+               .arg(ports.size() * units.size())
+               .arg(ports.size())
+               .arg(units.size())
+               .arg(threads)
+               .arg(backend)
+               .arg(map.dynamicItems())
+               .arg(tick)
+            << endl;
+
+        SimMonitor monitor(workers, out, clock, duration, interval);
+        monitor.start();
+
+        app.exec();
+    }
+
+    foreach (SimWorker* worker, workers)
+        worker->stopServers();
+
+    qDeleteAll(workers);
+
+    return isOk ? 0 : 1;
+}
+
+#include "main.moc"
@@ -0,0 +1,647 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "sim_model.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#include <cmath>
+
+namespace modbus4qt
+{
+
+namespace sim
+{
+
+//
+// Values are computed in double and clamped to register range
+//
+// Значения вычисляются в double и ограничиваются диапазоном регистра
+//
+static inline quint16
+toRegister(double value)
+{
+    return quint16(qBound(0.0, value + 0.5, 65535.0));
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Fixed value set at start, changed only by clients.
+ */
+class ConstantGenerator : public Generator
+{
+    private:
+
+        quint16 value_;
+
+    public:
+
+        explicit ConstantGenerator(quint16 value)
+            : value_(value)
+        {
+        }
+
+        virtual void update(double, double, quint32&, quint16* values, int count) const
+        {
+            std::fill(values, values + count, value_);
+        }
+
+        virtual bool isStatic() const
+        {
+            return true;
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Saw tooth from min to max with period; every next register is shifted by
+ * spread of period.
+ */
+class RampGenerator : public Generator
+{
+    private:
+
+        double min_;
+
+        double max_;
+
+        double period_;
+
+        double spread_;
+
+    public:
+
+        RampGenerator(double min, double max, double period, double spread)
+            : min_(min),
+              max_(max),
+              period_(period),
+              spread_(spread)
+        {
+        }
+
+        virtual void update(double timeS, double phase, quint32&, quint16* values, int count) const
+        {
+            const double base = timeS / period_ + phase;
+            const double range = max_ - min_;
+
+            for (int i = 0; i < count; ++i)
+            {
+                double x = base + i * spread_;
+                values[i] = toRegister(min_ + range * (x - std::floor(x)));
+            }
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Sine wave around offset.
+ */
+class SineGenerator : public Generator
+{
+    private:
+
+        double offset_;
+
+        double amplitude_;
+
+        double period_;
+
+        double spread_;
+
+    public:
+
+        SineGenerator(double offset, double amplitude, double period, double spread)
+            : offset_(offset),
+              amplitude_(amplitude),
+              period_(period),
+              spread_(spread)
+        {
+        }
+
+        virtual void update(double timeS, double phase, quint32&, quint16* values, int count) const
+        {
+            const double twoPi = 6.283185307179586;
+            const double base = twoPi * (timeS / period_ + phase);
+            const double step = twoPi * spread_;
+
+            for (int i = 0; i < count; ++i)
+                values[i] = toRegister(offset_ + amplitude_ * std::sin(base + i * step));
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Every register makes random step from its current value, bounded by min and max.
+ */
+class RandomWalkGenerator : public Generator
+{
+    private:
+
+        int step_;
+
+        int min_;
+
+        int max_;
+
+    public:
+
+        RandomWalkGenerator(int step, int min, int max)
+            : step_(step),
+              min_(min),
+              max_(max)
+        {
+        }
+
+        virtual void update(double, double, quint32& seed, quint16* values, int count) const
+        {
+            const quint32 span = 2 * step_ + 1;
+            quint32 state = seed ? seed : 1;
+
+            for (int i = 0; i < count; ++i)
+            {
+                // xorshift32
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+
+                int value = values[i] + int(state % span) - step_;
+                values[i] = quint16(qBound(min_, value, max_));
+            }
+
+            seed = state;
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Rows of recorded values played in loop, one row per period.
+ */
+class ReplayGenerator : public Generator
+{
+    private:
+
+        QVector<QVector<quint16> > rows_;
+
+        double period_;
+
+    public:
+
+        ReplayGenerator(const QVector<QVector<quint16> >& rows, double period)
+            : rows_(rows),
+              period_(period)
+        {
+        }
+
+        virtual void update(double timeS, double phase, quint32&, quint16* values, int count) const
+        {
+            const int rowCount = rows_.size();
+            int row = int(std::floor(timeS / period_ + phase * rowCount)) % rowCount;
+
+            const QVector<quint16>& data = rows_.at(row);
+            const int size = data.size();
+
+            // Short row is repeated over range
+            //
+            // Короткая строка повторяется по всему диапазону
+            //
+            for (int i = 0; i < count; i += size)
+                std::copy(data.constData(), data.constData() + qMin(size, count - i), values + i);
+        }
+};
+
+//-----------------------------------------------------------------------------
+
+Generator*
+Generator::create(const QJsonObject& description, QString& error)
+{
+    const QString type = description.value("generator").toString("constant");
+    const double period = description.value("period").toDouble(1.0);
+    const double spread = description.value("spread").toDouble(0.0);
+
+    if (period <= 0)
+    {
+        error = "period must be positive";
+        return 0;
+    }
+
+    if (type == "constant")
+        return new ConstantGenerator(toRegister(description.value("value").toDouble(0)));
+
+    if (type == "ramp")
+        return new RampGenerator(description.value("min").toDouble(0), description.value("max").toDouble(65535),
+                                 period, spread);
+
+    if (type == "sine")
+        return new SineGenerator(description.value("offset").toDouble(32768), description.value("amplitude").toDouble(1000),
+                                 period, spread);
+
+    if (type == "walk")
+    {
+        int step = description.value("step").toInt(1);
+        int min = description.value("min").toInt(0);
+        int max = description.value("max").toInt(65535);
+
+        if ((step < 0) || (min < 0) || (max > 65535) || (min > max))
+        {
+            error = "wrong step or bounds of random walk";
+            return 0;
+        }
+
+        return new RandomWalkGenerator(step, min, max);
+    }
+
+    if (type == "replay")
+    {
+        QVector<QVector<quint16> > rows;
+
+        foreach (const QJsonValue& rowValue, description.value("values").toArray())
+        {
+            QVector<quint16> row;
+
+            if (rowValue.isArray())
+            {
+                foreach (const QJsonValue& value, rowValue.toArray())
+                    row.append(toRegister(value.toDouble()));
+            }
+            else
+            {
+                row.append(toRegister(rowValue.toDouble()));
+            }
+
+            if (row.isEmpty())
+            {
+                error = "empty row of replay";
+                return 0;
+            }
+
+            rows.append(row);
+        }
+
+        if (rows.isEmpty())
+        {
+            error = "replay has no values";
+            return 0;
+        }
+
+        return new ReplayGenerator(rows, period);
+    }
+
+    error = QString("unknown generator \"%1\"").arg(type);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+RegisterMap::~RegisterMap()
+{
+    qDeleteAll(generators_);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RegisterMap::load(const QString& fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        errorString_ = QString("Can not open %1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+    if (document.isNull())
+    {
+        errorString_ = QString("%1: %2").arg(fileName).arg(parseError.errorString());
+        return false;
+    }
+
+    QJsonArray ranges = document.object().value("ranges").toArray();
+
+    for (int i = 0; i < ranges.size(); ++i)
+    {
+        QJsonObject description = ranges.at(i).toObject();
+        const QString table = description.value("table").toString();
+
+        MapEntry entry;
+
+        if (table == "coils")
+            entry.table = MapEntry::Coils;
+        else if (table == "discrete")
+            entry.table = MapEntry::DiscreteInputs;
+        else if (table == "holding")
+            entry.table = MapEntry::HoldingRegisters;
+        else if (table == "input")
+            entry.table = MapEntry::InputRegisters;
+        else
+        {
+            errorString_ = QString("%1: range %2: unknown table \"%3\"").arg(fileName).arg(i).arg(table);
+            return false;
+        }
+
+        int start = description.value("start").toInt(-1);
+        entry.count = description.value("count").toInt(1);
+
+        if ((start < 0) || (entry.count < 1) || (start + entry.count > 0x10000))
+        {
+            errorString_ = QString("%1: range %2: wrong start or count").arg(fileName).arg(i);
+            return false;
+        }
+
+        entry.start = start;
+
+        QString error;
+        Generator* generator = Generator::create(description, error);
+
+        if (!generator)
+        {
+            errorString_ = QString("%1: range %2: %3").arg(fileName).arg(i).arg(error);
+            return false;
+        }
+
+        generators_.append(generator);
+        entry.generator = generator;
+
+        entries_.append(entry);
+    }
+
+    if (entries_.isEmpty())
+    {
+        errorString_ = QString("%1: no ranges").arg(fileName);
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+RegisterMap::maxCount() const
+{
+    int result = 0;
+
+    foreach (const MapEntry& entry, entries_)
+        result = qMax(result, entry.count);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+int
+RegisterMap::dynamicItems() const
+{
+    int result = 0;
+
+    foreach (const MapEntry& entry, entries_)
+    {
+        if (!entry.generator->isStatic())
+            result += entry.count;
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+SimDevice::SimDevice(double phase, quint32 seed)
+    : Device(),
+      phase_(phase),
+      seed_(seed)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimDevice::initialize(const RegisterMap& map, QVector<quint16>& scratch, QVector<bool>& bitScratch)
+{
+    foreach (const MapEntry& entry, map.entries())
+        update_(entry, 0, scratch, bitScratch);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimDevice::tick(double timeS, const RegisterMap& map, QVector<quint16>& scratch, QVector<bool>& bitScratch)
+{
+    foreach (const MapEntry& entry, map.entries())
+    {
+        if (!entry.generator->isStatic())
+            update_(entry, timeS, scratch, bitScratch);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimDevice::update_(const MapEntry& entry, double timeS, QVector<quint16>& scratch, QVector<bool>& bitScratch)
+{
+    quint16* values = scratch.data();
+    bool* bits = bitScratch.data();
+
+    // Current values are input of random walk
+    //
+    // Текущие значения - вход случайного блуждания
+    //
+    switch (entry.table)
+    {
+        case MapEntry::Coils :
+            coils_.read(entry.start, entry.count, bits);
+            break;
+
+        case MapEntry::DiscreteInputs :
+            discreteInputs_.read(entry.start, entry.count, bits);
+            break;
+
+        case MapEntry::HoldingRegisters :
+            holdingRegisters_.read(entry.start, entry.count, values);
+            break;
+
+        case MapEntry::InputRegisters :
+            inputRegisters_.read(entry.start, entry.count, values);
+            break;
+    }
+
+    if (entry.isBits())
+    {
+        for (int i = 0; i < entry.count; ++i)
+            values[i] = bits[i];
+    }
+
+    entry.generator->update(timeS, phase_, seed_, values, entry.count);
+
+    if (entry.isBits())
+    {
+        for (int i = 0; i < entry.count; ++i)
+            bits[i] = (values[i] != 0);
+    }
+
+    switch (entry.table)
+    {
+        case MapEntry::Coils :
+            coils_.write(entry.start, entry.count, bits);
+            break;
+
+        case MapEntry::DiscreteInputs :
+            discreteInputs_.write(entry.start, entry.count, bits);
+            break;
+
+        case MapEntry::HoldingRegisters :
+            holdingRegisters_.write(entry.start, entry.count, values);
+            break;
+
+        case MapEntry::InputRegisters :
+            inputRegisters_.write(entry.start, entry.count, values);
+            break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::readCoil(quint16 regNo, bool &value)
+{
+    value = coils_.value(regNo);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::readCoils(quint16 regStart, quint16 regQty, bool* values)
+{
+    coils_.read(regStart, regQty, values);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::readDescreteInput(quint16 regNo, bool &value)
+{
+    value = discreteInputs_.value(regNo);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::readDescreteInputs(quint16 regStart, quint16 regQty, bool* values)
+{
+    discreteInputs_.read(regStart, regQty, values);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::readInputRegister(quint16 regNo, quint16 &value)
+{
+    value = inputRegisters_.value(regNo);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::readInputRegisters(quint16 regStart, quint16 regQty, quint16* values)
+{
+    inputRegisters_.read(regStart, regQty, values);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::readHoldingRegister(quint16 regNo, quint16 &value)
+{
+    value = holdingRegisters_.value(regNo);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::readHoldingRegisters(quint16 regStart, quint16 regQty, quint16* values)
+{
+    holdingRegisters_.read(regStart, regQty, values);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::writeCoil(quint16 regNo, bool value)
+{
+    coils_.setValue(regNo, value);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::writeHoldingRegister(quint16 regNo, quint16 value)
+{
+    holdingRegisters_.setValue(regNo, value);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::writeCoils(quint16 regStart, const bool* values, quint16 regQty)
+{
+    coils_.write(regStart, regQty, values);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimDevice::writeHoldingRegisters(quint16 regStart, const quint16* values, quint16 regQty)
+{
+    holdingRegisters_.write(regStart, regQty, values);
+    return true;
+}
+
+} // namespace sim
+
+} // namespace modbus4qt
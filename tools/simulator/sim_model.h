@@ -0,0 +1,266 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_SIM_MODEL_H
+#define MODBUS4QT_SIM_MODEL_H
+
+#include "device.h"
+#include "paged_table.h"
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+namespace modbus4qt
+{
+
+namespace sim
+{
+
+/**
+ * @brief
+ * @en Source of simulated values for range of registers
+ * @ru Источник моделируемых значений для диапазона регистров
+ *
+ * @en Generator keeps no state of device: current values are passed in and
+ * out, and every device has its own phase and random seed. So one generator
+ * serves all devices and threads. Whole range is updated by one call in
+ * tight loops.
+ *
+ * @ru Генератор не хранит состояние устройства: текущие значения передаются
+ * на вход и выход, а у каждого устройства своя фаза и начальное значение
+ * случайных чисел. Поэтому один генератор обслуживает все устройства и
+ * потоки. Весь диапазон обновляется одним вызовом в простых циклах.
+ */
+class Generator
+{
+    public:
+
+        virtual ~Generator()
+        {
+        }
+
+        /**
+         * @brief
+         * @en Update values of range
+         * @ru Обновляет значения диапазона
+         *
+         * @param
+         * @en timeS - time since start of simulation, s
+         * @ru timeS - время от начала моделирования, с
+         *
+         * @param
+         * @en phase - phase of device in range 0..1
+         * @ru phase - фаза устройства в диапазоне 0..1
+         *
+         * @param
+         * @en seed - random state of device
+         * @ru seed - состояние случайных чисел устройства
+         */
+        virtual void update(double timeS, double phase, quint32& seed, quint16* values, int count) const = 0;
+
+        //! @en True if values are set once at start and then changed only by clients @ru True, если значения задаются один раз при запуске, а затем меняются только клиентами
+        virtual bool isStatic() const
+        {
+            return false;
+        }
+
+        /**
+         * @brief
+         * @en Create generator by description
+         * @ru Создает генератор по описанию
+         *
+         * @return
+         * @en NULL if description is wrong, see error
+         * @ru NULL, если описание неверно, см. error
+         */
+        static Generator* create(const QJsonObject& description, QString& error);
+};
+
+/**
+ * @brief
+ * @en Range of register map with its generator
+ * @ru Диапазон карты регистров с его генератором
+ */
+struct MapEntry
+{
+    enum Table
+    {
+        Coils,
+        DiscreteInputs,
+        HoldingRegisters,
+        InputRegisters
+    };
+
+    Table table;
+
+    quint16 start;
+
+    int count;
+
+    const Generator* generator;
+
+    bool isBits() const
+    {
+        return (table == Coils) || (table == DiscreteInputs);
+    }
+};
+
+/**
+ * @brief
+ * @en Register map shared by all simulated devices
+ * @ru Карта регистров, общая для всех моделируемых устройств
+ *
+ * @en Map is JSON file:
+ * <pre>
+ * { "ranges": [
+ *     { "table": "holding", "start": 0, "count": 100, "generator": "constant", "value": 0 },
+ *     { "table": "input", "start": 30000, "count": 100, "generator": "sine",
+ *       "offset": 2000, "amplitude": 1000, "period": 60, "spread": 0.01 },
+ *     { "table": "input", "start": 40000, "count": 10000, "generator": "walk",
+ *       "step": 5, "min": 0, "max": 4000 },
+ *     { "table": "discrete", "start": 0, "count": 16, "generator": "ramp",
+ *       "min": 0, "max": 2, "period": 10 },
+ *     { "table": "holding", "start": 200, "count": 4, "generator": "replay",
+ *       "period": 1, "values": [[1, 2, 3, 4], [5, 6, 7, 8]] }
+ * ] }
+ * </pre>
+ * Tables are "coils", "discrete", "holding" and "input". Bit tables take non
+ * zero values as 1.
+ *
+ * @ru Карта - файл JSON (см. выше). Таблицы - "coils", "discrete", "holding"
+ * и "input". Битовые таблицы считают ненулевые значения единицей.
+ */
+class RegisterMap
+{
+    private:
+
+        QList<MapEntry> entries_;
+
+        QList<Generator*> generators_;
+
+        QString errorString_;
+
+        Q_DISABLE_COPY(RegisterMap)
+
+    public:
+
+        RegisterMap()
+        {
+        }
+
+        ~RegisterMap();
+
+        bool load(const QString& fileName);
+
+        const QList<MapEntry>& entries() const
+        {
+            return entries_;
+        }
+
+        //! @en Largest range, size of scratch buffer for updates @ru Наибольший диапазон, размер рабочего буфера для обновления
+        int maxCount() const;
+
+        //! @en Registers and bits updated every tick @ru Количество регистров и битов, обновляемых на каждом такте
+        int dynamicItems() const;
+
+        QString errorString() const
+        {
+            return errorString_;
+        }
+};
+
+/**
+ * @brief
+ * @en Simulated slave with sparse tables
+ * @ru Моделируемое ведомое устройство с разреженными таблицами
+ */
+class SimDevice : public Device
+{
+    private:
+
+        PagedTable<bool> coils_;
+
+        PagedTable<bool> discreteInputs_;
+
+        PagedTable<quint16> holdingRegisters_;
+
+        PagedTable<quint16> inputRegisters_;
+
+        double phase_;
+
+        quint32 seed_;
+
+    public:
+
+        SimDevice(double phase, quint32 seed);
+
+        //! @en Set values of static ranges @ru Устанавливает значения статических диапазонов
+        void initialize(const RegisterMap& map, QVector<quint16>& scratch, QVector<bool>& bitScratch);
+
+        //! @en Update dynamic ranges @ru Обновляет динамические диапазоны
+        void tick(double timeS, const RegisterMap& map, QVector<quint16>& scratch, QVector<bool>& bitScratch);
+
+    protected:
+
+        virtual bool readCoil(quint16 regNo, bool &value);
+
+        virtual bool readCoils(quint16 regStart, quint16 regQty, bool* values);
+
+        virtual bool readDescreteInput(quint16 regNo, bool &value);
+
+        virtual bool readDescreteInputs(quint16 regStart, quint16 regQty, bool* values);
+
+        virtual bool readInputRegister(quint16 regNo, quint16 &value);
+
+        virtual bool readInputRegisters(quint16 regStart, quint16 regQty, quint16* values);
+
+        virtual bool readHoldingRegister(quint16 regNo, quint16 &value);
+
+        virtual bool readHoldingRegisters(quint16 regStart, quint16 regQty, quint16* values);
+
+        virtual bool writeCoil(quint16 regNo, bool value);
+
+        virtual bool writeHoldingRegister(quint16 regNo, quint16 value);
+
+        virtual bool writeCoils(quint16 regStart, const bool* values, quint16 regQty);
+
+        virtual bool writeHoldingRegisters(quint16 regStart, const quint16* values, quint16 regQty);
+
+    private:
+
+        void update_(const MapEntry& entry, double timeS, QVector<quint16>& scratch, QVector<bool>& bitScratch);
+};
+
+} // namespace sim
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_SIM_MODEL_H
@@ -0,0 +1,243 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#include "sim_worker.h"
+
+#include "epoll_tcp_server.h"
+#include "tcp_server.h"
+
+#include <QMutexLocker>
+
+namespace modbus4qt
+{
+
+namespace sim
+{
+
+void
+TickCounters::merge(const TickCounters& other)
+{
+    ticks += other.ticks;
+    overruns += other.overruns;
+    totalNs += other.totalNs;
+    maxNs = qMax(maxNs, other.maxNs);
+}
+
+//-----------------------------------------------------------------------------
+
+SimTicker::SimTicker(const QList<SimDevice*>& devices, const SimConfig& config, const QElapsedTimer& clock)
+    : QObject(0),
+      devices_(devices),
+      config_(config),
+      clock_(clock),
+      scratch_(config.map->maxCount()),
+      bitScratch_(config.map->maxCount()),
+      timer_(this)
+{
+    timer_.setTimerType(Qt::PreciseTimer);
+    timer_.setInterval(config.tickMs);
+    connect(&timer_, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimTicker::start()
+{
+    foreach (SimDevice* device, devices_)
+        device->initialize(*config_.map, scratch_, bitScratch_);
+
+    timer_.start();
+}
+
+//-----------------------------------------------------------------------------
+
+TickCounters
+SimTicker::takeCounters()
+{
+    QMutexLocker locker(&mutex_);
+
+    TickCounters counters = counters_;
+    counters_ = TickCounters();
+
+    return counters;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimTicker::tick()
+{
+    const qint64 startNs = clock_.nsecsElapsed();
+    const double timeS = startNs / 1e9;
+
+    foreach (SimDevice* device, devices_)
+        device->tick(timeS, *config_.map, scratch_, bitScratch_);
+
+    const qint64 durationNs = clock_.nsecsElapsed() - startNs;
+
+    QMutexLocker locker(&mutex_);
+
+    ++counters_.ticks;
+    counters_.totalNs += durationNs;
+    counters_.maxNs = qMax(counters_.maxNs, durationNs);
+
+    if (durationNs > qint64(config_.tickMs) * 1000000)
+        ++counters_.overruns;
+}
+
+//-----------------------------------------------------------------------------
+
+SimWorker::SimWorker(const SimConfig& config, const QList<quint16>& ports, int firstDevice, const QElapsedTimer& clock)
+    : QThread(),
+      config_(config),
+      ports_(ports),
+      firstDevice_(firstDevice),
+      clock_(clock),
+      ticker_(0),
+      listening_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+SimWorker::startServers()
+{
+    start();
+    started_.acquire();
+
+    return errors_.isEmpty();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimWorker::stopServers()
+{
+    quit();
+    wait();
+}
+
+//-----------------------------------------------------------------------------
+
+TickCounters
+SimWorker::takeCounters()
+{
+    return ticker_ ? ticker_->takeCounters() : TickCounters();
+}
+
+//-----------------------------------------------------------------------------
+
+Server*
+SimWorker::createServer_(quint16 port)
+{
+    if (config_.backend == "epoll")
+    {
+        EpollTcpServer* server = new EpollTcpServer();
+
+        if (server->listen(config_.address, port))
+            return server;
+
+        delete server;
+    }
+
+    // Qt server is also fallback on systems without epoll
+    //
+    // Сервер Qt также используется на системах без epoll
+    //
+    TcpServer* server = new TcpServer();
+
+    if (server->listen(config_.address, port))
+        return server;
+
+    delete server;
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SimWorker::run()
+{
+    QList<SimDevice*> devices;
+    QList<Server*> servers;
+
+    int deviceNo = firstDevice_;
+
+    foreach (quint16 port, ports_)
+    {
+        Server* server = createServer_(port);
+
+        if (!server)
+        {
+            errors_.append(QString("Can not listen on port %1").arg(port));
+            continue;
+        }
+
+        foreach (int unit, config_.units)
+        {
+            // Golden ratio spreads phases of neighbour devices evenly
+            //
+            // Золотое сечение равномерно распределяет фазы соседних устройств
+            //
+            double phase = deviceNo * 0.6180339887;
+            phase -= int(phase);
+
+            SimDevice* device = new SimDevice(phase, quint32(deviceNo) * 2654435761u + 1);
+            server->setUnitDevice(unit, device);
+
+            devices.append(device);
+            ++deviceNo;
+        }
+
+        servers.append(server);
+    }
+
+    listening_ = servers.size();
+
+    SimTicker ticker(devices, config_, clock_);
+    ticker.start();
+    ticker_ = &ticker;
+
+    started_.release();
+
+    if (errors_.isEmpty())
+        exec();
+
+    ticker_ = 0;
+
+    qDeleteAll(servers);
+    qDeleteAll(devices);
+}
+
+} // namespace sim
+
+} // namespace modbus4qt
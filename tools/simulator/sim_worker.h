@@ -0,0 +1,213 @@
+/*****************************************************************************
+ * modbus4qt Library
+ * Author: Leonid Kolesnik, l.kolesnik@m-i.ru
+ * Copyright (C) 2012-2021
+ * https://mt11.net.ru
+ *****************************************************************************/
+
+/*
+
+The contents of this file are subject to the Mozilla Public License Version 1.1
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+the specific language governing rights and limitations under the License.
+
+Alternatively, the contents of this file may be used under the terms of the
+GNU General Public License Version 2 or later (the "GPL"), in which case
+the provisions of the GPL are applicable instead of those above. If you wish to
+allow use of your version of this file only under the terms of the GPL and not
+to allow others to use your version of this file under the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice and
+other provisions required by the GPL. If you do not delete the provisions
+above, a recipient may use your version of this file under either the MPL or
+the GPL.
+
+*/
+
+#ifndef MODBUS4QT_SIM_WORKER_H
+#define MODBUS4QT_SIM_WORKER_H
+
+#include "sim_model.h"
+
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QList>
+#include <QMutex>
+#include <QSemaphore>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+
+namespace modbus4qt
+{
+
+class Server;
+
+namespace sim
+{
+
+/**
+ * @brief
+ * @en Parameters of simulation
+ * @ru Параметры моделирования
+ */
+struct SimConfig
+{
+    QHostAddress address;
+
+    //! @en Unit IDs served on every port @ru Идентификаторы устройств, обслуживаемые на каждом порту
+    QList<int> units;
+
+    //! @en Interval of value updates, ms @ru Интервал обновления значений, мс
+    int tickMs;
+
+    //! @en "epoll" or "qt" @ru "epoll" или "qt"
+    QString backend;
+
+    const RegisterMap* map;
+};
+
+/**
+ * @brief
+ * @en Statistics of ticks collected during one report interval
+ * @ru Статистика тактов, собранная за один интервал отчета
+ */
+struct TickCounters
+{
+    int ticks;
+
+    //! @en Ticks longer than tick interval @ru Такты длиннее интервала тактов
+    int overruns;
+
+    qint64 totalNs;
+
+    qint64 maxNs;
+
+    TickCounters()
+        : ticks(0),
+          overruns(0),
+          totalNs(0),
+          maxNs(0)
+    {
+    }
+
+    void merge(const TickCounters& other);
+};
+
+/**
+ * @brief
+ * @en Updates values of devices of one thread by timer
+ * @ru Обновляет значения устройств одного потока по таймеру
+ */
+class SimTicker : public QObject
+{
+    Q_OBJECT
+
+    private:
+
+        const QList<SimDevice*>& devices_;
+
+        const SimConfig& config_;
+
+        const QElapsedTimer& clock_;
+
+        QVector<quint16> scratch_;
+
+        QVector<bool> bitScratch_;
+
+        QTimer timer_;
+
+        QMutex mutex_;
+
+        TickCounters counters_;
+
+    public:
+
+        SimTicker(const QList<SimDevice*>& devices, const SimConfig& config, const QElapsedTimer& clock);
+
+        void start();
+
+        TickCounters takeCounters();
+
+    private slots:
+
+        void tick();
+};
+
+/**
+ * @brief
+ * @en Thread serving several ports with all units on each
+ * @ru Поток, обслуживающий несколько портов со всеми устройствами на каждом
+ *
+ * @en Servers, devices and ticker live in the thread, so values are updated
+ * between requests without locks. Each port is served by one server with
+ * routing table of its units.
+ *
+ * @ru Серверы, устройства и таймер живут в потоке, поэтому значения
+ * обновляются между запросами без блокировок. Каждый порт обслуживается
+ * одним сервером с таблицей маршрутов его устройств.
+ */
+class SimWorker : public QThread
+{
+    private:
+
+        SimConfig config_;
+
+        QList<quint16> ports_;
+
+        int firstDevice_;
+
+        const QElapsedTimer& clock_;
+
+        QSemaphore started_;
+
+        SimTicker* ticker_;
+
+        QStringList errors_;
+
+        int listening_;
+
+    public:
+
+        /**
+         * @param
+         * @en firstDevice - global number of first device, sets phases and seeds
+         * @ru firstDevice - общий номер первого устройства, задает фазы и начальные значения
+         */
+        SimWorker(const SimConfig& config, const QList<quint16>& ports, int firstDevice, const QElapsedTimer& clock);
+
+        //! @en Start thread and wait until ports are open @ru Запускает поток и ждет открытия портов
+        bool startServers();
+
+        void stopServers();
+
+        //! @en Ports which could not be opened @ru Порты, которые не удалось открыть
+        QStringList errors() const
+        {
+            return errors_;
+        }
+
+        int listening() const
+        {
+            return listening_;
+        }
+
+        TickCounters takeCounters();
+
+    protected:
+
+        virtual void run();
+
+    private:
+
+        Server* createServer_(quint16 port);
+};
+
+} // namespace sim
+
+} // namespace modbus4qt
+
+#endif // MODBUS4QT_SIM_WORKER_H
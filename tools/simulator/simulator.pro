@@ -0,0 +1,15 @@
+include( $${PWD}/../tools.pri )
+
+TARGET = modbus4qt-simulator
+
+MOC_DIR = $${MOC_DIR}/tools/simulator
+OBJECTS_DIR = $${OBJECTS_DIR}/tools/simulator
+
+SOURCES += \
+    main.cpp \
+    sim_model.cpp \
+    sim_worker.cpp
+
+HEADERS += \
+    sim_model.h \
+    sim_worker.h
@@ -0,0 +1,42 @@
+################################################################
+# modbus4qt library
+# Copyright (C) 2012-2013, MELZ-INVEST JSC
+# Author: Leonid Kolesnik
+#
+# Common settings for command line tools
+#
+################################################################
+
+MODBUS4QT_ROOT = $${PWD}/..
+include($${MODBUS4QT_ROOT}/modbus4qt_config.pri)
+include($${MODBUS4QT_ROOT}/modbus4qt_build.pri)
+
+TEMPLATE = app
+
+QT += network serialport
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+DESTDIR = $${MODBUS4QT_BUILD}/tools
+
+# Statistics and report helpers are shared with benchmarks
+MODBUS4QT_BENCH_COMMON = $${MODBUS4QT_ROOT}/benchmarks/common
+
+INCLUDEPATH += $${MODBUS4QT_BENCH_COMMON}
+DEPENDPATH  += $${MODBUS4QT_BENCH_COMMON}
+
+SOURCES += \
+    $${MODBUS4QT_BENCH_COMMON}/bench_requests.cpp \
+    $${MODBUS4QT_BENCH_COMMON}/bench_utils.cpp
+
+HEADERS += \
+    $${MODBUS4QT_BENCH_COMMON}/bench_requests.h \
+    $${MODBUS4QT_BENCH_COMMON}/bench_utils.h
+
+LIBS += -lmodbus4qt
+
+target.path = $${MODBUS4QT_INSTALL_BIN}
+
+INSTALLS = target
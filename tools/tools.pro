@@ -0,0 +1,15 @@
+################################################################
+# modbus4qt library
+# Copyright (C) 2012-2013, MELZ-INVEST JSC
+# Author: Leonid Kolesnik
+#
+################################################################
+
+include( $${PWD}/../modbus4qt_config.pri )
+
+TEMPLATE = subdirs
+
+    SUBDIRS += \
+        loadgen \
+        simulator \
+        replay